@@ -1,13 +1,27 @@
 #include "pch.h"
 #include "BaseEffect.h"
 
-BaseEffect::BaseEffect(ID3D11Device* devicePtr, const std::wstring& path)
+BaseEffect::BaseEffect(ID3DX11Effect* effectPtr)
+	: m_EffectPtr{ effectPtr }
 {
-	m_EffectPtr = LoadEffect(devicePtr, path);
-
 	m_TechniquePtr = m_EffectPtr->GetTechniqueByName("DefaultTechnique");
 	if (!m_TechniquePtr->IsValid()) std::wcout << L"Technique not valid\n";
 
+	// optional, effects without it are drawn one instance at a time
+	m_InstancedTechniquePtr = m_EffectPtr->GetTechniqueByName("InstancedTechnique");
+	if (m_InstancedTechniquePtr->IsValid())
+	{
+		m_ViewProjMatrixPtr = m_EffectPtr->GetVariableByName("gViewProj")->AsMatrix();
+		if (!m_ViewProjMatrixPtr->IsValid())
+		{
+			std::wcout << L"ViewProjMatrixVariable not valid!\n";
+		}
+	}
+	else
+	{
+		m_InstancedTechniquePtr = nullptr;
+	}
+
 	m_WorldViewProjMatrixPtr = m_EffectPtr->GetVariableByName("gWorldViewProj")->AsMatrix();
 	if (!m_WorldViewProjMatrixPtr->IsValid())
 	{
@@ -41,6 +55,18 @@ BaseEffect::~BaseEffect()
 	}
 }
 
+ID3DX11Effect* BaseEffect::CloneEffect() const
+{
+	// non-single: the clone gets its own constant buffers instead of sharing the ones of this effect
+	ID3DX11Effect* clonePtr{ nullptr };
+	if (FAILED(m_EffectPtr->CloneEffect(D3DX11_EFFECT_CLONE_FORCE_NONSINGLE, &clonePtr)))
+	{
+		std::wcout << L"CloneEffect failed\n";
+		return nullptr;
+	}
+	return clonePtr;
+}
+
 ID3DX11Effect* BaseEffect::LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile)
 {
 	HRESULT result;
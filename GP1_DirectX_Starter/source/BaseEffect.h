@@ -2,27 +2,50 @@
 class BaseEffect
 {
 public:
-	BaseEffect(ID3D11Device* devicePtr, const std::wstring& path);
-	~BaseEffect();
+	virtual ~BaseEffect();
+
+	BaseEffect(const BaseEffect&) = delete;
+	BaseEffect(BaseEffect&&) noexcept = delete;
+	BaseEffect& operator=(const BaseEffect&) = delete;
+	BaseEffect& operator=(BaseEffect&&) noexcept = delete;
+
+	//Copy with its own variable storage and the current variable values, textures and shaders are shared
+	//Effects11 is not thread safe, every thread that records draws needs its own copy
+	virtual std::unique_ptr<BaseEffect> Clone() const = 0;
 
 	ID3DX11Effect* GetEffect() const { return m_EffectPtr; };
 	ID3DX11EffectTechnique* GetTechnique() const { return m_TechniquePtr; }
+	//nullptr when the effect has no "InstancedTechnique"
+	ID3DX11EffectTechnique* GetInstancedTechnique() const { return m_InstancedTechniquePtr; }
 	ID3DX11EffectVectorVariable* GetCameraPos() const { return m_CameraPosPtr; }
 
 	static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
 
 	ID3DX11EffectMatrixVariable* GetWorldViewProjMatrix() const { return m_WorldViewProjMatrixPtr; }
 	ID3DX11EffectMatrixVariable* GetWorldMatrix() const { return m_WorldMatrixPtr; }
+	ID3DX11EffectMatrixVariable* GetViewProjMatrix() const { return m_ViewProjMatrixPtr; }
 
 	void SetSamplerState(ID3D11Device* devicePtr, int state) const;
 
+	//blended effects are drawn after every opaque one
+	bool IsTransparent() const { return m_IsTransparent; }
+
 protected:
+	//takes ownership of effectPtr
+	explicit BaseEffect(ID3DX11Effect* effectPtr);
+
+	ID3DX11Effect* CloneEffect() const;
+
 	ID3DX11Effect* m_EffectPtr{};
 	ID3DX11EffectTechnique* m_TechniquePtr{};
+	ID3DX11EffectTechnique* m_InstancedTechniquePtr{};
 	ID3DX11EffectVectorVariable* m_CameraPosPtr{};
 
 	ID3DX11EffectMatrixVariable* m_WorldViewProjMatrixPtr{};
 	ID3DX11EffectMatrixVariable* m_WorldMatrixPtr{};
+	ID3DX11EffectMatrixVariable* m_ViewProjMatrixPtr{};
 
 	ID3DX11EffectSamplerVariable* m_SamplerStateVariablePtr{};
+
+	bool m_IsTransparent{ false };
 };
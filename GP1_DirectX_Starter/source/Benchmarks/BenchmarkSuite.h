@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	//Keeps the optimizer from discarding a result or hoisting work out of the timed loop
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static_cast<void>(*reinterpret_cast<const volatile char*>(&value));
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	inline void ClobberMemory()
+	{
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+	struct BenchmarkResult
+	{
+		std::string name{};
+		double nsPerOp{};
+	};
+
+	//Minimal micro-benchmark runner
+	//Every kernel is calibrated to run for at least m_MinSampleTime, the reported ns/op is the best of m_SampleCount samples
+	//Kernels that look slower than the baseline are re-measured up to m_RetryCount times to filter out scheduler noise
+	class BenchmarkSuite
+	{
+	public:
+		BenchmarkSuite(std::string filter, double minSampleTimeMs, int sampleCount)
+			: m_Filter{ std::move(filter) }
+			, m_MinSampleTime{ minSampleTimeMs * 1e6 }
+			, m_SampleCount{ sampleCount }
+		{
+		}
+
+		//kernel() performs opsPerCall operations per invocation, returns the reported ns/op or 0 when filtered out
+		template<typename Kernel>
+		double Run(const std::string& name, size_t opsPerCall, Kernel&& kernel)
+		{
+			if (!m_Filter.empty() && name.find(m_Filter) == std::string::npos) return 0.0;
+
+			//warm up caches and find an iteration count that fills one sample
+			size_t iterations{ 1 };
+			while (true)
+			{
+				const double elapsed = TimeIterations(kernel, iterations);
+				if (elapsed >= m_MinSampleTime) break;
+				const double scale = elapsed > 0.0 ? std::min(m_MinSampleTime * 1.2 / elapsed, 10.0) : 10.0;
+				iterations = std::max(iterations + 1, static_cast<size_t>(static_cast<double>(iterations) * scale));
+			}
+
+			const double opCount = static_cast<double>(iterations * opsPerCall);
+			double nsPerOp = MeasureBest(kernel, iterations) / opCount;
+
+			//a single noisy run should not fail the comparison: re-measure before reporting a regression
+			const BenchmarkResult* baselinePtr = FindResult(m_Baseline, name);
+			for (int retry{}; retry < m_RetryCount && baselinePtr && IsRegression(nsPerOp, baselinePtr->nsPerOp); ++retry)
+			{
+				nsPerOp = std::min(nsPerOp, MeasureBest(kernel, iterations) / opCount);
+			}
+
+			m_Results.push_back({ name, nsPerOp });
+			std::printf("%-48s %10.3f ns/op\n", name.c_str(), nsPerOp);
+			return nsPerOp;
+		}
+
+		//A kernel regresses when it is both threshold (fraction) and minDelta (ns/op) slower than its baseline
+		//minDelta keeps sub-nanosecond kernels from failing on timer resolution and alignment effects
+		void SetBaseline(std::vector<BenchmarkResult> baseline, double threshold, double minDelta)
+		{
+			m_Baseline = std::move(baseline);
+			m_Threshold = threshold;
+			m_MinDelta = minDelta;
+		}
+
+		const std::vector<BenchmarkResult>& GetResults() const { return m_Results; }
+
+		void WriteJson(std::ostream& out) const
+		{
+			out << "{\n\t\"benchmarks\": [\n";
+			for (size_t i{}; i < m_Results.size(); ++i)
+			{
+				char nsPerOp[32]{};
+				std::snprintf(nsPerOp, sizeof(nsPerOp), "%.4f", m_Results[i].nsPerOp);
+				out << "\t\t{ \"name\": \"" << m_Results[i].name << "\", \"ns_per_op\": " << nsPerOp << " }";
+				out << (i + 1 < m_Results.size() ? ",\n" : "\n");
+			}
+			out << "\t]\n}\n";
+		}
+
+		//Reads the format written by WriteJson, returns false if the file cannot be opened
+		static bool ReadJson(const std::string& path, std::vector<BenchmarkResult>& results)
+		{
+			std::ifstream file{ path };
+			if (!file) return false;
+
+			std::stringstream buffer{};
+			buffer << file.rdbuf();
+			const std::string text = buffer.str();
+
+			constexpr std::string_view nameKey{ "\"name\": \"" };
+			constexpr std::string_view valueKey{ "\"ns_per_op\": " };
+			size_t position{};
+			while ((position = text.find(nameKey, position)) != std::string::npos)
+			{
+				position += nameKey.size();
+				const size_t nameEnd = text.find('"', position);
+				const size_t valuePosition = text.find(valueKey, nameEnd);
+				if (nameEnd == std::string::npos || valuePosition == std::string::npos) break;
+
+				results.push_back({ text.substr(position, nameEnd - position), std::stod(text.substr(valuePosition + valueKey.size())) });
+				position = valuePosition;
+			}
+			return true;
+		}
+
+		//Prints every kernel that regressed (see SetBaseline) or improved and returns the number of regressions
+		int CompareToBaseline() const
+		{
+			int regressions{};
+			for (const BenchmarkResult& result : m_Results)
+			{
+				const BenchmarkResult* baselinePtr = FindResult(m_Baseline, result.name);
+				if (!baselinePtr)
+				{
+					std::printf("  [new]        %-48s %10.3f ns/op\n", result.name.c_str(), result.nsPerOp);
+					continue;
+				}
+
+				const double ratio = result.nsPerOp / baselinePtr->nsPerOp;
+				if (IsRegression(result.nsPerOp, baselinePtr->nsPerOp))
+				{
+					std::printf("  [REGRESSED]  %-48s %10.3f -> %10.3f ns/op (%+.0f%%)\n", result.name.c_str(), baselinePtr->nsPerOp, result.nsPerOp, (ratio - 1.0) * 100.0);
+					++regressions;
+				}
+				else if (ratio < 1.0 - m_Threshold)
+				{
+					std::printf("  [improved]   %-48s %10.3f -> %10.3f ns/op (%+.0f%%)\n", result.name.c_str(), baselinePtr->nsPerOp, result.nsPerOp, (ratio - 1.0) * 100.0);
+				}
+			}
+			return regressions;
+		}
+
+	private:
+		std::string m_Filter{};
+		double m_MinSampleTime{};
+		int m_SampleCount{};
+		std::vector<BenchmarkResult> m_Results{};
+		std::vector<BenchmarkResult> m_Baseline{};
+		double m_Threshold{};
+		double m_MinDelta{};
+		static constexpr int m_RetryCount{ 3 };
+
+		static const BenchmarkResult* FindResult(const std::vector<BenchmarkResult>& results, const std::string& name)
+		{
+			const auto it = std::find_if(results.begin(), results.end(), [&](const BenchmarkResult& result) { return result.name == name; });
+			return it != results.end() ? &*it : nullptr;
+		}
+
+		bool IsRegression(double nsPerOp, double baselineNsPerOp) const
+		{
+			return nsPerOp > baselineNsPerOp * (1.0 + m_Threshold) && nsPerOp - baselineNsPerOp > m_MinDelta;
+		}
+
+		template<typename Kernel>
+		double MeasureBest(Kernel& kernel, size_t iterations) const
+		{
+			double best{ 1e300 };
+			for (int sample{}; sample < m_SampleCount; ++sample)
+			{
+				best = std::min(best, TimeIterations(kernel, iterations));
+			}
+			return best;
+		}
+
+		template<typename Kernel>
+		static double TimeIterations(Kernel& kernel, size_t iterations)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i{}; i < iterations; ++i)
+			{
+				kernel();
+				ClobberMemory();
+			}
+			const auto end = std::chrono::steady_clock::now();
+			return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		}
+	};
+}
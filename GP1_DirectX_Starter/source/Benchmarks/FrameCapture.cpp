@@ -0,0 +1,256 @@
+//Headless golden image test for the renderer
+//Renders the scene of Renderer through the frame pipeline on the software render backend, along a fixed camera path with a
+//fixed timestep, writes every frame as PNG and compares it against the golden frame with the same index.
+//Builds without SDL / D3D, so it runs on machines without a GPU:
+//	Windows: FrameCapture.vcxproj (part of WX_DirectX_Start.sln)
+//	Linux  : g++ -std=c++20 -O2 -march=x86-64-v3 -pthread -I.. FrameCapture.cpp -o FrameCapture
+//
+//Usage: FrameCapture [--resources <dir, ../Resources>] [--golden <dir, Golden>] [--out <dir, Captures>] [--update]
+//                    [--frames <count, 8>] [--sampler <0 point | 1 linear | 2 anisotropic, 2>] [--threads <1 | all, all>]
+//                    [--min-psnr <dB, 40>] [--max-error <0.005>]
+//Prints the render time, PSNR and mean perceptual error of every frame
+//--update writes the frames to the golden directory instead of comparing them
+//Exits with 1 when a frame has no golden image, is below min-psnr or above max-error, 2 on bad arguments or missing resources
+//Goldens are only bit exact for one build on one CPU: SIMD widths and compilers round differently, the thresholds absorb that
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "SoftwareRenderBackend.h"
+#include "Utils.h"
+#include "ImageCompare.h"
+#include "PngFile.h"
+
+using namespace dae;
+
+namespace
+{
+	constexpr uint32_t WIDTH{ 640 };
+	constexpr uint32_t HEIGHT{ 480 };
+	//the vehicle turns like Renderer::Update with the rotation on, every frame advances the animation by the same step
+	//no matter how long it took, large enough for a few frames to cover the whole path
+	constexpr float FIXED_TIMESTEP{ 0.25f };
+	constexpr float VEHICLE_ROTATION_SPEED{ 45.f * TO_RADIANS };
+	constexpr Vector3 VEHICLE_POSITION{ 0.f, 0.f, 0.f };
+	constexpr float OCCLUDER_SCALE{ 0.6f };
+
+	//Mirrors Camera::CalculateViewMatrix + Camera::CalculateProjectionMatrix (Camera itself needs SDL)
+	Matrix CreateViewProjection(const Vector3& origin, const Vector3& target)
+	{
+		constexpr float nearPlane{ 0.1f };
+		constexpr float farPlane{ 1000.f };
+		const float fovValue{ tanf(45.f * TO_RADIANS / 2.f) };
+		constexpr float aspectRatio{ static_cast<float>(WIDTH) / static_cast<float>(HEIGHT) };
+
+		const Vector3 forward = (target - origin).Normalized();
+		const Vector3 right = Vector3::Cross(Vector3::UnitY, forward).Normalized();
+		const Vector3 up = Vector3::Cross(forward, right).Normalized();
+		const Matrix invViewMatrix = Matrix::InverseRigid(Matrix{ right, up, forward, origin });
+
+		const Matrix projectionMatrix{
+			Vector4{ 1 / (aspectRatio * fovValue), 0, 0, 0 },
+			Vector4{ 0, 1 / fovValue, 0, 0 },
+			Vector4{ 0, 0, farPlane / (farPlane - nearPlane), 1 },
+			Vector4{ 0, 0, -(farPlane * nearPlane) / (farPlane - nearPlane), 0 }
+		};
+		return invViewMatrix * projectionMatrix;
+	}
+
+	//Starts where Renderer puts the camera, then circles the vehicle while moving in and out and up and down, so the
+	//frames see the front, the sides, the fire and the vehicle close up. Stays around the vehicle for any frame count
+	Vector3 GetCameraPosition(float time)
+	{
+		const float angle = time * 0.8f;
+		const float distance = 40.f + 10.f * cosf(time * 0.9f);
+		return VEHICLE_POSITION + Vector3{ -sinf(angle) * distance, 8.f * sinf(time * 0.6f), -cosf(angle) * distance };
+	}
+
+	struct Settings
+	{
+		std::string resourceDirectory{ "../Resources" };
+		std::string goldenDirectory{ "Golden" };
+		std::string outDirectory{ "Captures" };
+		bool update{ false };
+		int frameCount{ 8 };
+		int samplerState{ 2 };
+		bool singleThreaded{ false };
+		double minPsnr{ 40.0 };
+		double maxError{ 0.005 };
+	};
+
+	//The whole argument has to be the number, no exceptions and no trailing characters
+	template<typename T>
+	bool ParseNumber(const char* text, T& value)
+	{
+		const char* end = text + std::strlen(text);
+		const auto [last, error] = std::from_chars(text, end, value);
+		return error == std::errc{} && last == end;
+	}
+
+	std::string GetFrameName(int frame)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame_%03d.png", frame);
+		return name;
+	}
+
+	//returns the exit code
+	int Run(const Settings& settings)
+	{
+		//the backend asks for Resources/<file> like the effects, the files are looked up in the resource directory instead
+		const auto loadTexture = [&](const std::string& path, SoftwareTexture& texture)
+		{
+			const std::filesystem::path file = std::filesystem::path{ settings.resourceDirectory } / std::filesystem::path{ path }.filename();
+			return Png::Read(file.string(), texture.width, texture.height, texture.texels);
+		};
+
+		JobSystem singleJobSystem{ 0 };
+		SoftwareRenderBackend backend{ WIDTH, HEIGHT, loadTexture, settings.singleThreaded ? singleJobSystem : JobSystem::Get() };
+		backend.SetSamplerState(settings.samplerState);
+		FramePipeline pipeline{ backend };
+
+		//same scene as the Renderer constructor
+		std::vector<MeshVertex> vertices{};
+		std::vector<uint32_t> indices{};
+		const std::string vehiclePath = (std::filesystem::path{ settings.resourceDirectory } / "vehicle.obj").string();
+		const std::string fireFXPath = (std::filesystem::path{ settings.resourceDirectory } / "fireFX.obj").string();
+		if (!Utils::ParseOBJ(vehiclePath, vertices, indices))
+		{
+			std::cerr << "could not read '" << vehiclePath << "'" << std::endl;
+			return 2;
+		}
+
+		const MaterialHandle vehicleMaterial = pipeline.CreateMaterial(MaterialType::Vehicle);
+		const MeshHandle vehicleMesh = pipeline.CreateMesh(vertices, indices, vehicleMaterial);
+		const Aabb& vehicleBounds = pipeline.GetMeshBounds(vehicleMesh);
+		pipeline.SetOccluderBounds(vehicleMesh, Aabb::FromCenterExtents(vehicleBounds.GetCenter(), vehicleBounds.GetExtents() * OCCLUDER_SCALE));
+		const NodeHandle vehicleNode = pipeline.GetSceneGraph().CreateNode(Transform{ VEHICLE_POSITION });
+		pipeline.GetRenderWorld().CreateEntity(vehicleMesh, vehicleMaterial, vehicleBounds, Transform{}, vehicleNode);
+
+		if (!Utils::ParseOBJ(fireFXPath, vertices, indices))
+		{
+			std::cerr << "could not read '" << fireFXPath << "'" << std::endl;
+			return 2;
+		}
+		const MaterialHandle fireFXMaterial = pipeline.CreateMaterial(MaterialType::FireFX);
+		const MeshHandle fireFXMesh = pipeline.CreateMesh(vertices, indices, fireFXMaterial);
+		pipeline.GetRenderWorld().CreateEntity(fireFXMesh, fireFXMaterial, pipeline.GetMeshBounds(fireFXMesh), Transform{}, vehicleNode);
+
+		std::filesystem::create_directories(settings.update ? settings.goldenDirectory : settings.outDirectory);
+
+		int failedCount{};
+		double totalTimeMs{};
+		std::vector<uint32_t> frame(size_t{ WIDTH } * HEIGHT);
+		for (int frameIndex{}; frameIndex < settings.frameCount; ++frameIndex)
+		{
+			const float time = static_cast<float>(frameIndex) * FIXED_TIMESTEP;
+			Transform vehicleTransform{ VEHICLE_POSITION };
+			vehicleTransform.RotateAround(VEHICLE_POSITION, Quaternion::CreateFromAxisAngle(Vector3::UnitY, time * VEHICLE_ROTATION_SPEED));
+			pipeline.GetSceneGraph().SetLocalTransform(vehicleNode, vehicleTransform);
+
+			const Vector3 cameraPosition = GetCameraPosition(time);
+			const Matrix viewProjection = CreateViewProjection(cameraPosition, VEHICLE_POSITION);
+
+			const auto start = std::chrono::steady_clock::now();
+			pipeline.Update(viewProjection);
+			backend.BeginFrame();
+			backend.SetCameraPosition(cameraPosition);
+			pipeline.Submit();
+			backend.EndFrame();
+			const double timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			totalTimeMs += timeMs;
+
+			//the swap chain ignores alpha, the blended fire leaves 0 in it
+			const SoftwareRasterizer& rasterizer = backend.GetRasterizer();
+			for (uint32_t y{}; y < HEIGHT; ++y)
+			{
+				for (uint32_t x{}; x < WIDTH; ++x)
+				{
+					frame[size_t{ y } * WIDTH + x] = rasterizer.GetPixel(x, y) | 0xFF000000;
+				}
+			}
+
+			const std::string name = GetFrameName(frameIndex);
+			const std::filesystem::path outPath = std::filesystem::path{ settings.update ? settings.goldenDirectory : settings.outDirectory } / name;
+			if (!Png::Write(outPath.string(), WIDTH, HEIGHT, frame.data(), WIDTH))
+			{
+				std::cerr << "could not write '" << outPath.string() << "'" << std::endl;
+				return 2;
+			}
+			if (settings.update)
+			{
+				std::printf("%-16s %8.2f ms  written\n", name.c_str(), timeMs);
+				continue;
+			}
+
+			uint32_t goldenWidth{}, goldenHeight{};
+			std::vector<uint32_t> golden{};
+			const std::filesystem::path goldenPath = std::filesystem::path{ settings.goldenDirectory } / name;
+			if (!Png::Read(goldenPath.string(), goldenWidth, goldenHeight, golden) || goldenWidth != WIDTH || goldenHeight != HEIGHT)
+			{
+				std::printf("%-16s %8.2f ms  [MISSING]  no %ux%u golden image '%s'\n", name.c_str(), timeMs, WIDTH, HEIGHT, goldenPath.string().c_str());
+				++failedCount;
+				continue;
+			}
+
+			const ImageCompare::Difference difference = ImageCompare::Compare(golden.data(), frame.data(), WIDTH, HEIGHT, WIDTH);
+			const bool passed = difference.psnr >= settings.minPsnr && difference.meanError <= settings.maxError;
+			if (!passed) ++failedCount;
+			std::printf("%-16s %8.2f ms  %s  PSNR %6.2f dB  error %.5f (max %.3f)  %llu pixels differ\n",
+				name.c_str(), timeMs, passed ? "[ok]    " : "[FAILED]", difference.psnr, difference.meanError, difference.maxError,
+				static_cast<unsigned long long>(difference.differentPixelCount));
+		}
+
+		std::printf("%d frames, %.2f ms average\n", settings.frameCount, settings.frameCount > 0 ? totalTimeMs / settings.frameCount : 0.0);
+		if (settings.update) return 0;
+		std::printf("%d frame(s) failed\n", failedCount);
+		return failedCount > 0 ? 1 : 0;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Settings settings{};
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		bool isValid{ true };
+		if (hasValue && std::strcmp(args[i], "--resources") == 0) settings.resourceDirectory = args[++i];
+		else if (hasValue && std::strcmp(args[i], "--golden") == 0) settings.goldenDirectory = args[++i];
+		else if (hasValue && std::strcmp(args[i], "--out") == 0) settings.outDirectory = args[++i];
+		else if (std::strcmp(args[i], "--update") == 0) settings.update = true;
+		else if (hasValue && std::strcmp(args[i], "--threads") == 0) settings.singleThreaded = std::strcmp(args[++i], "1") == 0;
+		else if (hasValue && std::strcmp(args[i], "--frames") == 0)
+		{
+			isValid = ParseNumber(args[++i], settings.frameCount) && settings.frameCount >= 0;
+		}
+		else if (hasValue && std::strcmp(args[i], "--sampler") == 0)
+		{
+			isValid = ParseNumber(args[++i], settings.samplerState) && settings.samplerState >= 0 && settings.samplerState <= 2;
+		}
+		else if (hasValue && std::strcmp(args[i], "--min-psnr") == 0) isValid = ParseNumber(args[++i], settings.minPsnr);
+		else if (hasValue && std::strcmp(args[i], "--max-error") == 0) isValid = ParseNumber(args[++i], settings.maxError);
+		else
+		{
+			std::cerr << "unknown argument '" << args[i] << "'" << std::endl;
+			return 2;
+		}
+
+		if (!isValid)
+		{
+			std::cerr << "invalid value '" << args[i] << "' for " << args[i - 1] << std::endl;
+			return 2;
+		}
+	}
+
+	return Run(settings);
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dae
+{
+	//Error metrics between a rendered frame and its golden image
+	namespace ImageCompare
+	{
+		struct Difference
+		{
+			double psnr{};					//dB over RGB, infinity when the images are identical
+			double meanError{};				//of the perceptual error map, 0 is identical and 1 is black against white
+			double maxError{};
+			uint64_t differentPixelCount{};	//any of R, G or B differs
+		};
+
+		//Compares two RGBA8 images (red in the low byte, alpha ignored) of the same size, rows pitch pixels apart
+		//The perceptual error is a simplified take on FLIP: both images are low pass filtered, which stands in for the
+		//contrast sensitivity of the eye at desktop viewing distance, converted to CIELAB and compared per pixel with the
+		//HyAB distance. Single pixel noise fades out, shifted edges and wrong colors don't
+		Difference Compare(const uint32_t* referencePtr, const uint32_t* testPtr, uint32_t width, uint32_t height, uint32_t pitch);
+
+		namespace Detail
+		{
+			//L*, a*, b* planes of an image
+			using LabImage = std::array<std::vector<float>, 3>;
+
+			inline LabImage ToLab(const uint32_t* pixelsPtr, uint32_t width, uint32_t height, uint32_t pitch)
+			{
+				static const std::array<float, 256> linearTable = []
+				{
+					std::array<float, 256> table{};
+					for (int i{}; i < 256; ++i)
+					{
+						const float value = static_cast<float>(i) / 255.f;
+						table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+					}
+					return table;
+				}();
+				const auto f = [](float t) { return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.f / 116.f; };
+
+				LabImage lab{};
+				for (std::vector<float>& plane : lab) plane.resize(size_t{ width } * height);
+				for (uint32_t y{}; y < height; ++y)
+				{
+					for (uint32_t x{}; x < width; ++x)
+					{
+						const uint32_t pixel = pixelsPtr[size_t{ y } * pitch + x];
+						const float r = linearTable[pixel & 0xFF];
+						const float g = linearTable[pixel >> 8 & 0xFF];
+						const float b = linearTable[pixel >> 16 & 0xFF];
+
+						//linear sRGB to XYZ relative to the D65 white point
+						const float fx = f((0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.9505f);
+						const float fy = f(0.2126f * r + 0.7152f * g + 0.0722f * b);
+						const float fz = f((0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.089f);
+
+						const size_t index = size_t{ y } * width + x;
+						lab[0][index] = 116.f * fy - 16.f;
+						lab[1][index] = 500.f * (fx - fy);
+						lab[2][index] = 200.f * (fy - fz);
+					}
+				}
+				return lab;
+			}
+
+			//Separable binomial 5 tap blur, clamped at the borders
+			inline void Blur(std::vector<float>& plane, uint32_t width, uint32_t height)
+			{
+				constexpr std::array<float, 5> weights{ 1.f / 16.f, 4.f / 16.f, 6.f / 16.f, 4.f / 16.f, 1.f / 16.f };
+				std::vector<float> blurred(plane.size());
+				const auto pass = [&](const std::vector<float>& source, std::vector<float>& target, bool isHorizontal)
+				{
+					for (uint32_t y{}; y < height; ++y)
+					{
+						for (uint32_t x{}; x < width; ++x)
+						{
+							float sum{};
+							for (int tap{ -2 }; tap <= 2; ++tap)
+							{
+								const int sampleX = isHorizontal ? std::clamp(static_cast<int>(x) + tap, 0, static_cast<int>(width) - 1) : static_cast<int>(x);
+								const int sampleY = isHorizontal ? static_cast<int>(y) : std::clamp(static_cast<int>(y) + tap, 0, static_cast<int>(height) - 1);
+								sum += weights[tap + 2] * source[static_cast<size_t>(sampleY) * width + static_cast<size_t>(sampleX)];
+							}
+							target[size_t{ y } * width + x] = sum;
+						}
+					}
+				};
+				pass(plane, blurred, true);
+				pass(blurred, plane, false);
+			}
+		}
+
+		inline Difference Compare(const uint32_t* referencePtr, const uint32_t* testPtr, uint32_t width, uint32_t height, uint32_t pitch)
+		{
+			using namespace Detail;
+
+			Difference difference{};
+			const size_t pixelCount = size_t{ width } * height;
+			if (pixelCount == 0) return difference;
+
+			double squaredErrorSum{};
+			for (uint32_t y{}; y < height; ++y)
+			{
+				for (uint32_t x{}; x < width; ++x)
+				{
+					const uint32_t reference = referencePtr[size_t{ y } * pitch + x];
+					const uint32_t test = testPtr[size_t{ y } * pitch + x];
+					if ((reference ^ test) & 0x00FFFFFF) ++difference.differentPixelCount;
+					for (int channel{}; channel < 3; ++channel)
+					{
+						const int delta = static_cast<int>(reference >> (channel * 8) & 0xFF) - static_cast<int>(test >> (channel * 8) & 0xFF);
+						squaredErrorSum += static_cast<double>(delta * delta);
+					}
+				}
+			}
+			const double meanSquaredError = squaredErrorSum / (static_cast<double>(pixelCount) * 3.0);
+			difference.psnr = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+			if (difference.differentPixelCount == 0) return difference;
+
+			LabImage referenceLab = ToLab(referencePtr, width, height, pitch);
+			LabImage testLab = ToLab(testPtr, width, height, pitch);
+			for (int plane{}; plane < 3; ++plane)
+			{
+				Blur(referenceLab[plane], width, height);
+				Blur(testLab[plane], width, height);
+			}
+
+			//HyAB: lightness and chroma differences add instead of forming one Euclidean distance, which tracks large
+			//color differences better. Black against white is 100
+			double errorSum{};
+			for (size_t i{}; i < pixelCount; ++i)
+			{
+				const float deltaL = referenceLab[0][i] - testLab[0][i];
+				const float deltaA = referenceLab[1][i] - testLab[1][i];
+				const float deltaB = referenceLab[2][i] - testLab[2][i];
+				const double error = std::min(1.0, (std::abs(deltaL) + std::sqrt(deltaA * deltaA + deltaB * deltaB)) / 100.0);
+				errorSum += error;
+				difference.maxError = std::max(difference.maxError, error);
+			}
+			difference.meanError = errorSum / static_cast<double>(pixelCount);
+			return difference;
+		}
+	}
+}
@@ -0,0 +1,344 @@
+//Self checks and scaling benchmarks for the job system
+//Only depends on JobSystem.h (and the profiler macros it uses) and CommandBackend.h, so it builds without SDL / D3D:
+//	Windows: JobBenchmark.vcxproj (part of WX_DirectX_Start.sln)
+//	Linux  : g++ -std=c++20 -O2 -march=x86-64-v3 -pthread -I.. JobBenchmark.cpp -o JobBenchmark
+//
+//Usage: JobBenchmark [--threads <max, hardware threads>] [--samples <count, 5>] [--skip-checks] [--skip-benchmarks]
+//The checks run job systems with 0, 1, 3 and 7 workers no matter how many cores there are: every index runs exactly once,
+//nested loops, more jobs than a deque holds, dependency chains, jobs queued from a thread the job system doesn't know and
+//parallel command recording: every draw recorded once, in contiguous chunks, executed in queue order
+//The benchmarks run at 1, 2, 4 ... --threads threads and print per thread count
+//	empty jobs  : million jobs per second queued with RunBatch and joined with Wait
+//	chain       : ns per link of a RunAfter dependency chain, the cost of handing one job to the next
+//	parallel for: speedup over one thread and efficiency (speedup / threads) of a loop with uniform and uneven work
+//Exits with 1 when a check fails, 2 on bad arguments
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "CommandBackend.h"
+#include "BenchmarkSuite.h"
+
+using namespace dae;
+
+namespace
+{
+	struct Settings
+	{
+		uint32_t maxThreadCount{ std::max(std::thread::hardware_concurrency(), 1u) };
+		int sampleCount{ 5 };
+		bool runChecks{ true };
+		bool runBenchmarks{ true };
+	};
+
+	int g_FailureCount{};
+
+	void Check(bool condition, const char* description, uint32_t workerCount)
+	{
+		if (condition) return;
+		std::printf("  FAILED with %u workers: %s\n", workerCount, description);
+		++g_FailureCount;
+	}
+
+	//Some work that doesn't touch memory, its cost grows with iterationCount
+	float Work(uint32_t seed, uint32_t iterationCount)
+	{
+		float value = static_cast<float>(seed);
+		for (uint32_t i{}; i < iterationCount; ++i)
+		{
+			value = std::sqrt(value * 1.0001f + 1.f);
+		}
+		return value;
+	}
+
+	void CheckParallelFor(JobSystem& jobSystem, uint32_t workerCount)
+	{
+		for (const uint32_t count : { 0u, 1u, 2u, 7u, 100u, 10'000u, 100'000u })
+		{
+			std::vector<std::atomic<uint32_t>> hits(count);
+			jobSystem.ParallelFor(count, [&](uint32_t index) { hits[index].fetch_add(1, std::memory_order_relaxed); });
+			Check(std::all_of(hits.begin(), hits.end(), [](const std::atomic<uint32_t>& hit) { return hit.load() == 1; }),
+				"ParallelFor runs every index exactly once", workerCount);
+		}
+
+		std::atomic<uint32_t> coveredCount{};
+		std::atomic<bool> isGrainKept{ true };
+		jobSystem.ParallelForRange(1000, 300, [&](uint32_t begin, uint32_t end)
+		{
+			coveredCount.fetch_add(end - begin, std::memory_order_relaxed);
+			if (end - begin < 100) isGrainKept = false;
+		});
+		Check(coveredCount == 1000, "ParallelForRange covers the whole range", workerCount);
+		Check(isGrainKept, "ParallelForRange keeps the grain size, the last range excepted", workerCount);
+
+		//every outer index waits on its inner loop from inside a job
+		std::atomic<uint64_t> sum{};
+		jobSystem.ParallelFor(64, [&](uint32_t outer)
+		{
+			jobSystem.ParallelFor(64, [&](uint32_t inner) { sum.fetch_add(outer * 64 + inner, std::memory_order_relaxed); });
+		});
+		Check(sum == 4096ull * 4095 / 2, "nested ParallelFor", workerCount);
+	}
+
+	void CheckJobs(JobSystem& jobSystem, uint32_t workerCount)
+	{
+		//five times what a deque holds, the rest runs inline
+		std::atomic<uint32_t> runCount{};
+		JobCounter counter{};
+		const Job job{ [](void* dataPtr, uint32_t) { static_cast<std::atomic<uint32_t>*>(dataPtr)->fetch_add(1, std::memory_order_relaxed); }, &runCount };
+		for (uint32_t i{}; i < 20'000; ++i)
+		{
+			jobSystem.Run(job, counter);
+		}
+		jobSystem.Wait(counter);
+		Check(runCount == 20'000 && counter.IsDone(), "Run past the deque capacity", workerCount);
+
+		//the counter is reused once it reached zero
+		runCount = 0;
+		jobSystem.RunBatch(job.function, &runCount, 5000, counter);
+		jobSystem.Wait(counter);
+		Check(runCount == 5000, "RunBatch on a reused counter", workerCount);
+	}
+
+	void CheckDependencies(JobSystem& jobSystem, uint32_t workerCount)
+	{
+		//a batch of 8, then a job that must see all 8, then a job that must see that one
+		struct Data
+		{
+			std::atomic<uint32_t> batchCount{};
+			std::atomic<uint32_t> stage{};
+		};
+		bool isOrdered{ true };
+		for (int repeat{}; repeat < 2000; ++repeat)
+		{
+			Data data{};
+			JobCounter batch{}, second{}, third{};
+			jobSystem.RunBatch([](void* dataPtr, uint32_t) { static_cast<Data*>(dataPtr)->batchCount.fetch_add(1); }, &data, 8, batch);
+			jobSystem.RunAfter(batch, { [](void* dataPtr, uint32_t)
+			{
+				Data& data = *static_cast<Data*>(dataPtr);
+				data.stage = data.batchCount == 8 ? 1 : 100;
+			}, &data }, second);
+			jobSystem.RunAfter(second, { [](void* dataPtr, uint32_t)
+			{
+				Data& data = *static_cast<Data*>(dataPtr);
+				data.stage = data.stage == 1 ? 2 : 100;
+			}, &data }, third);
+
+			jobSystem.Wait(third);
+			isOrdered &= data.stage == 2;
+			//the continuation bookkeeping is done once the counters are, before data goes out of scope
+			jobSystem.Wait(batch);
+			jobSystem.Wait(second);
+		}
+		Check(isOrdered, "RunAfter runs after every job of its dependency", workerCount);
+
+		//a dependency that is already done queues right away
+		std::atomic<uint32_t> runCount{};
+		JobCounter done{}, counter{};
+		jobSystem.RunAfter(done, { [](void* dataPtr, uint32_t) { static_cast<std::atomic<uint32_t>*>(dataPtr)->fetch_add(1); }, &runCount }, counter);
+		jobSystem.Wait(counter);
+		Check(runCount == 1, "RunAfter on a finished counter", workerCount);
+	}
+
+	void CheckExternalThread(JobSystem& jobSystem, uint32_t workerCount)
+	{
+		std::vector<std::atomic<uint32_t>> hits(5000);
+		std::thread thread{ [&]
+		{
+			jobSystem.ParallelFor(static_cast<uint32_t>(hits.size()), [&](uint32_t index) { hits[index].fetch_add(1, std::memory_order_relaxed); });
+		} };
+		jobSystem.ParallelFor(5000, [](uint32_t index) { DoNotOptimize(Work(index, 16)); });
+		thread.join();
+		Check(std::all_of(hits.begin(), hits.end(), [](const std::atomic<uint32_t>& hit) { return hit.load() == 1; }),
+			"ParallelFor from a thread outside the job system", workerCount);
+	}
+
+	void CheckCommandRecording(JobSystem& jobSystem, uint32_t workerCount)
+	{
+		//no draws, one draw, just under and over one chunk, and enough for more chunks than there are contexts
+		constexpr uint32_t minChunkSize{ 16 };
+		constexpr uint32_t maxChunkCount{ 4 };
+		ParallelCommandRecorder recorder{ minChunkSize, jobSystem };
+		RecordingCommandBackend backend{ maxChunkCount };
+		bool isRecordedOnce{ true };
+		bool isContiguous{ true };
+		bool isExecutedInOrder{ true };
+		for (const uint32_t commandCount : { 0u, 1u, minChunkSize - 1, minChunkSize + 1, minChunkSize * 2, minChunkSize * maxChunkCount * 3 + 5 })
+		{
+			backend.ClearRecordOrder();
+			const uint32_t chunkCount = recorder.Record(backend, commandCount);
+			const std::vector<CommandChunk>& chunks = recorder.GetChunks();
+
+			std::vector<uint32_t> recordOrder = backend.GetRecordOrder();
+			std::sort(recordOrder.begin(), recordOrder.end());
+			for (uint32_t chunk{}; chunk < recordOrder.size(); ++chunk)
+			{
+				isRecordedOnce &= recordOrder[chunk] == chunk;
+			}
+			isRecordedOnce &= recordOrder.size() == chunkCount && chunkCount == chunks.size() && chunkCount <= maxChunkCount;
+
+			//chunks tile [0, commandCount) without gaps, all but a lone chunk hold at least minChunkSize commands
+			uint32_t nextCommand{};
+			for (const CommandChunk& chunk : chunks)
+			{
+				isContiguous &= chunk.firstCommand == nextCommand && chunk.commandCount > 0 && (chunkCount == 1 || chunk.commandCount >= minChunkSize);
+				nextCommand += chunk.commandCount;
+			}
+			isContiguous &= nextCommand == commandCount;
+
+			const std::vector<uint32_t>& executedCommands = backend.GetExecutedCommands();
+			isExecutedInOrder &= executedCommands.size() == commandCount;
+			for (uint32_t command{}; command < executedCommands.size(); ++command)
+			{
+				isExecutedInOrder &= executedCommands[command] == command;
+			}
+		}
+		Check(isRecordedOnce, "ParallelCommandRecorder records every chunk exactly once", workerCount);
+		Check(isContiguous, "ParallelCommandRecorder splits the queue into contiguous chunks", workerCount);
+		Check(isExecutedInOrder, "ParallelCommandRecorder executes every command once, in queue order", workerCount);
+	}
+
+	bool RunChecks()
+	{
+		std::printf("Checks\n");
+		for (const uint32_t workerCount : { 0u, 1u, 3u, 7u })
+		{
+			const int failureCount = g_FailureCount;
+			JobSystem jobSystem{ workerCount };
+			CheckParallelFor(jobSystem, workerCount);
+			CheckJobs(jobSystem, workerCount);
+			CheckDependencies(jobSystem, workerCount);
+			CheckExternalThread(jobSystem, workerCount);
+			CheckCommandRecording(jobSystem, workerCount);
+			std::printf("  %u workers: %s\n", workerCount, failureCount == g_FailureCount ? "passed" : "FAILED");
+		}
+		return g_FailureCount == 0;
+	}
+
+	//Best of sampleCount runs, in ms
+	template<typename Kernel>
+	double MeasureBest(int sampleCount, const Kernel& kernel)
+	{
+		using Clock = std::chrono::steady_clock;
+		double best{ 1e300 };
+		for (int sample{}; sample < sampleCount; ++sample)
+		{
+			const auto start = Clock::now();
+			kernel();
+			best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+
+	void RunBenchmarks(const Settings& settings)
+	{
+		constexpr uint32_t emptyJobCount{ 1u << 16 };
+		constexpr uint32_t chainLength{ 2000 };
+		constexpr uint32_t loopCount{ 4096 };
+		constexpr uint32_t loopIterationCount{ 2000 };
+
+		std::vector<float> results(loopCount);
+		const auto uniformLoop = [&](JobSystem& jobSystem)
+		{
+			jobSystem.ParallelFor(loopCount, [&](uint32_t index) { results[index] = Work(index, loopIterationCount); });
+		};
+		//the cost rises along the range, late ranges are up to 4 times the early ones
+		const auto unevenLoop = [&](JobSystem& jobSystem)
+		{
+			jobSystem.ParallelFor(loopCount, [&](uint32_t index) { results[index] = Work(index, loopIterationCount / 2 + index * 3 * loopIterationCount / 2 / loopCount); });
+		};
+
+		std::printf("\nBenchmarks, best of %d\n", settings.sampleCount);
+		std::printf("%-8s %14s %14s %12s %10s %12s %10s\n", "threads", "empty Mjobs/s", "chain ns/link", "uniform ms", "eff", "uneven ms", "eff");
+
+		std::vector<uint32_t> threadCounts{};
+		for (uint32_t threadCount{ 1 }; threadCount < settings.maxThreadCount; threadCount *= 2)
+		{
+			threadCounts.push_back(threadCount);
+		}
+		threadCounts.push_back(settings.maxThreadCount);
+
+		double uniformSingleMs{}, unevenSingleMs{};
+		for (const uint32_t threadCount : threadCounts)
+		{
+			JobSystem jobSystem{ threadCount - 1 };
+
+			JobCounter counter{};
+			const double emptyMs = MeasureBest(settings.sampleCount, [&]
+			{
+				jobSystem.RunBatch([](void*, uint32_t) {}, nullptr, emptyJobCount, counter);
+				jobSystem.Wait(counter);
+			});
+
+			//every link waits on the one before it, nothing runs in parallel
+			std::vector<JobCounter> links(chainLength);
+			const double chainMs = MeasureBest(settings.sampleCount, [&]
+			{
+				const Job link{ [](void*, uint32_t) {} };
+				jobSystem.Run(link, links[0]);
+				for (uint32_t i{ 1 }; i < chainLength; ++i)
+				{
+					jobSystem.RunAfter(links[i - 1], link, links[i]);
+				}
+				for (const JobCounter& linkCounter : links)
+				{
+					jobSystem.Wait(linkCounter);
+				}
+			});
+
+			const double uniformMs = MeasureBest(settings.sampleCount, [&] { uniformLoop(jobSystem); });
+			const double unevenMs = MeasureBest(settings.sampleCount, [&] { unevenLoop(jobSystem); });
+			if (threadCount == 1)
+			{
+				uniformSingleMs = uniformMs;
+				unevenSingleMs = unevenMs;
+			}
+			DoNotOptimize(results.front());
+
+			const double threads = static_cast<double>(threadCount);
+			std::printf("%-8u %14.2f %14.1f %12.3f %9.0f%% %12.3f %9.0f%%\n", threadCount,
+				emptyJobCount / (emptyMs * 1e3), chainMs * 1e6 / chainLength,
+				uniformMs, uniformSingleMs / uniformMs / threads * 100.0, unevenMs, unevenSingleMs / unevenMs / threads * 100.0);
+		}
+
+		if (settings.maxThreadCount > std::thread::hardware_concurrency())
+		{
+			std::printf("more threads than the %u hardware threads, efficiency drops past that\n", std::thread::hardware_concurrency());
+		}
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Settings settings{};
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (hasValue && std::strcmp(args[i], "--threads") == 0) settings.maxThreadCount = static_cast<uint32_t>(std::max(std::stoi(args[++i]), 1));
+		else if (hasValue && std::strcmp(args[i], "--samples") == 0) settings.sampleCount = std::max(std::stoi(args[++i]), 1);
+		else if (std::strcmp(args[i], "--skip-checks") == 0) settings.runChecks = false;
+		else if (std::strcmp(args[i], "--skip-benchmarks") == 0) settings.runBenchmarks = false;
+		else
+		{
+			std::fprintf(stderr, "unknown argument '%s'\n", args[i]);
+			return 2;
+		}
+	}
+
+	if (settings.runChecks && !RunChecks())
+	{
+		std::printf("%d checks failed\n", g_FailureCount);
+		return 1;
+	}
+	if (settings.runBenchmarks) RunBenchmarks(settings);
+	return 0;
+}
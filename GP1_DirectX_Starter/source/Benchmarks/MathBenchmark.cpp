@@ -0,0 +1,1545 @@
+//Standalone micro-benchmarks for the math library and the per-frame math of the renderer
+//Only depends on the header-only math library, scene graph, render world, render queue, triangle sorter, instance batcher, occlusion culler,
+//frame time histogram, profiler and the frame pipeline on the null and software render backends, so it builds without SDL / D3D:
+//	Windows: MathBenchmark.vcxproj (part of WX_DirectX_Start.sln)
+//	Linux  : g++ -std=c++20 -O2 -march=x86-64-v3 -pthread -I.. MathBenchmark.cpp -o MathBenchmark
+//
+//Usage: MathBenchmark [--filter <substring>] [--out <results.json>] [--baseline <baseline.json>]
+//                     [--threshold <fraction, 0.25>] [--min-delta <ns, 0.1>] [--min-time <ms, 20>] [--samples <count, 5>]
+//                     [--skip-checks] [--skip-benchmarks]
+//The checks compare the fast paths against their reference first: the affine and rigid inverse against the general one,
+//the batched frustum cull against the per-box test, SinCos and InvSqrt against double precision within the bounds stated
+//in FastMath.h, the packed formats against their quantization step, the bulk SSE2 packers against the scalar ones (and
+//all 65536 halves against F16C when it is available), the render queue and triangle sort orders, the occlusion culler
+//against a known occluder, the SIMD software shading against the scalar one for every sampler filter, the software
+//rasterizer with Hi-Z and the depth prepass against the image it renders without them
+//Prints a ns/op table, --out writes the results as JSON (same format as the baseline)
+//Exits with 1 when a check fails or any kernel is slower than baseline * (1 + threshold) and baseline + min-delta
+//Baselines are machine specific, regenerate MathBaseline.json with --out on the machine that runs the comparison
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+#include "FramePipeline.h"
+#include "FrameTimeHistogram.h"
+#include "InstanceBatcher.h"
+#include "NullRenderBackend.h"
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "RenderWorld.h"
+#include "SceneGraph.h"
+#include "SoftwareRenderBackend.h"
+#include "TriangleSorter.h"
+#include "BenchmarkSuite.h"
+
+using namespace dae;
+
+namespace
+{
+	//Large enough to defeat constant folding, small enough to stay in L1/L2
+	constexpr size_t COUNT{ 1024 };
+	//Culling runs over a scene sized working set, the bounds no longer fit in L1/L2
+	constexpr size_t CULL_COUNT{ 100'000 };
+
+	std::mt19937 g_Random{ 1337 };
+
+	float RandomFloat(float min, float max)
+	{
+		return std::uniform_real_distribution<float>{ min, max }(g_Random);
+	}
+
+	Vector3 RandomVector3(float range = 10.f)
+	{
+		return { RandomFloat(-range, range), RandomFloat(-range, range), RandomFloat(-range, range) };
+	}
+
+	Vector4 RandomVector4(float range = 10.f)
+	{
+		return { RandomFloat(-range, range), RandomFloat(-range, range), RandomFloat(-range, range), RandomFloat(-range, range) };
+	}
+
+	Quaternion RandomRotation()
+	{
+		return Quaternion::CreateFromAxisAngle(RandomVector3(), RandomFloat(-PI, PI));
+	}
+
+	Transform RandomTransform()
+	{
+		return Transform{ RandomVector3(100.f), RandomRotation(), Vector3{ 1.f, 1.f, 1.f } * RandomFloat(0.5f, 2.f) };
+	}
+
+	Matrix RandomMatrix()
+	{
+		return { RandomVector4(), RandomVector4(), RandomVector4(), RandomVector4() };
+	}
+
+	int g_FailureCount{};
+
+	void Check(bool condition, const char* description)
+	{
+		if (condition) return;
+		std::printf("  FAILED: %s\n", description);
+		++g_FailureCount;
+	}
+
+	struct CameraState
+	{
+		Vector3 origin{};
+		Vector3 forward{};
+		float fovValue{};
+		float aspectRatio{};
+		Matrix viewMatrix{};
+		Matrix invViewMatrix{};
+		Matrix projectionMatrix{};
+	};
+
+	//Mirrors Camera::CalculateViewMatrix + Camera::CalculateProjectionMatrix (Camera itself needs SDL)
+	void RebuildCamera(CameraState& camera)
+	{
+		constexpr float nearPlane{ 0.1f };
+		constexpr float farPlane{ 1000.f };
+
+		camera.forward.Normalize();
+		const Vector3 right = Vector3::Cross(Vector3::UnitY, camera.forward).Normalized();
+		const Vector3 up = Vector3::Cross(camera.forward, right).Normalized();
+
+		camera.viewMatrix = { right, up, camera.forward, camera.origin };
+		camera.invViewMatrix = Matrix::InverseRigid(camera.viewMatrix);
+
+		camera.projectionMatrix = {
+			Vector4{ 1 / (camera.aspectRatio * camera.fovValue), 0, 0, 0 },
+			Vector4{ 0, 1 / camera.fovValue, 0, 0 },
+			Vector4{ 0, 0, farPlane / (farPlane - nearPlane), 1 },
+			Vector4{ 0, 0, -(farPlane * nearPlane) / (farPlane - nearPlane), 0 }
+		};
+	}
+
+	CameraState CreateCamera()
+	{
+		CameraState camera{};
+		camera.origin = { 0.f, 0.f, -50.f };
+		camera.forward = Vector3::UnitZ;
+		camera.fovValue = tanf(45.f * TO_RADIANS / 2.f);
+		camera.aspectRatio = 640.f / 480.f;
+		RebuildCamera(camera);
+		return camera;
+	}
+
+	void RunMatrixBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<Matrix> a(COUNT), b(COUNT), out(COUNT), affine(COUNT), rigid(COUNT);
+		std::vector<Vector3> points(COUNT), points3Out(COUNT);
+		std::vector<Vector4> points4(COUNT), points4Out(COUNT);
+		std::vector<float> angles(COUNT);
+		std::vector<MatrixKind> kinds(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			a[i] = RandomMatrix();
+			b[i] = RandomMatrix();
+			rigid[i] = RandomRotation().ToMatrix() * Matrix::CreateTranslation(RandomVector3(100.f));
+			affine[i] = RandomTransform().ToMatrix();
+			points[i] = RandomVector3();
+			points4[i] = RandomVector4();
+			angles[i] = RandomFloat(-PI, PI);
+		}
+
+		suite.Run("Matrix/Multiply", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = a[i] * b[i]; });
+		suite.Run("Matrix/MultiplyAssign", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] *= b[i]; });
+		suite.Run("Matrix/TransformVector", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) points3Out[i] = a[i].TransformVector(points[i]); });
+		suite.Run("Matrix/TransformPoint3", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) points3Out[i] = a[i].TransformPoint(points[i]); });
+		suite.Run("Matrix/TransformPoint4", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) points4Out[i] = a[i].TransformPoint(points4[i]); });
+		suite.Run("Matrix/Transpose", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::Transpose(a[i]); });
+		suite.Run("Matrix/Inverse", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::Inverse(affine[i]); });
+		suite.Run("Matrix/InverseAffine", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::InverseAffine(affine[i]); });
+		suite.Run("Matrix/InverseRigid", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::InverseRigid(rigid[i]); });
+		suite.Run("Matrix/Classify", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) kinds[i] = Matrix::Classify(affine[i]); });
+		suite.Run("Matrix/CreateTranslation", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateTranslation(points[i]); });
+		suite.Run("Matrix/CreateScale", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateScale(points[i]); });
+		suite.Run("Matrix/CreateRotationY", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateRotationY(angles[i]); });
+		suite.Run("Matrix/CreateRotationY<Fast>", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateRotationY<MathPrecision::Fast>(angles[i]); });
+		suite.Run("Matrix/CreateRotation", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateRotation(points[i]); });
+		suite.Run("Matrix/CreateRotation<Fast>", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out[i] = Matrix::CreateRotation<MathPrecision::Fast>(points[i]); });
+		DoNotOptimize(kinds.data());
+	}
+
+	void RunVectorBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<Vector2> a2(COUNT), b2(COUNT), out2(COUNT);
+		std::vector<Vector3> a3(COUNT), b3(COUNT), out3(COUNT);
+		std::vector<Vector4> a4(COUNT), b4(COUNT), out4(COUNT);
+		std::vector<float> scalars(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			a3[i] = RandomVector3();
+			b3[i] = RandomVector3();
+			a2[i] = a3[i].GetXY();
+			b2[i] = b3[i].GetXY();
+			a4[i] = RandomVector4();
+			b4[i] = RandomVector4();
+		}
+
+		suite.Run("Vector2/Dot", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = Vector2::Dot(a2[i], b2[i]); });
+		suite.Run("Vector2/Cross", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = Vector2::Cross(a2[i], b2[i]); });
+		suite.Run("Vector2/Magnitude", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = a2[i].Magnitude(); });
+		suite.Run("Vector2/Normalized", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out2[i] = a2[i].Normalized(); });
+		suite.Run("Vector2/MultiplyAdd", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out2[i] = a2[i] * 0.5f + b2[i]; });
+
+		suite.Run("Vector3/Dot", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = Vector3::Dot(a3[i], b3[i]); });
+		suite.Run("Vector3/Cross", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = Vector3::Cross(a3[i], b3[i]); });
+		suite.Run("Vector3/Magnitude", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = a3[i].Magnitude(); });
+		suite.Run("Vector3/Normalized", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = a3[i].Normalized(); });
+		suite.Run("Vector3/Normalized<Fast>", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = a3[i].Normalized<MathPrecision::Fast>(); });
+		suite.Run("Vector3/Normalized<Estimate>", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = a3[i].Normalized<MathPrecision::Estimate>(); });
+		suite.Run("Vector3/Project", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = Vector3::Project(a3[i], b3[i]); });
+		suite.Run("Vector3/Reject", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = Vector3::Reject(a3[i], b3[i]); });
+		suite.Run("Vector3/Reflect", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = Vector3::Reflect(a3[i], b3[i]); });
+		suite.Run("Vector3/Distance", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = Vector3::Distance(a3[i], b3[i]); });
+		suite.Run("Vector3/Lerp", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = Vector3::Lerp(a3[i], b3[i], 0.25f); });
+		suite.Run("Vector3/MultiplyAdd", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out3[i] = a3[i] * 0.5f + b3[i]; });
+
+		suite.Run("Vector4/Dot", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = Vector4::Dot(a4[i], b4[i]); });
+		suite.Run("Vector4/Magnitude", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) scalars[i] = a4[i].Magnitude(); });
+		suite.Run("Vector4/Normalized", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out4[i] = a4[i].Normalized(); });
+		suite.Run("Vector4/MultiplyAdd", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) out4[i] = a4[i] * 0.5f + b4[i]; });
+	}
+
+	void RunTransformBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<Quaternion> a(COUNT), b(COUNT), outRotations(COUNT);
+		std::vector<Transform> transforms(COUNT);
+		std::vector<Vector3> points(COUNT), outPoints(COUNT);
+		std::vector<Matrix> outMatrices(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			a[i] = RandomRotation();
+			b[i] = RandomRotation();
+			transforms[i] = RandomTransform();
+			points[i] = RandomVector3();
+		}
+
+		suite.Run("Quaternion/Multiply", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outRotations[i] = a[i] * b[i]; });
+		suite.Run("Quaternion/Rotate", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outPoints[i] = a[i].Rotate(points[i]); });
+		suite.Run("Quaternion/ToMatrix", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outMatrices[i] = a[i].ToMatrix(); });
+		suite.Run("Quaternion/Slerp", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outRotations[i] = Quaternion::Slerp(a[i], b[i], 0.3f); });
+		suite.Run("Quaternion/CreateFromAxisAngle", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outRotations[i] = Quaternion::CreateFromAxisAngle(points[i], points[i].x); });
+		suite.Run("Transform/ToMatrix", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outMatrices[i] = transforms[i].ToMatrix(); });
+		suite.Run("Transform/TransformPoint", COUNT, [&] { for (size_t i{}; i < COUNT; ++i) outPoints[i] = transforms[i].TransformPoint(points[i]); });
+	}
+
+	void RunRendererBenchmarks(BenchmarkSuite& suite)
+	{
+		CameraState camera = CreateCamera();
+		std::vector<Transform> transforms(COUNT);
+		std::vector<Matrix> worldMatrices(COUNT), wvpMatrices(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			transforms[i] = RandomTransform();
+			worldMatrices[i] = transforms[i].ToMatrix();
+		}
+
+		suite.Run("Camera/Rebuild", 1, [&]
+		{
+			camera.forward.x += 1e-6f;
+			RebuildCamera(camera);
+			DoNotOptimize(camera);
+		});
+
+		//Renderer::Render: world * invView * projection per mesh
+		suite.Run("Renderer/MeshWVP", COUNT, [&]
+		{
+			for (size_t i{}; i < COUNT; ++i) wvpMatrices[i] = worldMatrices[i] * camera.invViewMatrix * camera.projectionMatrix;
+		});
+
+		//Renderer::Update with rotation enabled: rotate about the pivot and recompose the world matrix
+		const Quaternion deltaRotation = Quaternion::CreateFromAxisAngle(Vector3::UnitY, 0.01f);
+		suite.Run("Renderer/MeshRotateAndCompose", COUNT, [&]
+		{
+			for (size_t i{}; i < COUNT; ++i)
+			{
+				transforms[i].RotateAround(Vector3::Zero, deltaRotation);
+				worldMatrices[i] = transforms[i].ToMatrix();
+			}
+		});
+
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+		Frustum frustum{};
+		suite.Run("Frustum/FromViewProjection", 1, [&]
+		{
+			frustum = Frustum::FromViewProjection(viewProjection);
+			DoNotOptimize(frustum);
+		});
+
+		AabbSoA bounds{};
+		std::vector<Aabb> boxes(CULL_COUNT);
+		for (size_t i{}; i < CULL_COUNT; ++i)
+		{
+			boxes[i] = Aabb::FromCenterExtents(RandomVector3(100.f), Vector3{ 1.f, 1.f, 1.f } * RandomFloat(0.5f, 5.f));
+			bounds.PushBack(boxes[i]);
+		}
+		std::vector<uint8_t> visibility(CULL_COUNT);
+		size_t visibleCount{};
+
+		//one op is one box against the six planes, also printed as millions of tests per second
+		const auto printTestRate = [](double nsPerOp)
+		{
+			if (nsPerOp > 0.0) std::printf("  %.1f Mtests/s over %zu boxes\n", 1e3 / nsPerOp, CULL_COUNT);
+		};
+		printTestRate(suite.Run("Culling/AabbScalar", CULL_COUNT, [&] { for (size_t i{}; i < CULL_COUNT; ++i) visibility[i] = frustum.Intersects(boxes[i]); }));
+		printTestRate(suite.Run("Culling/AabbSoA", CULL_COUNT, [&] { visibleCount += CullAabbs(frustum, bounds, visibility.data()); }));
+		suite.Run("Culling/AabbTransformed", CULL_COUNT, [&] { for (size_t i{}; i < CULL_COUNT; ++i) boxes[i] = boxes[i].Transformed(worldMatrices[i & 15]); });
+		DoNotOptimize(visibleCount);
+	}
+
+	void RunSceneGraphBenchmarks(BenchmarkSuite& suite)
+	{
+		//100 vehicles with 1000 attached nodes each (4-ary trees, 6 levels deep)
+		//created tree by tree, so the graph has to re-sort itself by depth on the first update
+		constexpr size_t rootCount{ 100 };
+		constexpr size_t nodesPerRoot{ 1000 };
+		constexpr size_t nodeCount{ rootCount * nodesPerRoot };
+
+		SceneGraph sceneGraph{};
+		sceneGraph.Reserve(nodeCount);
+		std::vector<NodeHandle> roots(rootCount);
+		std::vector<NodeHandle> subtree(nodesPerRoot);
+		for (size_t root{}; root < rootCount; ++root)
+		{
+			subtree[0] = roots[root] = sceneGraph.CreateNode(RandomTransform());
+			for (size_t i{ 1 }; i < nodesPerRoot; ++i)
+			{
+				subtree[i] = sceneGraph.CreateNode(Transform{ RandomVector3(), RandomRotation() }, subtree[(i - 1) / 4]);
+			}
+		}
+		sceneGraph.UpdateWorldMatrices();
+
+		const Quaternion deltaRotation = Quaternion::CreateFromAxisAngle(Vector3::UnitY, 0.01f);
+		const auto rotateRoot = [&](NodeHandle root)
+		{
+			Transform transform{ sceneGraph.GetLocalTransform(root) };
+			transform.RotateAround(Vector3::Zero, deltaRotation);
+			sceneGraph.SetLocalTransform(root, transform);
+		};
+
+		size_t updatedCount{};
+		suite.Run("SceneGraph/Update100k/AllDirty", nodeCount, [&]
+		{
+			for (const NodeHandle root : roots) rotateRoot(root);
+			updatedCount += sceneGraph.UpdateWorldMatrices();
+		});
+		suite.Run("SceneGraph/Update100k/OneSubtreeDirty", nodeCount, [&]
+		{
+			rotateRoot(roots[updatedCount % rootCount]);
+			updatedCount += sceneGraph.UpdateWorldMatrices();
+		});
+		suite.Run("SceneGraph/Update100k/Clean", nodeCount, [&] { updatedCount += sceneGraph.UpdateWorldMatrices(); });
+		DoNotOptimize(updatedCount);
+	}
+
+	//Renderer::Update frame prep for a field of moving vehicles: move, update, cull, build the draw list
+	//ns/op is per vehicle, it should stay flat from 1k to 50k
+	void RunRenderWorldBenchmarks(BenchmarkSuite& suite)
+	{
+		const CameraState camera = CreateCamera();
+		const Frustum frustum = Frustum::FromViewProjection(camera.invViewMatrix * camera.projectionMatrix);
+		const Aabb vehicleBounds = Aabb::FromCenterExtents(Vector3{ 0.f, 1.f, 0.f }, Vector3{ 2.f, 1.f, 4.f });
+		const Quaternion deltaRotation = Quaternion::CreateFromAxisAngle(Vector3::UnitY, 0.01f);
+
+		for (const size_t vehicleCount : { size_t{ 1000 }, size_t{ 10000 }, size_t{ 50000 } })
+		{
+			SceneGraph sceneGraph{};
+			RenderWorld renderWorld{};
+			renderWorld.Reserve(vehicleCount);
+			std::vector<Entity> vehicles(vehicleCount);
+			for (Entity& vehicle : vehicles)
+			{
+				const Transform transform{ RandomVector3(500.f), RandomRotation() };
+				vehicle = renderWorld.CreateEntity(static_cast<MeshHandle>(g_Random() % 4), static_cast<MaterialHandle>(g_Random() % 2), vehicleBounds, transform);
+			}
+			renderWorld.Update(sceneGraph);
+
+			std::vector<DrawItem> drawList{};
+			drawList.reserve(vehicleCount);
+			const std::string suffix = std::to_string(vehicleCount / 1000) + "k";
+
+			suite.Run("RenderWorld/FramePrep" + suffix + "/Moving", vehicleCount, [&]
+			{
+				for (const Entity vehicle : vehicles)
+				{
+					Transform transform{ renderWorld.GetTransform(vehicle) };
+					transform.RotateAround(Vector3::Zero, deltaRotation);
+					renderWorld.SetTransform(vehicle, transform);
+				}
+				renderWorld.Update(sceneGraph);
+				renderWorld.Cull(frustum);
+				drawList.clear();
+				renderWorld.BuildDrawList(drawList);
+			});
+			suite.Run("RenderWorld/FramePrep" + suffix + "/Static", vehicleCount, [&]
+			{
+				renderWorld.Update(sceneGraph);
+				renderWorld.Cull(frustum);
+				drawList.clear();
+				renderWorld.BuildDrawList(drawList);
+			});
+
+			//one batch per mesh/material run of the sorted queue, the instance data is what gets uploaded
+			RenderQueue renderQueue{};
+			for (uint32_t item{}; item < drawList.size(); ++item)
+			{
+				const float viewDepth = renderWorld.GetWorldMatrices()[drawList[item].instance].GetTranslation().z - camera.origin.z;
+				renderQueue.Submit(RenderQueue::MakeKey(RenderPass::Main, false, drawList[item].material, drawList[item].mesh, viewDepth), item);
+			}
+			renderQueue.Sort();
+
+			InstanceBatcher instanceBatcher{};
+			suite.Run("RenderWorld/InstanceBatches" + suffix, vehicleCount, [&] { instanceBatcher.Build(renderQueue.GetCommands(), drawList, renderWorld.GetWorldMatrices()); });
+			DoNotOptimize(drawList.data());
+			DoNotOptimize(instanceBatcher.GetBatches().data());
+		}
+	}
+
+	//Renderer::Update sorts the visible draws every frame, radix sort vs std::sort on the same keys
+	void RunRenderQueueBenchmarks(BenchmarkSuite& suite)
+	{
+		for (const size_t drawCount : { size_t{ 1000 }, size_t{ 10000 }, size_t{ 50000 } })
+		{
+			//few materials and meshes, mostly opaque, depth spread over the view distance
+			std::vector<RenderCommand> unsorted(drawCount);
+			for (uint32_t i{}; i < drawCount; ++i)
+			{
+				const bool isTransparent = g_Random() % 8 == 0;
+				unsorted[i] = { RenderQueue::MakeKey(RenderPass::Main, isTransparent, g_Random() % 8, g_Random() % 16, RandomFloat(0.1f, 1000.f)), i };
+			}
+
+			const std::string suffix = std::to_string(drawCount / 1000) + "k";
+			RenderQueue renderQueue{};
+			renderQueue.Reserve(drawCount);
+			suite.Run("RenderQueue/RadixSort" + suffix, drawCount, [&]
+			{
+				renderQueue.Clear();
+				for (const RenderCommand& command : unsorted) renderQueue.Submit(command.key, command.item);
+				renderQueue.Sort();
+			});
+
+			std::vector<RenderCommand> sorted(drawCount);
+			suite.Run("RenderQueue/StdSort" + suffix, drawCount, [&]
+			{
+				sorted = unsorted;
+				std::sort(sorted.begin(), sorted.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+			});
+			DoNotOptimize(renderQueue.GetCommands().data());
+			DoNotOptimize(sorted.data());
+		}
+
+		//a blended mesh of 50k random triangles, sorted back-to-front per triangle and per cluster of 64
+		constexpr size_t triangleCount{ 50000 };
+		std::vector<Vector3> positions(triangleCount * 3);
+		std::vector<uint32_t> indices(triangleCount * 3);
+		for (uint32_t i{}; i < positions.size(); ++i)
+		{
+			positions[i] = { RandomFloat(-10.f, 10.f), RandomFloat(-10.f, 10.f), RandomFloat(-10.f, 10.f) };
+			indices[i] = i;
+		}
+		const CameraState camera = CreateCamera();
+		const Matrix worldViewProjection{ camera.invViewMatrix * camera.projectionMatrix };
+
+		TriangleSorter triangleSorter{};
+		suite.Run("RenderQueue/TriangleSort50k", triangleCount, [&] { DoNotOptimize(triangleSorter.Sort(positions.data(), positions.size(), sizeof(Vector3), indices, worldViewProjection).data()); });
+		suite.Run("RenderQueue/ClusterSort50k", triangleCount, [&] { DoNotOptimize(triangleSorter.Sort(positions.data(), positions.size(), sizeof(Vector3), indices, worldViewProjection, 64).data()); });
+	}
+
+	//Renderer::CullOccludedDrawItems: a row of 64 vehicle occluder boxes in front of a 10k vehicle field
+	void RunOcclusionBenchmarks(BenchmarkSuite& suite)
+	{
+		const CameraState camera = CreateCamera();
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+		const Aabb occluderBox = Aabb::FromCenterExtents(Vector3{ 0.f, 1.f, 0.f }, Vector3{ 1.2f, 0.6f, 2.4f });
+
+		std::vector<Matrix> occluderWorlds(64);
+		for (size_t i{}; i < occluderWorlds.size(); ++i)
+		{
+			occluderWorlds[i] = Matrix::CreateTranslation(static_cast<float>(i % 16) * 5.f - 40.f, static_cast<float>(i / 16) * 2.f - 4.f, -20.f);
+		}
+
+		constexpr size_t testCount{ 10000 };
+		std::vector<Aabb> testBounds(testCount);
+		for (Aabb& bounds : testBounds)
+		{
+			bounds = Aabb::FromCenterExtents(Vector3{ RandomFloat(-60.f, 60.f), RandomFloat(-10.f, 10.f), RandomFloat(0.f, 200.f) }, Vector3{ 2.f, 1.f, 4.f });
+		}
+
+		OcclusionCuller occlusionCuller{};
+		suite.Run("Occlusion/Rasterize64Boxes", occluderWorlds.size(), [&]
+		{
+			occlusionCuller.BeginFrame(viewProjection);
+			for (const Matrix& world : occluderWorlds) occlusionCuller.AddOccluderBox(occluderBox, world);
+			occlusionCuller.Rasterize();
+		});
+
+		size_t visibleCount{};
+		suite.Run("Occlusion/TestAabb10k", testCount, [&] { for (const Aabb& bounds : testBounds) visibleCount += occlusionCuller.IsVisible(bounds); });
+		DoNotOptimize(visibleCount);
+	}
+
+	//Unit cube, 8 corners and 12 triangles
+	void CreateBox(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		for (int corner{}; corner < 8; ++corner)
+		{
+			MeshVertex vertex{};
+			vertex.position = { (corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, (corner & 4) ? 0.5f : -0.5f };
+			vertices.push_back(vertex);
+		}
+		indices = { 0,2,1, 1,2,3, 4,5,6, 5,7,6, 0,1,4, 1,5,4, 2,6,3, 3,6,7, 0,4,2, 2,4,6, 1,3,5, 3,7,5 };
+	}
+
+	//The whole update, cull, sort and submit path of a frame on the null backend: a 64x64 crowd with occluders
+	//and one blended, triangle sorted mesh per row, so the numbers are the CPU cost of a frame without the driver
+	void RunFrameBenchmarks(BenchmarkSuite& suite)
+	{
+		const CameraState camera = CreateCamera();
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+
+		std::vector<MeshVertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CreateBox(vertices, indices);
+
+		NullRenderBackend backend{ JobSystem::Get().GetThreadCount() };
+		FramePipeline pipeline{ backend };
+
+		const MaterialHandle opaqueMaterial = pipeline.CreateMaterial(MaterialType::Vehicle);
+		const MaterialHandle blendedMaterial = pipeline.CreateMaterial(MaterialType::FireFX);
+		const MeshHandle opaqueMesh = pipeline.CreateMesh(vertices, indices, opaqueMaterial);
+		const MeshHandle blendedMesh = pipeline.CreateMesh(vertices, indices, blendedMaterial);
+		pipeline.SetOccluderBounds(opaqueMesh, Aabb::FromCenterExtents(Vector3{}, Vector3{ 0.3f, 0.3f, 0.3f }));
+
+		constexpr int gridSize{ 64 };
+		constexpr float spacing{ 3.f };
+		RenderWorld& renderWorld = pipeline.GetRenderWorld();
+		renderWorld.Reserve(gridSize * gridSize + gridSize);
+		for (int row{}; row < gridSize; ++row)
+		{
+			for (int column{}; column < gridSize; ++column)
+			{
+				const Vector3 position{ (static_cast<float>(column) - gridSize * 0.5f) * spacing, 0.f, static_cast<float>(row) * spacing };
+				renderWorld.CreateEntity(opaqueMesh, opaqueMaterial, pipeline.GetMeshBounds(opaqueMesh), Transform{ position });
+			}
+			const Vector3 position{ 0.f, 2.f, static_cast<float>(row) * spacing };
+			renderWorld.CreateEntity(blendedMesh, blendedMaterial, pipeline.GetMeshBounds(blendedMesh), Transform{ position });
+		}
+		const size_t entityCount{ renderWorld.GetEntityCount() };
+
+		const auto runFrame = [&]
+		{
+			pipeline.Update(viewProjection);
+			backend.BeginFrame();
+			pipeline.Submit();
+			backend.EndFrame();
+		};
+
+		FramePipeline::Settings& settings = pipeline.GetSettings();
+		suite.Run("Frame/Headless4k/Instanced", entityCount, runFrame);
+
+		settings.useInstancing = false;
+		suite.Run("Frame/Headless4k/PerDraw", entityCount, runFrame);
+
+		settings.useParallelRecording = true;
+		suite.Run("Frame/Headless4k/ParallelRecording", entityCount, runFrame);
+		DoNotOptimize(backend.GetCounters().drawCount);
+	}
+
+	//UV sphere with the normals and tangents the vehicle shader needs, clockwise seen from outside
+	void CreateSphere(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, float radius, uint32_t ringCount, uint32_t segmentCount)
+	{
+		vertices.clear();
+		indices.clear();
+		for (uint32_t ring{}; ring <= ringCount; ++ring)
+		{
+			const float theta = PI * static_cast<float>(ring) / static_cast<float>(ringCount);
+			for (uint32_t segment{}; segment <= segmentCount; ++segment)
+			{
+				const float phi = PI_2 * static_cast<float>(segment) / static_cast<float>(segmentCount);
+				const Vector3 normal{ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) };
+
+				MeshVertex vertex{};
+				vertex.position = normal * radius;
+				vertex.uv = { static_cast<float>(segment) / static_cast<float>(segmentCount), static_cast<float>(ring) / static_cast<float>(ringCount) };
+				vertex.normal = normal;
+				vertex.tangent = { -sinf(phi), 0.f, cosf(phi) };
+				vertices.push_back(vertex);
+			}
+		}
+
+		for (uint32_t ring{}; ring < ringCount; ++ring)
+		{
+			for (uint32_t segment{}; segment < segmentCount; ++segment)
+			{
+				const uint32_t topLeft = ring * (segmentCount + 1) + segment;
+				const uint32_t bottomLeft = topLeft + segmentCount + 1;
+				indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft, topLeft + 1, bottomLeft + 1, bottomLeft });
+			}
+		}
+	}
+
+	//Procedural stand-ins for the vehicle and fire fx textures, so the benchmark needs no image decoder
+	bool CreateProceduralTexture(const std::string& path, SoftwareTexture& texture)
+	{
+		constexpr uint32_t size{ 256 };
+		texture.width = size;
+		texture.height = size;
+		texture.texels.resize(size * size);
+		for (uint32_t y{}; y < size; ++y)
+		{
+			for (uint32_t x{}; x < size; ++x)
+			{
+				const float checker = ((x / 32 + y / 32) % 2) ? 0.8f : 0.2f;
+				Vector4 color{ checker, checker, checker, 1.f };
+				if (path.find("normal") != std::string::npos) color = { 0.5f + 0.2f * sinf(static_cast<float>(x) * 0.1f), 0.5f, 1.f, 1.f };
+				else if (path.find("fireFX") != std::string::npos) color = { 1.f, checker, 0.f, checker };
+				texture.texels[y * size + x] = SoftwareTexture::PackColor(color);
+			}
+		}
+		return true;
+	}
+
+	//The PosCol3D shading model on COUNT random pixels with the anisotropic filter: the scalar reference against the SIMD kernel
+	//The vehicle maps and COUNT random vehicle pixels, as PixelInputs and as the same pixels in PixelBlocks
+	void CreateVehiclePixels(std::array<SoftwareTexture, 4>& textures, std::vector<PixelInput>& pixels, std::vector<PixelBlock>& blocks)
+	{
+		const char* paths[]{ "vehicle_diffuse", "vehicle_normal", "vehicle_specular", "vehicle_gloss" };
+		for (size_t i{}; i < textures.size(); ++i)
+		{
+			CreateProceduralTexture(paths[i], textures[i]);
+		}
+
+		pixels.resize(COUNT);
+		for (PixelInput& pixel : pixels)
+		{
+			pixel.worldPosition = RandomVector3();
+			pixel.uv = { RandomFloat(0.f, 1.f), RandomFloat(0.f, 1.f) };
+			pixel.normal = RandomVector3().Normalized();
+			pixel.tangent = Vector3::Cross(pixel.normal, Vector3::UnitY).Normalized();
+			pixel.uvDx = { RandomFloat(-0.01f, 0.01f), RandomFloat(-0.01f, 0.01f) };
+			pixel.uvDy = { RandomFloat(-0.01f, 0.01f), RandomFloat(-0.01f, 0.01f) };
+		}
+
+		//the same pixels as blocks, structure of arrays
+		blocks.resize(COUNT / SimdFloat::Width);
+		for (size_t block{}; block < blocks.size(); ++block)
+		{
+			const auto load = [&](const auto& getValue)
+			{
+				alignas(32) float lanes[SimdFloat::Width];
+				for (int lane{}; lane < SimdFloat::Width; ++lane)
+				{
+					lanes[lane] = getValue(pixels[block * SimdFloat::Width + lane]);
+				}
+				return SimdFloat::Load(lanes);
+			};
+			PixelBlock& pixelBlock = blocks[block];
+			pixelBlock.worldPosition = { load([](const PixelInput& p) { return p.worldPosition.x; }), load([](const PixelInput& p) { return p.worldPosition.y; }), load([](const PixelInput& p) { return p.worldPosition.z; }) };
+			pixelBlock.uv = { load([](const PixelInput& p) { return p.uv.x; }), load([](const PixelInput& p) { return p.uv.y; }) };
+			pixelBlock.normal = { load([](const PixelInput& p) { return p.normal.x; }), load([](const PixelInput& p) { return p.normal.y; }), load([](const PixelInput& p) { return p.normal.z; }) };
+			pixelBlock.tangent = { load([](const PixelInput& p) { return p.tangent.x; }), load([](const PixelInput& p) { return p.tangent.y; }), load([](const PixelInput& p) { return p.tangent.z; }) };
+			pixelBlock.uvDx = { load([](const PixelInput& p) { return p.uvDx.x; }), load([](const PixelInput& p) { return p.uvDx.y; }) };
+			pixelBlock.uvDy = { load([](const PixelInput& p) { return p.uvDy.x; }), load([](const PixelInput& p) { return p.uvDy.y; }) };
+		}
+	}
+
+	void RunSoftwareShadingBenchmarks(BenchmarkSuite& suite)
+	{
+		std::array<SoftwareTexture, 4> textures{};
+		std::vector<PixelInput> pixels{};
+		std::vector<PixelBlock> blocks{};
+		CreateVehiclePixels(textures, pixels, blocks);
+		const VehicleShading shading{ &textures[0], &textures[1], &textures[2], &textures[3], Vector3{ 0.f, 0.f, -50.f } };
+
+		std::vector<Vector4> colors(COUNT);
+		std::vector<SimdVector4> blockColors(blocks.size());
+		suite.Run("SoftwareShading/Vehicle/Scalar", COUNT, [&]
+		{
+			for (size_t i{}; i < COUNT; ++i) colors[i] = ShadeVehicle(shading, pixels[i]);
+		});
+		suite.Run("SoftwareShading/Vehicle/Simd", COUNT, [&]
+		{
+			for (size_t i{}; i < blocks.size(); ++i) blockColors[i] = ShadeVehicle(shading, blocks[i]);
+		});
+		DoNotOptimize(colors.front());
+		DoNotOptimize(blockColors.front());
+	}
+
+	//The software backend at 640x480: nine opaque spheres, nine more half hidden behind them and one blended sphere in front,
+	//through the frame pipeline. Every kernel renders the same frame, ops are the submitted triangles or the shaded pixels of that frame
+	//The single thread frame is also rendered without Hi-Z and with the depth prepass, their overdraw is printed next to the times
+	void RunSoftwareRasterBenchmarks(BenchmarkSuite& suite)
+	{
+		const CameraState camera = CreateCamera();
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+
+		std::vector<MeshVertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CreateSphere(vertices, indices, 7.f, 48, 96);
+
+		//a job system without workers, the calling thread does every job
+		JobSystem singleJobSystem{ 0 };
+		for (JobSystem* jobSystemPtr : { &singleJobSystem, &JobSystem::Get() })
+		{
+			SoftwareRenderBackend backend{ 640, 480, CreateProceduralTexture, *jobSystemPtr };
+			FramePipeline pipeline{ backend };
+
+			const MaterialHandle opaqueMaterial = pipeline.CreateMaterial(MaterialType::Vehicle);
+			const MaterialHandle blendedMaterial = pipeline.CreateMaterial(MaterialType::FireFX);
+			const MeshHandle opaqueMesh = pipeline.CreateMesh(vertices, indices, opaqueMaterial);
+			const MeshHandle blendedMesh = pipeline.CreateMesh(vertices, indices, blendedMaterial);
+
+			RenderWorld& renderWorld = pipeline.GetRenderWorld();
+			for (int layer{}; layer < 2; ++layer)
+			{
+				for (int row{ -1 }; row <= 1; ++row)
+				{
+					for (int column{ -1 }; column <= 1; ++column)
+					{
+						const Vector3 position{ static_cast<float>(column) * 16.f + static_cast<float>(layer) * 6.f, static_cast<float>(row) * 14.f + static_cast<float>(layer) * 4.f, static_cast<float>(layer) * 12.f };
+						renderWorld.CreateEntity(opaqueMesh, opaqueMaterial, pipeline.GetMeshBounds(opaqueMesh), Transform{ position });
+					}
+				}
+			}
+			renderWorld.CreateEntity(blendedMesh, blendedMaterial, pipeline.GetMeshBounds(blendedMesh), Transform{ Vector3{ 0.f, 0.f, -20.f } });
+
+			const auto runFrame = [&]
+			{
+				pipeline.Update(viewProjection);
+				backend.BeginFrame();
+				backend.SetCameraPosition(camera.origin);
+				pipeline.Submit();
+				backend.EndFrame();
+			};
+			runFrame();
+
+			const SoftwareRasterizerStats& stats = backend.GetRasterizer().GetStats();
+			const std::string threads = jobSystemPtr == &singleJobSystem ? "1Thread" : "AllThreads";
+			suite.Run("SoftwareRaster/640x480/Triangles/" + threads, stats.triangleCount, runFrame);
+			suite.Run("SoftwareRaster/640x480/Pixels/" + threads, stats.shadedPixelCount, runFrame);
+			DoNotOptimize(backend.GetRasterizer().GetColorBuffer().front());
+			if (jobSystemPtr != &singleJobSystem) continue;
+
+			SoftwareRasterizer::Settings& settings = backend.GetRasterizerSettings();
+			const auto runVariant = [&](const std::string& name, bool useHiZ, bool useDepthPrepass)
+			{
+				settings.useHiZ = useHiZ;
+				settings.useDepthPrepass = useDepthPrepass;
+				runFrame();
+				suite.Run("SoftwareRaster/640x480/Frame/" + name, 1, runFrame);
+				std::printf("  shaded %llu pixels, overdraw %.3f, Hi-Z culled %llu triangle tiles and %llu blocks\n",
+					static_cast<unsigned long long>(stats.shadedPixelCount), stats.GetOverdraw(),
+					static_cast<unsigned long long>(stats.hiZCulledTriangleCount), static_cast<unsigned long long>(stats.hiZCulledBlockCount));
+			};
+			runVariant("NoHiZ", false, false);
+			runVariant("HiZ", true, false);
+			runVariant("HiZ+DepthPrepass", true, true);
+			settings = SoftwareRasterizer::Settings{};
+		}
+	}
+
+	void RunFastMathBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<float> values(COUNT), sines(COUNT), cosines(COUNT), results(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			values[i] = RandomFloat(1e-3f, 100.f);
+		}
+
+		suite.Run("FastMath/SinCos<Precise>", COUNT, [&] { SinCos<MathPrecision::Precise>(values.data(), sines.data(), cosines.data(), COUNT); });
+		suite.Run("FastMath/SinCos<Fast>", COUNT, [&] { SinCos<MathPrecision::Fast>(values.data(), sines.data(), cosines.data(), COUNT); });
+		suite.Run("FastMath/SinCos<Estimate>", COUNT, [&] { SinCos<MathPrecision::Estimate>(values.data(), sines.data(), cosines.data(), COUNT); });
+		suite.Run("FastMath/InvSqrt<Precise>", COUNT, [&] { InvSqrt<MathPrecision::Precise>(values.data(), results.data(), COUNT); });
+		suite.Run("FastMath/InvSqrt<Fast>", COUNT, [&] { InvSqrt<MathPrecision::Fast>(values.data(), results.data(), COUNT); });
+		suite.Run("FastMath/InvSqrt<Estimate>", COUNT, [&] { InvSqrt<MathPrecision::Estimate>(values.data(), results.data(), COUNT); });
+	}
+
+	void RunPackingBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<float> values(COUNT), unpacked(COUNT);
+		std::vector<uint16_t> halves(COUNT), unorm16(COUNT);
+		std::vector<uint8_t> unorm8(COUNT);
+		std::vector<int8_t> snorm8(COUNT);
+		std::vector<Vector2> uvs(COUNT);
+		std::vector<Vector3> normals(COUNT);
+		std::vector<ColorRGB> colors(COUNT);
+		std::vector<uint32_t> packed(COUNT);
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			values[i] = RandomFloat(-1.5f, 1.5f);
+			uvs[i] = { RandomFloat(0.f, 1.f), RandomFloat(0.f, 1.f) };
+			normals[i] = RandomVector3().Normalized();
+			colors[i] = { RandomFloat(0.f, 8.f), RandomFloat(0.f, 8.f), RandomFloat(0.f, 8.f) };
+		}
+		Packing::FloatToHalf(values, halves);
+
+		suite.Run("Packing/FloatToHalf", COUNT, [&] { Packing::FloatToHalf(values, halves); });
+		suite.Run("Packing/HalfToFloat", COUNT, [&] { Packing::HalfToFloat(halves, unpacked); });
+		suite.Run("Packing/Half2", COUNT, [&] { Packing::PackHalf2(uvs, packed); });
+		suite.Run("Packing/Unorm8", COUNT, [&] { Packing::FloatToUnorm8(values, unorm8); });
+		suite.Run("Packing/Snorm8", COUNT, [&] { Packing::FloatToSnorm8(values, snorm8); });
+		suite.Run("Packing/Unorm16", COUNT, [&] { Packing::FloatToUnorm16(values, unorm16); });
+		suite.Run("Packing/R10G10B10A2", COUNT, [&] { Packing::PackR10G10B10A2(colors, packed); });
+		suite.Run("Packing/R11G11B10F", COUNT, [&] { Packing::PackR11G11B10F(colors, packed); });
+		suite.Run("Packing/OctahedralSnorm16", COUNT, [&] { Packing::PackOctahedralSnorm16(normals, packed); });
+	}
+
+	//Timer adds every frame to a FrameTimeHistogram, one op is one Add to a full window, 4 to 40 ms frames
+	void RunFrameTimeBenchmarks(BenchmarkSuite& suite)
+	{
+		std::vector<uint32_t> frameTimes(COUNT);
+		for (uint32_t& frameTime : frameTimes)
+		{
+			frameTime = static_cast<uint32_t>(std::exp(RandomFloat(std::log(4'000.f), std::log(40'000.f))));
+		}
+
+		FrameTimeHistogram histogram{};
+		for (const uint32_t frameTime : frameTimes)
+		{
+			histogram.Add(frameTime);
+		}
+		suite.Run("FrameTimeHistogram/Record", COUNT, [&] { for (const uint32_t frameTime : frameTimes) histogram.Add(frameTime); });
+		DoNotOptimize(histogram.GetMean());
+	}
+
+	//One op is an empty DAE_PROFILE_SCOPE: two timestamps and a zone stored in the ring buffer of this thread
+	//Built with DAE_PROFILING_OFF the scope is gone and this times an empty loop
+	void RunProfilerBenchmarks(BenchmarkSuite& suite)
+	{
+		suite.Run("Profiler/Zone", COUNT, [&]
+		{
+			for (size_t i{}; i < COUNT; ++i)
+			{
+				DAE_PROFILE_SCOPE("Benchmark");
+			}
+		});
+	}
+
+	//Largest element difference, relative to the element when it is above 1
+	float GetMaxError(const Matrix& a, const Matrix& b)
+	{
+		float maxError{};
+		for (int row{}; row < 4; ++row)
+		{
+			for (int column{}; column < 4; ++column)
+			{
+				const float reference{ b[row][column] };
+				maxError = std::max(maxError, std::abs(a[row][column] - reference) / std::max(1.f, std::abs(reference)));
+			}
+		}
+		return maxError;
+	}
+
+	void CheckMatrixInverse()
+	{
+		constexpr float epsilon{ 1e-4f };
+		float rigidError{}, affineError{}, dispatchError{};
+		bool isRigidClassified{ true }, isAffineClassified{ true }, isGeneralClassified{ true };
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			const Matrix rigid{ RandomRotation().ToMatrix() * Matrix::CreateTranslation(RandomVector3(100.f)) };
+			rigidError = std::max(rigidError, GetMaxError(Matrix::InverseRigid(rigid), Matrix::Inverse(rigid)));
+			isRigidClassified &= Matrix::Classify(rigid) == MatrixKind::Rigid;
+
+			//non-uniform scale, then a shear of every axis along the others
+			const Vector3 scale{ RandomFloat(0.5f, 2.f), RandomFloat(0.5f, 2.f), RandomFloat(2.5f, 4.f) };
+			const Matrix shear{ Vector4{ 1.f, RandomFloat(-0.5f, 0.5f), RandomFloat(-0.5f, 0.5f), 0.f }, Vector4{ RandomFloat(-0.5f, 0.5f), 1.f, RandomFloat(-0.5f, 0.5f), 0.f },
+				Vector4{ RandomFloat(-0.5f, 0.5f), RandomFloat(-0.5f, 0.5f), 1.f, 0.f }, Vector4{ 0.f, 0.f, 0.f, 1.f } };
+			const Matrix affine{ Matrix::CreateScale(scale) * shear * rigid };
+			affineError = std::max(affineError, GetMaxError(Matrix::InverseAffine(affine), Matrix::Inverse(affine)));
+			dispatchError = std::max(dispatchError, GetMaxError(Matrix::Inverse(affine, Matrix::Classify(affine)), Matrix::Inverse(affine)));
+			isAffineClassified &= Matrix::Classify(affine) == MatrixKind::Affine;
+
+			Matrix general{ affine };
+			general[RandomFloat(0.f, 1.f) < 0.5f ? 0 : 2].w = RandomFloat(0.1f, 1.f);
+			isGeneralClassified &= Matrix::Classify(general) == MatrixKind::General && Matrix::Classify(RandomMatrix()) == MatrixKind::General;
+		}
+		isGeneralClassified &= Matrix::Classify(CreateCamera().projectionMatrix) == MatrixKind::General;
+
+		std::printf("  Matrix inverse: rigid error %.2e, affine error %.2e, classified error %.2e\n", rigidError, affineError, dispatchError);
+		Check(rigidError <= epsilon, "InverseRigid matches Inverse on rotation + translation");
+		Check(affineError <= epsilon, "InverseAffine matches Inverse on non-uniform scale + shear + rotation + translation");
+		Check(dispatchError <= epsilon, "Inverse(m, Classify(m)) matches Inverse");
+		Check(isRigidClassified, "Classify returns Rigid for rotation + translation");
+		Check(isAffineClassified, "Classify returns Affine for non-uniform scale and shear");
+		Check(isGeneralClassified, "Classify returns General when the last column isn't (0, 0, 0, 1)");
+	}
+
+	//The 8-wide batched cull against Frustum::Intersects on every box: random boxes around the camera and boxes centered
+	//near one of the planes, so most of them straddle it. 1003 boxes and a range starting at 3 leave scalar tails behind
+	void CheckCulling()
+	{
+		const CameraState camera = CreateCamera();
+		const Frustum frustum = Frustum::FromViewProjection(camera.invViewMatrix * camera.projectionMatrix);
+
+		AabbSoA bounds{};
+		for (size_t i{}; i < 1003; ++i)
+		{
+			const Vector3 extents = Vector3{ RandomFloat(0.1f, 4.f), RandomFloat(0.1f, 4.f), RandomFloat(0.1f, 4.f) };
+			Vector3 center = Vector3{ 0.f, 0.f, 50.f } + RandomVector3(60.f);
+			if (i % 2 == 0)
+			{
+				//moved onto the plane, then up to 1.5 times the box's reach along the normal to either side
+				const Plane& plane = frustum.planes[i / 2 % Frustum::PlaneCount];
+				const float reach = std::abs(plane.normal.x) * extents.x + std::abs(plane.normal.y) * extents.y + std::abs(plane.normal.z) * extents.z;
+				center -= plane.normal * (plane.Distance(center) + RandomFloat(-1.5f, 1.5f) * reach);
+			}
+			bounds.PushBack(Aabb::FromCenterExtents(center, extents));
+		}
+
+		std::vector<uint8_t> visibility(bounds.Size());
+		bool isMatching{ true };
+		bool isCountMatching{ true };
+		size_t visibleBoxCount{}, hiddenBoxCount{};
+		for (const size_t begin : { size_t{ 0 }, size_t{ 3 } })
+		{
+			std::fill(visibility.begin(), visibility.end(), uint8_t{ 2 });
+			const size_t visibleCount = CullAabbs(frustum, bounds, visibility.data(), begin, bounds.Size());
+
+			size_t expectedCount{};
+			for (size_t i{}; i < bounds.Size(); ++i)
+			{
+				const bool isVisible = frustum.Intersects(bounds.Get(i));
+				expectedCount += i >= begin && isVisible;
+				isMatching &= visibility[i] == (i < begin ? 2 : static_cast<uint8_t>(isVisible));
+				(isVisible ? visibleBoxCount : hiddenBoxCount) += begin == 0;
+			}
+			isCountMatching &= visibleCount == expectedCount;
+		}
+
+		std::printf("  Culling: %zu visible and %zu culled boxes\n", visibleBoxCount, hiddenBoxCount);
+		Check(isMatching, "CullAabbs matches Frustum::Intersects on every box, and leaves the boxes outside the range alone");
+		Check(isCountMatching, "CullAabbs returns the number of visible boxes");
+	}
+
+	//Max absolute error against double precision over count evenly spaced angles in [-range, range], scalar and bulk
+	//An odd count leaves a scalar tail behind the 4-wide loop of the bulk version
+	template<MathPrecision precision>
+	double GetSinCosError(float range, size_t count)
+	{
+		std::vector<float> angles(count), sines(count), cosines(count);
+		for (size_t i{}; i < count; ++i)
+		{
+			angles[i] = -range + 2.f * range * static_cast<float>(i) / static_cast<float>(count - 1);
+		}
+		SinCos<precision>(angles.data(), sines.data(), cosines.data(), count);
+
+		double maxError{};
+		for (size_t i{}; i < count; ++i)
+		{
+			float sine{}, cosine{};
+			SinCos<precision>(angles[i], sine, cosine);
+			const double referenceSine{ std::sin(static_cast<double>(angles[i])) };
+			const double referenceCosine{ std::cos(static_cast<double>(angles[i])) };
+			maxError = std::max({ maxError, std::abs(sine - referenceSine), std::abs(cosine - referenceCosine),
+				std::abs(sines[i] - referenceSine), std::abs(cosines[i] - referenceCosine) });
+		}
+		return maxError;
+	}
+
+	//Max relative error against double precision over count values spaced evenly in log scale over [1e-6, 1e6]
+	template<MathPrecision precision>
+	double GetInvSqrtError(size_t count)
+	{
+		std::vector<float> values(count), results(count);
+		for (size_t i{}; i < count; ++i)
+		{
+			values[i] = static_cast<float>(std::pow(10.0, -6.0 + 12.0 * static_cast<double>(i) / static_cast<double>(count - 1)));
+		}
+		InvSqrt<precision>(values.data(), results.data(), count);
+
+		double maxError{};
+		for (size_t i{}; i < count; ++i)
+		{
+			const double reference{ 1.0 / std::sqrt(static_cast<double>(values[i])) };
+			maxError = std::max({ maxError, std::abs(InvSqrt<precision>(values[i]) - reference) / reference, std::abs(results[i] - reference) / reference });
+		}
+		return maxError;
+	}
+
+	//The error bounds in the MathPrecision comment
+	void CheckFastMath()
+	{
+		constexpr size_t sampleCount{ 1'000'003 };
+		const double fastError{ GetSinCosError<MathPrecision::Fast>(PI, sampleCount) };
+		const double fastWideError{ GetSinCosError<MathPrecision::Fast>(100.f, 4 * sampleCount) };
+		const double estimateError{ GetSinCosError<MathPrecision::Estimate>(PI, sampleCount) };
+		const double estimateWideError{ GetSinCosError<MathPrecision::Estimate>(100.f, 4 * sampleCount) };
+		const double fastInvSqrtError{ GetInvSqrtError<MathPrecision::Fast>(4 * sampleCount) };
+		const double estimateInvSqrtError{ GetInvSqrtError<MathPrecision::Estimate>(4 * sampleCount) };
+
+		std::printf("  SinCos<Fast>: %.2e / %.2e, SinCos<Estimate>: %.2e / %.2e, InvSqrt<Fast>: %.2e, InvSqrt<Estimate>: %.2e\n",
+			fastError, fastWideError, estimateError, estimateWideError, fastInvSqrtError, estimateInvSqrtError);
+		Check(fastError <= 2.2e-7 && fastWideError <= 3.6e-6, "SinCos<Fast> within 2.2e-7 on [-PI, PI] and 3.6e-6 on [-100, 100]");
+		Check(estimateError <= 9.4e-6 && estimateWideError <= 1.3e-5, "SinCos<Estimate> within 9.4e-6 on [-PI, PI] and 1.3e-5 on [-100, 100]");
+		Check(fastInvSqrtError <= 2.7e-7, "InvSqrt<Fast> within 2.7e-7 relative on [1e-6, 1e6]");
+		Check(estimateInvSqrtError <= 3.3e-4, "InvSqrt<Estimate> within 3.3e-4 relative on [1e-6, 1e6]");
+	}
+
+	//Round trips of every format, worst case errors against their quantization step and the F16C conversions when available
+	void CheckPacking()
+	{
+		//every half survives half -> float -> half, NaNs stay NaN
+		bool isHalfRoundTripExact{ true };
+		for (uint32_t bits{}; bits <= UINT16_MAX; ++bits)
+		{
+			const uint16_t half{ static_cast<uint16_t>(bits) };
+			const float value{ Packing::HalfToFloat(half) };
+			isHalfRoundTripExact &= std::isnan(value) ? std::isnan(Packing::HalfToFloat(Packing::FloatToHalf(value))) : Packing::FloatToHalf(value) == half;
+		}
+		Check(isHalfRoundTripExact, "every half round trips through float");
+
+		//floats exactly between two halves test the ties, the rest covers overflow, denormals and underflow
+		std::vector<float> floats{};
+		for (uint32_t bits{}; bits < 0x7C00; ++bits)
+		{
+			const float low{ Packing::HalfToFloat(static_cast<uint16_t>(bits)) };
+			const float high{ Packing::HalfToFloat(static_cast<uint16_t>(bits + 1)) };
+			floats.push_back(0.5f * (low + high));
+			floats.push_back(-0.5f * (low + high));
+		}
+		for (int i{}; i < 100'000; ++i)
+		{
+			floats.push_back(std::ldexp(RandomFloat(-2.f, 2.f), static_cast<int>(RandomFloat(-30.f, 20.f))));
+		}
+		std::vector<uint16_t> halves(floats.size());
+		std::vector<float> unpacked(floats.size());
+		Packing::FloatToHalf(floats, halves);
+		bool isBulkHalfExact{ true };
+		for (size_t i{}; i < floats.size(); ++i)
+		{
+			isBulkHalfExact &= halves[i] == Packing::FloatToHalf(floats[i]);
+		}
+		Packing::HalfToFloat(halves, unpacked);
+		for (size_t i{}; i < halves.size(); ++i)
+		{
+			isBulkHalfExact &= std::bit_cast<uint32_t>(unpacked[i]) == std::bit_cast<uint32_t>(Packing::HalfToFloat(halves[i]));
+		}
+		Check(isBulkHalfExact, "bulk FloatToHalf / HalfToFloat match the scalar conversions");
+
+#if defined(DAE_F16C)
+		bool isHalfF16CExact{ true };
+		for (uint32_t bits{}; bits <= UINT16_MAX; ++bits)
+		{
+			const float value{ Packing::HalfToFloat(static_cast<uint16_t>(bits)) };
+			const float f16cValue{ _cvtsh_ss(static_cast<uint16_t>(bits)) };
+			isHalfF16CExact &= std::isnan(value) ? std::isnan(f16cValue) : std::bit_cast<uint32_t>(value) == std::bit_cast<uint32_t>(f16cValue);
+		}
+		for (const float value : floats)
+		{
+			isHalfF16CExact &= Packing::FloatToHalf(value) == _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+		}
+		Check(isHalfF16CExact, "HalfToFloat (all 65536 halves) and FloatToHalf are bit exact with F16C");
+#endif
+
+		//round to nearest: half a quantization step at most
+		double unorm8Error{}, unorm10Error{}, unorm16Error{}, snorm8Error{}, snorm16Error{};
+		for (int i{}; i <= 1'000'000; ++i)
+		{
+			const float unit{ static_cast<float>(i) / 1'000'000.f };
+			const float signedUnit{ 2.f * unit - 1.f };
+			unorm8Error = std::max<double>(unorm8Error, std::abs(Packing::UnormToFloat<8>(Packing::FloatToUnorm<8>(unit)) - unit));
+			unorm10Error = std::max<double>(unorm10Error, std::abs(Packing::UnormToFloat<10>(Packing::FloatToUnorm<10>(unit)) - unit));
+			unorm16Error = std::max<double>(unorm16Error, std::abs(Packing::UnormToFloat<16>(Packing::FloatToUnorm<16>(unit)) - unit));
+			snorm8Error = std::max<double>(snorm8Error, std::abs(Packing::SnormToFloat<8>(Packing::FloatToSnorm<8>(signedUnit)) - signedUnit));
+			snorm16Error = std::max<double>(snorm16Error, std::abs(Packing::SnormToFloat<16>(Packing::FloatToSnorm<16>(signedUnit)) - signedUnit));
+		}
+		//plus the rounding of the float math in the decode
+		constexpr double floatSlack{ FLT_EPSILON };
+		Check(unorm8Error <= 0.5 / 255.0 + floatSlack && unorm10Error <= 0.5 / 1023.0 + floatSlack && unorm16Error <= 0.5 / 65535.0 + floatSlack,
+			"UNORM 8 / 10 / 16 within half a step");
+		Check(snorm8Error <= 0.5 / 127.0 + floatSlack && snorm16Error <= 0.5 / 32767.0 + floatSlack, "SNORM 8 / 16 within half a step");
+
+		std::vector<float> values(COUNT);
+		std::vector<uint8_t> unorm8(COUNT);
+		std::vector<int8_t> snorm8(COUNT);
+		for (float& value : values)
+		{
+			value = RandomFloat(-1.5f, 1.5f);
+		}
+		Packing::FloatToUnorm8(values, unorm8);
+		Packing::FloatToSnorm8(values, snorm8);
+		bool isBulkNormExact{ true };
+		for (size_t i{}; i < COUNT; ++i)
+		{
+			isBulkNormExact &= unorm8[i] == Packing::FloatToUnorm<8>(values[i]) && snorm8[i] == Packing::FloatToSnorm<8>(values[i]);
+		}
+		Check(isBulkNormExact, "bulk FloatToUnorm8 / FloatToSnorm8 match the scalar conversions, clamped");
+
+		//R11G11B10F: every code round trips, in range values are within half a mantissa step relative
+		bool isSmallFloatRoundTripExact{ true };
+		for (uint32_t code{}; code < 0x7C0; ++code)
+		{
+			const uint32_t packed{ code | code << 11 | (code >> 1) << 22 };
+			isSmallFloatRoundTripExact &= Packing::PackR11G11B10F(Packing::UnpackR11G11B10F(packed)) == packed;
+		}
+		Check(isSmallFloatRoundTripExact, "every finite R11G11B10F code round trips");
+
+		double r11Error{}, b10Error{}, r10g10b10a2Error{};
+		for (int i{}; i < 1'000'000; ++i)
+		{
+			const ColorRGB hdr{ std::ldexp(RandomFloat(1.f, 2.f), static_cast<int>(RandomFloat(-14.f, 15.f))), RandomFloat(0.f, 1.f), std::ldexp(RandomFloat(1.f, 2.f), static_cast<int>(RandomFloat(-14.f, 15.f))) };
+			const ColorRGB unpacked{ Packing::UnpackR11G11B10F(Packing::PackR11G11B10F(hdr)) };
+			r11Error = std::max<double>(r11Error, std::abs(unpacked.r - hdr.r) / hdr.r);
+			b10Error = std::max<double>(b10Error, std::abs(unpacked.b - hdr.b) / hdr.b);
+
+			const ColorRGB color{ RandomFloat(0.f, 1.f), RandomFloat(0.f, 1.f), RandomFloat(0.f, 1.f) };
+			const Vector4 unpackedColor{ Packing::UnpackR10G10B10A2(Packing::PackR10G10B10A2(color)) };
+			r10g10b10a2Error = std::max<double>({ r10g10b10a2Error, std::abs(unpackedColor.x - color.r), std::abs(unpackedColor.y - color.g), std::abs(unpackedColor.z - color.b) });
+		}
+		std::printf("  Packing: R11G11B10F relative error %.2e / %.2e, R10G10B10A2 error %.2e\n", r11Error, b10Error, r10g10b10a2Error);
+		Check(r11Error <= 1.0 / 128.0 && b10Error <= 1.0 / 64.0, "R11G11B10F within half a mantissa step relative");
+		Check(r10g10b10a2Error <= 0.5 / 1023.0 + floatSlack, "R10G10B10A2 within half a step");
+
+		//random bit patterns (NaN, INF, denormals, negatives) and small float ties, the count leaves a scalar tail
+		std::vector<ColorRGB> colors(10'003);
+		for (size_t i{}; i < colors.size(); ++i)
+		{
+			const auto randomBits = [] { return std::bit_cast<float>(static_cast<uint32_t>(g_Random())); };
+			const auto randomTie = [] { return std::ldexp(static_cast<float>(2 * static_cast<int>(RandomFloat(64.f, 128.f)) + 1), static_cast<int>(RandomFloat(-30.f, 10.f))); };
+			colors[i] = i % 2 == 0 ? ColorRGB{ randomBits(), randomBits(), randomBits() } : ColorRGB{ randomTie(), -randomTie(), randomTie() };
+		}
+		std::vector<uint32_t> packedColors(colors.size());
+		Packing::PackR11G11B10F(colors, packedColors);
+		bool isBulkColorExact{ true };
+		for (size_t i{}; i < colors.size(); ++i)
+		{
+			isBulkColorExact &= packedColors[i] == Packing::PackR11G11B10F(colors[i]);
+		}
+		//the scalar UNORM conversion of NaN is undefined
+		for (size_t i{}; i < colors.size(); ++i)
+		{
+			const ColorRGB& color{ colors[i] };
+			colors[i] = i < 1'000 ? ColorRGB{ RandomFloat(-0.1f, 1.1f), RandomFloat(-0.1f, 1.1f), RandomFloat(-0.1f, 1.1f) }
+				: ColorRGB{ std::isnan(color.r) ? 0.f : color.r, std::isnan(color.g) ? 0.f : color.g, std::isnan(color.b) ? 0.f : color.b };
+		}
+		Packing::PackR10G10B10A2(colors, packedColors);
+		for (size_t i{}; i < colors.size(); ++i)
+		{
+			isBulkColorExact &= packedColors[i] == Packing::PackR10G10B10A2(colors[i]);
+		}
+		Check(isBulkColorExact, "bulk PackR11G11B10F / PackR10G10B10A2 match the scalar conversions");
+
+		//angle between a random unit normal and its decoded encoding
+		std::normal_distribution<float> gaussian{};
+		double octahedralError{}, octahedralSnorm16Error{};
+		const auto getAngleDegrees = [](const Vector3& a, const Vector3& b)
+		{
+			return std::atan2(static_cast<double>(Vector3::Cross(a, b).Magnitude()), static_cast<double>(Vector3::Dot(a, b))) * 180.0 / 3.14159265358979323846;
+		};
+		for (int i{}; i < 1'000'000; ++i)
+		{
+			const Vector3 normal{ Vector3{ gaussian(g_Random), gaussian(g_Random), gaussian(g_Random) }.Normalized() };
+			octahedralError = std::max(octahedralError, getAngleDegrees(normal, Packing::DecodeOctahedral(Packing::EncodeOctahedral(normal))));
+			octahedralSnorm16Error = std::max(octahedralSnorm16Error, getAngleDegrees(normal, Packing::UnpackOctahedralSnorm16(Packing::PackOctahedralSnorm16(normal))));
+		}
+		std::printf("  Octahedral: max error %.2e degrees, %.2e degrees through R16G16_SNORM\n", octahedralError, octahedralSnorm16Error);
+		Check(octahedralError <= 1e-3, "DecodeOctahedral(EncodeOctahedral(n)) within 0.001 degrees");
+		Check(octahedralSnorm16Error <= 0.004, "PackOctahedralSnorm16 within 0.004 degrees");
+
+		//unnormalized, axis aligned and signed zero normals fold the same way in bulk
+		std::vector<Vector3> normals{ { 0.f, 0.f, 1.f }, { -0.f, 0.f, -1.f }, { 0.f, -0.f, -1.f }, { -0.f, -0.f, -0.5f }, { 1.f, 0.f, -0.f }, { -1.f, -0.f, 0.f }, { 0.f, -1.f, -0.f } };
+		while (normals.size() < 10'003)
+		{
+			normals.push_back(Vector3{ gaussian(g_Random), gaussian(g_Random), gaussian(g_Random) }.Normalized());
+			normals.push_back({ RandomFloat(-2.f, 2.f), RandomFloat(-2.f, 2.f), RandomFloat(-2.f, 2.f) });
+		}
+		std::vector<uint32_t> packedNormals(normals.size());
+		Packing::PackOctahedralSnorm16(normals, packedNormals);
+		bool isBulkOctahedralExact{ true };
+		for (size_t i{}; i < normals.size(); ++i)
+		{
+			isBulkOctahedralExact &= packedNormals[i] == Packing::PackOctahedralSnorm16(normals[i]);
+		}
+		Check(isBulkOctahedralExact, "bulk PackOctahedralSnorm16 matches the scalar conversion");
+	}
+
+	//The queue order without a GPU: the radix sort against std::stable_sort, opaque before blended, blended back-to-front
+	//in submission order for equal depths, and the triangle sorter keeping clusters whole, farthest first
+	void CheckDrawOrder()
+	{
+		//few distinct keys so most of them repeat, below and above the insertion sort cutoff
+		RenderQueue renderQueue{};
+		bool isStableSorted{ true };
+		for (const size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 40 }, size_t{ 64 }, size_t{ 65 }, size_t{ 10'000 } })
+		{
+			renderQueue.Clear();
+			std::vector<RenderCommand> expected{};
+			for (uint32_t item{}; item < count; ++item)
+			{
+				const uint64_t key{ static_cast<uint64_t>(g_Random() % 32) << (g_Random() % 8 * 8) | (item % 2 ? uint64_t{ g_Random() } << 32 : 0) };
+				renderQueue.Submit(key, item);
+				expected.push_back({ key, item });
+			}
+			renderQueue.Sort();
+			std::stable_sort(expected.begin(), expected.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+			isStableSorted &= std::equal(expected.begin(), expected.end(), renderQueue.GetCommands().begin(), renderQueue.GetCommands().end(),
+				[](const RenderCommand& a, const RenderCommand& b) { return a.key == b.key && a.item == b.item; });
+		}
+		Check(isStableSorted, "RenderQueue::Sort matches std::stable_sort");
+
+		//items index the depths, every fourth blended draw repeats the depth of the one before it
+		renderQueue.Clear();
+		std::vector<float> depths{};
+		std::vector<bool> isTransparent{};
+		for (uint32_t item{}; item < 1000; ++item)
+		{
+			const bool isItemTransparent{ item % 3 == 0 };
+			const float depth{ isItemTransparent && item % 4 == 0 && item > 0 ? depths.back() : RandomFloat(0.1f, 1000.f) };
+			depths.push_back(depth);
+			isTransparent.push_back(isItemTransparent);
+			renderQueue.Submit(RenderQueue::MakeKey(RenderPass::Main, isItemTransparent, isItemTransparent ? 1 : item % 2, 3, depth), item);
+		}
+		for (uint32_t item{}; item < 8; ++item)
+		{
+			depths.push_back(500.f);
+			isTransparent.push_back(true);
+			renderQueue.Submit(RenderQueue::MakeKey(RenderPass::Main, true, 1, 3, 500.f), 1000 + item);
+		}
+		renderQueue.Sort();
+
+		//the key keeps 16 mantissa bits of the depth, closer depths may come in either order
+		constexpr float depthTolerance{ 1.f + 1.f / 65536.f };
+		const std::vector<RenderCommand>& commands{ renderQueue.GetCommands() };
+		bool isOpaqueFirst{ true }, isFrontToBack{ true }, isBackToFront{ true }, isEqualDepthStable{ true };
+		for (size_t i{ 1 }; i < commands.size(); ++i)
+		{
+			const uint32_t previous{ commands[i - 1].item };
+			const uint32_t current{ commands[i].item };
+			isOpaqueFirst &= !isTransparent[previous] || isTransparent[current];
+			isOpaqueFirst &= RenderQueue::IsTransparent(commands[i].key) == isTransparent[current];
+			if (!isTransparent[previous] && !isTransparent[current] && previous % 2 == current % 2)
+			{
+				isFrontToBack &= depths[previous] <= depths[current] * depthTolerance;
+			}
+			if (isTransparent[previous] && isTransparent[current])
+			{
+				isBackToFront &= depths[previous] * depthTolerance >= depths[current];
+				if (depths[previous] == depths[current]) isEqualDepthStable &= previous < current;
+			}
+		}
+		Check(isOpaqueFirst, "opaque draws sort before blended draws");
+		Check(isFrontToBack, "opaque draws of one material and mesh sort front-to-back");
+		Check(isBackToFront, "blended draws sort back-to-front");
+		Check(isEqualDepthStable, "blended draws at equal depths keep their submission order");
+
+		//a strip of triangles along z in shuffled order, w = z so the view depth is the z of the centroid
+		constexpr uint32_t triangleCount{ 1001 };
+		std::vector<Vector3> positions{};
+		std::vector<uint32_t> indices{};
+		for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			const float z{ triangle % 7 == 0 ? 50.f : RandomFloat(1.f, 100.f) };
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				indices.push_back(static_cast<uint32_t>(positions.size()));
+				positions.push_back({ static_cast<float>(corner), static_cast<float>(corner % 2), z });
+			}
+		}
+		const Matrix depthProjection{ Vector4{ 1.f, 0.f, 0.f, 0.f }, Vector4{ 0.f, 1.f, 0.f, 0.f }, Vector4{ 0.f, 0.f, 1.f, 1.f }, Vector4{ 0.f, 0.f, 0.f, 0.f } };
+
+		TriangleSorter triangleSorter{};
+		bool isClusterWhole{ true }, isClusterFarthestFirst{ true }, isClusterStable{ true };
+		for (const uint32_t clusterTriangleCount : { 1u, 4u, 16u })
+		{
+			const std::vector<uint32_t>& sorted{ triangleSorter.Sort(positions.data(), positions.size(), sizeof(Vector3), indices, depthProjection, clusterTriangleCount) };
+			isClusterWhole &= sorted.size() == indices.size();
+
+			const uint32_t clusterIndexCount{ clusterTriangleCount * 3 };
+			float previousDepth{ FLT_MAX };
+			uint32_t previousCluster{};
+			for (size_t first{}; first < sorted.size() && isClusterWhole; )
+			{
+				//the cluster is found through its first index, the rest must follow it unchanged
+				const uint32_t cluster{ sorted[first] / clusterIndexCount };
+				const size_t clusterSize{ std::min<size_t>(clusterIndexCount, indices.size() - size_t{ cluster } * clusterIndexCount) };
+				float depthSum{};
+				for (size_t i{}; i < clusterSize; ++i)
+				{
+					isClusterWhole &= first + i < sorted.size() && sorted[first + i] == cluster * clusterIndexCount + i;
+					depthSum += positions[cluster * clusterIndexCount + i].z;
+				}
+				const float depth{ depthSum / static_cast<float>(clusterSize) };
+
+				//depths are quantized to 16 bits over [1, 100], closer than a step they may swap
+				isClusterFarthestFirst &= depth <= previousDepth + 100.f / 65535.f;
+				if (depth == previousDepth) isClusterStable &= cluster > previousCluster;
+				previousDepth = depth;
+				previousCluster = cluster;
+				first += clusterSize;
+			}
+		}
+		Check(isClusterWhole, "TriangleSorter keeps every cluster whole and in its own order");
+		Check(isClusterFarthestFirst, "TriangleSorter orders clusters farthest first, with 1, 4 and 16 triangles per cluster");
+		Check(isClusterStable, "TriangleSorter keeps clusters at equal depths in their original order");
+	}
+
+	//A 20x20 quad 50 units in front of the camera: boxes behind it are culled, boxes in front of it, next to it or only
+	//partly behind it stay visible, with the tiles rasterized on one thread and on four
+	void CheckOcclusion()
+	{
+		const CameraState camera = CreateCamera();
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+		const std::array<Vector3, 4> quad{ Vector3{ -10.f, -10.f, 0.f }, Vector3{ 10.f, -10.f, 0.f }, Vector3{ 10.f, 10.f, 0.f }, Vector3{ -10.f, 10.f, 0.f } };
+		const std::array<uint32_t, 6> quadIndices{ 0, 1, 2, 0, 2, 3 };
+
+		std::vector<Aabb> testBounds{};
+		for (int i{}; i < 10'000; ++i)
+		{
+			testBounds.push_back(Aabb::FromCenterExtents(Vector3{ RandomFloat(-30.f, 30.f), RandomFloat(-20.f, 20.f), RandomFloat(-40.f, 100.f) }, Vector3{ 1.f, 1.f, 1.f } * RandomFloat(0.5f, 6.f)));
+		}
+
+		JobSystem singleJobSystem{ 0 };
+		JobSystem parallelJobSystem{ 3 };
+		std::vector<float> singleDepth{};
+		std::vector<uint8_t> singleVisibility{};
+		bool isThreadingIdentical{ true };
+		for (JobSystem* jobSystemPtr : { &singleJobSystem, &parallelJobSystem })
+		{
+			OcclusionCuller occlusionCuller{};
+			occlusionCuller.BeginFrame(viewProjection);
+			occlusionCuller.AddOccluder(quad.data(), quad.size(), sizeof(Vector3), quadIndices.data(), quadIndices.size(), Matrix{});
+			occlusionCuller.Rasterize(*jobSystemPtr);
+
+			Check(!occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 0.f, 0.f, 20.f }, Vector3{ 2.f, 2.f, 2.f })), "a box fully behind the quad is culled");
+			Check(!occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 3.f, -2.f, 80.f }, Vector3{ 8.f, 8.f, 8.f })), "a large box far behind the quad is culled");
+			Check(occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 0.f, 0.f, -10.f }, Vector3{ 2.f, 2.f, 2.f })), "a box in front of the quad is visible");
+			Check(occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 0.f, 0.f, 0.f }, Vector3{ 2.f, 2.f, 2.f })), "a box crossing the quad is visible");
+			Check(occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 12.f, 0.f, 20.f }, Vector3{ 4.f, 4.f, 4.f })), "a box behind the edge of the quad is visible");
+			Check(occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 40.f, 0.f, 20.f }, Vector3{ 2.f, 2.f, 2.f })), "a box next to the quad is visible");
+			Check(occlusionCuller.IsVisible(Aabb::FromCenterExtents(Vector3{ 0.f, 0.f, -55.f }, Vector3{ 2.f, 2.f, 2.f })), "a box around the camera is visible");
+
+			std::vector<uint8_t> visibility{};
+			for (const Aabb& bounds : testBounds)
+			{
+				visibility.push_back(occlusionCuller.IsVisible(bounds));
+			}
+			if (jobSystemPtr == &singleJobSystem)
+			{
+				singleDepth = occlusionCuller.GetDepth();
+				singleVisibility = visibility;
+			}
+			else
+			{
+				isThreadingIdentical &= occlusionCuller.GetDepth() == singleDepth && visibility == singleVisibility;
+			}
+		}
+		Check(isThreadingIdentical, "the depth buffer and 10k box tests are identical with 0 and 3 workers");
+	}
+
+	//Every lane of the SIMD ShadeVehicle against the scalar one, per sampler filter, with and without the normal map
+	//The math is the same but for the pow, which the SIMD version does through Log2 / Exp2 (about 1e-6 relative error)
+	void CheckSoftwareShading()
+	{
+		constexpr float tolerance{ 1e-5f };
+		std::array<SoftwareTexture, 4> textures{};
+		std::vector<PixelInput> pixels{};
+		std::vector<PixelBlock> blocks{};
+		CreateVehiclePixels(textures, pixels, blocks);
+
+		const char* filterNames[]{ "point", "linear", "anisotropic" };
+		float errors[3]{};
+		for (const SamplerFilter filter : { SamplerFilter::Point, SamplerFilter::Linear, SamplerFilter::Anisotropic })
+		{
+			float& error = errors[static_cast<int>(filter)];
+			for (const bool useNormalMap : { true, false })
+			{
+				const VehicleShading shading{ &textures[0], &textures[1], &textures[2], &textures[3], Vector3{ 0.f, 0.f, -50.f }, filter, useNormalMap };
+				for (size_t block{}; block < blocks.size(); ++block)
+				{
+					const SimdVector4 blockColor = ShadeVehicle(shading, blocks[block]);
+					for (int lane{}; lane < SimdFloat::Width; ++lane)
+					{
+						const Vector4 color = ShadeVehicle(shading, pixels[block * SimdFloat::Width + lane]);
+						error = std::max({ error, std::abs(blockColor.x.GetLane(lane) - color.x), std::abs(blockColor.y.GetLane(lane) - color.y),
+							std::abs(blockColor.z.GetLane(lane) - color.z), std::abs(blockColor.w.GetLane(lane) - color.w) });
+					}
+				}
+			}
+
+			char description[96]{};
+			std::snprintf(description, sizeof(description), "SIMD ShadeVehicle matches the scalar one with the %s filter", filterNames[static_cast<int>(filter)]);
+			Check(error <= tolerance, description);
+		}
+		std::printf("  ShadeVehicle %d-wide: max error point %.2e, linear %.2e, anisotropic %.2e (tolerance %.0e)\n",
+			SimdFloat::Width, errors[0], errors[1], errors[2], tolerance);
+	}
+
+	//Hi-Z, the depth test it skips for blocks in front and the depth prepass only save work, the image stays the same:
+	//two layers of overlapping opaque spheres, the far layer drawn first so the near one covers it, a third layer between
+	//them that cuts through both, and a blended sphere in front
+	void CheckSoftwareRaster()
+	{
+		const CameraState camera = CreateCamera();
+		const Matrix viewProjection = camera.invViewMatrix * camera.projectionMatrix;
+		std::vector<MeshVertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CreateSphere(vertices, indices, 7.f, 48, 96);
+
+		SoftwareRenderBackend backend{ 640, 480, CreateProceduralTexture };
+		const MaterialHandle opaqueMaterial = backend.CreateMaterial(MaterialType::Vehicle);
+		const MaterialHandle blendedMaterial = backend.CreateMaterial(MaterialType::FireFX);
+		const MeshHandle opaqueMesh = backend.CreateMesh(vertices, indices, opaqueMaterial);
+		const MeshHandle blendedMesh = backend.CreateMesh(vertices, indices, blendedMaterial);
+
+		std::vector<uint32_t> referenceColors{};
+		std::vector<float> referenceDepths{};
+		std::vector<float> depths{};
+		const SoftwareRasterizer& rasterizer = backend.GetRasterizer();
+		SoftwareRasterizer::Settings& settings = backend.GetRasterizerSettings();
+		const char* variantNames[]{ "Hi-Z", "Hi-Z and the depth prepass" };
+		int variant{ -1 };
+		for (const SoftwareRasterizer::Settings variantSettings : { SoftwareRasterizer::Settings{ false, false }, SoftwareRasterizer::Settings{ true, false }, SoftwareRasterizer::Settings{ true, true } })
+		{
+			settings = variantSettings;
+			backend.BeginFrame();
+			backend.SetCameraPosition(camera.origin);
+			for (const float layer : { 1.f, 0.f, 0.5f })
+			{
+				for (int row{ -1 }; row <= 1; ++row)
+				{
+					for (int column{ -1 }; column <= 1; ++column)
+					{
+						const Matrix world = Matrix::CreateTranslation(static_cast<float>(column) * 16.f + layer * 6.f, static_cast<float>(row) * 14.f + layer * 4.f, layer * 12.f);
+						backend.GetImmediateContext().Draw(opaqueMesh, opaqueMaterial, world, world * viewProjection);
+					}
+				}
+			}
+			const Matrix blendedWorld = Matrix::CreateTranslation(0.f, 0.f, -20.f);
+			backend.GetImmediateContext().Draw(blendedMesh, blendedMaterial, blendedWorld, blendedWorld * viewProjection);
+			backend.EndFrame();
+
+			depths.clear();
+			for (uint32_t y{}; y < rasterizer.GetHeight(); ++y)
+			{
+				for (uint32_t x{}; x < rasterizer.GetWidth(); ++x)
+				{
+					depths.push_back(rasterizer.GetDepth(x, y));
+				}
+			}
+			if (variant < 0)
+			{
+				referenceColors = rasterizer.GetColorBuffer();
+				referenceDepths = depths;
+				++variant;
+				continue;
+			}
+
+			char description[96]{};
+			std::snprintf(description, sizeof(description), "the software rasterizer with %s renders the same colors as without", variantNames[variant]);
+			Check(rasterizer.GetColorBuffer() == referenceColors, description);
+			std::snprintf(description, sizeof(description), "the software rasterizer with %s renders the same depths as without", variantNames[variant]);
+			Check(depths == referenceDepths, description);
+			std::printf("  SoftwareRaster %s: Hi-Z culled %llu triangle tiles and %llu blocks\n", variantNames[variant],
+				static_cast<unsigned long long>(rasterizer.GetStats().hiZCulledTriangleCount), static_cast<unsigned long long>(rasterizer.GetStats().hiZCulledBlockCount));
+			++variant;
+		}
+		settings = SoftwareRasterizer::Settings{};
+	}
+
+	void RunChecks()
+	{
+		std::printf("Checks\n");
+		CheckMatrixInverse();
+		CheckCulling();
+		CheckFastMath();
+		CheckPacking();
+		CheckDrawOrder();
+		CheckOcclusion();
+		CheckSoftwareShading();
+		CheckSoftwareRaster();
+		std::printf("%d check(s) failed\n\n", g_FailureCount);
+	}
+}
+
+int main(int argc, char* args[])
+{
+	std::string filter{};
+	std::string outPath{};
+	std::string baselinePath{};
+	double threshold{ 0.25 };
+	double minDeltaNs{ 0.1 };
+	double minTimeMs{ 20.0 };
+	int sampleCount{ 5 };
+	bool runChecks{ true };
+	bool runBenchmarks{ true };
+
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (hasValue && std::strcmp(args[i], "--filter") == 0) filter = args[++i];
+		else if (hasValue && std::strcmp(args[i], "--out") == 0) outPath = args[++i];
+		else if (hasValue && std::strcmp(args[i], "--baseline") == 0) baselinePath = args[++i];
+		else if (hasValue && std::strcmp(args[i], "--threshold") == 0) threshold = std::stod(args[++i]);
+		else if (hasValue && std::strcmp(args[i], "--min-delta") == 0) minDeltaNs = std::stod(args[++i]);
+		else if (hasValue && std::strcmp(args[i], "--min-time") == 0) minTimeMs = std::stod(args[++i]);
+		else if (hasValue && std::strcmp(args[i], "--samples") == 0) sampleCount = std::stoi(args[++i]);
+		else if (std::strcmp(args[i], "--skip-checks") == 0) runChecks = false;
+		else if (std::strcmp(args[i], "--skip-benchmarks") == 0) runBenchmarks = false;
+		else
+		{
+			std::cerr << "unknown argument '" << args[i] << "'" << std::endl;
+			return 2;
+		}
+	}
+
+	if (runChecks) RunChecks();
+	if (!runBenchmarks) return g_FailureCount > 0 ? 1 : 0;
+
+	BenchmarkSuite suite{ filter, minTimeMs, sampleCount };
+	if (!baselinePath.empty())
+	{
+		std::vector<BenchmarkResult> baseline{};
+		if (!BenchmarkSuite::ReadJson(baselinePath, baseline))
+		{
+			std::cerr << "could not read baseline '" << baselinePath << "'" << std::endl;
+			return 2;
+		}
+		suite.SetBaseline(std::move(baseline), threshold, minDeltaNs);
+	}
+
+	RunMatrixBenchmarks(suite);
+	RunVectorBenchmarks(suite);
+	RunTransformBenchmarks(suite);
+	RunRendererBenchmarks(suite);
+	RunSceneGraphBenchmarks(suite);
+	RunRenderWorldBenchmarks(suite);
+	RunRenderQueueBenchmarks(suite);
+	RunOcclusionBenchmarks(suite);
+	RunFrameBenchmarks(suite);
+	RunSoftwareShadingBenchmarks(suite);
+	RunSoftwareRasterBenchmarks(suite);
+	RunFastMathBenchmarks(suite);
+	RunPackingBenchmarks(suite);
+	RunFrameTimeBenchmarks(suite);
+	RunProfilerBenchmarks(suite);
+
+	if (!outPath.empty())
+	{
+		std::ofstream file{ outPath };
+		suite.WriteJson(file);
+	}
+
+	if (baselinePath.empty()) return g_FailureCount > 0 ? 1 : 0;
+
+	std::cout << "comparing against " << baselinePath << " (threshold " << threshold * 100.0 << "%)" << std::endl;
+	const int regressions = suite.CompareToBaseline();
+	std::cout << regressions << " regression(s)" << std::endl;
+	return regressions > 0 || g_FailureCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,571 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	//PNG files for the headless tools, pixels are RGBA8 with red in the low byte like SoftwareTexture and the software rasterizer
+	//Read takes non interlaced 8 bit gray, gray alpha, RGB, RGBA and palette images, which covers the textures in Resources
+	//Write stores RGBA with the usual per row filter heuristic and fixed Huffman deflate, matches only look back to the
+	//previous occurrence of the same 3 bytes. Far from optimal, but flat backgrounds and repeated rows still shrink a lot
+	namespace Png
+	{
+		bool Read(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels);
+		//rows are pitch pixels apart
+		bool Write(const std::string& path, uint32_t width, uint32_t height, const uint32_t* pixelsPtr, uint32_t pitch);
+
+		namespace Detail
+		{
+			constexpr std::array<uint16_t, 29> lengthBases{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			constexpr std::array<uint8_t, 29> lengthExtraBits{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			constexpr std::array<uint16_t, 30> distanceBases{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			constexpr std::array<uint8_t, 30> distanceExtraBits{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			inline uint32_t Crc32(const uint8_t* dataPtr, size_t size, uint32_t crc = 0)
+			{
+				static const std::array<uint32_t, 256> table = []
+				{
+					std::array<uint32_t, 256> result{};
+					for (uint32_t i{}; i < 256; ++i)
+					{
+						uint32_t value = i;
+						for (int bit{}; bit < 8; ++bit) value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+						result[i] = value;
+					}
+					return result;
+				}();
+
+				crc = ~crc;
+				for (size_t i{}; i < size; ++i) crc = table[(crc ^ dataPtr[i]) & 0xFF] ^ (crc >> 8);
+				return ~crc;
+			}
+
+			inline uint32_t Adler32(const std::vector<uint8_t>& data)
+			{
+				uint32_t a{ 1 }, b{};
+				for (const uint8_t byte : data)
+				{
+					a = (a + byte) % 65521;
+					b = (b + a) % 65521;
+				}
+				return b << 16 | a;
+			}
+
+			inline uint32_t ReadBigEndian(const uint8_t* dataPtr)
+			{
+				return uint32_t{ dataPtr[0] } << 24 | uint32_t{ dataPtr[1] } << 16 | uint32_t{ dataPtr[2] } << 8 | dataPtr[3];
+			}
+
+			inline void AppendBigEndian(std::vector<uint8_t>& data, uint32_t value)
+			{
+				data.insert(data.end(), { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) });
+			}
+
+			inline uint8_t Paeth(int left, int up, int upLeft)
+			{
+				const int estimate = left + up - upLeft;
+				const int toLeft = std::abs(estimate - left);
+				const int toUp = std::abs(estimate - up);
+				const int toUpLeft = std::abs(estimate - upLeft);
+				if (toLeft <= toUp && toLeft <= toUpLeft) return static_cast<uint8_t>(left);
+				return static_cast<uint8_t>(toUp <= toUpLeft ? up : upLeft);
+			}
+
+			//Deflate bits come least significant first
+			class BitReader final
+			{
+			public:
+				BitReader(const uint8_t* dataPtr, size_t size) : m_DataPtr{ dataPtr }, m_Size{ size } {}
+
+				uint32_t GetBits(int count)
+				{
+					while (m_BitCount < count)
+					{
+						if (m_Position == m_Size) m_IsOverrun = true;
+						const uint32_t byte = m_Position < m_Size ? m_DataPtr[m_Position++] : 0;
+						m_BitBuffer |= byte << m_BitCount;
+						m_BitCount += 8;
+					}
+					const uint32_t value = m_BitBuffer & ((1u << count) - 1);
+					m_BitBuffer >>= count;
+					m_BitCount -= count;
+					return value;
+				}
+
+				//bytes are only fetched when needed, so fewer than 8 bits are ever left to drop
+				void AlignToByte()
+				{
+					m_BitBuffer = 0;
+					m_BitCount = 0;
+				}
+
+				const uint8_t* GetBytes(size_t count)
+				{
+					if (m_Size - m_Position < count)
+					{
+						m_IsOverrun = true;
+						return nullptr;
+					}
+					m_Position += count;
+					return m_DataPtr + m_Position - count;
+				}
+
+				bool IsOverrun() const { return m_IsOverrun; }
+
+			private:
+				const uint8_t* m_DataPtr;
+				size_t m_Size;
+				size_t m_Position{};
+				uint32_t m_BitBuffer{};
+				int m_BitCount{};
+				bool m_IsOverrun{};
+			};
+
+			//Canonical Huffman code: how many codes each length has and the symbols sorted by code
+			struct HuffmanTable
+			{
+				std::array<uint16_t, 16> counts{};
+				std::array<uint16_t, 288> symbols{};
+			};
+
+			inline bool BuildHuffmanTable(HuffmanTable& table, const uint8_t* lengthsPtr, int symbolCount)
+			{
+				table.counts.fill(0);
+				for (int symbol{}; symbol < symbolCount; ++symbol) ++table.counts[lengthsPtr[symbol]];
+				table.counts[0] = 0;
+
+				//an over subscribed set of lengths can't be decoded
+				int left{ 1 };
+				for (int length{ 1 }; length < 16; ++length)
+				{
+					left = (left << 1) - table.counts[length];
+					if (left < 0) return false;
+				}
+
+				std::array<uint16_t, 16> offsets{};
+				for (int length{ 1 }; length < 15; ++length) offsets[length + 1] = offsets[length] + table.counts[length];
+				for (int symbol{}; symbol < symbolCount; ++symbol)
+				{
+					if (lengthsPtr[symbol] != 0) table.symbols[offsets[lengthsPtr[symbol]]++] = static_cast<uint16_t>(symbol);
+				}
+				return true;
+			}
+
+			//Walks the code one bit at a time, returns -1 for a code that is not in the table
+			inline int DecodeSymbol(BitReader& reader, const HuffmanTable& table)
+			{
+				int code{}, first{}, index{};
+				for (int length{ 1 }; length < 16; ++length)
+				{
+					code |= static_cast<int>(reader.GetBits(1));
+					const int count = table.counts[length];
+					if (code - first < count) return table.symbols[index + code - first];
+					index += count;
+					first = (first + count) << 1;
+					code <<= 1;
+				}
+				return -1;
+			}
+
+			inline bool InflateCodes(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, std::vector<uint8_t>& output)
+			{
+				while (!reader.IsOverrun())
+				{
+					const int symbol = DecodeSymbol(reader, literals);
+					if (symbol < 0) return false;
+					if (symbol < 256)
+					{
+						output.push_back(static_cast<uint8_t>(symbol));
+						continue;
+					}
+					if (symbol == 256) return true;
+
+					const int lengthCode = symbol - 257;
+					if (lengthCode >= static_cast<int>(lengthBases.size())) return false;
+					const size_t length = lengthBases[lengthCode] + reader.GetBits(lengthExtraBits[lengthCode]);
+
+					const int distanceCode = DecodeSymbol(reader, distances);
+					if (distanceCode < 0 || distanceCode >= static_cast<int>(distanceBases.size())) return false;
+					const size_t distance = distanceBases[distanceCode] + reader.GetBits(distanceExtraBits[distanceCode]);
+					if (distance > output.size()) return false;
+
+					//byte by byte, the match may overlap what it copies
+					const size_t from = output.size() - distance;
+					for (size_t i{}; i < length; ++i) output.push_back(output[from + i]);
+				}
+				return false;
+			}
+
+			inline bool Inflate(const uint8_t* dataPtr, size_t size, std::vector<uint8_t>& output)
+			{
+				BitReader reader{ dataPtr, size };
+				bool isLastBlock{};
+				while (!isLastBlock)
+				{
+					isLastBlock = reader.GetBits(1) != 0;
+					const uint32_t blockType = reader.GetBits(2);
+					if (blockType == 0)
+					{
+						reader.AlignToByte();
+						const uint8_t* headerPtr = reader.GetBytes(4);
+						if (!headerPtr) return false;
+						const uint32_t length = headerPtr[0] | uint32_t{ headerPtr[1] } << 8;
+						const uint32_t invLength = headerPtr[2] | uint32_t{ headerPtr[3] } << 8;
+						if (length != (~invLength & 0xFFFF)) return false;
+						const uint8_t* bytesPtr = reader.GetBytes(length);
+						if (!bytesPtr) return false;
+						output.insert(output.end(), bytesPtr, bytesPtr + length);
+						continue;
+					}
+
+					std::array<uint8_t, 320> lengths{};
+					HuffmanTable literals{};
+					HuffmanTable distances{};
+					if (blockType == 1)
+					{
+						std::fill(lengths.begin(), lengths.begin() + 144, uint8_t{ 8 });
+						std::fill(lengths.begin() + 144, lengths.begin() + 256, uint8_t{ 9 });
+						std::fill(lengths.begin() + 256, lengths.begin() + 280, uint8_t{ 7 });
+						std::fill(lengths.begin() + 280, lengths.begin() + 288, uint8_t{ 8 });
+						std::fill(lengths.begin() + 288, lengths.begin() + 318, uint8_t{ 5 });
+						BuildHuffmanTable(literals, lengths.data(), 288);
+						BuildHuffmanTable(distances, lengths.data() + 288, 30);
+					}
+					else if (blockType == 2)
+					{
+						const int literalCount = static_cast<int>(reader.GetBits(5)) + 257;
+						const int distanceCount = static_cast<int>(reader.GetBits(5)) + 1;
+						const int codeLengthCount = static_cast<int>(reader.GetBits(4)) + 4;
+
+						constexpr std::array<uint8_t, 19> codeLengthOrder{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+						std::array<uint8_t, 19> codeLengths{};
+						for (int i{}; i < codeLengthCount; ++i) codeLengths[codeLengthOrder[i]] = static_cast<uint8_t>(reader.GetBits(3));
+						HuffmanTable codeLengthTable{};
+						if (!BuildHuffmanTable(codeLengthTable, codeLengths.data(), 19)) return false;
+
+						//16 repeats the previous length, 17 and 18 are runs of zeros
+						int index{};
+						while (index < literalCount + distanceCount)
+						{
+							const int symbol = DecodeSymbol(reader, codeLengthTable);
+							if (symbol < 0) return false;
+							if (symbol < 16)
+							{
+								lengths[index++] = static_cast<uint8_t>(symbol);
+								continue;
+							}
+
+							uint8_t repeatedLength{};
+							int repeatCount{};
+							if (symbol == 16)
+							{
+								if (index == 0) return false;
+								repeatedLength = lengths[index - 1];
+								repeatCount = 3 + static_cast<int>(reader.GetBits(2));
+							}
+							else if (symbol == 17) repeatCount = 3 + static_cast<int>(reader.GetBits(3));
+							else repeatCount = 11 + static_cast<int>(reader.GetBits(7));
+							if (index + repeatCount > literalCount + distanceCount) return false;
+							std::fill(lengths.begin() + index, lengths.begin() + index + repeatCount, repeatedLength);
+							index += repeatCount;
+						}
+
+						if (lengths[256] == 0) return false;
+						if (!BuildHuffmanTable(literals, lengths.data(), literalCount)) return false;
+						if (!BuildHuffmanTable(distances, lengths.data() + literalCount, distanceCount)) return false;
+					}
+					else return false;
+
+					if (!InflateCodes(reader, literals, distances, output)) return false;
+				}
+				return !reader.IsOverrun();
+			}
+
+			class BitWriter final
+			{
+			public:
+				explicit BitWriter(std::vector<uint8_t>& output) : m_Output{ output } {}
+
+				void PutBits(uint32_t value, int count)
+				{
+					m_BitBuffer |= value << m_BitCount;
+					m_BitCount += count;
+					while (m_BitCount >= 8)
+					{
+						m_Output.push_back(static_cast<uint8_t>(m_BitBuffer));
+						m_BitBuffer >>= 8;
+						m_BitCount -= 8;
+					}
+				}
+
+				//Huffman codes go out most significant bit first
+				void PutCode(uint32_t code, int length)
+				{
+					uint32_t reversed{};
+					for (int bit{}; bit < length; ++bit) reversed |= (code >> bit & 1) << (length - 1 - bit);
+					PutBits(reversed, length);
+				}
+
+				void PutLiteral(uint32_t symbol)
+				{
+					if (symbol < 144) PutCode(0x30 + symbol, 8);
+					else if (symbol < 256) PutCode(0x190 + symbol - 144, 9);
+					else if (symbol < 280) PutCode(symbol - 256, 7);
+					else PutCode(0xC0 + symbol - 280, 8);
+				}
+
+				void Flush() { PutBits(0, 7); }
+
+			private:
+				std::vector<uint8_t>& m_Output;
+				uint32_t m_BitBuffer{};
+				int m_BitCount{};
+			};
+
+			//One fixed Huffman block, greedy matches against the last position every 3 byte hash was seen at
+			inline void Deflate(const std::vector<uint8_t>& data, std::vector<uint8_t>& output)
+			{
+				constexpr size_t windowSize{ 32768 };
+				constexpr size_t maxMatchLength{ 258 };
+				constexpr int hashBits{ 15 };
+
+				BitWriter writer{ output };
+				writer.PutBits(1, 1);
+				writer.PutBits(1, 2);
+
+				std::vector<int64_t> lastPositions(size_t{ 1 } << hashBits, -1);
+				const auto getHash = [&](size_t position)
+				{
+					const uint32_t bytes = data[position] | uint32_t{ data[position + 1] } << 8 | uint32_t{ data[position + 2] } << 16;
+					return (bytes * 2654435761u) >> (32 - hashBits);
+				};
+
+				size_t position{};
+				while (position < data.size())
+				{
+					size_t matchLength{};
+					size_t matchDistance{};
+					if (position + 3 <= data.size())
+					{
+						const uint32_t hash = getHash(position);
+						const int64_t candidate = lastPositions[hash];
+						lastPositions[hash] = static_cast<int64_t>(position);
+						if (candidate >= 0 && position - static_cast<size_t>(candidate) <= windowSize)
+						{
+							const size_t maxLength = std::min(maxMatchLength, data.size() - position);
+							while (matchLength < maxLength && data[static_cast<size_t>(candidate) + matchLength] == data[position + matchLength]) ++matchLength;
+							matchDistance = position - static_cast<size_t>(candidate);
+						}
+					}
+
+					if (matchLength < 3)
+					{
+						writer.PutLiteral(data[position++]);
+						continue;
+					}
+
+					int lengthCode{ static_cast<int>(lengthBases.size()) - 1 };
+					while (lengthBases[lengthCode] > matchLength) --lengthCode;
+					writer.PutLiteral(257 + static_cast<uint32_t>(lengthCode));
+					writer.PutBits(static_cast<uint32_t>(matchLength - lengthBases[lengthCode]), lengthExtraBits[lengthCode]);
+
+					int distanceCode{ static_cast<int>(distanceBases.size()) - 1 };
+					while (distanceBases[distanceCode] > matchDistance) --distanceCode;
+					writer.PutCode(static_cast<uint32_t>(distanceCode), 5);
+					writer.PutBits(static_cast<uint32_t>(matchDistance - distanceBases[distanceCode]), distanceExtraBits[distanceCode]);
+
+					//the skipped positions still go into the hash table, so later matches can start inside this one
+					for (size_t skipped{ position + 1 }; skipped < position + matchLength && skipped + 3 <= data.size(); ++skipped)
+					{
+						lastPositions[getHash(skipped)] = static_cast<int64_t>(skipped);
+					}
+					position += matchLength;
+				}
+
+				writer.PutLiteral(256);
+				writer.Flush();
+			}
+		}
+
+		inline bool Read(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels)
+		{
+			using namespace Detail;
+
+			std::ifstream file{ path, std::ios::binary };
+			if (!file) return false;
+			const std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+			constexpr std::array<uint8_t, 8> signature{ 137, 80, 78, 71, 13, 10, 26, 10 };
+			if (bytes.size() < signature.size() || !std::equal(signature.begin(), signature.end(), bytes.begin())) return false;
+
+			uint32_t bitDepth{}, colorType{}, interlace{};
+			std::vector<uint8_t> compressed{};
+			std::vector<uint32_t> palette(256, 0xFF000000);
+			width = height = 0;
+			for (size_t position{ signature.size() }; position + 12 <= bytes.size();)
+			{
+				const uint32_t length = ReadBigEndian(&bytes[position]);
+				if (bytes.size() - position - 12 < length) return false;
+				const std::string type{ bytes.begin() + static_cast<std::ptrdiff_t>(position) + 4, bytes.begin() + static_cast<std::ptrdiff_t>(position) + 8 };
+				const uint8_t* dataPtr = &bytes[position + 8];
+				position += 12 + size_t{ length };
+
+				if (type == "IHDR" && length >= 13)
+				{
+					width = ReadBigEndian(dataPtr);
+					height = ReadBigEndian(dataPtr + 4);
+					bitDepth = dataPtr[8];
+					colorType = dataPtr[9];
+					interlace = dataPtr[12];
+				}
+				else if (type == "PLTE")
+				{
+					for (uint32_t entry{}; entry < std::min(length / 3, 256u); ++entry)
+					{
+						palette[entry] = 0xFF000000 | uint32_t{ dataPtr[entry * 3 + 2] } << 16 | uint32_t{ dataPtr[entry * 3 + 1] } << 8 | dataPtr[entry * 3];
+					}
+				}
+				else if (type == "tRNS" && colorType == 3)
+				{
+					for (uint32_t entry{}; entry < std::min(length, 256u); ++entry)
+					{
+						palette[entry] = (palette[entry] & 0x00FFFFFF) | uint32_t{ dataPtr[entry] } << 24;
+					}
+				}
+				else if (type == "IDAT") compressed.insert(compressed.end(), dataPtr, dataPtr + length);
+				else if (type == "IEND") break;
+			}
+
+			//channels per color type: gray, -, RGB, palette, gray alpha, -, RGBA
+			constexpr std::array<uint32_t, 7> channelCounts{ 1, 0, 3, 1, 2, 0, 4 };
+			if (width == 0 || height == 0 || bitDepth != 8 || interlace != 0 || colorType >= channelCounts.size() || channelCounts[colorType] == 0) return false;
+			const uint32_t channelCount = channelCounts[colorType];
+			const size_t rowSize = size_t{ width } * channelCount;
+
+			//2 byte zlib header, the adler32 at the end is left unchecked, the row filters catch most corruption anyway
+			std::vector<uint8_t> filtered{};
+			filtered.reserve((rowSize + 1) * height);
+			if (compressed.size() < 2 || (compressed[0] & 0x0F) != 8 || !Inflate(compressed.data() + 2, compressed.size() - 2, filtered)) return false;
+			if (filtered.size() < (rowSize + 1) * height) return false;
+
+			std::vector<uint8_t> previousRow(rowSize), row(rowSize);
+			pixels.resize(size_t{ width } * height);
+			for (uint32_t y{}; y < height; ++y)
+			{
+				const uint8_t* sourcePtr = &filtered[y * (rowSize + 1)];
+				const uint8_t filter = sourcePtr[0];
+				for (size_t i{}; i < rowSize; ++i)
+				{
+					const int left = i >= channelCount ? row[i - channelCount] : 0;
+					const int up = previousRow[i];
+					const int upLeft = i >= channelCount ? previousRow[i - channelCount] : 0;
+					int predicted{};
+					switch (filter)
+					{
+					case 0: predicted = 0; break;
+					case 1: predicted = left; break;
+					case 2: predicted = up; break;
+					case 3: predicted = (left + up) / 2; break;
+					case 4: predicted = Paeth(left, up, upLeft); break;
+					default: return false;
+					}
+					row[i] = static_cast<uint8_t>(sourcePtr[1 + i] + predicted);
+				}
+
+				for (uint32_t x{}; x < width; ++x)
+				{
+					const uint8_t* texelPtr = &row[size_t{ x } * channelCount];
+					uint32_t& pixel = pixels[size_t{ y } * width + x];
+					switch (colorType)
+					{
+					case 0: pixel = 0xFF000000 | uint32_t{ texelPtr[0] } * 0x010101; break;
+					case 2: pixel = 0xFF000000 | uint32_t{ texelPtr[2] } << 16 | uint32_t{ texelPtr[1] } << 8 | texelPtr[0]; break;
+					case 3: pixel = palette[texelPtr[0]]; break;
+					case 4: pixel = uint32_t{ texelPtr[1] } << 24 | uint32_t{ texelPtr[0] } * 0x010101; break;
+					default: pixel = uint32_t{ texelPtr[3] } << 24 | uint32_t{ texelPtr[2] } << 16 | uint32_t{ texelPtr[1] } << 8 | texelPtr[0]; break;
+					}
+				}
+				std::swap(previousRow, row);
+			}
+			return true;
+		}
+
+		inline bool Write(const std::string& path, uint32_t width, uint32_t height, const uint32_t* pixelsPtr, uint32_t pitch)
+		{
+			using namespace Detail;
+
+			//every row takes the filter with the smallest sum of absolute residuals
+			constexpr size_t channelCount{ 4 };
+			const size_t rowSize = size_t{ width } * channelCount;
+			std::vector<uint8_t> filtered{};
+			filtered.reserve((rowSize + 1) * height);
+			std::vector<uint8_t> previousRow(rowSize), row(rowSize), candidate(rowSize), best(rowSize);
+			for (uint32_t y{}; y < height; ++y)
+			{
+				for (uint32_t x{}; x < width; ++x)
+				{
+					const uint32_t pixel = pixelsPtr[size_t{ y } * pitch + x];
+					for (size_t channel{}; channel < channelCount; ++channel) row[x * channelCount + channel] = static_cast<uint8_t>(pixel >> (channel * 8));
+				}
+
+				uint8_t bestFilter{};
+				uint64_t bestCost{ UINT64_MAX };
+				for (uint8_t filter{}; filter < 5; ++filter)
+				{
+					uint64_t cost{};
+					for (size_t i{}; i < rowSize; ++i)
+					{
+						const int left = i >= channelCount ? row[i - channelCount] : 0;
+						const int up = previousRow[i];
+						const int upLeft = i >= channelCount ? previousRow[i - channelCount] : 0;
+						const int predicted = filter == 0 ? 0 : filter == 1 ? left : filter == 2 ? up : filter == 3 ? (left + up) / 2 : Paeth(left, up, upLeft);
+						candidate[i] = static_cast<uint8_t>(row[i] - predicted);
+						cost += static_cast<uint64_t>(std::abs(static_cast<int8_t>(candidate[i])));
+					}
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestFilter = filter;
+						std::swap(best, candidate);
+					}
+				}
+
+				filtered.push_back(bestFilter);
+				filtered.insert(filtered.end(), best.begin(), best.end());
+				std::swap(previousRow, row);
+			}
+
+			std::vector<uint8_t> zlib{ 0x78, 0x01 };
+			Deflate(filtered, zlib);
+			AppendBigEndian(zlib, Adler32(filtered));
+
+			std::vector<uint8_t> bytes{ 137, 80, 78, 71, 13, 10, 26, 10 };
+			const auto appendChunk = [&](const char* type, const std::vector<uint8_t>& data)
+			{
+				AppendBigEndian(bytes, static_cast<uint32_t>(data.size()));
+				const size_t typeStart = bytes.size();
+				bytes.insert(bytes.end(), type, type + 4);
+				bytes.insert(bytes.end(), data.begin(), data.end());
+				AppendBigEndian(bytes, Crc32(&bytes[typeStart], bytes.size() - typeStart));
+			};
+
+			std::vector<uint8_t> header{};
+			AppendBigEndian(header, width);
+			AppendBigEndian(header, height);
+			header.insert(header.end(), { 8, 6, 0, 0, 0 });
+			appendChunk("IHDR", header);
+			appendChunk("IDAT", zlib);
+			appendChunk("IEND", {});
+
+			std::ofstream file{ path, std::ios::binary };
+			file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			return static_cast<bool>(file);
+		}
+	}
+}
@@ -0,0 +1,347 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "MathHelpers.h"
+#include "Matrix.h"
+#include "Vector3.h"
+
+namespace dae
+{
+	//Axis aligned bounding box, default constructed empty so Grow() can build it up
+	struct Aabb
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		static constexpr Aabb FromCenterExtents(const Vector3& center, const Vector3& extents)
+		{
+			return { center - extents, center + extents };
+		}
+
+		//stride allows reading positions straight out of interleaved vertex data
+		static Aabb FromPoints(const Vector3* pointsPtr, size_t count, size_t stride = sizeof(Vector3))
+		{
+			Aabb box{};
+			const char* bytePtr = reinterpret_cast<const char*>(pointsPtr);
+			for (size_t i{}; i < count; ++i)
+			{
+				box.Grow(*reinterpret_cast<const Vector3*>(bytePtr + i * stride));
+			}
+			return box;
+		}
+
+		constexpr Vector3 GetCenter() const { return (min + max) * 0.5f; }
+		constexpr Vector3 GetExtents() const { return (max - min) * 0.5f; }
+		constexpr bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+		constexpr void Grow(const Vector3& p)
+		{
+			min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+			max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+		}
+
+		constexpr void Grow(const Aabb& box)
+		{
+			Grow(box.min);
+			Grow(box.max);
+		}
+
+		//Arvo's method: transform the center, project the extents on |M|
+		Aabb Transformed(const Matrix& m) const
+		{
+			const Vector3 c = GetCenter();
+			const Vector3 e = GetExtents();
+#if defined(DAE_SSE)
+			const Vector4 m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+			const __m128 r0 = _mm_loadu_ps(&m0.x);
+			const __m128 r1 = _mm_loadu_ps(&m1.x);
+			const __m128 r2 = _mm_loadu_ps(&m2.x);
+			const __m128 r3 = _mm_loadu_ps(&m3.x);
+			const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+			const __m128 center = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(c.x), r0), _mm_mul_ps(_mm_set1_ps(c.y), r1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(c.z), r2), r3));
+			const __m128 extents = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(e.x), _mm_and_ps(r0, absMask)), _mm_mul_ps(_mm_set1_ps(e.y), _mm_and_ps(r1, absMask))),
+				_mm_mul_ps(_mm_set1_ps(e.z), _mm_and_ps(r2, absMask)));
+
+			float minOut[4], maxOut[4];
+			_mm_storeu_ps(minOut, _mm_sub_ps(center, extents));
+			_mm_storeu_ps(maxOut, _mm_add_ps(center, extents));
+			return { { minOut[0], minOut[1], minOut[2] }, { maxOut[0], maxOut[1], maxOut[2] } };
+#else
+			const Vector3 ax = m.GetAxisX(), ay = m.GetAxisY(), az = m.GetAxisZ();
+			const Vector3 newCenter = m.TransformPoint(c);
+			const Vector3 newExtents{
+				std::abs(ax.x) * e.x + std::abs(ay.x) * e.y + std::abs(az.x) * e.z,
+				std::abs(ax.y) * e.x + std::abs(ay.y) * e.y + std::abs(az.y) * e.z,
+				std::abs(ax.z) * e.x + std::abs(ay.z) * e.y + std::abs(az.z) * e.z
+			};
+			return FromCenterExtents(newCenter, newExtents);
+#endif
+		}
+	};
+
+	struct Sphere
+	{
+		Vector3 center{};
+		float radius{};
+
+		static Sphere FromAabb(const Aabb& box)
+		{
+			return { box.GetCenter(), box.GetExtents().Magnitude() };
+		}
+	};
+
+	//Points with Dot(normal, p) + d >= 0 are on the inner side
+	struct Plane
+	{
+		Vector3 normal{};
+		float d{};
+
+		constexpr float Distance(const Vector3& p) const
+		{
+			return Vector3::Dot(normal, p) + d;
+		}
+
+		void Normalize()
+		{
+			const float invLength = 1.f / normal.Magnitude();
+			normal *= invLength;
+			d *= invLength;
+		}
+	};
+
+	struct Frustum
+	{
+		enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+		Plane planes[PlaneCount]{};
+
+		//planes again in SoA layout for the SIMD tests, padded to 8 with planes every point passes
+		alignas(32) float planeX[8]{};
+		alignas(32) float planeY[8]{};
+		alignas(32) float planeZ[8]{};
+		alignas(32) float planeD[8]{ 0, 0, 0, 0, 0, 0, 1, 1 };
+
+		//Gribb/Hartmann extraction for row vectors (clip = v * M) and D3D depth (0 <= z <= w)
+		static Frustum FromViewProjection(const Matrix& m)
+		{
+			const Vector4 c0{ m[0].x, m[1].x, m[2].x, m[3].x };
+			const Vector4 c1{ m[0].y, m[1].y, m[2].y, m[3].y };
+			const Vector4 c2{ m[0].z, m[1].z, m[2].z, m[3].z };
+			const Vector4 c3{ m[0].w, m[1].w, m[2].w, m[3].w };
+
+			const Vector4 equations[PlaneCount]{ c3 + c0, c3 - c0, c3 + c1, c3 - c1, c2, c3 - c2 };
+
+			Frustum frustum{};
+			for (int i{}; i < PlaneCount; ++i)
+			{
+				Plane& plane = frustum.planes[i];
+				plane.normal = equations[i].GetXYZ();
+				plane.d = equations[i].w;
+				plane.Normalize();
+
+				frustum.planeX[i] = plane.normal.x;
+				frustum.planeY[i] = plane.normal.y;
+				frustum.planeZ[i] = plane.normal.z;
+				frustum.planeD[i] = plane.d;
+			}
+			return frustum;
+		}
+
+		bool Intersects(const Aabb& box) const
+		{
+			const Vector3 c = box.GetCenter();
+			const Vector3 e = box.GetExtents();
+			for (const Plane& plane : planes)
+			{
+				const float radius = std::abs(plane.normal.x) * e.x + std::abs(plane.normal.y) * e.y + std::abs(plane.normal.z) * e.z;
+				if (plane.Distance(c) + radius < 0.f) return false;
+			}
+			return true;
+		}
+
+		//all 6 planes tested at once
+		bool Intersects(const Sphere& sphere) const
+		{
+#if defined(DAE_AVX)
+			const __m256 dist = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(planeX), _mm256_set1_ps(sphere.center.x)), _mm256_mul_ps(_mm256_load_ps(planeY), _mm256_set1_ps(sphere.center.y))),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(planeZ), _mm256_set1_ps(sphere.center.z)), _mm256_load_ps(planeD)));
+			return _mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_set1_ps(-sphere.radius), _CMP_LT_OQ)) == 0;
+#elif defined(DAE_SSE)
+			const __m128 cx = _mm_set1_ps(sphere.center.x);
+			const __m128 cy = _mm_set1_ps(sphere.center.y);
+			const __m128 cz = _mm_set1_ps(sphere.center.z);
+			const __m128 negRadius = _mm_set1_ps(-sphere.radius);
+
+			int outsideMask{};
+			for (int i{}; i < 8; i += 4)
+			{
+				const __m128 dist = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_load_ps(planeX + i), cx), _mm_mul_ps(_mm_load_ps(planeY + i), cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_load_ps(planeZ + i), cz), _mm_load_ps(planeD + i)));
+				outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(dist, negRadius));
+			}
+			return outsideMask == 0;
+#else
+			for (const Plane& plane : planes)
+			{
+				if (plane.Distance(sphere.center) < -sphere.radius) return false;
+			}
+			return true;
+#endif
+		}
+	};
+
+	//Bounds stored as center/extents streams so the batched cull reads them with plain vector loads
+	struct AabbSoA
+	{
+		std::vector<float> centerX{};
+		std::vector<float> centerY{};
+		std::vector<float> centerZ{};
+		std::vector<float> extentX{};
+		std::vector<float> extentY{};
+		std::vector<float> extentZ{};
+
+		size_t Size() const { return centerX.size(); }
+
+		void Resize(size_t size)
+		{
+			for (std::vector<float>* streamPtr : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+			{
+				streamPtr->resize(size);
+			}
+		}
+
+		void Set(size_t index, const Aabb& box)
+		{
+			const Vector3 c = box.GetCenter();
+			const Vector3 e = box.GetExtents();
+			centerX[index] = c.x; centerY[index] = c.y; centerZ[index] = c.z;
+			extentX[index] = e.x; extentY[index] = e.y; extentZ[index] = e.z;
+		}
+
+		Aabb Get(size_t index) const
+		{
+			return Aabb::FromCenterExtents({ centerX[index], centerY[index], centerZ[index] }, { extentX[index], extentY[index], extentZ[index] });
+		}
+
+		void PushBack(const Aabb& box)
+		{
+			Resize(Size() + 1);
+			Set(Size() - 1, box);
+		}
+	};
+
+	//Writes 1 to visibilityPtr[i] for every box in [begin, end) that intersects the frustum, 0 otherwise
+	//Returns the number of visible boxes. Boxes are tested 8 at a time against all planes.
+	inline size_t CullAabbs(const Frustum& frustum, const AabbSoA& bounds, uint8_t* visibilityPtr, size_t begin, size_t end)
+	{
+		size_t visibleCount{};
+		size_t i{ begin };
+
+#if defined(DAE_AVX)
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		for (; i + 8 <= end; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(bounds.centerX.data() + i);
+			const __m256 cy = _mm256_loadu_ps(bounds.centerY.data() + i);
+			const __m256 cz = _mm256_loadu_ps(bounds.centerZ.data() + i);
+			const __m256 ex = _mm256_loadu_ps(bounds.extentX.data() + i);
+			const __m256 ey = _mm256_loadu_ps(bounds.extentY.data() + i);
+			const __m256 ez = _mm256_loadu_ps(bounds.extentZ.data() + i);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (int p{}; p < Frustum::PlaneCount; ++p)
+			{
+				const __m256 nx = _mm256_set1_ps(frustum.planeX[p]);
+				const __m256 ny = _mm256_set1_ps(frustum.planeY[p]);
+				const __m256 nz = _mm256_set1_ps(frustum.planeZ[p]);
+
+				const __m256 dist = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+					_mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(frustum.planeD[p])));
+				const __m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(_mm256_and_ps(nx, absMask), ex), _mm256_mul_ps(_mm256_and_ps(ny, absMask), ey)),
+					_mm256_mul_ps(_mm256_and_ps(nz, absMask), ez));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			const int visibleBits = ~_mm256_movemask_ps(outside) & 0xff;
+			for (int lane{}; lane < 8; ++lane)
+			{
+				visibilityPtr[i + lane] = static_cast<uint8_t>((visibleBits >> lane) & 1);
+			}
+			visibleCount += std::popcount(static_cast<unsigned>(visibleBits));
+		}
+#elif defined(DAE_SSE)
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		for (; i + 8 <= end; i += 8)
+		{
+			//two 4-wide halves per block of 8
+			int outsideBits{};
+			for (int half{}; half < 2; ++half)
+			{
+				const size_t base = i + half * 4;
+				const __m128 cx = _mm_loadu_ps(bounds.centerX.data() + base);
+				const __m128 cy = _mm_loadu_ps(bounds.centerY.data() + base);
+				const __m128 cz = _mm_loadu_ps(bounds.centerZ.data() + base);
+				const __m128 ex = _mm_loadu_ps(bounds.extentX.data() + base);
+				const __m128 ey = _mm_loadu_ps(bounds.extentY.data() + base);
+				const __m128 ez = _mm_loadu_ps(bounds.extentZ.data() + base);
+
+				__m128 outside = _mm_setzero_ps();
+				for (int p{}; p < Frustum::PlaneCount; ++p)
+				{
+					const __m128 nx = _mm_set1_ps(frustum.planeX[p]);
+					const __m128 ny = _mm_set1_ps(frustum.planeY[p]);
+					const __m128 nz = _mm_set1_ps(frustum.planeZ[p]);
+
+					const __m128 dist = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+						_mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(frustum.planeD[p])));
+					const __m128 radius = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, absMask), ex), _mm_mul_ps(_mm_and_ps(ny, absMask), ey)),
+						_mm_mul_ps(_mm_and_ps(nz, absMask), ez));
+
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+				}
+				outsideBits |= _mm_movemask_ps(outside) << (half * 4);
+			}
+
+			const int visibleBits = ~outsideBits & 0xff;
+			for (int lane{}; lane < 8; ++lane)
+			{
+				visibilityPtr[i + lane] = static_cast<uint8_t>((visibleBits >> lane) & 1);
+			}
+			visibleCount += std::popcount(static_cast<unsigned>(visibleBits));
+		}
+#endif
+
+		//scalar tail (and fallback)
+		for (; i < end; ++i)
+		{
+			const Vector3 c{ bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i] };
+			const Vector3 e{ bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i] };
+			const bool isVisible = frustum.Intersects(Aabb::FromCenterExtents(c, e));
+			visibilityPtr[i] = static_cast<uint8_t>(isVisible);
+			visibleCount += isVisible;
+		}
+
+		return visibleCount;
+	}
+
+	//Every box of bounds
+	inline size_t CullAabbs(const Frustum& frustum, const AabbSoA& bounds, uint8_t* visibilityPtr)
+	{
+		return CullAabbs(frustum, bounds, visibilityPtr, 0, bounds.Size());
+	}
+}
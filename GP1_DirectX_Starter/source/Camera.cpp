@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "Camera.h"
+#include "Profiler.h"
+
+#include <cassert>
 
 Camera::Camera(const Vector3& origin, float fovAngle, float aspectRatio, Vector3 target):
 	m_Origin{ origin },
@@ -25,6 +28,9 @@ void Camera::CalculateViewMatrix()
 	//ONB => invViewMatrix
 	//Inverse(ONB) => ViewMatrix
 
+	//keep the basis orthonormal so the cheap rigid inverse is exact (refocusing lerps forward)
+	m_Forward.Normalize();
+
 	m_Right = Vector3::Cross(Vector3::UnitY, m_Forward);
 	m_Right.Normalize();
 
@@ -38,7 +44,8 @@ void Camera::CalculateViewMatrix()
 		{ m_Origin.x	, m_Origin.y	, m_Origin.z	, 1}
 	};
 
-	m_InvViewMatrix = Matrix::Inverse(m_ViewMatrix);
+	assert(Matrix::Classify(m_ViewMatrix) == MatrixKind::Rigid);
+	m_InvViewMatrix = Matrix::InverseRigid(m_ViewMatrix);
 
 	//ViewMatrix => Matrix::CreateLookAtLH(...) [not implemented yet]
 	//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
@@ -56,6 +63,8 @@ void Camera::CalculateProjectionMatrix()
 
 void Camera::CalculateViewMatrixTargetRotation()
 {
+	m_Forward.Normalize();
+
 	m_Right = Vector3::Cross(Vector3::UnitY, m_Forward);
 	m_Right.Normalize();
 
@@ -71,11 +80,13 @@ void Camera::CalculateViewMatrixTargetRotation()
 		{ m_RotationOrigin.x	, m_RotationOrigin.y	, m_RotationOrigin.z	, 1}
 	};
 
-	m_InvViewMatrix = Matrix::Inverse(m_ViewMatrix);
+	assert(Matrix::Classify(m_ViewMatrix) == MatrixKind::Rigid);
+	m_InvViewMatrix = Matrix::InverseRigid(m_ViewMatrix);
 }
 
 void Camera::Update(const Timer* pTimer)
 {
+	DAE_PROFILE_FUNCTION();
 	const float deltaTime = pTimer->GetElapsed();
 
 	//Camera Update Logic
@@ -253,3 +264,16 @@ void Camera::UpdateFOV(float increment)
 	m_FovValue = tanf(m_FovAngle * TO_RADIANS / 2.f);
 	CalculateProjectionMatrix();
 }
+
+void Camera::SetLookAt(const Vector3& origin, const Vector3& target)
+{
+	m_Origin = origin;
+	m_Target = target;
+	m_Forward = (target - origin).Normalized();
+
+	// keep mouse look continuous with the new direction
+	m_TotalPitch = asinf(m_Forward.y);
+	m_TotalYaw = atan2f(m_Forward.x, m_Forward.z);
+
+	CalculateViewMatrix();
+}
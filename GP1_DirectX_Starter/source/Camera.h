@@ -12,11 +12,16 @@ public:
 	Matrix& GetInvViewMatrix() { return m_InvViewMatrix; }
 	Matrix& GetProjectionMatrix() { return m_ProjectionMatrix; }
 	Vector3& GetOrigin() { return m_Origin; }
+	Matrix GetViewProjectionMatrix() const { return m_InvViewMatrix * m_ProjectionMatrix; }
+	Frustum GetFrustum() const { return Frustum::FromViewProjection(GetViewProjectionMatrix()); }
 
 	void Update(const Timer* pTimer);
 
 	void UpdateFOV(float increment);
 
+	//Places the camera at origin looking at target, for scripted paths
+	void SetLookAt(const Vector3& origin, const Vector3& target);
+
 private:
 	Vector3 m_Origin{};
 	Vector3 m_Target{};
@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace dae
+{
+	//A contiguous run of the sorted render queue, recorded as one command list
+	struct CommandChunk
+	{
+		uint32_t firstCommand{};
+		uint32_t commandCount{};
+	};
+
+	//Receives the chunks of a frame: RecordChunk runs on worker threads, ExecuteChunks on the submitting thread
+	class CommandBackend
+	{
+	public:
+		virtual ~CommandBackend() = default;
+
+		//how many chunks can be recorded at the same time, one recording context each
+		virtual uint32_t GetMaxChunkCount() const = 0;
+
+		//Records the commands of one chunk, chunkIndex is unique within a frame and below GetMaxChunkCount()
+		virtual void RecordChunk(uint32_t chunkIndex, const CommandChunk& chunk) = 0;
+
+		//Plays chunks [0, chunkCount) back in chunk order, so the queue order survives the parallel recording
+		virtual void ExecuteChunks(uint32_t chunkCount) = 0;
+	};
+
+	//Splits a sorted queue into contiguous chunks, records them in parallel and executes them in order
+	class ParallelCommandRecorder final
+	{
+	public:
+		//fewer commands than this per chunk costs more in command list overhead than recording saves
+		explicit ParallelCommandRecorder(uint32_t minChunkSize = 256, JobSystem& jobSystem = JobSystem::Get())
+			: m_JobSystem{ jobSystem }, m_MinChunkSize{ std::max(minChunkSize, 1u) } {}
+
+		//Returns the number of chunks used
+		uint32_t Record(CommandBackend& backend, uint32_t commandCount);
+
+		//At most maxChunkCount chunks of at least minChunkSize commands, sizes differ by at most one
+		static void Split(uint32_t commandCount, uint32_t maxChunkCount, uint32_t minChunkSize, std::vector<CommandChunk>& chunks);
+
+		const std::vector<CommandChunk>& GetChunks() const { return m_Chunks; }
+
+	private:
+		JobSystem& m_JobSystem;
+		uint32_t m_MinChunkSize;
+		std::vector<CommandChunk> m_Chunks{};
+	};
+
+	inline uint32_t ParallelCommandRecorder::Record(CommandBackend& backend, uint32_t commandCount)
+	{
+		Split(commandCount, backend.GetMaxChunkCount(), m_MinChunkSize, m_Chunks);
+
+		const uint32_t chunkCount = static_cast<uint32_t>(m_Chunks.size());
+		m_JobSystem.ParallelFor(chunkCount, [&](uint32_t chunkIndex) { backend.RecordChunk(chunkIndex, m_Chunks[chunkIndex]); });
+		backend.ExecuteChunks(chunkCount);
+		return chunkCount;
+	}
+
+	inline void ParallelCommandRecorder::Split(uint32_t commandCount, uint32_t maxChunkCount, uint32_t minChunkSize, std::vector<CommandChunk>& chunks)
+	{
+		chunks.clear();
+		if (commandCount == 0 || maxChunkCount == 0) return;
+
+		const uint32_t chunkCount = std::clamp(commandCount / std::max(minChunkSize, 1u), 1u, maxChunkCount);
+		const uint32_t baseSize = commandCount / chunkCount;
+		const uint32_t remainder = commandCount % chunkCount;
+
+		uint32_t firstCommand{};
+		for (uint32_t chunk{}; chunk < chunkCount; ++chunk)
+		{
+			const uint32_t size = baseSize + (chunk < remainder ? 1 : 0);
+			chunks.push_back({ firstCommand, size });
+			firstCommand += size;
+		}
+	}
+
+	//Backend that only remembers what it was given, to check partitioning and ordering without a device
+	class RecordingCommandBackend final : public CommandBackend
+	{
+	public:
+		explicit RecordingCommandBackend(uint32_t maxChunkCount) : m_RecordedChunks(maxChunkCount) {}
+
+		uint32_t GetMaxChunkCount() const override { return static_cast<uint32_t>(m_RecordedChunks.size()); }
+
+		void RecordChunk(uint32_t chunkIndex, const CommandChunk& chunk) override
+		{
+			std::vector<uint32_t>& commands = m_RecordedChunks[chunkIndex];
+			commands.clear();
+			for (uint32_t command{ chunk.firstCommand }; command < chunk.firstCommand + chunk.commandCount; ++command)
+			{
+				commands.push_back(command);
+			}
+
+			std::lock_guard lock{ m_Mutex };
+			m_RecordOrder.push_back(chunkIndex);
+		}
+
+		void ExecuteChunks(uint32_t chunkCount) override
+		{
+			m_ExecutedCommands.clear();
+			for (uint32_t chunk{}; chunk < chunkCount; ++chunk)
+			{
+				m_ExecutedCommands.insert(m_ExecutedCommands.end(), m_RecordedChunks[chunk].begin(), m_RecordedChunks[chunk].end());
+			}
+		}
+
+		//command indices in the order they would reach the device
+		const std::vector<uint32_t>& GetExecutedCommands() const { return m_ExecutedCommands; }
+		//chunk indices in the order the workers recorded them, any order is valid
+		const std::vector<uint32_t>& GetRecordOrder() const { return m_RecordOrder; }
+		void ClearRecordOrder() { m_RecordOrder.clear(); }
+
+	private:
+		std::vector<std::vector<uint32_t>> m_RecordedChunks{};
+		std::vector<uint32_t> m_ExecutedCommands{};
+		std::vector<uint32_t> m_RecordOrder{};
+		std::mutex m_Mutex{};
+	};
+}
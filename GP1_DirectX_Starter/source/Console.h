@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace dae
+{
+	namespace Console
+	{
+		//Win32 attribute layout: background color in the high nibble, text color in the low nibble
+		//Consoles without attributes print the text uncolored
+		inline void SetTextAttribute(uint16_t attribute)
+		{
+#if defined(_WIN32)
+			SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), attribute);
+#else
+			(void)attribute;
+#endif
+		}
+
+		//Prints "<label> true" in green or "<label> false" in dark red, the label itself in red
+		inline void PrintToggle(const char* label, bool isEnabled)
+		{
+			SetTextAttribute(0x0c);
+			std::cout << label << ' ';
+
+			SetTextAttribute(isEnabled ? 0x0a : 0x04);
+			std::cout << std::boolalpha << isEnabled << std::endl;
+
+			SetTextAttribute(0x07);
+		}
+	}
+}
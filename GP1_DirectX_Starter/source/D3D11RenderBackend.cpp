@@ -0,0 +1,334 @@
+#include "pch.h"
+#include "D3D11RenderBackend.h"
+
+#include "FireFXEffect.h"
+#include "JobSystem.h"
+#include "VehicleEffect.h"
+
+D3D11RenderBackend::D3D11RenderBackend(SDL_Window* windowPtr)
+	: m_WindowPtr{ windowPtr }
+{
+	SDL_GetWindowSize(windowPtr, &m_Width, &m_Height);
+
+	//Initialize DirectX pipeline
+	const HRESULT result = InitializeDirectX();
+	if (result == S_OK)
+	{
+		m_IsInitialized = true;
+		std::cout << "DirectX is initialized and ready!\n";
+	}
+	else
+	{
+		std::cout << "DirectX initialization failed!\n";
+	}
+
+	m_InstanceBufferPtr = std::make_unique<InstanceBuffer>(static_cast<uint32_t>(sizeof(dae::Matrix)));
+	m_ImmediateContextPtr = std::make_unique<Context>(*this, m_DeviceContextPtr, m_Materials);
+
+	if (m_IsInitialized)
+	{
+		InitializeCommandBackend();
+	}
+}
+
+D3D11RenderBackend::~D3D11RenderBackend()
+{
+	// release the GPU resources before the device
+	m_CommandBackendPtr.reset();
+	m_ChunkMaterials.clear();
+	m_Meshes.clear();
+	m_Materials.clear();
+	m_InstanceBufferPtr.reset();
+
+	if (m_DevicePtr)
+	{
+		m_DevicePtr->Release();
+	}
+
+	if(m_DeviceContextPtr)
+	{
+		m_DeviceContextPtr->ClearState();
+		m_DeviceContextPtr->Flush();
+		m_DeviceContextPtr->Release();
+	}
+
+	if (m_SwapChainPtr)
+	{
+		m_SwapChainPtr->Release();
+	}
+
+	if (m_DepthStencilBufferPtr)
+	{
+		m_DepthStencilBufferPtr->Release();
+	}
+
+	if (m_DepthStencilViewPtr)
+	{
+		m_DepthStencilViewPtr->Release();
+	}
+
+	if (m_RenderTargetBufferPtr)
+	{
+		m_RenderTargetBufferPtr->Release();
+	}
+
+	if (m_RenderTargetViewPtr)
+	{
+		m_RenderTargetViewPtr->Release();
+	}
+}
+
+dae::MeshHandle D3D11RenderBackend::CreateMesh(const std::vector<dae::MeshVertex>& vertices, const std::vector<uint32_t>& indices, dae::MaterialHandle material)
+{
+	m_Meshes.push_back(std::make_unique<Mesh>(m_DevicePtr, vertices, indices, m_Materials[material].get()));
+	return static_cast<dae::MeshHandle>(m_Meshes.size() - 1);
+}
+
+void D3D11RenderBackend::UpdateIndices(dae::MeshHandle mesh, const std::vector<uint32_t>& indices)
+{
+	if (!m_IsInitialized) return;
+	m_Meshes[mesh]->UpdateIndices(m_DeviceContextPtr, indices);
+}
+
+void D3D11RenderBackend::UploadInstances(const dae::Matrix* worldMatricesPtr, uint32_t count)
+{
+	if (!m_IsInitialized) return;
+	m_InstanceBufferPtr->Upload(m_DevicePtr, m_DeviceContextPtr, worldMatricesPtr, count);
+}
+
+dae::MaterialHandle D3D11RenderBackend::CreateMaterial(dae::MaterialType type)
+{
+	switch (type)
+	{
+	case dae::MaterialType::FireFX:
+		m_Materials.push_back(std::make_unique<FireFXEffect>(m_DevicePtr));
+		break;
+	case dae::MaterialType::Vehicle:
+	default:
+		m_Materials.push_back(std::make_unique<VehicleEffect>(m_DevicePtr));
+		break;
+	}
+	m_MaterialTypes.push_back(type);
+	return static_cast<dae::MaterialHandle>(m_Materials.size() - 1);
+}
+
+void D3D11RenderBackend::SetCameraPosition(const dae::Vector3& position)
+{
+	ForEachMaterial([&position](const BaseEffect* materialPtr, dae::MaterialHandle)
+	{
+		materialPtr->GetCameraPos()->SetFloatVector(reinterpret_cast<const float*>(&position));
+	});
+}
+
+void D3D11RenderBackend::SetSamplerState(int state)
+{
+	ForEachMaterial([this, state](const BaseEffect* materialPtr, dae::MaterialHandle)
+	{
+		materialPtr->SetSamplerState(m_DevicePtr, state);
+	});
+}
+
+void D3D11RenderBackend::SetUseNormalMap(bool useNormalMap)
+{
+	ForEachMaterial([this, useNormalMap](const BaseEffect* materialPtr, dae::MaterialHandle material)
+	{
+		if (m_MaterialTypes[material] != dae::MaterialType::Vehicle) return;
+		static_cast<const VehicleEffect*>(materialPtr)->SetUseNormalMap(useNormalMap);
+	});
+}
+
+void D3D11RenderBackend::BeginFrame()
+{
+	// clear RTV & DSV
+	constexpr float color[4] = {0.39f, 0.59f, 0.93f, 1.f};
+	m_DeviceContextPtr->ClearRenderTargetView(m_RenderTargetViewPtr, color);
+	m_DeviceContextPtr->ClearDepthStencilView(m_DepthStencilViewPtr, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+}
+
+void D3D11RenderBackend::EndFrame()
+{
+	// present back buffer (swap)
+	m_SwapChainPtr->Present(0, 0);
+}
+
+uint32_t D3D11RenderBackend::GetMaxChunkCount() const
+{
+	return m_CommandBackendPtr ? m_CommandBackendPtr->GetMaxChunkCount() : 0;
+}
+
+uint32_t D3D11RenderBackend::RecordParallel(uint32_t commandCount, const dae::RecordChunkFunction& recordChunk)
+{
+	if (!m_CommandBackendPtr) return 0;
+
+	CloneChunkMaterials();
+
+	m_RecordChunkPtr = &recordChunk;
+	const uint32_t chunkCount{ m_CommandRecorder.Record(*m_CommandBackendPtr, commandCount) };
+	m_RecordChunkPtr = nullptr;
+
+	// executing the command lists cleared the state of the immediate context
+	BindRenderTargets(m_DeviceContextPtr);
+	return chunkCount;
+}
+
+HRESULT D3D11RenderBackend::InitializeDirectX()
+{
+	// create device & deviceContext
+	constexpr D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+	uint32_t createDeviceFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+	createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+	HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, createDeviceFlags, &featureLevel,
+		1, D3D11_SDK_VERSION, &m_DevicePtr, nullptr, &m_DeviceContextPtr);
+	if (FAILED(result)) return result;
+
+	// create DGXIFactory
+	IDXGIFactory1* dxgiFactoryPtr{};
+	result = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&dxgiFactoryPtr));
+
+	if (FAILED(result)) return result;
+
+	// Create a swap chain
+	DXGI_SWAP_CHAIN_DESC swapChainDesc{};
+	swapChainDesc.BufferDesc.Width = m_Width;
+	swapChainDesc.BufferDesc.Height = m_Height;
+	swapChainDesc.BufferDesc.RefreshRate.Numerator = 1;
+	swapChainDesc.BufferDesc.RefreshRate.Denominator = 60;
+	swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+	swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+	swapChainDesc.SampleDesc.Count = 1;
+	swapChainDesc.SampleDesc.Quality = 0;
+	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swapChainDesc.BufferCount = 1;
+	swapChainDesc.Windowed = true;
+	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+	swapChainDesc.Flags = 0;
+
+	// get the handle from the SDL backBuffer
+	SDL_SysWMinfo sysWMInfo{};
+	SDL_GetVersion(&sysWMInfo.version);
+	SDL_GetWindowWMInfo(m_WindowPtr, &sysWMInfo);
+	swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
+
+	// Create swap chain
+	result = dxgiFactoryPtr->CreateSwapChain(m_DevicePtr, &swapChainDesc, &m_SwapChainPtr);
+
+	dxgiFactoryPtr->Release();
+	if (FAILED(result)) return result;
+
+	//3. Create DepthStencil (DS) & DepthStencilView (DSV)
+	//Resource
+	D3D11_TEXTURE2D_DESC depthStencilDesc{};
+	depthStencilDesc.Width = m_Width;
+	depthStencilDesc.Height = m_Height;
+	depthStencilDesc.MipLevels = 1;
+	depthStencilDesc.ArraySize = 1;
+	depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilDesc.SampleDesc.Count = 1;
+	depthStencilDesc.SampleDesc.Quality = 0;
+	depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+	depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	depthStencilDesc.CPUAccessFlags = 0;
+	depthStencilDesc.MiscFlags = 0;
+
+	//View
+	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
+	depthStencilViewDesc.Format = depthStencilDesc.Format;
+	depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	depthStencilViewDesc.Texture2D.MipSlice = 0;
+
+	result = m_DevicePtr->CreateTexture2D(&depthStencilDesc, nullptr, &m_DepthStencilBufferPtr);
+	if (FAILED(result)) return result;
+
+	result = m_DevicePtr->CreateDepthStencilView(m_DepthStencilBufferPtr, &depthStencilViewDesc, &m_DepthStencilViewPtr);
+	if (FAILED(result)) return result;
+
+	// Create renderTarget and renderTargetView
+	// resource
+	result = m_SwapChainPtr->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_RenderTargetBufferPtr));
+	if (FAILED(result)) return result;
+
+	// view
+	result = m_DevicePtr->CreateRenderTargetView(m_RenderTargetBufferPtr, nullptr, &m_RenderTargetViewPtr);
+	if (FAILED(result)) return result;
+
+	// bind renderTargetView and depthStencilView to output merger stage, set viewport
+	BindRenderTargets(m_DeviceContextPtr);
+
+	return S_OK;
+}
+
+void D3D11RenderBackend::BindRenderTargets(ID3D11DeviceContext* deviceContextPtr) const
+{
+	deviceContextPtr->OMSetRenderTargets(1, &m_RenderTargetViewPtr, m_DepthStencilViewPtr);
+
+	D3D11_VIEWPORT viewport{};
+	viewport.Width = static_cast<float>(m_Width);
+	viewport.Height = static_cast<float>(m_Height);
+	viewport.TopLeftX = 0.f;
+	viewport.TopLeftY = 0.f;
+	viewport.MinDepth = 0.f;
+	viewport.MaxDepth = 1.f;
+
+	deviceContextPtr->RSSetViewports(1, &viewport);
+}
+
+void D3D11RenderBackend::InitializeCommandBackend()
+{
+	// one deferred context per job system thread, the calling thread records a chunk as well
+	const uint32_t contextCount{ dae::JobSystem::Get().GetThreadCount() };
+	m_CommandBackendPtr = std::make_unique<DeferredCommandBackend>(m_DevicePtr, m_DeviceContextPtr, contextCount,
+		[this](ID3D11DeviceContext* deviceContextPtr, uint32_t chunkIndex, const dae::CommandChunk& chunk)
+		{
+			// deferred contexts start from the default state
+			BindRenderTargets(deviceContextPtr);
+			Context context{ *this, deviceContextPtr, m_ChunkMaterials[chunkIndex] };
+			(*m_RecordChunkPtr)(context, chunkIndex, chunk);
+		});
+
+	m_ChunkMaterials.resize(m_CommandBackendPtr->GetMaxChunkCount());
+}
+
+void D3D11RenderBackend::CloneChunkMaterials()
+{
+	for (std::vector<std::unique_ptr<BaseEffect>>& chunkMaterials : m_ChunkMaterials)
+	{
+		for (size_t material{ chunkMaterials.size() }; material < m_Materials.size(); ++material)
+		{
+			chunkMaterials.push_back(m_Materials[material]->Clone());
+		}
+	}
+}
+
+void D3D11RenderBackend::ForEachMaterial(const std::function<void(const BaseEffect*, dae::MaterialHandle)>& function) const
+{
+	for (dae::MaterialHandle material{}; material < m_Materials.size(); ++material)
+	{
+		function(m_Materials[material].get(), material);
+		for (const std::vector<std::unique_ptr<BaseEffect>>& chunkMaterials : m_ChunkMaterials)
+		{
+			if (material < chunkMaterials.size() && chunkMaterials[material]) function(chunkMaterials[material].get(), material);
+		}
+	}
+}
+
+void D3D11RenderBackend::Context::BindMesh(dae::MeshHandle mesh, bool isInstanced)
+{
+	const Mesh* meshPtr = m_Backend.m_Meshes[mesh].get();
+	if (isInstanced) meshPtr->BindInstanced(m_DeviceContextPtr, m_Backend.m_InstanceBufferPtr->GetBuffer());
+	else meshPtr->Bind(m_DeviceContextPtr);
+}
+
+void D3D11RenderBackend::Context::Draw(dae::MeshHandle mesh, dae::MaterialHandle material, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix)
+{
+	m_Backend.m_Meshes[mesh]->Draw(m_DeviceContextPtr, m_Materials[material].get(), worldMatrix, worldViewProjectionMatrix);
+}
+
+void D3D11RenderBackend::Context::DrawInstanced(dae::MeshHandle mesh, dae::MaterialHandle material, const dae::Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount)
+{
+	const BaseEffect* materialPtr = m_Materials[material].get();
+	materialPtr->GetViewProjMatrix()->SetMatrix(reinterpret_cast<const float*>(&viewProjectionMatrix));
+	m_Backend.m_Meshes[mesh]->DrawInstanced(m_DeviceContextPtr, materialPtr, firstInstance, instanceCount);
+}
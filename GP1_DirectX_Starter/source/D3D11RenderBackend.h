@@ -0,0 +1,98 @@
+#pragma once
+#include "BaseEffect.h"
+#include "CommandBackend.h"
+#include "DeferredCommandBackend.h"
+#include "InstanceBuffer.h"
+#include "Mesh.h"
+#include "RenderBackend.h"
+struct SDL_Window;
+
+//RenderBackend on D3D11 + Effects11: owns the device, the swap chain with its targets, the meshes and the effects
+//Parallel recording uses one deferred context per job system thread, every chunk draws with its own clones of the effects
+//because effect variables are not thread safe
+class D3D11RenderBackend final : public dae::RenderBackend
+{
+public:
+	explicit D3D11RenderBackend(SDL_Window* windowPtr);
+	~D3D11RenderBackend() override;
+
+	D3D11RenderBackend(const D3D11RenderBackend&) = delete;
+	D3D11RenderBackend(D3D11RenderBackend&&) noexcept = delete;
+	D3D11RenderBackend& operator=(const D3D11RenderBackend&) = delete;
+	D3D11RenderBackend& operator=(D3D11RenderBackend&&) noexcept = delete;
+
+	bool IsInitialized() const { return m_IsInitialized; }
+
+	dae::MeshHandle CreateMesh(const std::vector<dae::MeshVertex>& vertices, const std::vector<uint32_t>& indices, dae::MaterialHandle material) override;
+	void UpdateIndices(dae::MeshHandle mesh, const std::vector<uint32_t>& indices) override;
+	void UploadInstances(const dae::Matrix* worldMatricesPtr, uint32_t count) override;
+
+	dae::MaterialHandle CreateMaterial(dae::MaterialType type) override;
+	bool IsTransparent(dae::MaterialHandle material) const override { return m_Materials[material]->IsTransparent(); }
+	bool SupportsInstancing(dae::MaterialHandle material) const override { return m_Materials[material]->GetInstancedTechnique() != nullptr; }
+	void SetCameraPosition(const dae::Vector3& position) override;
+	void SetSamplerState(int state) override;
+	void SetUseNormalMap(bool useNormalMap) override;
+
+	void BeginFrame() override;
+	void EndFrame() override;
+	dae::RenderContext& GetImmediateContext() override { return *m_ImmediateContextPtr; }
+
+	uint32_t GetMaxChunkCount() const override;
+	uint32_t RecordParallel(uint32_t commandCount, const dae::RecordChunkFunction& recordChunk) override;
+
+private:
+	//Draws on one device context with one set of effects
+	class Context final : public dae::RenderContext
+	{
+	public:
+		Context(const D3D11RenderBackend& backend, ID3D11DeviceContext* deviceContextPtr, const std::vector<std::unique_ptr<BaseEffect>>& materials)
+			: m_Backend{ backend }, m_DeviceContextPtr{ deviceContextPtr }, m_Materials{ materials } {}
+
+		void BindMesh(dae::MeshHandle mesh, bool isInstanced) override;
+		void Draw(dae::MeshHandle mesh, dae::MaterialHandle material, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix) override;
+		void DrawInstanced(dae::MeshHandle mesh, dae::MaterialHandle material, const dae::Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount) override;
+
+	private:
+		const D3D11RenderBackend& m_Backend;
+		ID3D11DeviceContext* m_DeviceContextPtr;
+		const std::vector<std::unique_ptr<BaseEffect>>& m_Materials;
+	};
+
+	SDL_Window*				m_WindowPtr{};
+	ID3D11Device*			m_DevicePtr{};
+	ID3D11DeviceContext*	m_DeviceContextPtr{};
+	IDXGISwapChain*			m_SwapChainPtr{};
+
+	ID3D11Texture2D*		m_DepthStencilBufferPtr{};
+	ID3D11DepthStencilView* m_DepthStencilViewPtr{};
+
+	ID3D11Resource*			m_RenderTargetBufferPtr{};
+	ID3D11RenderTargetView* m_RenderTargetViewPtr{};
+
+	int m_Width{};
+	int m_Height{};
+	bool m_IsInitialized{ false };
+
+	//indexed by MeshHandle / MaterialHandle
+	std::vector<std::unique_ptr<Mesh>> m_Meshes{};
+	std::vector<std::unique_ptr<BaseEffect>> m_Materials{};
+	std::vector<dae::MaterialType> m_MaterialTypes{};
+
+	std::unique_ptr<InstanceBuffer> m_InstanceBufferPtr{};
+	std::unique_ptr<Context> m_ImmediateContextPtr{};
+
+	//materials are cloned per chunk by the first RecordParallel after they are created
+	std::unique_ptr<DeferredCommandBackend> m_CommandBackendPtr{};
+	dae::ParallelCommandRecorder m_CommandRecorder{};
+	std::vector<std::vector<std::unique_ptr<BaseEffect>>> m_ChunkMaterials{};
+	const dae::RecordChunkFunction* m_RecordChunkPtr{};
+
+	HRESULT InitializeDirectX();
+	void BindRenderTargets(ID3D11DeviceContext* deviceContextPtr) const;
+	void InitializeCommandBackend();
+	void CloneChunkMaterials();
+
+	//calls function for every material and every chunk clone of it
+	void ForEachMaterial(const std::function<void(const BaseEffect*, dae::MaterialHandle)>& function) const;
+};
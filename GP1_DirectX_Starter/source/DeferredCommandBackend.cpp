@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "DeferredCommandBackend.h"
+#include "Profiler.h"
+
+DeferredCommandBackend::DeferredCommandBackend(ID3D11Device* devicePtr, ID3D11DeviceContext* immediateContextPtr, uint32_t contextCount, RecordFunction recordFunction)
+	: m_ImmediateContextPtr{ immediateContextPtr }
+	, m_RecordFunction{ std::move(recordFunction) }
+{
+	m_DeferredContexts.reserve(contextCount);
+	for (uint32_t i{}; i < contextCount; ++i)
+	{
+		ID3D11DeviceContext* deferredContextPtr{};
+		if (FAILED(devicePtr->CreateDeferredContext(0, &deferredContextPtr)))
+		{
+			std::wcout << L"CreateDeferredContext failed\n";
+			break;
+		}
+		m_DeferredContexts.push_back(deferredContextPtr);
+	}
+	m_CommandLists.resize(m_DeferredContexts.size());
+}
+
+DeferredCommandBackend::~DeferredCommandBackend()
+{
+	for (ID3D11CommandList* commandListPtr : m_CommandLists)
+	{
+		if (commandListPtr)
+		{
+			commandListPtr->Release();
+		}
+	}
+	for (ID3D11DeviceContext* deferredContextPtr : m_DeferredContexts)
+	{
+		deferredContextPtr->Release();
+	}
+}
+
+void DeferredCommandBackend::RecordChunk(uint32_t chunkIndex, const dae::CommandChunk& chunk)
+{
+	DAE_PROFILE_FUNCTION();
+	ID3D11DeviceContext* deferredContextPtr = m_DeferredContexts[chunkIndex];
+	m_RecordFunction(deferredContextPtr, chunkIndex, chunk);
+
+	ID3D11CommandList*& commandListPtr = m_CommandLists[chunkIndex];
+	if (commandListPtr)
+	{
+		commandListPtr->Release();
+		commandListPtr = nullptr;
+	}
+	if (FAILED(deferredContextPtr->FinishCommandList(FALSE, &commandListPtr)))
+	{
+		commandListPtr = nullptr;
+	}
+}
+
+void DeferredCommandBackend::ExecuteChunks(uint32_t chunkCount)
+{
+	for (uint32_t chunk{}; chunk < chunkCount; ++chunk)
+	{
+		ID3D11CommandList*& commandListPtr = m_CommandLists[chunk];
+		if (!commandListPtr) continue;
+
+		m_ImmediateContextPtr->ExecuteCommandList(commandListPtr, FALSE);
+		commandListPtr->Release();
+		commandListPtr = nullptr;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <functional>
+
+#include "CommandBackend.h"
+
+//Records every chunk on its own D3D11 deferred context and plays the command lists back on the immediate context
+//Deferred contexts start from the default pipeline state, so the record function binds everything it draws with.
+//Executing a command list resets the immediate context state as well.
+class DeferredCommandBackend final : public dae::CommandBackend
+{
+public:
+	using RecordFunction = std::function<void(ID3D11DeviceContext* deviceContextPtr, uint32_t chunkIndex, const dae::CommandChunk& chunk)>;
+
+	//Creates up to contextCount deferred contexts, GetMaxChunkCount() is 0 when none could be created
+	DeferredCommandBackend(ID3D11Device* devicePtr, ID3D11DeviceContext* immediateContextPtr, uint32_t contextCount, RecordFunction recordFunction);
+	~DeferredCommandBackend() override;
+
+	DeferredCommandBackend(const DeferredCommandBackend&) = delete;
+	DeferredCommandBackend(DeferredCommandBackend&&) noexcept = delete;
+	DeferredCommandBackend& operator=(const DeferredCommandBackend&) = delete;
+	DeferredCommandBackend& operator=(DeferredCommandBackend&&) noexcept = delete;
+
+	uint32_t GetMaxChunkCount() const override { return static_cast<uint32_t>(m_DeferredContexts.size()); }
+	void RecordChunk(uint32_t chunkIndex, const dae::CommandChunk& chunk) override;
+	void ExecuteChunks(uint32_t chunkCount) override;
+
+private:
+	ID3D11DeviceContext* m_ImmediateContextPtr{};
+	std::vector<ID3D11DeviceContext*> m_DeferredContexts{};
+	std::vector<ID3D11CommandList*> m_CommandLists{};
+	RecordFunction m_RecordFunction{};
+};
@@ -0,0 +1,202 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#include "MathHelpers.h"
+
+namespace dae
+{
+	//Accuracy/speed policy for the trig and reciprocal square root kernels
+	//Max absolute sin/cos error vs double precision on [-PI, PI] / [-100, 100], max relative InvSqrt error on [1e-6, 1e6]:
+	//	Precise  : libm sinf/cosf, 1 / sqrtf                                  (reference)
+	//	Fast     : 11/10-degree minimax   2.2e-7 / 3.6e-6,   rsqrt + 1 Newton step   2.7e-7
+	//	Estimate : 7/6-degree minimax     9.4e-6 / 1.3e-5,   raw rsqrt estimate      3.3e-4
+	enum class MathPrecision
+	{
+		Precise,
+		Fast,
+		Estimate
+	};
+
+	namespace FastMath
+	{
+		constexpr float INV_PI_2 = 1.f / PI_2;
+		//Cody-Waite split of 2*PI: PI_2 + PI_2_LOW is exact to ~1e-15, keeps the reduction accurate for larger angles
+		constexpr float PI_2_LOW = -1.7484555e-07f;
+
+		//Reduces angle to [-PI/2, PI/2] (returned) and the sign cos must be multiplied with
+		inline float ReduceAngle(float angle, float& cosSign)
+		{
+			const float quotient = std::nearbyint(angle * INV_PI_2);
+			float y = (angle - PI_2 * quotient) - PI_2_LOW * quotient;
+
+			//sin(PI - y) = sin(y), cos(PI - y) = -cos(y)
+			cosSign = 1.f;
+			if (y > PI_DIV_2)
+			{
+				y = PI - y;
+				cosSign = -1.f;
+			}
+			else if (y < -PI_DIV_2)
+			{
+				y = -PI - y;
+				cosSign = -1.f;
+			}
+			return y;
+		}
+
+		inline float SinPoly11(float x, float x2)
+		{
+			return (((((-2.3889859e-08f * x2 + 2.7525562e-06f) * x2 - 0.00019840874f) * x2 + 0.0083333310f) * x2 - 0.16666667f) * x2 + 1.f) * x;
+		}
+
+		inline float CosPoly10(float x2)
+		{
+			return ((((-2.6051615e-07f * x2 + 2.4760495e-05f) * x2 - 0.0013888378f) * x2 + 0.041666638f) * x2 - 0.5f) * x2 + 1.f;
+		}
+
+		inline float SinPoly7(float x, float x2)
+		{
+			return (((-0.00018524670f * x2 + 0.0083139502f) * x2 - 0.16665852f) * x2 + 1.f) * x;
+		}
+
+		inline float CosPoly6(float x2)
+		{
+			return ((-0.0012712436f * x2 + 0.041493919f) * x2 - 0.49992746f) * x2 + 1.f;
+		}
+
+#if defined(DAE_SSE)
+		//4-wide version of ReduceAngle + polynomial evaluation
+		template<MathPrecision precision>
+		void SinCos4(__m128 angle, __m128& sinOut, __m128& cosOut)
+		{
+			const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+			const __m128 quotient = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(INV_PI_2))));
+			__m128 y = _mm_sub_ps(angle, _mm_mul_ps(quotient, _mm_set1_ps(PI_2)));
+			y = _mm_sub_ps(y, _mm_mul_ps(quotient, _mm_set1_ps(PI_2_LOW)));
+
+			//mirror |y| > PI/2 around +-PI/2: y = sign(y) * PI - y, and flip the sign of cos
+			const __m128 ySign = _mm_and_ps(y, signMask);
+			const __m128 mirrored = _mm_sub_ps(_mm_or_ps(_mm_set1_ps(PI), ySign), y);
+			const __m128 needsMirror = _mm_cmpgt_ps(_mm_andnot_ps(signMask, y), _mm_set1_ps(PI_DIV_2));
+			y = _mm_or_ps(_mm_and_ps(needsMirror, mirrored), _mm_andnot_ps(needsMirror, y));
+			const __m128 cosSign = _mm_and_ps(needsMirror, signMask);
+
+			const __m128 y2 = _mm_mul_ps(y, y);
+			const auto madd = [](__m128 a, __m128 b, float c) { return _mm_add_ps(_mm_mul_ps(a, b), _mm_set1_ps(c)); };
+
+			__m128 s, c;
+			if constexpr (precision == MathPrecision::Estimate)
+			{
+				s = madd(madd(madd(_mm_set1_ps(-0.00018524670f), y2, 0.0083139502f), y2, -0.16665852f), y2, 1.f);
+				c = madd(madd(madd(_mm_set1_ps(-0.0012712436f), y2, 0.041493919f), y2, -0.49992746f), y2, 1.f);
+			}
+			else
+			{
+				s = madd(madd(madd(madd(madd(_mm_set1_ps(-2.3889859e-08f), y2, 2.7525562e-06f), y2, -0.00019840874f), y2, 0.0083333310f), y2, -0.16666667f), y2, 1.f);
+				c = madd(madd(madd(madd(madd(_mm_set1_ps(-2.6051615e-07f), y2, 2.4760495e-05f), y2, -0.0013888378f), y2, 0.041666638f), y2, -0.5f), y2, 1.f);
+			}
+
+			sinOut = _mm_mul_ps(s, y);
+			cosOut = _mm_xor_ps(c, cosSign);
+		}
+#endif
+	}
+
+	template<MathPrecision precision = MathPrecision::Precise>
+	void SinCos(float angle, float& sinOut, float& cosOut)
+	{
+		if constexpr (precision == MathPrecision::Precise)
+		{
+			sinOut = std::sin(angle);
+			cosOut = std::cos(angle);
+		}
+		else
+		{
+			float cosSign{};
+			const float y = FastMath::ReduceAngle(angle, cosSign);
+			const float y2 = y * y;
+			if constexpr (precision == MathPrecision::Fast)
+			{
+				sinOut = FastMath::SinPoly11(y, y2);
+				cosOut = FastMath::CosPoly10(y2) * cosSign;
+			}
+			else
+			{
+				sinOut = FastMath::SinPoly7(y, y2);
+				cosOut = FastMath::CosPoly6(y2) * cosSign;
+			}
+		}
+	}
+
+	//Bulk version, 4 angles per iteration on the approximate paths
+	template<MathPrecision precision = MathPrecision::Fast>
+	void SinCos(const float* anglesPtr, float* sinPtr, float* cosPtr, size_t count)
+	{
+		//the tail starts at a multiple of 4 computed up front, so the compiler can bound both loops
+		size_t vectorEnd{};
+#if defined(DAE_SSE)
+		if constexpr (precision != MathPrecision::Precise)
+		{
+			vectorEnd = count & ~size_t{ 3 };
+			for (size_t i{}; i < vectorEnd; i += 4)
+			{
+				__m128 s, c;
+				FastMath::SinCos4<precision>(_mm_loadu_ps(anglesPtr + i), s, c);
+				_mm_storeu_ps(sinPtr + i, s);
+				_mm_storeu_ps(cosPtr + i, c);
+			}
+		}
+#endif
+		for (size_t i{ vectorEnd }; i < count; ++i)
+		{
+			SinCos<precision>(anglesPtr[i], sinPtr[i], cosPtr[i]);
+		}
+	}
+
+	template<MathPrecision precision = MathPrecision::Precise>
+	float InvSqrt(float x)
+	{
+#if defined(DAE_SSE)
+		if constexpr (precision != MathPrecision::Precise)
+		{
+			const float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+			if constexpr (precision == MathPrecision::Estimate)
+			{
+				return estimate;
+			}
+			//one Newton-Raphson step: y' = y * (1.5 - 0.5 * x * y * y)
+			return estimate * (1.5f - 0.5f * x * estimate * estimate);
+		}
+#endif
+		return 1.f / sqrtf(x);
+	}
+
+	//Bulk version, 4 values per iteration on the approximate paths
+	template<MathPrecision precision = MathPrecision::Fast>
+	void InvSqrt(const float* valuesPtr, float* resultPtr, size_t count)
+	{
+		size_t vectorEnd{};
+#if defined(DAE_SSE)
+		if constexpr (precision != MathPrecision::Precise)
+		{
+			vectorEnd = count & ~size_t{ 3 };
+			for (size_t i{}; i < vectorEnd; i += 4)
+			{
+				const __m128 x = _mm_loadu_ps(valuesPtr + i);
+				__m128 y = _mm_rsqrt_ps(x);
+				if constexpr (precision == MathPrecision::Fast)
+				{
+					const __m128 xyy = _mm_mul_ps(_mm_mul_ps(x, y), y);
+					y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_set1_ps(0.5f), xyy)));
+				}
+				_mm_storeu_ps(resultPtr + i, y);
+			}
+		}
+#endif
+		for (size_t i{ vectorEnd }; i < count; ++i)
+		{
+			resultPtr[i] = InvSqrt<precision>(valuesPtr[i]);
+		}
+	}
+}
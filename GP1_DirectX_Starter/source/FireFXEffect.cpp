@@ -2,21 +2,34 @@
 #include "FireFXEffect.h"
 
 FireFXEffect::FireFXEffect(ID3D11Device* devicePtr) :
-	BaseEffect(devicePtr, L"Resources/PartialCoverage.fx")
+	FireFXEffect(LoadEffect(devicePtr, L"Resources/PartialCoverage.fx"))
 {
+	SetDiffuseMap(new Texture("Resources/fireFX_diffuse.png", devicePtr));
+}
+
+FireFXEffect::FireFXEffect(ID3DX11Effect* effectPtr) :
+	BaseEffect(effectPtr)
+{
+	m_IsTransparent = true;
+
 	m_DiffuseMapVariablePtr = m_EffectPtr->GetVariableByName("gDiffuseMap")->AsShaderResource();
 	if (!m_DiffuseMapVariablePtr->IsValid())
 	{
 		std::wcout << L"DiffuseMapVariable not valid!\n";
 	}
-
-	SetDiffuseMap(new Texture("Resources/fireFX_diffuse.png", devicePtr));
 }
 
 FireFXEffect::~FireFXEffect()
 {
 }
 
+std::unique_ptr<BaseEffect> FireFXEffect::Clone() const
+{
+	ID3DX11Effect* clonePtr = CloneEffect();
+	if (!clonePtr) return nullptr;
+	return std::unique_ptr<BaseEffect>(new FireFXEffect(clonePtr));
+}
+
 void FireFXEffect::SetDiffuseMap(const Texture* diffuseTexturePtr) const
 {
 	if (m_DiffuseMapVariablePtr) m_DiffuseMapVariablePtr->SetResource(diffuseTexturePtr->GetResourceView());
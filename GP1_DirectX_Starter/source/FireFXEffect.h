@@ -8,9 +8,13 @@ public:
 	FireFXEffect(ID3D11Device* devicePtr);
 	~FireFXEffect();
 
+	std::unique_ptr<BaseEffect> Clone() const override;
+
 	void SetDiffuseMap(const Texture* diffuseTexturePtr) const;
 
 private:
+	explicit FireFXEffect(ID3DX11Effect* effectPtr);
+
 	ID3DX11EffectShaderResourceVariable* m_DiffuseMapVariablePtr{};
 };
 
@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	//Scripted camera flythrough to compare builds with.
+	//Every frame advances the script by the same fixed step no matter how long it took, so every build renders the same
+	//frames and only the times differ. The camera follows a closed spline around the vehicle while the rotation and the
+	//fire effect switch on a schedule. Per frame the update, render (recording + submit) and present times are recorded
+	class FlythroughBenchmark final
+	{
+	public:
+		static constexpr float FixedTimestep{ 1.f / 60.f };
+
+		struct Settings
+		{
+			float duration{ 20.f };						//seconds of script, duration / FixedTimestep frames
+			uint32_t warmupFrameCount{ 60 };			//first frame of the script, not recorded
+			std::string reportPath{ "benchmark" };		//writes <reportPath>.csv and <reportPath>.json
+		};
+
+		//What the script wants in one frame
+		struct Frame
+		{
+			Vector3 cameraOrigin{};
+			Vector3 cameraTarget{};
+			bool canRotate{};
+			bool renderFireFX{};
+		};
+
+		struct FrameTimes
+		{
+			double updateMs{};
+			double renderMs{};
+			double presentMs{};
+			double frameMs{};		//whole iteration of the loop, event pump included
+		};
+
+		struct Summary
+		{
+			double min{};
+			double avg{};
+			double p50{};
+			double p95{};
+			double p99{};
+			double max{};
+		};
+
+		explicit FlythroughBenchmark(const Settings& settings);
+
+		bool IsFinished() const { return m_FrameIndex >= m_Settings.warmupFrameCount + GetFrameCount(); }
+		uint32_t GetFrameCount() const { return static_cast<uint32_t>(std::ceil(m_Settings.duration / FixedTimestep)); }
+
+		//Script of the current frame, warmup frames hold the first one
+		Frame GetFrame() const;
+		//Records the current frame outside of the warmup and moves to the next
+		void EndFrame(const FrameTimes& times);
+
+		//Nearest rank percentiles
+		static Summary Summarize(std::vector<double> values);
+
+		void PrintReport() const;
+		bool WriteReport() const;
+
+	private:
+		//Switches of the schedule, each one holds until the next, as fractions of the duration
+		struct ScheduleEntry
+		{
+			float start;
+			bool canRotate;
+			bool renderFireFX;
+		};
+		static constexpr std::array<ScheduleEntry, 4> m_Schedule{ {
+			{ 0.00f, false, true },
+			{ 0.25f, true, true },
+			{ 0.50f, true, false },
+			{ 0.75f, false, true }
+		} };
+
+		//Control points of the closed camera spline, around the vehicle at the origin. Starts where Renderer puts the
+		//camera, then goes around at varying height and distance with a close pass by the front
+		static constexpr std::array<Vector3, 8> m_CameraPath{ {
+			{ 0.f, 0.f, -50.f },
+			{ -35.f, 10.f, -30.f },
+			{ -45.f, 4.f, 5.f },
+			{ -20.f, -4.f, 35.f },
+			{ 5.f, 15.f, 45.f },
+			{ 30.f, 6.f, 20.f },
+			{ 15.f, 2.f, -18.f },
+			{ 30.f, 12.f, -40.f }
+		} };
+		static constexpr Vector3 m_CameraTarget{ 0.f, 0.f, 0.f };
+
+		Settings m_Settings{};
+		uint32_t m_FrameIndex{};
+		std::vector<FrameTimes> m_Times{};
+		std::vector<Frame> m_Frames{};
+
+		float GetScriptTime(uint32_t frameIndex) const;
+		static Vector3 CatmullRom(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3, float t);
+	};
+
+	inline FlythroughBenchmark::FlythroughBenchmark(const Settings& settings) :
+		m_Settings{ settings }
+	{
+		m_Settings.duration = std::max(m_Settings.duration, FixedTimestep);
+		m_Times.reserve(GetFrameCount());
+		m_Frames.reserve(GetFrameCount());
+	}
+
+	inline float FlythroughBenchmark::GetScriptTime(uint32_t frameIndex) const
+	{
+		if (frameIndex < m_Settings.warmupFrameCount) return 0.f;
+		return static_cast<float>(frameIndex - m_Settings.warmupFrameCount) * FixedTimestep;
+	}
+
+	inline FlythroughBenchmark::Frame FlythroughBenchmark::GetFrame() const
+	{
+		const float progress = std::min(GetScriptTime(m_FrameIndex) / m_Settings.duration, 1.f);
+
+		Frame frame{};
+		for (const ScheduleEntry& entry : m_Schedule)
+		{
+			if (progress < entry.start) break;
+			frame.canRotate = entry.canRotate;
+			frame.renderFireFX = entry.renderFireFX;
+		}
+
+		//one lap over the whole duration, uniform Catmull-Rom through the control points
+		constexpr int pointCount{ static_cast<int>(m_CameraPath.size()) };
+		const float position = progress * static_cast<float>(pointCount);
+		const int segment = std::min(static_cast<int>(position), pointCount - 1);
+		const auto point = [&](int offset) { return m_CameraPath[(segment + offset + pointCount) % pointCount]; };
+
+		frame.cameraOrigin = CatmullRom(point(-1), point(0), point(1), point(2), position - static_cast<float>(segment));
+		frame.cameraTarget = m_CameraTarget;
+		return frame;
+	}
+
+	inline void FlythroughBenchmark::EndFrame(const FrameTimes& times)
+	{
+		if (m_FrameIndex >= m_Settings.warmupFrameCount)
+		{
+			m_Times.push_back(times);
+			m_Frames.push_back(GetFrame());
+		}
+		++m_FrameIndex;
+	}
+
+	inline Vector3 FlythroughBenchmark::CatmullRom(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3, float t)
+	{
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		return (p1 * 2.f
+			+ (p2 - p0) * t
+			+ (p0 * 2.f - p1 * 5.f + p2 * 4.f - p3) * t2
+			+ (p1 * 3.f - p0 - p2 * 3.f + p3) * t3) * 0.5f;
+	}
+
+	inline FlythroughBenchmark::Summary FlythroughBenchmark::Summarize(std::vector<double> values)
+	{
+		Summary summary{};
+		if (values.empty()) return summary;
+
+		std::sort(values.begin(), values.end());
+		const auto percentile = [&](double fraction)
+		{
+			const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+			return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+		};
+
+		double sum{};
+		for (const double value : values) sum += value;
+
+		summary.min = values.front();
+		summary.avg = sum / static_cast<double>(values.size());
+		summary.p50 = percentile(0.50);
+		summary.p95 = percentile(0.95);
+		summary.p99 = percentile(0.99);
+		summary.max = values.back();
+		return summary;
+	}
+
+	namespace BenchmarkDetail
+	{
+		//Name and member of every recorded column, in report order
+		struct Column
+		{
+			const char* name;
+			double FlythroughBenchmark::FrameTimes::* member;
+		};
+		inline constexpr std::array<Column, 4> Columns{ {
+			{ "update", &FlythroughBenchmark::FrameTimes::updateMs },
+			{ "render", &FlythroughBenchmark::FrameTimes::renderMs },
+			{ "present", &FlythroughBenchmark::FrameTimes::presentMs },
+			{ "frame", &FlythroughBenchmark::FrameTimes::frameMs }
+		} };
+	}
+
+	inline void FlythroughBenchmark::PrintReport() const
+	{
+		using namespace BenchmarkDetail;
+
+		char line[128];
+		std::snprintf(line, sizeof(line), "Benchmark: %zu frames, %.1f s of script\n", m_Times.size(), static_cast<double>(m_Settings.duration));
+		std::cout << line;
+		std::snprintf(line, sizeof(line), "%-10s %9s %9s %9s %9s %9s %9s\n", "ms", "min", "avg", "p50", "p95", "p99", "max");
+		std::cout << line;
+		for (const Column& column : Columns)
+		{
+			std::vector<double> values(m_Times.size());
+			std::transform(m_Times.begin(), m_Times.end(), values.begin(), [&](const FrameTimes& times) { return times.*column.member; });
+			const Summary summary = Summarize(std::move(values));
+			std::snprintf(line, sizeof(line), "%-10s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", column.name,
+				summary.min, summary.avg, summary.p50, summary.p95, summary.p99, summary.max);
+			std::cout << line;
+		}
+	}
+
+	inline bool FlythroughBenchmark::WriteReport() const
+	{
+		using namespace BenchmarkDetail;
+
+		std::ofstream csv{ m_Settings.reportPath + ".csv" };
+		std::ofstream json{ m_Settings.reportPath + ".json" };
+		if (!csv || !json)
+		{
+			std::cerr << "Can't write " << m_Settings.reportPath << ".csv / .json" << std::endl;
+			return false;
+		}
+
+		//one row per recorded frame
+		char line[256];
+		csv << "frame,time,rotation,fire_fx,update_ms,render_ms,present_ms,frame_ms\n";
+		for (size_t frame{}; frame < m_Times.size(); ++frame)
+		{
+			const FrameTimes& times = m_Times[frame];
+			std::snprintf(line, sizeof(line), "%zu,%.4f,%d,%d,%.4f,%.4f,%.4f,%.4f\n", frame, static_cast<double>(frame) * FixedTimestep,
+				m_Frames[frame].canRotate, m_Frames[frame].renderFireFX, times.updateMs, times.renderMs, times.presentMs, times.frameMs);
+			csv << line;
+		}
+
+		//the summary, keys like the console table
+		json << "{\n";
+		std::snprintf(line, sizeof(line), "  \"duration\": %.3f,\n  \"timestep\": %.6f,\n  \"warmupFrames\": %u,\n  \"frames\": %zu,\n",
+			static_cast<double>(m_Settings.duration), static_cast<double>(FixedTimestep), m_Settings.warmupFrameCount, m_Times.size());
+		json << line;
+		for (size_t index{}; index < Columns.size(); ++index)
+		{
+			const Column& column = Columns[index];
+			std::vector<double> values(m_Times.size());
+			std::transform(m_Times.begin(), m_Times.end(), values.begin(), [&](const FrameTimes& times) { return times.*column.member; });
+			const Summary summary = Summarize(std::move(values));
+			std::snprintf(line, sizeof(line), "  \"%sMs\": { \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+				column.name, summary.min, summary.avg, summary.p50, summary.p95, summary.p99, summary.max, index + 1 < Columns.size() ? "," : "");
+			json << line;
+		}
+		json << "}\n";
+
+		std::cout << "Report written to " << m_Settings.reportPath << ".csv / .json" << std::endl;
+		return true;
+	}
+}
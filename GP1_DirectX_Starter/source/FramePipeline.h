@@ -0,0 +1,485 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "BoundingVolumes.h"
+#include "InstanceBatcher.h"
+#include "JobSystem.h"
+#include "Matrix.h"
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include "RenderQueue.h"
+#include "RenderWorld.h"
+#include "SceneGraph.h"
+#include "TriangleSorter.h"
+
+namespace dae
+{
+	//The per-frame CPU work of the renderer: scene update, frustum and occlusion culling, queue sort,
+	//transparent triangle sort, instance batching and draw submission
+	//Only talks to the device through a RenderBackend, so it runs headless on a NullRenderBackend
+	//Update writes everything Submit needs into a FramePacket and doesn't touch the backend, Submit only reads the
+	//packet. Update can so fill the next packet on another thread while Submit draws the last one
+	class FramePipeline final
+	{
+	public:
+		struct Settings
+		{
+			bool useInstancing{ true };
+			bool sortTransparentTriangles{ true };
+			bool useOcclusionCulling{ true };
+			//without instancing the queue is split into chunks recorded in parallel, when the backend supports it
+			bool useParallelRecording{ false };
+		};
+
+		struct RenderStats
+		{
+			uint32_t drawCount{};
+			uint32_t meshBindCount{};
+			uint32_t meshBindsSkipped{};
+			uint32_t effectSwitchCount{};
+			uint32_t chunkCount{};
+			uint32_t visibleCount{};
+			uint32_t culledCount{};
+			uint32_t occludedCount{};
+			uint32_t occluderCount{};
+			uint32_t queueSize{};
+			double cullTimeMs{};
+			double occlusionTimeMs{};
+			double sortTimeMs{};
+		};
+
+		//One queued draw without instancing
+		struct DrawConstants
+		{
+			MeshHandle mesh{};
+			MaterialHandle material{};
+			Matrix worldMatrix{};
+			Matrix worldViewProjectionMatrix{};
+		};
+
+		//One reordered index buffer of a blended mesh
+		struct SortedIndices
+		{
+			MeshHandle mesh{};
+			std::vector<uint32_t> indices{};
+		};
+
+		//The result of one Update, read only until the next Update into it
+		struct FramePacket
+		{
+			Matrix viewProjectionMatrix{};
+			//as of the Update, so a toggle on the update side doesn't change a packet in flight
+			Settings settings{};
+			//the update half of the stats, Submit adds the draw counts
+			RenderStats stats{};
+
+			//without instancing, in queue order
+			std::vector<DrawConstants> draws{};
+			//with instancing
+			std::vector<InstanceBatch> instanceBatches{};
+			std::vector<Matrix> instanceWorldMatrices{};
+			std::vector<SortedIndices> sortedIndices{};
+		};
+
+		//backend has to outlive the pipeline
+		explicit FramePipeline(RenderBackend& backend) : m_Backend{ backend } {}
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline(FramePipeline&&) noexcept = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+		FramePipeline& operator=(FramePipeline&&) noexcept = delete;
+
+		//Creates the material on the backend and caches the properties the queue sorts on
+		MaterialHandle CreateMaterial(MaterialType type);
+		//Creates the mesh on the backend, the pipeline keeps the CPU copy for its bounds and the triangle sort
+		MeshHandle CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle material);
+
+		//object space bounds, computed once in CreateMesh
+		const Aabb& GetMeshBounds(MeshHandle mesh) const { return m_Meshes[mesh].bounds; }
+		//the box rasterized for mesh when it is one of the nearest opaque draws, object space
+		void SetOccluderBounds(MeshHandle mesh, const Aabb& bounds) { m_Meshes[mesh].occluderBounds = bounds; }
+
+		//the update side, Update reads them
+		SceneGraph& GetSceneGraph() { return m_SceneGraph; }
+		RenderWorld& GetRenderWorld() { return m_RenderWorld; }
+		Settings& GetSettings() { return m_Settings; }
+		//the submit side, of the last Submit
+		const RenderStats& GetStats() const { return m_RenderStats; }
+
+		//Updates world matrices, culls, sorts the queue and batches instances for viewProjectionMatrix into packet
+		void Update(const Matrix& viewProjectionMatrix, FramePacket& packet);
+		//Uploads the dynamic buffers of packet and submits its draws, between BeginFrame and EndFrame of the backend
+		void Submit(const FramePacket& packet);
+
+		//Update and Submit on one thread, through a packet the pipeline keeps
+		void Update(const Matrix& viewProjectionMatrix) { Update(viewProjectionMatrix, m_Packet); }
+		void Submit() { Submit(m_Packet); }
+
+	private:
+		struct MeshData
+		{
+			std::vector<MeshVertex> vertices{};
+			std::vector<uint32_t> indices{};
+			Aabb bounds{};
+			Aabb occluderBounds{}; //empty when the mesh does not occlude
+			bool hasDynamicIndices{};
+		};
+
+		struct MaterialData
+		{
+			bool isTransparent{};
+			bool supportsInstancing{};
+		};
+
+		RenderBackend& m_Backend;
+		Settings m_Settings{};
+		RenderStats m_RenderStats{};
+		std::vector<RenderStats> m_ChunkStats{};
+		FramePacket m_Packet{};
+
+		//indexed by MeshHandle / MaterialHandle
+		std::vector<MeshData> m_Meshes{};
+		std::vector<MaterialData> m_Materials{};
+
+		SceneGraph m_SceneGraph{};
+		RenderWorld m_RenderWorld{};
+		std::vector<DrawItem> m_DrawList{};
+		RenderQueue m_RenderQueue{};
+
+		// the nearest opaque draws rasterize a simplified occluder box, everything hidden behind them is dropped
+		OcclusionCuller m_OcclusionCuller{};
+		std::vector<std::pair<float, uint32_t>> m_OccluderCandidates{};
+		static constexpr size_t m_MaxOccluderCount{ 64 };
+
+		// visible draw items grouped per mesh/material, their world matrices live in the instance buffer
+		InstanceBatcher m_InstanceBatcher{};
+		// per-draw constants are written in blocks on the job system
+		static constexpr uint32_t m_DrawConstantsGrainSize{ 1024 };
+
+		// reorders the triangles of blended meshes back-to-front every frame
+		TriangleSorter m_TriangleSorter{};
+		std::vector<uint8_t> m_IsMeshTriangleSorted{};
+		static constexpr uint32_t m_TriangleSortClusterSize{ 1 };
+
+		void CullOccludedDrawItems(const Matrix& viewProjectionMatrix, RenderStats& stats);
+		void SortTransparentTriangles(const Matrix& viewProjectionMatrix, std::vector<SortedIndices>& sortedIndices);
+		void WriteDrawConstants(FramePacket& packet) const;
+		void SubmitParallel(const FramePacket& packet);
+		static void RecordDrawRange(RenderContext& context, const FramePacket& packet, uint32_t firstDraw, uint32_t drawCount, RenderStats& stats);
+		void SubmitInstanceBatches(const FramePacket& packet);
+	};
+
+	inline MaterialHandle FramePipeline::CreateMaterial(MaterialType type)
+	{
+		const MaterialHandle material = m_Backend.CreateMaterial(type);
+		m_Materials.resize(std::max<size_t>(m_Materials.size(), material + 1));
+		m_Materials[material] = { m_Backend.IsTransparent(material), m_Backend.SupportsInstancing(material) };
+		return material;
+	}
+
+	inline MeshHandle FramePipeline::CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle material)
+	{
+		const MeshHandle mesh = m_Backend.CreateMesh(vertices, indices, material);
+		m_Meshes.resize(std::max<size_t>(m_Meshes.size(), mesh + 1));
+
+		MeshData& meshData = m_Meshes[mesh];
+		meshData.vertices = vertices;
+		meshData.indices = indices;
+		meshData.bounds = Aabb::FromPoints(&vertices.data()->position, vertices.size(), sizeof(MeshVertex));
+		meshData.hasDynamicIndices = m_Materials[material].isTransparent;
+		return mesh;
+	}
+
+	inline void FramePipeline::Update(const Matrix& viewProjectionMatrix, FramePacket& packet)
+	{
+		DAE_PROFILE_FUNCTION();
+		packet.viewProjectionMatrix = viewProjectionMatrix;
+		packet.settings = m_Settings;
+		RenderStats& stats{ packet.stats };
+		stats = RenderStats{};
+
+		m_SceneGraph.UpdateWorldMatrices();
+
+		// frame prep: world matrices, culling and the draw list are linear passes over the entity arrays
+		m_RenderWorld.Update(m_SceneGraph);
+
+		// entities outside the frustum never reach the queue, so they get no world-view-projection and no draw
+		const auto cullStart{ std::chrono::steady_clock::now() };
+		size_t visibleCount{};
+		{
+			DAE_PROFILE_SCOPE("Cull");
+			visibleCount = m_RenderWorld.Cull(Frustum::FromViewProjection(viewProjectionMatrix));
+		}
+		stats.cullTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+		stats.visibleCount = static_cast<uint32_t>(visibleCount);
+		stats.culledCount = static_cast<uint32_t>(m_RenderWorld.GetEntityCount() - visibleCount);
+
+		m_DrawList.clear();
+		m_RenderWorld.BuildDrawList(m_DrawList);
+
+		if (m_Settings.useOcclusionCulling)
+		{
+			CullOccludedDrawItems(viewProjectionMatrix, stats);
+		}
+
+		// sort by pass, transparency, material, mesh and depth so consecutive draws share state,
+		// blended draws go last and back-to-front
+		const std::vector<Matrix>& worldMatrices{ m_RenderWorld.GetWorldMatrices() };
+		m_RenderQueue.Clear();
+		m_RenderQueue.Reserve(m_DrawList.size());
+		for (uint32_t item{}; item < m_DrawList.size(); ++item)
+		{
+			const DrawItem& drawItem{ m_DrawList[item] };
+
+			// clip space w of the entity origin is its view depth
+			const float viewDepth{ viewProjectionMatrix.TransformPoint(Vector4{ worldMatrices[drawItem.instance].GetTranslation(), 1.f }).w };
+			const bool isTransparent{ m_Materials[drawItem.material].isTransparent };
+			m_RenderQueue.Submit(RenderQueue::MakeKey(RenderPass::Main, isTransparent, drawItem.material, drawItem.mesh, viewDepth), item);
+		}
+
+		const auto sortStart{ std::chrono::steady_clock::now() };
+		{
+			DAE_PROFILE_SCOPE("Sort");
+			m_RenderQueue.Sort();
+		}
+		stats.sortTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+		stats.queueSize = static_cast<uint32_t>(m_RenderQueue.GetCommands().size());
+
+		if (m_Settings.sortTransparentTriangles)
+		{
+			SortTransparentTriangles(viewProjectionMatrix, packet.sortedIndices);
+		}
+		else
+		{
+			packet.sortedIndices.clear();
+		}
+
+		packet.draws.clear();
+		packet.instanceBatches.clear();
+		packet.instanceWorldMatrices.clear();
+		if (m_Settings.useInstancing)
+		{
+			DAE_PROFILE_SCOPE("Instancing");
+			m_InstanceBatcher.Build(m_RenderQueue.GetCommands(), m_DrawList, worldMatrices);
+			packet.instanceBatches = m_InstanceBatcher.GetBatches();
+			packet.instanceWorldMatrices = m_InstanceBatcher.GetInstanceWorldMatrices();
+		}
+		else
+		{
+			WriteDrawConstants(packet);
+		}
+	}
+
+	inline void FramePipeline::Submit(const FramePacket& packet)
+	{
+		DAE_PROFILE_FUNCTION();
+		m_RenderStats = packet.stats;
+
+		for (const SortedIndices& sortedIndices : packet.sortedIndices)
+		{
+			m_Backend.UpdateIndices(sortedIndices.mesh, sortedIndices.indices);
+		}
+
+		if (packet.settings.useInstancing)
+		{
+			m_Backend.UploadInstances(packet.instanceWorldMatrices.data(), static_cast<uint32_t>(packet.instanceWorldMatrices.size()));
+			SubmitInstanceBatches(packet);
+		}
+		else if (packet.settings.useParallelRecording && m_Backend.GetMaxChunkCount() > 0)
+		{
+			SubmitParallel(packet);
+		}
+		else
+		{
+			RecordDrawRange(m_Backend.GetImmediateContext(), packet, 0, static_cast<uint32_t>(packet.draws.size()), m_RenderStats);
+		}
+	}
+
+	inline void FramePipeline::CullOccludedDrawItems(const Matrix& viewProjectionMatrix, RenderStats& stats)
+	{
+		DAE_PROFILE_FUNCTION();
+		const auto occlusionStart{ std::chrono::steady_clock::now() };
+		const std::vector<Matrix>& worldMatrices{ m_RenderWorld.GetWorldMatrices() };
+
+		// the nearest opaque draws with an occluder box hide the most
+		m_OccluderCandidates.clear();
+		for (uint32_t item{}; item < m_DrawList.size(); ++item)
+		{
+			const DrawItem& drawItem{ m_DrawList[item] };
+			if (!m_Meshes[drawItem.mesh].occluderBounds.IsValid() || m_Materials[drawItem.material].isTransparent) continue;
+
+			const float viewDepth{ viewProjectionMatrix.TransformPoint(Vector4{ worldMatrices[drawItem.instance].GetTranslation(), 1.f }).w };
+			m_OccluderCandidates.emplace_back(viewDepth, item);
+		}
+
+		const size_t occluderCount{ std::min(m_OccluderCandidates.size(), m_MaxOccluderCount) };
+		std::nth_element(m_OccluderCandidates.begin(), m_OccluderCandidates.begin() + occluderCount, m_OccluderCandidates.end());
+
+		m_OcclusionCuller.BeginFrame(viewProjectionMatrix);
+		for (size_t i{}; i < occluderCount; ++i)
+		{
+			const DrawItem& drawItem{ m_DrawList[m_OccluderCandidates[i].second] };
+			m_OcclusionCuller.AddOccluderBox(m_Meshes[drawItem.mesh].occluderBounds, worldMatrices[drawItem.instance]);
+		}
+		m_OcclusionCuller.Rasterize();
+
+		// occluder boxes sit inside their own bounds, so occluders always pass
+		const AabbSoA& worldBounds{ m_RenderWorld.GetWorldBounds() };
+		const size_t drawCount{ m_DrawList.size() };
+		std::erase_if(m_DrawList, [&](const DrawItem& drawItem) { return !m_OcclusionCuller.IsVisible(worldBounds.Get(drawItem.instance)); });
+
+		stats.occluderCount = static_cast<uint32_t>(occluderCount);
+		stats.occludedCount = static_cast<uint32_t>(drawCount - m_DrawList.size());
+		stats.occlusionTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - occlusionStart).count();
+	}
+
+	inline void FramePipeline::SortTransparentTriangles(const Matrix& viewProjectionMatrix, std::vector<SortedIndices>& sortedIndices)
+	{
+		DAE_PROFILE_FUNCTION();
+		// a mesh has one index buffer, so instances share its order: sort for the nearest instance,
+		// which is the last one in the back-to-front part of the queue
+		// the index vectors of the packet are refilled in place, they keep their capacity from frame to frame
+		m_IsMeshTriangleSorted.assign(m_Meshes.size(), 0);
+		size_t sortedCount{};
+		const std::vector<RenderCommand>& commands{ m_RenderQueue.GetCommands() };
+		const std::vector<Matrix>& worldMatrices{ m_RenderWorld.GetWorldMatrices() };
+		for (auto it{ commands.rbegin() }; it != commands.rend() && RenderQueue::IsTransparent(it->key); ++it)
+		{
+			const DrawItem& drawItem{ m_DrawList[it->item] };
+			const MeshData& meshData{ m_Meshes[drawItem.mesh] };
+			if (m_IsMeshTriangleSorted[drawItem.mesh] || !meshData.hasDynamicIndices) continue;
+			m_IsMeshTriangleSorted[drawItem.mesh] = 1;
+
+			const Matrix worldViewProjectionMatrix{ worldMatrices[drawItem.instance] * viewProjectionMatrix };
+			if (sortedCount == sortedIndices.size()) sortedIndices.emplace_back();
+			SortedIndices& sorted{ sortedIndices[sortedCount++] };
+			sorted.mesh = drawItem.mesh;
+			sorted.indices = m_TriangleSorter.Sort(&meshData.vertices.data()->position, meshData.vertices.size(), sizeof(MeshVertex),
+				meshData.indices, worldViewProjectionMatrix, m_TriangleSortClusterSize);
+		}
+		sortedIndices.resize(sortedCount);
+	}
+
+	inline void FramePipeline::WriteDrawConstants(FramePacket& packet) const
+	{
+		// the world-view-projection of every draw is worked out here, so recording only copies constants
+		const std::vector<RenderCommand>& commands{ m_RenderQueue.GetCommands() };
+		const std::vector<Matrix>& worldMatrices{ m_RenderWorld.GetWorldMatrices() };
+		packet.draws.resize(commands.size());
+		JobSystem::Get().ParallelForRange(static_cast<uint32_t>(commands.size()), m_DrawConstantsGrainSize, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t command{ begin }; command < end; ++command)
+			{
+				const DrawItem& drawItem{ m_DrawList[commands[command].item] };
+				const Matrix& worldMatrix{ worldMatrices[drawItem.instance] };
+				packet.draws[command] = { drawItem.mesh, drawItem.material, worldMatrix, worldMatrix * packet.viewProjectionMatrix };
+			}
+		});
+	}
+
+	inline void FramePipeline::SubmitParallel(const FramePacket& packet)
+	{
+		// every chunk counts into its own stats, summed once all of them are recorded
+		m_ChunkStats.assign(m_Backend.GetMaxChunkCount(), RenderStats{});
+
+		m_RenderStats.chunkCount = m_Backend.RecordParallel(static_cast<uint32_t>(packet.draws.size()),
+			[&](RenderContext& context, uint32_t chunkIndex, const CommandChunk& chunk)
+			{
+				RecordDrawRange(context, packet, chunk.firstCommand, chunk.commandCount, m_ChunkStats[chunkIndex]);
+			});
+
+		for (const RenderStats& chunkStats : m_ChunkStats)
+		{
+			m_RenderStats.drawCount += chunkStats.drawCount;
+			m_RenderStats.meshBindCount += chunkStats.meshBindCount;
+			m_RenderStats.meshBindsSkipped += chunkStats.meshBindsSkipped;
+			m_RenderStats.effectSwitchCount += chunkStats.effectSwitchCount;
+		}
+	}
+
+	inline void FramePipeline::RecordDrawRange(RenderContext& context, const FramePacket& packet, uint32_t firstDraw, uint32_t drawCount, RenderStats& stats)
+	{
+		// one draw call per visible entity, in queue order, vertex/index buffers are only bound when the mesh changes
+		MeshHandle boundMesh{ InvalidMesh };
+		MaterialHandle appliedMaterial{ UINT32_MAX };
+		for (uint32_t drawIndex{ firstDraw }; drawIndex < firstDraw + drawCount; ++drawIndex)
+		{
+			const DrawConstants& drawItem{ packet.draws[drawIndex] };
+
+			if (drawItem.mesh != boundMesh)
+			{
+				context.BindMesh(drawItem.mesh, false);
+				boundMesh = drawItem.mesh;
+				++stats.meshBindCount;
+			}
+			else
+			{
+				++stats.meshBindsSkipped;
+			}
+
+			if (drawItem.material != appliedMaterial)
+			{
+				appliedMaterial = drawItem.material;
+				++stats.effectSwitchCount;
+			}
+
+			context.Draw(drawItem.mesh, drawItem.material, drawItem.worldMatrix, drawItem.worldViewProjectionMatrix);
+			++stats.drawCount;
+		}
+	}
+
+	inline void FramePipeline::SubmitInstanceBatches(const FramePacket& packet)
+	{
+		// one draw call per mesh/material run of the queue
+		RenderContext& context{ m_Backend.GetImmediateContext() };
+		const Matrix& viewProjectionMatrix{ packet.viewProjectionMatrix };
+		const std::vector<Matrix>& instanceWorldMatrices{ packet.instanceWorldMatrices };
+		MeshHandle boundMesh{ InvalidMesh };
+		bool isBoundInstanced{};
+		MaterialHandle appliedMaterial{ UINT32_MAX };
+		for (const InstanceBatch& batch : packet.instanceBatches)
+		{
+			const bool isInstanced{ m_Materials[batch.material].supportsInstancing };
+
+			// batches are cut on material or mesh changes, the input layout differs between the two paths
+			if (batch.mesh != boundMesh || isInstanced != isBoundInstanced)
+			{
+				context.BindMesh(batch.mesh, isInstanced);
+				boundMesh = batch.mesh;
+				isBoundInstanced = isInstanced;
+				++m_RenderStats.meshBindCount;
+			}
+			else
+			{
+				++m_RenderStats.meshBindsSkipped;
+			}
+
+			if (batch.material != appliedMaterial)
+			{
+				appliedMaterial = batch.material;
+				++m_RenderStats.effectSwitchCount;
+			}
+
+			if (isInstanced)
+			{
+				context.DrawInstanced(batch.mesh, batch.material, viewProjectionMatrix, batch.firstInstance, batch.instanceCount);
+				++m_RenderStats.drawCount;
+				continue;
+			}
+
+			// materials without an instanced technique (fire fx) are drawn one instance at a time
+			for (uint32_t instance{ batch.firstInstance }; instance < batch.firstInstance + batch.instanceCount; ++instance)
+			{
+				const Matrix& worldMatrix{ instanceWorldMatrices[instance] };
+				const Matrix worldViewProjectionMatrix{ worldMatrix * viewProjectionMatrix };
+				context.Draw(batch.mesh, batch.material, worldMatrix, worldViewProjectionMatrix);
+				++m_RenderStats.drawCount;
+			}
+		}
+	}
+}
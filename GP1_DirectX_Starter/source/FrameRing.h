@@ -0,0 +1,163 @@
+#pragma once
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace dae
+{
+	//Fixed ring of frames that pass two stages on two threads
+	//The requester fills the input of a frame, the producer thread turns the oldest requested frame into its output
+	//and the requester consumes the oldest produced one. Frames never overtake each other: with request r, produce p
+	//and consume c, c <= p <= r <= c + depth, so the producer is never more than depth - 1 frames ahead of the consumer
+	//and nothing waits in the ring longer than depth frames. Frames are reused, vectors in them keep their capacity
+	template<typename Frame>
+	class FrameRing final
+	{
+	public:
+		explicit FrameRing(uint32_t depth) : m_Frames(depth) {}
+
+		FrameRing(const FrameRing&) = delete;
+		FrameRing(FrameRing&&) noexcept = delete;
+		FrameRing& operator=(const FrameRing&) = delete;
+		FrameRing& operator=(FrameRing&&) noexcept = delete;
+
+		uint32_t GetDepth() const { return static_cast<uint32_t>(m_Frames.size()); }
+		//requested and not consumed yet
+		uint32_t GetInFlightCount() const;
+
+		//Requester, only while fewer than depth frames are in flight
+		Frame& BeginRequest();
+		void EndRequest();
+		//Requester, blocks until the oldest requested frame is produced
+		Frame& BeginConsume();
+		void EndConsume();
+		//Requester, drops every frame in flight once the producer finished the one it is on
+		void Reset(uint32_t depth);
+		//Requester, waits for the producer to finish the frame it is on and keeps it from starting another until Resume
+		void Pause();
+		void Resume();
+
+		//Producer, blocks until a frame is requested, nullptr once the ring is closed
+		Frame* BeginProduce();
+		void EndProduce();
+		void Close();
+
+	private:
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::vector<Frame> m_Frames;
+		uint64_t m_RequestCount{};
+		uint64_t m_ProduceCount{};
+		uint64_t m_ConsumeCount{};
+		bool m_IsProducing{ false };
+		bool m_IsPaused{ false };
+		bool m_IsClosed{ false };
+
+		Frame& GetFrame(uint64_t sequence) { return m_Frames[sequence % m_Frames.size()]; }
+	};
+
+	template<typename Frame>
+	uint32_t FrameRing<Frame>::GetInFlightCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<uint32_t>(m_RequestCount - m_ConsumeCount);
+	}
+
+	template<typename Frame>
+	Frame& FrameRing<Frame>::BeginRequest()
+	{
+		//only the requester moves the request and consume counts, the slot can't be taken meanwhile
+		std::lock_guard lock{ m_Mutex };
+		assert(m_RequestCount - m_ConsumeCount < m_Frames.size());
+		return GetFrame(m_RequestCount);
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::EndRequest()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			++m_RequestCount;
+		}
+		m_Condition.notify_all();
+	}
+
+	template<typename Frame>
+	Frame& FrameRing<Frame>::BeginConsume()
+	{
+		std::unique_lock lock{ m_Mutex };
+		assert(m_ConsumeCount < m_RequestCount);
+		m_Condition.wait(lock, [this] { return m_ProduceCount > m_ConsumeCount; });
+		return GetFrame(m_ConsumeCount);
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::EndConsume()
+	{
+		std::lock_guard lock{ m_Mutex };
+		++m_ConsumeCount;
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::Reset(uint32_t depth)
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this] { return !m_IsProducing; });
+		m_RequestCount = 0;
+		m_ProduceCount = 0;
+		m_ConsumeCount = 0;
+		m_Frames.resize(depth);
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::Pause()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_IsPaused = true;
+		m_Condition.wait(lock, [this] { return !m_IsProducing; });
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::Resume()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsPaused = false;
+		}
+		m_Condition.notify_all();
+	}
+
+	template<typename Frame>
+	Frame* FrameRing<Frame>::BeginProduce()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this] { return m_IsClosed || (!m_IsPaused && m_ProduceCount < m_RequestCount); });
+		if (m_IsClosed) return nullptr;
+
+		m_IsProducing = true;
+		return &GetFrame(m_ProduceCount);
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::EndProduce()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			++m_ProduceCount;
+			m_IsProducing = false;
+		}
+		m_Condition.notify_all();
+	}
+
+	template<typename Frame>
+	void FrameRing<Frame>::Close()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsClosed = true;
+		}
+		m_Condition.notify_all();
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace dae
+{
+	//Frame time statistics over the last WindowSize frames, in microseconds
+	//A ring buffer keeps the window, every frame that enters it is added to a log-linear histogram (HDR histogram
+	//style) and the one it pushes out is removed again, so adding a frame is O(1) and the percentiles always describe
+	//the window. Sums are integers, nothing drifts no matter how long the window slides.
+	//Buckets are exact below 64 us and 1 / 32 wide relative to their value above that, up to ~67 s
+	class FrameTimeHistogram final
+	{
+	public:
+		static constexpr uint32_t WindowSize{ 1024 };
+
+		void Add(uint32_t microseconds);
+		void Clear();
+
+		//a frame above the threshold counts as a hitch, recounts the window
+		void SetHitchThreshold(uint32_t microseconds);
+		uint32_t GetHitchThreshold() const { return m_HitchThreshold; }
+
+		uint32_t GetCount() const { return m_Count; }
+		//hitches in the window, and since the last Clear
+		uint32_t GetHitchCount() const { return m_HitchCount; }
+		uint64_t GetTotalHitchCount() const { return m_TotalHitchCount; }
+
+		//fraction in [0, 1], the midpoint of the bucket holding that rank, never above the largest frame
+		uint32_t GetPercentile(double fraction) const;
+		uint32_t GetMax() const;
+		double GetMean() const { return m_Count ? static_cast<double>(m_Sum) / m_Count : 0.0; }
+		//of the frame times, how evenly the frames are paced
+		double GetVariance() const;
+
+	private:
+		static constexpr uint32_t SubBucketBits{ 6 };
+		static constexpr uint32_t SubBucketCount{ 1u << SubBucketBits };
+		static constexpr uint32_t HalfSubBucketCount{ SubBucketCount / 2 };
+		static constexpr uint32_t MaxValue{ (1u << 26) - 1 };
+		static constexpr uint32_t BucketCount{ SubBucketCount + (26 - SubBucketBits) * HalfSubBucketCount };
+
+		std::array<uint32_t, WindowSize> m_Window{};
+		std::array<uint32_t, BucketCount> m_Buckets{};
+		uint32_t m_Next{};
+		uint32_t m_Count{};
+
+		uint64_t m_Sum{};
+		uint64_t m_SquaredSum{};
+
+		uint32_t m_HitchThreshold{ 33'333 };
+		uint32_t m_HitchCount{};
+		uint64_t m_TotalHitchCount{};
+
+		//below SubBucketCount one bucket per value, above it HalfSubBucketCount buckets per power of two
+		static uint32_t GetBucket(uint32_t value)
+		{
+			if (value < SubBucketCount) return value;
+			const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - SubBucketBits;
+			return SubBucketCount + (shift - 1) * HalfSubBucketCount + ((value >> shift) - HalfSubBucketCount);
+		}
+		static uint32_t GetBucketMidpoint(uint32_t bucket)
+		{
+			if (bucket < SubBucketCount) return bucket;
+			const uint32_t shift = (bucket - SubBucketCount) / HalfSubBucketCount + 1;
+			const uint32_t first = (HalfSubBucketCount + (bucket - SubBucketCount) % HalfSubBucketCount) << shift;
+			return first + ((1u << shift) >> 1);
+		}
+	};
+
+	inline void FrameTimeHistogram::Add(uint32_t microseconds)
+	{
+		const uint32_t value = std::min(microseconds, MaxValue);
+		if (m_Count == WindowSize)
+		{
+			const uint32_t oldest = m_Window[m_Next];
+			--m_Buckets[GetBucket(oldest)];
+			m_Sum -= oldest;
+			m_SquaredSum -= uint64_t{ oldest } * oldest;
+			m_HitchCount -= oldest > m_HitchThreshold;
+		}
+		else
+		{
+			++m_Count;
+		}
+
+		m_Window[m_Next] = value;
+		m_Next = (m_Next + 1) & (WindowSize - 1);
+		++m_Buckets[GetBucket(value)];
+		m_Sum += value;
+		m_SquaredSum += uint64_t{ value } * value;
+
+		const bool isHitch = value > m_HitchThreshold;
+		m_HitchCount += isHitch;
+		m_TotalHitchCount += isHitch;
+	}
+
+	inline void FrameTimeHistogram::Clear()
+	{
+		const uint32_t hitchThreshold = m_HitchThreshold;
+		*this = {};
+		m_HitchThreshold = hitchThreshold;
+	}
+
+	inline void FrameTimeHistogram::SetHitchThreshold(uint32_t microseconds)
+	{
+		m_HitchThreshold = microseconds;
+		m_HitchCount = static_cast<uint32_t>(std::count_if(m_Window.begin(), m_Window.begin() + m_Count,
+			[&](uint32_t value) { return value > m_HitchThreshold; }));
+	}
+
+	inline uint32_t FrameTimeHistogram::GetPercentile(double fraction) const
+	{
+		if (m_Count == 0) return 0;
+
+		//nearest rank
+		const uint32_t rank = std::clamp(static_cast<uint32_t>(std::ceil(fraction * m_Count)), 1u, m_Count);
+		uint32_t seen{};
+		for (uint32_t bucket{}; bucket < BucketCount; ++bucket)
+		{
+			seen += m_Buckets[bucket];
+			if (seen >= rank) return std::min(GetBucketMidpoint(bucket), GetMax());
+		}
+		return GetMax();
+	}
+
+	inline uint32_t FrameTimeHistogram::GetMax() const
+	{
+		if (m_Count == 0) return 0;
+		return *std::max_element(m_Window.begin(), m_Window.begin() + m_Count);
+	}
+
+	inline double FrameTimeHistogram::GetVariance() const
+	{
+		if (m_Count == 0) return 0.0;
+
+		const double mean = GetMean();
+		return std::max(0.0, static_cast<double>(m_SquaredSum) / m_Count - mean * mean);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Matrix.h"
+#include "RenderQueue.h"
+#include "RenderWorld.h"
+
+namespace dae
+{
+	//A run of instances sharing mesh and material, drawn with one DrawIndexedInstanced
+	struct InstanceBatch
+	{
+		MeshHandle mesh{};
+		MaterialHandle material{};
+		uint32_t firstInstance{};
+		uint32_t instanceCount{};
+	};
+
+	//Cuts a sorted render queue into runs of equal material and mesh
+	//Instance world matrices are written in queue order, ready to be uploaded as one instance buffer,
+	//so batches keep the queue order (opaque first) and instances inside a batch stay sorted by depth
+	class InstanceBatcher final
+	{
+	public:
+		void Build(const std::vector<RenderCommand>& commands, const std::vector<DrawItem>& drawList, const std::vector<Matrix>& worldMatrices);
+
+		const std::vector<InstanceBatch>& GetBatches() const { return m_Batches; }
+		const std::vector<Matrix>& GetInstanceWorldMatrices() const { return m_InstanceWorldMatrices; }
+
+	private:
+		std::vector<InstanceBatch> m_Batches{};
+		std::vector<Matrix> m_InstanceWorldMatrices{};
+	};
+
+	inline void InstanceBatcher::Build(const std::vector<RenderCommand>& commands, const std::vector<DrawItem>& drawList, const std::vector<Matrix>& worldMatrices)
+	{
+		m_Batches.clear();
+		m_InstanceWorldMatrices.resize(commands.size());
+
+		for (uint32_t instance{}; instance < commands.size(); ++instance)
+		{
+			const DrawItem& drawItem = drawList[commands[instance].item];
+			m_InstanceWorldMatrices[instance] = worldMatrices[drawItem.instance];
+
+			if (!m_Batches.empty() && m_Batches.back().mesh == drawItem.mesh && m_Batches.back().material == drawItem.material)
+			{
+				++m_Batches.back().instanceCount;
+				continue;
+			}
+			m_Batches.push_back({ drawItem.mesh, drawItem.material, instance, 1 });
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "InstanceBuffer.h"
+
+#include <bit>
+#include <cstring>
+
+InstanceBuffer::InstanceBuffer(uint32_t stride)
+	: m_Stride{ stride }
+{
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (m_BufferPtr)
+	{
+		m_BufferPtr->Release();
+	}
+}
+
+HRESULT InstanceBuffer::Upload(ID3D11Device* devicePtr, ID3D11DeviceContext* deviceContextPtr, const void* dataPtr, uint32_t count)
+{
+	if (count == 0) return S_OK;
+
+	if (count > m_Capacity)
+	{
+		if (m_BufferPtr)
+		{
+			m_BufferPtr->Release();
+			m_BufferPtr = nullptr;
+		}
+		m_Capacity = 0;
+
+		const uint32_t capacity = std::bit_ceil(std::max(count, 64u));
+
+		D3D11_BUFFER_DESC bd{};
+		bd.Usage = D3D11_USAGE_DYNAMIC;
+		bd.ByteWidth = m_Stride * capacity;
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bd.MiscFlags = 0;
+
+		const HRESULT result = devicePtr->CreateBuffer(&bd, nullptr, &m_BufferPtr);
+		if (FAILED(result)) return result;
+
+		m_Capacity = capacity;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource{};
+	const HRESULT result = deviceContextPtr->Map(m_BufferPtr, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if (FAILED(result)) return result;
+
+	std::memcpy(mappedResource.pData, dataPtr, static_cast<size_t>(m_Stride) * count);
+	deviceContextPtr->Unmap(m_BufferPtr, 0);
+
+	return S_OK;
+}
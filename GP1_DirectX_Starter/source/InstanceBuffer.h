@@ -0,0 +1,26 @@
+#pragma once
+
+//Dynamic vertex buffer holding per-instance data, rewritten every frame with a single discard map
+//The buffer is created on the first Upload and grows to the next power of two when it is too small
+class InstanceBuffer
+{
+public:
+	explicit InstanceBuffer(uint32_t stride);
+	~InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer(InstanceBuffer&&) noexcept = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(InstanceBuffer&&) noexcept = delete;
+
+	//Copies count elements of GetStride() bytes from dataPtr
+	HRESULT Upload(ID3D11Device* devicePtr, ID3D11DeviceContext* deviceContextPtr, const void* dataPtr, uint32_t count);
+
+	ID3D11Buffer* GetBuffer() const { return m_BufferPtr; }
+	uint32_t GetStride() const { return m_Stride; }
+
+private:
+	ID3D11Buffer* m_BufferPtr{};
+	uint32_t m_Stride{};
+	uint32_t m_Capacity{};
+};
@@ -0,0 +1,539 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Profiler.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	//A function with its data, what a job runs is function(dataPtr, index)
+	//The data is not copied, it has to outlive the job: wait on the counter before it goes out of scope
+	struct Job
+	{
+		void (*function)(void* dataPtr, uint32_t index){};
+		void* dataPtr{};
+		uint32_t index{};
+	};
+
+	//Counts the unfinished jobs of a group, JobSystem::Wait joins them
+	//Reusable once it reached zero, and may be the dependency of jobs queued with JobSystem::RunAfter
+	class JobCounter final
+	{
+	public:
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter(JobCounter&&) noexcept = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+		JobCounter& operator=(JobCounter&&) noexcept = delete;
+
+		bool IsDone() const { return m_State.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		static constexpr uint32_t ContinuationBit{ 1u << 30 };
+		static constexpr uint32_t LockBit{ 1u << 31 };
+		static constexpr uint32_t CountMask{ ContinuationBit - 1 };
+
+		//the unfinished jobs in the low bits, a bit while continuations wait and a spin lock bit guarding them.
+		//One word, so the last job releases the counter with a single atomic: a waiter may destroy it right after
+		std::atomic<uint32_t> m_State{};
+		std::vector<std::pair<Job, JobCounter*>> m_Continuations{};
+	};
+
+	//Work stealing job system
+	//Every worker owns a deque: it pushes and pops the newest jobs at the bottom while idle threads steal the oldest
+	//from the top, so related jobs stay on one core and large batches still spread out. The deques are fixed size
+	//Chase-Lev deques, lock free for the owner and for thieves. The thread that creates the job system owns one deque
+	//as well, any other thread queues through a locked queue. Waiting threads run jobs instead of blocking, so jobs
+	//can wait on other jobs and parallel loops can nest
+	class JobSystem final
+	{
+	public:
+		//one worker per hardware thread next to the calling thread
+		static JobSystem& Get()
+		{
+			static JobSystem jobSystem{ std::max(std::thread::hardware_concurrency(), 1u) - 1 };
+			return jobSystem;
+		}
+
+		//without workers every job runs inline, in the order it is queued
+		explicit JobSystem(uint32_t workerCount);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) noexcept = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) noexcept = delete;
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		//Queues job, counter counts it until it ran
+		void Run(const Job& job, JobCounter& counter);
+		//Queues function(dataPtr, index) for every index in [0, count) at once
+		void RunBatch(void (*function)(void* dataPtr, uint32_t index), void* dataPtr, uint32_t count, JobCounter& counter);
+		//Queues job once every job counted by dependency ran
+		void RunAfter(JobCounter& dependency, const Job& job, JobCounter& counter);
+		//Runs queued jobs until every job counted by counter ran
+		void Wait(const JobCounter& counter);
+
+		//Runs task(begin, end) over [0, count) split into ranges of at least grainSize, returns once all of them ran
+		template<typename Task>
+		void ParallelForRange(uint32_t count, uint32_t grainSize, const Task& task);
+		//Runs task(index) for every index in [0, count), returns once every index ran
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+	private:
+		//Fixed size Chase-Lev deque ("Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013)
+		//Slots are relaxed atomics: a thief may read a slot the owner is refilling, it then loses the race on top and
+		//drops what it read
+		class JobDeque final
+		{
+		public:
+			static constexpr int64_t Capacity{ 4096 };
+
+			//false when full
+			bool Push(const Job& job, JobCounter* counterPtr);
+			bool Pop(Job& job, JobCounter*& counterPtr);
+			bool Steal(Job& job, JobCounter*& counterPtr);
+
+		private:
+			struct Slot
+			{
+				std::atomic<void (*)(void*, uint32_t)> function{};
+				std::atomic<void*> dataPtr{};
+				std::atomic<uint32_t> index{};
+				std::atomic<JobCounter*> counterPtr{};
+			};
+
+			//top and bottom on their own cache lines, thieves hammer top while the owner works on bottom
+			alignas(64) std::atomic<int64_t> m_Top{};
+			alignas(64) std::atomic<int64_t> m_Bottom{};
+			alignas(64) std::unique_ptr<Slot[]> m_Slots{ std::make_unique<Slot[]>(Capacity) };
+
+			void Read(int64_t index, Job& job, JobCounter*& counterPtr) const;
+		};
+
+		static constexpr uint32_t ExternalQueue{ UINT32_MAX };
+
+		//deque 0 belongs to the thread that created the job system, deque i + 1 to worker i
+		std::vector<std::unique_ptr<JobDeque>> m_Deques{};
+		std::vector<std::thread> m_Workers{};
+		const std::thread::id m_OwnerThreadId{ std::this_thread::get_id() };
+
+		//jobs queued by every other thread
+		std::mutex m_ExternalMutex{};
+		std::deque<std::pair<Job, JobCounter*>> m_ExternalJobs{};
+		std::atomic<uint32_t> m_ExternalJobCount{};
+
+		//idle workers sleep until a job is queued, queueing only takes the lock while someone sleeps
+		std::mutex m_SleepMutex{};
+		std::condition_variable m_WakeCondition{};
+		std::atomic<uint32_t> m_SleepingCount{};
+		uint64_t m_WakeGeneration{};
+		bool m_IsStopping{ false };
+
+		struct ThreadContext
+		{
+			const JobSystem* jobSystemPtr{};
+			uint32_t queue{};
+		};
+		static ThreadContext& GetThreadContext()
+		{
+			static thread_local ThreadContext context{};
+			return context;
+		}
+
+		uint32_t GetQueue() const;
+		static void LockContinuations(JobCounter& counter);
+		void Enqueue(const Job& job, JobCounter* counterPtr, uint32_t queue);
+		void Wake();
+		bool TryRunJob(uint32_t queue);
+		void Execute(const Job& job, JobCounter* counterPtr);
+		void WorkerLoop(uint32_t queue);
+
+		static void Pause()
+		{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			_mm_pause();
+#endif
+		}
+	};
+
+	inline bool JobSystem::JobDeque::Push(const Job& job, JobCounter* counterPtr)
+	{
+		const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		const int64_t top = m_Top.load(std::memory_order_acquire);
+		if (bottom - top >= Capacity) return false;
+
+		Slot& slot = m_Slots[bottom & (Capacity - 1)];
+		slot.function.store(job.function, std::memory_order_relaxed);
+		slot.dataPtr.store(job.dataPtr, std::memory_order_relaxed);
+		slot.index.store(job.index, std::memory_order_relaxed);
+		slot.counterPtr.store(counterPtr, std::memory_order_relaxed);
+		m_Bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool JobSystem::JobDeque::Pop(Job& job, JobCounter*& counterPtr)
+	{
+		const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		Read(bottom, job, counterPtr);
+		if (top == bottom)
+		{
+			//the last job, a thief may be taking it too
+			const bool hasWon = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return hasWon;
+		}
+		return true;
+	}
+
+	inline bool JobSystem::JobDeque::Steal(Job& job, JobCounter*& counterPtr)
+	{
+		int64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+		if (top >= bottom) return false;
+
+		Read(top, job, counterPtr);
+		return m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	inline void JobSystem::JobDeque::Read(int64_t index, Job& job, JobCounter*& counterPtr) const
+	{
+		const Slot& slot = m_Slots[index & (Capacity - 1)];
+		job.function = slot.function.load(std::memory_order_relaxed);
+		job.dataPtr = slot.dataPtr.load(std::memory_order_relaxed);
+		job.index = slot.index.load(std::memory_order_relaxed);
+		counterPtr = slot.counterPtr.load(std::memory_order_relaxed);
+	}
+
+	inline JobSystem::JobSystem(uint32_t workerCount)
+	{
+		m_Deques.reserve(workerCount + 1);
+		for (uint32_t i{}; i <= workerCount; ++i)
+		{
+			m_Deques.push_back(std::make_unique<JobDeque>());
+		}
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i{}; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back([this, i] { WorkerLoop(i + 1); });
+		}
+	}
+
+	inline JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard lock{ m_SleepMutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	inline uint32_t JobSystem::GetQueue() const
+	{
+		const ThreadContext& context = GetThreadContext();
+		if (context.jobSystemPtr == this) return context.queue;
+		return std::this_thread::get_id() == m_OwnerThreadId ? 0 : ExternalQueue;
+	}
+
+	inline void JobSystem::LockContinuations(JobCounter& counter)
+	{
+		while (counter.m_State.fetch_or(JobCounter::LockBit, std::memory_order_acquire) & JobCounter::LockBit)
+		{
+			Pause();
+		}
+	}
+
+	inline void JobSystem::Run(const Job& job, JobCounter& counter)
+	{
+		counter.m_State.fetch_add(1, std::memory_order_relaxed);
+		Enqueue(job, &counter, GetQueue());
+		Wake();
+	}
+
+	inline void JobSystem::RunBatch(void (*function)(void* dataPtr, uint32_t index), void* dataPtr, uint32_t count, JobCounter& counter)
+	{
+		if (count == 0) return;
+
+		counter.m_State.fetch_add(count, std::memory_order_relaxed);
+		const uint32_t queue = GetQueue();
+		if (queue == ExternalQueue && !m_Workers.empty())
+		{
+			{
+				std::lock_guard lock{ m_ExternalMutex };
+				for (uint32_t index{}; index < count; ++index)
+				{
+					m_ExternalJobs.push_back({ Job{ function, dataPtr, index }, &counter });
+				}
+			}
+			m_ExternalJobCount.fetch_add(count, std::memory_order_release);
+		}
+		else
+		{
+			for (uint32_t index{}; index < count; ++index)
+			{
+				Enqueue({ function, dataPtr, index }, &counter, queue);
+			}
+		}
+		Wake();
+	}
+
+	inline void JobSystem::RunAfter(JobCounter& dependency, const Job& job, JobCounter& counter)
+	{
+		counter.m_State.fetch_add(1, std::memory_order_relaxed);
+
+		//the continuation bit and the last job meet on the same word: either that job sees the bit and queues the
+		//continuations, or this sees that no job is left
+		LockContinuations(dependency);
+		const uint32_t previous = dependency.m_State.fetch_or(JobCounter::ContinuationBit, std::memory_order_acq_rel);
+		if ((previous & JobCounter::CountMask) == 0 && !(previous & JobCounter::ContinuationBit))
+		{
+			dependency.m_State.fetch_and(~(JobCounter::ContinuationBit | JobCounter::LockBit), std::memory_order_release);
+			Enqueue(job, &counter, GetQueue());
+			Wake();
+			return;
+		}
+		dependency.m_Continuations.push_back({ job, &counter });
+		dependency.m_State.fetch_and(~JobCounter::LockBit, std::memory_order_release);
+	}
+
+	inline void JobSystem::Wait(const JobCounter& counter)
+	{
+		const uint32_t queue = GetQueue();
+		while (!counter.IsDone())
+		{
+			if (!TryRunJob(queue))
+			{
+				//the rest is running on other threads
+				Pause();
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	template<typename Task>
+	void JobSystem::ParallelForRange(uint32_t count, uint32_t grainSize, const Task& task)
+	{
+		if (count == 0) return;
+
+		//a few ranges per thread so stealing can even out ranges of uneven cost
+		const uint32_t maxRangeCount = m_Workers.empty() ? 1 : GetThreadCount() * 4;
+		const uint32_t rangeSize = std::max({ grainSize, 1u, (count + maxRangeCount - 1) / maxRangeCount });
+		const uint32_t rangeCount = (count + rangeSize - 1) / rangeSize;
+		if (rangeCount == 1)
+		{
+			task(0u, count);
+			return;
+		}
+
+		struct Data
+		{
+			const Task* taskPtr;
+			uint32_t count;
+			uint32_t rangeSize;
+		};
+		Data data{ &task, count, rangeSize };
+		const auto runRange = [](void* dataPtr, uint32_t range)
+		{
+			const Data& data = *static_cast<const Data*>(dataPtr);
+			const uint32_t begin = range * data.rangeSize;
+			(*data.taskPtr)(begin, std::min(begin + data.rangeSize, data.count));
+		};
+
+		//the last range runs here right away, the others are up for grabs meanwhile
+		JobCounter counter{};
+		RunBatch(runRange, &data, rangeCount - 1, counter);
+		runRange(&data, rangeCount - 1);
+		Wait(counter);
+	}
+
+	inline void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+	{
+		ParallelForRange(count, 1, [&task](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t index{ begin }; index < end; ++index) task(index);
+		});
+	}
+
+	inline void JobSystem::Enqueue(const Job& job, JobCounter* counterPtr, uint32_t queue)
+	{
+		if (m_Workers.empty())
+		{
+			Execute(job, counterPtr);
+		}
+		else if (queue == ExternalQueue)
+		{
+			{
+				std::lock_guard lock{ m_ExternalMutex };
+				m_ExternalJobs.push_back({ job, counterPtr });
+			}
+			m_ExternalJobCount.fetch_add(1, std::memory_order_release);
+		}
+		else if (!m_Deques[queue]->Push(job, counterPtr))
+		{
+			//full, run it now rather than wait for room
+			Execute(job, counterPtr);
+		}
+	}
+
+	inline void JobSystem::Wake()
+	{
+		//pairs with the increment of m_SleepingCount in WorkerLoop: either this sees the sleeper or it sees the job
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_SleepingCount.load(std::memory_order_relaxed) == 0) return;
+
+		{
+			std::lock_guard lock{ m_SleepMutex };
+			++m_WakeGeneration;
+		}
+		m_WakeCondition.notify_all();
+	}
+
+	inline bool JobSystem::TryRunJob(uint32_t queue)
+	{
+		Job job{};
+		JobCounter* counterPtr{};
+
+		//own jobs first, newest first
+		if (queue != ExternalQueue && m_Deques[queue]->Pop(job, counterPtr))
+		{
+			Execute(job, counterPtr);
+			return true;
+		}
+
+		if (m_ExternalJobCount.load(std::memory_order_acquire) > 0)
+		{
+			std::unique_lock lock{ m_ExternalMutex };
+			if (!m_ExternalJobs.empty())
+			{
+				std::tie(job, counterPtr) = m_ExternalJobs.front();
+				m_ExternalJobs.pop_front();
+				m_ExternalJobCount.fetch_sub(1, std::memory_order_relaxed);
+				lock.unlock();
+
+				Execute(job, counterPtr);
+				return true;
+			}
+		}
+
+		//steal the oldest job of another deque, starting next to our own so thieves spread out
+		const uint32_t dequeCount = static_cast<uint32_t>(m_Deques.size());
+		const uint32_t first = queue == ExternalQueue ? 0 : queue + 1;
+		for (uint32_t i{}; i < dequeCount; ++i)
+		{
+			const uint32_t victim = (first + i) % dequeCount;
+			if (victim != queue && m_Deques[victim]->Steal(job, counterPtr))
+			{
+				Execute(job, counterPtr);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline void JobSystem::Execute(const Job& job, JobCounter* counterPtr)
+	{
+		job.function(job.dataPtr, job.index);
+		const uint32_t previous = counterPtr->m_State.fetch_sub(1, std::memory_order_acq_rel);
+		if ((previous & JobCounter::CountMask) != 1 || !(previous & JobCounter::ContinuationBit)) return;
+
+		//the last job of its counter, queue what waited on it. The counter isn't done until the bit is cleared
+		std::vector<std::pair<Job, JobCounter*>> continuations{};
+		LockContinuations(*counterPtr);
+		continuations.swap(counterPtr->m_Continuations);
+		counterPtr->m_State.fetch_and(~(JobCounter::ContinuationBit | JobCounter::LockBit), std::memory_order_release);
+
+		const uint32_t queue = GetQueue();
+		for (const auto& [continuation, continuationCounterPtr] : continuations)
+		{
+			Enqueue(continuation, continuationCounterPtr, queue);
+		}
+		Wake();
+	}
+
+	inline void JobSystem::WorkerLoop(uint32_t queue)
+	{
+		GetThreadContext() = { this, queue };
+		DAE_PROFILE_THREAD("Worker");
+
+		constexpr int spinCount{ 64 };
+		int idleCount{};
+		for (;;)
+		{
+			if (TryRunJob(queue))
+			{
+				idleCount = 0;
+				continue;
+			}
+			if (++idleCount < spinCount)
+			{
+				Pause();
+				continue;
+			}
+
+			//announce the nap, then look once more: a job queued before the announcement is found here, one queued
+			//after it wakes us
+			uint64_t generation{};
+			{
+				std::lock_guard lock{ m_SleepMutex };
+				generation = m_WakeGeneration;
+			}
+			m_SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+			if (TryRunJob(queue))
+			{
+				m_SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+				idleCount = 0;
+				continue;
+			}
+
+			{
+				std::unique_lock lock{ m_SleepMutex };
+				m_WakeCondition.wait(lock, [&] { return m_IsStopping || m_WakeGeneration != generation; });
+				if (m_IsStopping) return;
+			}
+			m_SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+			idleCount = 0;
+		}
+	}
+
+	//Runs task(index) for every index in [0, count) on the shared job system
+	inline void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+	{
+		JobSystem::Get().ParallelFor(count, task);
+	}
+}
@@ -4,4 +4,8 @@
 #include "Vector3.h"
 #include "Vector4.h"
 #include "Matrix.h"
+#include "Quaternion.h"
+#include "Transform.h"
+#include "BoundingVolumes.h"
+#include "PackedFormats.h"
 #include "MathHelpers.h"
\ No newline at end of file
@@ -1,6 +1,24 @@
 #pragma once
+#include <cfloat>
 #include <cmath>
 
+/* --- SIMD SUPPORT --- */
+//SSE2 is baseline on x64, AVX only when the compiler targets it (/arch:AVX, -mavx)
+#if defined(_M_X64) || defined(__SSE2__)
+#define DAE_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define DAE_AVX
+#include <immintrin.h>
+#endif
+
+//AVX2 adds 256 bit integer ops and gathers (/arch:AVX2, -mavx2)
+#if defined(__AVX2__)
+#define DAE_AVX2
+#endif
+
 namespace dae
 {
 	/* --- HELPER STRUCTS --- */
@@ -21,36 +39,36 @@ namespace dae
 	constexpr auto TO_RADIANS(PI / 180.0f);
 
 	/* --- HELPER FUNCTIONS --- */
-	inline float Square(float a)
+	constexpr float Square(float a)
 	{
 		return a * a;
 	}
 
-	inline float Lerpf(float a, float b, float factor)
+	constexpr float Lerpf(float a, float b, float factor)
 	{
 		return ((1 - factor) * a) + (factor * b);
 	}
 
 	inline bool AreEqual(float a, float b, float epsilon = FLT_EPSILON)
 	{
-		return abs(a - b) < epsilon;
+		return std::abs(a - b) < epsilon;
 	}
 
-	inline int Clamp(const int v, int min, int max)
+	constexpr int Clamp(const int v, int min, int max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Clamp(const float v, float min, float max)
+	constexpr float Clamp(const float v, float min, float max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Saturate(const float v)
+	constexpr float Saturate(const float v)
 	{
 		if (v < 0.f) return 0.f;
 		if (v > 1.f) return 1.f;
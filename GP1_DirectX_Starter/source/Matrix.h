@@ -1,60 +1,79 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+
+#include "FastMath.h"
+#include "MathHelpers.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
 namespace dae {
+	//Describes what is known about the layout of a matrix, so the cheapest inverse can be picked
+	enum class MatrixKind
+	{
+		General,	//arbitrary 4x4 (e.g. projection)
+		Affine,		//last column is (0,0,0,1): linear part + translation
+		Rigid		//affine with an orthonormal linear part: rotation + translation
+	};
+
 	struct Matrix
 	{
-		Matrix() = default;
-		Matrix(
+		constexpr Matrix() = default;
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
 			const Vector3& t);
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
 			const Vector4& t);
 
-		Matrix(const Matrix& m);
+		constexpr Matrix(const Matrix& m) = default;
 
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
+		constexpr Vector3 TransformVector(const Vector3& v) const;
+		constexpr Vector3 TransformVector(float x, float y, float z) const;
+		constexpr Vector3 TransformPoint(const Vector3& p) const;
+		constexpr Vector3 TransformPoint(float x, float y, float z) const;
 
-		Vector4 TransformPoint(const Vector4& p) const;
-		Vector4 TransformPoint(float x, float y, float z, float w) const;
+		constexpr Vector4 TransformPoint(const Vector4& p) const;
+		constexpr Vector4 TransformPoint(float x, float y, float z, float w) const;
 
-		const Matrix& Transpose();
+		constexpr const Matrix& Transpose();
 		const Matrix& Inverse();
+		const Matrix& InverseAffine();
+		const Matrix& InverseRigid();
 
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
-
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
-		static Matrix CreateRotationX(float pitch);
-		static Matrix CreateRotationY(float yaw);
-		static Matrix CreateRotationZ(float roll);
-		static Matrix CreateRotation(float pitch, float yaw, float roll);
-		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
+		constexpr Vector3 GetAxisX() const;
+		constexpr Vector3 GetAxisY() const;
+		constexpr Vector3 GetAxisZ() const;
+		constexpr Vector3 GetTranslation() const;
+
+		static constexpr Matrix CreateTranslation(float x, float y, float z);
+		static constexpr Matrix CreateTranslation(const Vector3& t);
+		template<MathPrecision precision = MathPrecision::Precise> static Matrix CreateRotationX(float pitch);
+		template<MathPrecision precision = MathPrecision::Precise> static Matrix CreateRotationY(float yaw);
+		template<MathPrecision precision = MathPrecision::Precise> static Matrix CreateRotationZ(float roll);
+		template<MathPrecision precision = MathPrecision::Precise> static Matrix CreateRotation(float pitch, float yaw, float roll);
+		template<MathPrecision precision = MathPrecision::Precise> static Matrix CreateRotation(const Vector3& r);
+		static constexpr Matrix CreateScale(float sx, float sy, float sz);
+		static constexpr Matrix CreateScale(const Vector3& s);
+		static constexpr Matrix Transpose(const Matrix& m);
 		static Matrix Inverse(const Matrix& m);
+		static Matrix Inverse(const Matrix& m, MatrixKind kind);
+		static Matrix InverseAffine(const Matrix& m);
+		static Matrix InverseRigid(const Matrix& m);
+		static MatrixKind Classify(const Matrix& m, float epsilon = 1e-4f);
 
 		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
 		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
 
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
+		constexpr Vector4& operator[](int index);
+		constexpr Vector4 operator[](int index) const;
+		constexpr Matrix operator*(const Matrix& m) const;
+		constexpr const Matrix& operator*=(const Matrix& m);
 
 	private:
 
@@ -72,4 +91,416 @@ namespace dae {
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
 	};
-}
\ No newline at end of file
+
+	constexpr Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
+		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	{
+	}
+
+	constexpr Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t)
+	{
+		data[0] = xAxis;
+		data[1] = yAxis;
+		data[2] = zAxis;
+		data[3] = t;
+	}
+
+	constexpr Vector3 Matrix::TransformVector(const Vector3& v) const
+	{
+		return TransformVector(v.x, v.y, v.z);
+	}
+
+	constexpr Vector3 Matrix::TransformVector(float x, float y, float z) const
+	{
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z,
+			data[0].y * x + data[1].y * y + data[2].y * z,
+			data[0].z * x + data[1].z * y + data[2].z * z
+		};
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(const Vector3& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z);
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	{
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+		};
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(const Vector4& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z, p.w);
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(float x, float y, float z, float w) const
+	{
+		return Vector4{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
+		};
+	}
+
+	constexpr const Matrix& Matrix::Transpose()
+	{
+		const Matrix copy{ *this };
+		data[0] = { copy.data[0].x, copy.data[1].x, copy.data[2].x, copy.data[3].x };
+		data[1] = { copy.data[0].y, copy.data[1].y, copy.data[2].y, copy.data[3].y };
+		data[2] = { copy.data[0].z, copy.data[1].z, copy.data[2].z, copy.data[3].z };
+		data[3] = { copy.data[0].w, copy.data[1].w, copy.data[2].w, copy.data[3].w };
+
+		return *this;
+	}
+
+	inline const Matrix& Matrix::Inverse()
+	{
+		//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
+		const Vector3& a = data[0];
+		const Vector3& b = data[1];
+		const Vector3& c = data[2];
+		const Vector3& d = data[3];
+
+		const float x = data[0][3];
+		const float y = data[1][3];
+		const float z = data[2][3];
+		const float w = data[3][3];
+
+		Vector3 s = Vector3::Cross(a, b);
+		Vector3 t = Vector3::Cross(c, d);
+		Vector3 u = a * y - b * x;
+		Vector3 v = c * w - d * z;
+
+		const float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		const float invDet = 1.f / det;
+
+		s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+		const Vector3 r0 = Vector3::Cross(b, v) + t * y;
+		const Vector3 r1 = Vector3::Cross(v, a) - t * x;
+		const Vector3 r2 = Vector3::Cross(d, u) + s * w;
+		//Vector3 r3 = Vector3::Cross(u, c) - s * z;
+
+		data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
+		data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
+		data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
+		data[3] = {-Vector3::Dot(b, t),Vector3::Dot(a, t),-Vector3::Dot(d, s),Vector3::Dot(c, s) };
+
+		return *this;
+	}
+
+	inline const Matrix& Matrix::InverseAffine()
+	{
+		//Inverse of [L 0; t 1] is [L^-1 0; -t*L^-1 1], L^-1 = adjugate / det (rows a, b, c)
+#if defined(DAE_SSE)
+		const __m128 a = _mm_loadu_ps(&data[0].x);
+		const __m128 b = _mm_loadu_ps(&data[1].x);
+		const __m128 c = _mm_loadu_ps(&data[2].x);
+		const __m128 t = _mm_loadu_ps(&data[3].x);
+
+		const auto cross = [](__m128 v1, __m128 v2)
+		{
+			const __m128 v1YZX = _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 v2YZX = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 r = _mm_sub_ps(_mm_mul_ps(v1, v2YZX), _mm_mul_ps(v1YZX, v2));
+			return _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 0, 2, 1));
+		};
+
+		__m128 r0 = cross(b, c);
+		__m128 r1 = cross(c, a);
+		__m128 r2 = cross(a, b);
+
+		//det = a . (b x c)
+		const __m128 d = _mm_mul_ps(a, r0);
+		const float det = _mm_cvtss_f32(d) + _mm_cvtss_f32(_mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1)))
+			+ _mm_cvtss_f32(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2)));
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+
+		//the cross products are the columns of the inverse, transpose them into rows
+		__m128 r3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		const __m128 invDet = _mm_set1_ps(1.f / det);
+		r0 = _mm_mul_ps(r0, invDet);
+		r1 = _mm_mul_ps(r1, invDet);
+		r2 = _mm_mul_ps(r2, invDet);
+
+		const __m128 tx = _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 ty = _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 tz = _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2));
+		r3 = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, r0), _mm_mul_ps(ty, r1)), _mm_mul_ps(tz, r2)));
+
+		_mm_storeu_ps(&data[0].x, r0);
+		_mm_storeu_ps(&data[1].x, r1);
+		_mm_storeu_ps(&data[2].x, r2);
+		_mm_storeu_ps(&data[3].x, r3);
+		data[3].w = 1.f;
+#else
+		const Vector3 a = data[0];
+		const Vector3 b = data[1];
+		const Vector3 c = data[2];
+		const Vector3 t = data[3];
+
+		const Vector3 bc = Vector3::Cross(b, c);
+		const Vector3 ca = Vector3::Cross(c, a);
+		const Vector3 ab = Vector3::Cross(a, b);
+
+		const float det = Vector3::Dot(a, bc);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		const float invDet = 1.f / det;
+
+		const Vector3 r0 = Vector3{ bc.x, ca.x, ab.x } * invDet;
+		const Vector3 r1 = Vector3{ bc.y, ca.y, ab.y } * invDet;
+		const Vector3 r2 = Vector3{ bc.z, ca.z, ab.z } * invDet;
+
+		data[0] = { r0, 0.f };
+		data[1] = { r1, 0.f };
+		data[2] = { r2, 0.f };
+		data[3] = { -(r0 * t.x + r1 * t.y + r2 * t.z), 1.f };
+#endif
+		return *this;
+	}
+
+	inline const Matrix& Matrix::InverseRigid()
+	{
+		//Orthonormal basis: L^-1 = L^T, so the inverse is [L^T 0; -t*L^T 1]
+#if defined(DAE_SSE)
+		__m128 r0 = _mm_loadu_ps(&data[0].x);
+		__m128 r1 = _mm_loadu_ps(&data[1].x);
+		__m128 r2 = _mm_loadu_ps(&data[2].x);
+		const __m128 t = _mm_loadu_ps(&data[3].x);
+		//the zero row becomes the w column of the transposed rows
+		__m128 r3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		const __m128 tx = _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 ty = _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 tz = _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2));
+		r3 = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, r0), _mm_mul_ps(ty, r1)), _mm_mul_ps(tz, r2)));
+
+		_mm_storeu_ps(&data[0].x, r0);
+		_mm_storeu_ps(&data[1].x, r1);
+		_mm_storeu_ps(&data[2].x, r2);
+		_mm_storeu_ps(&data[3].x, r3);
+		data[3].w = 1.f;
+#else
+		const Vector3 a = data[0];
+		const Vector3 b = data[1];
+		const Vector3 c = data[2];
+		const Vector3 t = data[3];
+
+		data[0] = { a.x, b.x, c.x, 0.f };
+		data[1] = { a.y, b.y, c.y, 0.f };
+		data[2] = { a.z, b.z, c.z, 0.f };
+		data[3] = { -Vector3::Dot(t, a), -Vector3::Dot(t, b), -Vector3::Dot(t, c), 1.f };
+#endif
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Transpose(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Transpose();
+
+		return out;
+	}
+
+	inline Matrix Matrix::Inverse(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Inverse();
+
+		return out;
+	}
+
+	inline Matrix Matrix::Inverse(const Matrix& m, MatrixKind kind)
+	{
+		switch (kind)
+		{
+		case MatrixKind::Rigid:
+			return InverseRigid(m);
+		case MatrixKind::Affine:
+			return InverseAffine(m);
+		default:
+			return Inverse(m);
+		}
+	}
+
+	inline Matrix Matrix::InverseAffine(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.InverseAffine();
+
+		return out;
+	}
+
+	inline Matrix Matrix::InverseRigid(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.InverseRigid();
+
+		return out;
+	}
+
+	inline MatrixKind Matrix::Classify(const Matrix& m, float epsilon)
+	{
+		if (!AreEqual(m[0].w, 0.f, epsilon) || !AreEqual(m[1].w, 0.f, epsilon) ||
+			!AreEqual(m[2].w, 0.f, epsilon) || !AreEqual(m[3].w, 1.f, epsilon))
+		{
+			return MatrixKind::General;
+		}
+
+		const Vector3 a = m[0];
+		const Vector3 b = m[1];
+		const Vector3 c = m[2];
+
+		const bool isOrthonormal =
+			AreEqual(a.SqrMagnitude(), 1.f, epsilon) && AreEqual(b.SqrMagnitude(), 1.f, epsilon) && AreEqual(c.SqrMagnitude(), 1.f, epsilon) &&
+			AreEqual(Vector3::Dot(a, b), 0.f, epsilon) && AreEqual(Vector3::Dot(b, c), 0.f, epsilon) && AreEqual(Vector3::Dot(c, a), 0.f, epsilon);
+
+		return isOrthonormal ? MatrixKind::Rigid : MatrixKind::Affine;
+	}
+
+	inline Matrix Matrix::CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up)
+	{
+		assert(false && "Not Implemented");
+		return {};
+	}
+
+	inline Matrix Matrix::CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf)
+	{
+		assert(false && "Not Implemented");
+		return {};
+	}
+
+	constexpr Vector3 Matrix::GetAxisX() const
+	{
+		return data[0];
+	}
+
+	constexpr Vector3 Matrix::GetAxisY() const
+	{
+		return data[1];
+	}
+
+	constexpr Vector3 Matrix::GetAxisZ() const
+	{
+		return data[2];
+	}
+
+	constexpr Vector3 Matrix::GetTranslation() const
+	{
+		return data[3];
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(float x, float y, float z)
+	{
+		return CreateTranslation({ x, y, z });
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(const Vector3& t)
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	template<MathPrecision precision>
+	Matrix Matrix::CreateRotationX(float pitch)
+	{
+		float s{}, c{};
+		SinCos<precision>(pitch, s, c);
+		return {
+			{1, 0, 0, 0},
+			{0, c, -s, 0},
+			{0, s, c, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	template<MathPrecision precision>
+	Matrix Matrix::CreateRotationY(float yaw)
+	{
+		float s{}, c{};
+		SinCos<precision>(yaw, s, c);
+		return {
+			{c, 0, -s, 0},
+			{0, 1, 0, 0},
+			{s, 0, c, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	template<MathPrecision precision>
+	Matrix Matrix::CreateRotationZ(float roll)
+	{
+		float s{}, c{};
+		SinCos<precision>(roll, s, c);
+		return {
+			{c, s, 0, 0},
+			{-s, c, 0, 0},
+			{0, 0, 1, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	template<MathPrecision precision>
+	Matrix Matrix::CreateRotation(float pitch, float yaw, float roll)
+	{
+		return CreateRotation<precision>({ pitch, yaw, roll });
+	}
+
+	template<MathPrecision precision>
+	Matrix Matrix::CreateRotation(const Vector3& r)
+	{
+		return CreateRotationX<precision>(r[0]) * CreateRotationY<precision>(r[1]) * CreateRotationZ<precision>(r[2]);
+	}
+
+	constexpr Matrix Matrix::CreateScale(float sx, float sy, float sz)
+	{
+		return { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, Vector3::Zero };
+	}
+
+	constexpr Matrix Matrix::CreateScale(const Vector3& s)
+	{
+		return CreateScale(s[0], s[1], s[2]);
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4& Matrix::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Vector4 Matrix::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Matrix Matrix::operator*(const Matrix& m) const
+	{
+		//row-vector convention: result row r is the combination of the rows of m weighted by row r of this
+		Matrix result{};
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			const Vector4& row = data[r];
+			result.data[r] = m.data[0] * row.x + m.data[1] * row.y + m.data[2] * row.z + m.data[3] * row.w;
+		}
+
+		return result;
+	}
+
+	constexpr const Matrix& Matrix::operator*=(const Matrix& m)
+	{
+		*this = *this * m;
+		return *this;
+	}
+#pragma endregion
+}
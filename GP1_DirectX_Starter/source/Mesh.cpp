@@ -1,14 +1,16 @@
 #include "pch.h"
 #include "Mesh.h"
+#include "Profiler.h"
 
-Mesh::Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, BaseEffect* effect)
-	: m_Vertices{ vertices }
-	, m_Indices{ indices }
-	, m_EffectPtr{ effect }
+#include <cassert>
+#include <cstring>
+
+Mesh::Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const BaseEffect* effect)
 {
-	//Create Vertex Layout
+	//Create Vertex Layout, the instanced layout appends the rows of the per-instance world matrix from slot 1
 	static constexpr uint32_t numElements{ 5 };
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
+	static constexpr uint32_t numInstancedElements{ numElements + 4 };
+	D3D11_INPUT_ELEMENT_DESC vertexDesc[numInstancedElements]{};
 
 	vertexDesc[0].SemanticName = "POSITION";
 	vertexDesc[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
@@ -35,9 +37,21 @@ Mesh::Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const s
 	vertexDesc[4].AlignedByteOffset = 44;
 	vertexDesc[4].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
+	for (uint32_t row{}; row < 4; ++row)
+	{
+		D3D11_INPUT_ELEMENT_DESC& instanceDesc = vertexDesc[numElements + row];
+		instanceDesc.SemanticName = "WORLD";
+		instanceDesc.SemanticIndex = row;
+		instanceDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		instanceDesc.InputSlot = 1;
+		instanceDesc.AlignedByteOffset = row * sizeof(dae::Vector4);
+		instanceDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+		instanceDesc.InstanceDataStepRate = 1;
+	}
+
 	//Create Input Layout
 	D3DX11_PASS_DESC passDesc{};
-	m_EffectPtr->GetTechnique()->GetPassByIndex(0)->GetDesc(&passDesc);
+	effect->GetTechnique()->GetPassByIndex(0)->GetDesc(&passDesc);
 
 	HRESULT result = devicePtr->CreateInputLayout(
 		vertexDesc,
@@ -48,41 +62,57 @@ Mesh::Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const s
 
 	if (FAILED(result)) return;
 
+	if (ID3DX11EffectTechnique* instancedTechniquePtr = effect->GetInstancedTechnique())
+	{
+		instancedTechniquePtr->GetPassByIndex(0)->GetDesc(&passDesc);
+
+		result = devicePtr->CreateInputLayout(
+			vertexDesc,
+			numInstancedElements,
+			passDesc.pIAInputSignature,
+			passDesc.IAInputSignatureSize,
+			&m_InstancedInputLayout);
+
+		if (FAILED(result)) return;
+	}
+
 	// Create vertex buffer
 	D3D11_BUFFER_DESC bd = {};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(m_Vertices.size());
+	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData = {};
-	initData.pSysMem = m_Vertices.data();
+	initData.pSysMem = vertices.data();
 
 	result = devicePtr->CreateBuffer(&bd, &initData, &m_VertexBufferPtr);
 	if (FAILED(result)) return;
 
-	//Create index buffer
-	m_NumIndices = static_cast<uint32_t>(m_Indices.size());
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
+	//Create index buffer, blended meshes get a dynamic one so their triangles can be sorted back-to-front
+	m_NumIndices = static_cast<uint32_t>(indices.size());
+	m_HasDynamicIndices = effect->IsTransparent();
+	bd.Usage = m_HasDynamicIndices ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE;
 	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bd.CPUAccessFlags = 0;
+	bd.CPUAccessFlags = m_HasDynamicIndices ? D3D11_CPU_ACCESS_WRITE : 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = m_Indices.data();
+	initData.pSysMem = indices.data();
 	result = devicePtr->CreateBuffer(&bd, &initData, &m_IndexBufferPtr);
 	if (FAILED(result)) return;
 }
 
 Mesh::~Mesh()
 {
-	delete m_EffectPtr;
-	m_EffectPtr = nullptr;
-
 	if (m_InputLayout)
 	{
 		m_InputLayout->Release();
 	}
+	if (m_InstancedInputLayout)
+	{
+		m_InstancedInputLayout->Release();
+	}
 	if (m_VertexBufferPtr)
 	{
 		m_VertexBufferPtr->Release();
@@ -93,7 +123,24 @@ Mesh::~Mesh()
 	}
 }
 
-void Mesh::Render(ID3D11DeviceContext* deviceContextPtr, const float* dataPtr)
+void Mesh::UpdateIndices(ID3D11DeviceContext* deviceContextPtr, const std::vector<uint32_t>& indices) const
+{
+	assert(indices.size() == static_cast<size_t>(m_NumIndices));
+	if (!m_HasDynamicIndices || !m_IndexBufferPtr) return;
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource{};
+	if (FAILED(deviceContextPtr->Map(m_IndexBufferPtr, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) return;
+	std::memcpy(mappedResource.pData, indices.data(), sizeof(uint32_t) * indices.size());
+	deviceContextPtr->Unmap(m_IndexBufferPtr, 0);
+}
+
+void Mesh::Render(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix) const
+{
+	Bind(deviceContextPtr);
+	Draw(deviceContextPtr, effectPtr, worldMatrix, worldViewProjectionMatrix);
+}
+
+void Mesh::Bind(ID3D11DeviceContext* deviceContextPtr) const
 {
 	//1. Set Primitive Topology
 	deviceContextPtr->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -101,9 +148,6 @@ void Mesh::Render(ID3D11DeviceContext* deviceContextPtr, const float* dataPtr)
 	//2. Set Input Layout
 	deviceContextPtr->IASetInputLayout(m_InputLayout);
 
-	m_EffectPtr->GetWorldViewProjMatrix()->SetMatrix(dataPtr);
-	m_EffectPtr->GetWorldMatrix()->SetMatrix(reinterpret_cast<const float*>(&m_WorldMatrix));
-
 	//3. Set VertexBuffer
 	constexpr UINT stride = sizeof(Vertex);
 	constexpr UINT offset = 0;
@@ -111,13 +155,53 @@ void Mesh::Render(ID3D11DeviceContext* deviceContextPtr, const float* dataPtr)
 
 	//4. Set IndexBuffer
 	deviceContextPtr->IASetIndexBuffer(m_IndexBufferPtr, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void Mesh::Draw(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix) const
+{
+	DAE_PROFILE_FUNCTION();
+	effectPtr->GetWorldViewProjMatrix()->SetMatrix(reinterpret_cast<const float*>(&worldViewProjectionMatrix));
+	effectPtr->GetWorldMatrix()->SetMatrix(reinterpret_cast<const float*>(&worldMatrix));
 
-	//5. Draw
+	//5. Draw, applying the pass uploads the matrices
 	D3DX11_TECHNIQUE_DESC techDesc{};
-	m_EffectPtr->GetTechnique()->GetDesc(&techDesc);
+	effectPtr->GetTechnique()->GetDesc(&techDesc);
 	for (UINT p = 0; p < techDesc.Passes; ++p)
 	{
-		m_EffectPtr->GetTechnique()->GetPassByIndex(p)->Apply(0, deviceContextPtr);
+		effectPtr->GetTechnique()->GetPassByIndex(p)->Apply(0, deviceContextPtr);
 		deviceContextPtr->DrawIndexed(m_NumIndices,  0, 0);
 	}
 }
+
+void Mesh::RenderInstanced(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, ID3D11Buffer* instanceBufferPtr, uint32_t firstInstance, uint32_t instanceCount) const
+{
+	BindInstanced(deviceContextPtr, instanceBufferPtr);
+	DrawInstanced(deviceContextPtr, effectPtr, firstInstance, instanceCount);
+}
+
+void Mesh::BindInstanced(ID3D11DeviceContext* deviceContextPtr, ID3D11Buffer* instanceBufferPtr) const
+{
+	deviceContextPtr->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	deviceContextPtr->IASetInputLayout(m_InstancedInputLayout);
+
+	// slot 0: vertices, slot 1: one world matrix per instance
+	ID3D11Buffer* buffers[2]{ m_VertexBufferPtr, instanceBufferPtr };
+	constexpr UINT strides[2]{ sizeof(Vertex), sizeof(dae::Matrix) };
+	constexpr UINT offsets[2]{ 0, 0 };
+	deviceContextPtr->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+
+	deviceContextPtr->IASetIndexBuffer(m_IndexBufferPtr, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void Mesh::DrawInstanced(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, uint32_t firstInstance, uint32_t instanceCount) const
+{
+	DAE_PROFILE_FUNCTION();
+	ID3DX11EffectTechnique* techniquePtr = effectPtr->GetInstancedTechnique();
+	D3DX11_TECHNIQUE_DESC techDesc{};
+	techniquePtr->GetDesc(&techDesc);
+	for (UINT p = 0; p < techDesc.Passes; ++p)
+	{
+		techniquePtr->GetPassByIndex(p)->Apply(0, deviceContextPtr);
+		deviceContextPtr->DrawIndexedInstanced(m_NumIndices, instanceCount, 0, 0, firstInstance);
+	}
+}
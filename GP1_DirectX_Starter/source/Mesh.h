@@ -1,39 +1,41 @@
 #pragma once
+#include "RenderBackend.h"
 #include "VehicleEffect.h"
 
 class Mesh
 {
 public:
-	struct Vertex
-	{
-		dae::Vector3 position;
-		dae::Vector3 color;
-		dae::Vector2 uv;
-		dae::Vector3 normal;
-		dae::Vector3 tangent;
-	};
-	Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, BaseEffect* effect);
+	using Vertex = dae::MeshVertex;
+
+	//effect is only used to build the input layout, the mesh does not own it
+	Mesh(ID3D11Device* devicePtr, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const BaseEffect* effect);
 	~Mesh();
 
-	void Render(ID3D11DeviceContext* deviceContextPtr, const float* dataPtr);
+	Mesh(const Mesh&) = delete;
+	Mesh(Mesh&&) noexcept = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	Mesh& operator=(Mesh&&) noexcept = delete;
 
-	dae::Matrix& GetWorldMatrix() { return m_WorldMatrix; }
-	BaseEffect* GetEffectPtr() const { return m_EffectPtr; }
-private:
-	std::vector<Vertex> m_Vertices{};
-	std::vector<uint32_t> m_Indices{};
+	//Render = Bind + Draw, a render queue calls Bind only when the previous draw used another mesh
+	void Render(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix) const;
+	void Bind(ID3D11DeviceContext* deviceContextPtr) const;
+	void Draw(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, const dae::Matrix& worldMatrix, const dae::Matrix& worldViewProjectionMatrix) const;
 
-	BaseEffect* m_EffectPtr;
+	//Draws instanceCount copies whose world matrices start at firstInstance in instanceBufferPtr
+	//effectPtr needs an instanced technique, its view projection matrix has to be set by the caller
+	void RenderInstanced(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, ID3D11Buffer* instanceBufferPtr, uint32_t firstInstance, uint32_t instanceCount) const;
+	void BindInstanced(ID3D11DeviceContext* deviceContextPtr, ID3D11Buffer* instanceBufferPtr) const;
+	void DrawInstanced(ID3D11DeviceContext* deviceContextPtr, const BaseEffect* effectPtr, uint32_t firstInstance, uint32_t instanceCount) const;
 
+	//Replaces the draw order of the triangles, only meshes of a transparent effect have a writable index buffer
+	//indices has to hold the same triangles as the ones the mesh was created with
+	void UpdateIndices(ID3D11DeviceContext* deviceContextPtr, const std::vector<uint32_t>& indices) const;
+	bool HasDynamicIndices() const { return m_HasDynamicIndices; }
+private:
 	ID3D11Buffer* m_VertexBufferPtr{};
 	ID3D11Buffer* m_IndexBufferPtr{};
 	ID3D11InputLayout* m_InputLayout{};
+	ID3D11InputLayout* m_InstancedInputLayout{};
 	int m_NumIndices{};
-
-	dae::Matrix m_WorldMatrix{
-		{1.0f,	0.0f,	0.0f},
-		{0.0f,	1.0f,	0.0f},
-		{0.0f,	0.0f,	1.0f},
-		{0.0f,	0.0f,	0.0f}
-	};
+	bool m_HasDynamicIndices{ false };
 };
\ No newline at end of file
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.h"
+#include "RenderBackend.h"
+
+namespace dae
+{
+	//A draw or bind that reached the backend, in submission order
+	struct NullRenderCommand
+	{
+		enum class Type : uint8_t
+		{
+			BindMesh,
+			Draw,
+			DrawInstanced
+		};
+
+		Type type{};
+		MeshHandle mesh{};
+		MaterialHandle material{};
+		uint32_t firstInstance{};
+		uint32_t instanceCount{};
+	};
+
+	//Totals of one frame: the draws and uploads since the last BeginFrame
+	struct NullRenderCounters
+	{
+		uint32_t drawCount{};
+		uint32_t meshBindCount{};
+		uint64_t instanceCount{};
+		uint64_t triangleCount{};
+		uint64_t uploadedBytes{}; //instance and index buffer updates
+	};
+
+	//Backend without a device: it records the commands it receives and counts draws and bytes,
+	//so the whole update, cull, sort and submit path runs headless, for CPU benchmarks and checks
+	class NullRenderBackend final : public RenderBackend
+	{
+	public:
+		//maxChunkCount 0 keeps RecordParallel unsupported, like a device without deferred contexts
+		explicit NullRenderBackend(uint32_t maxChunkCount = 0);
+
+		MeshHandle CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle material) override;
+		void UpdateIndices(MeshHandle mesh, const std::vector<uint32_t>& indices) override;
+		void UploadInstances(const Matrix* worldMatricesPtr, uint32_t count) override;
+
+		//mirrors the effect files: the fire fx blends and has no instanced technique
+		MaterialHandle CreateMaterial(MaterialType type) override;
+		bool IsTransparent(MaterialHandle material) const override { return m_MaterialTypes[material] == MaterialType::FireFX; }
+		bool SupportsInstancing(MaterialHandle material) const override { return m_MaterialTypes[material] == MaterialType::Vehicle; }
+		void SetCameraPosition(const Vector3&) override {}
+		void SetSamplerState(int) override {}
+		void SetUseNormalMap(bool) override {}
+
+		void BeginFrame() override;
+		void EndFrame() override {}
+		RenderContext& GetImmediateContext() override { return m_Contexts[0]; }
+
+		uint32_t GetMaxChunkCount() const override { return m_MaxChunkCount; }
+		uint32_t RecordParallel(uint32_t commandCount, const RecordChunkFunction& recordChunk) override;
+
+		//commands since the last BeginFrame, parallel chunks appear in chunk order
+		const std::vector<NullRenderCommand>& GetCommands() const { return m_Contexts[0].commands; }
+		const NullRenderCounters& GetCounters() const { return m_Contexts[0].counters; }
+		//vertex and index bytes of every mesh created so far
+		uint64_t GetMeshBytes() const { return m_MeshBytes; }
+
+	private:
+		class Context final : public RenderContext
+		{
+		public:
+			explicit Context(const NullRenderBackend& backend) : m_Backend{ backend } {}
+
+			void BindMesh(MeshHandle mesh, bool isInstanced) override;
+			void Draw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix) override;
+			void DrawInstanced(MeshHandle mesh, MaterialHandle material, const Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount) override;
+
+			void Clear();
+			void Append(const Context& other);
+
+			std::vector<NullRenderCommand> commands{};
+			NullRenderCounters counters{};
+
+		private:
+			const NullRenderBackend& m_Backend;
+		};
+
+		//index 0 is the immediate context, chunk i records into index i + 1
+		std::vector<Context> m_Contexts{};
+		std::vector<CommandChunk> m_Chunks{};
+		std::vector<MaterialType> m_MaterialTypes{};
+		std::vector<uint32_t> m_MeshIndexCounts{};
+		uint64_t m_MeshBytes{};
+		uint32_t m_MaxChunkCount{};
+
+		//fewer commands than this per chunk are not worth a thread, same as the device backend
+		static constexpr uint32_t m_MinChunkSize{ 256 };
+	};
+
+	inline NullRenderBackend::NullRenderBackend(uint32_t maxChunkCount)
+		: m_MaxChunkCount{ maxChunkCount }
+	{
+		m_Contexts.reserve(maxChunkCount + 1);
+		for (uint32_t i{}; i < maxChunkCount + 1; ++i)
+		{
+			m_Contexts.emplace_back(*this);
+		}
+	}
+
+	inline MeshHandle NullRenderBackend::CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle)
+	{
+		m_MeshBytes += vertices.size() * sizeof(MeshVertex) + indices.size() * sizeof(uint32_t);
+		m_MeshIndexCounts.push_back(static_cast<uint32_t>(indices.size()));
+		return static_cast<MeshHandle>(m_MeshIndexCounts.size() - 1);
+	}
+
+	inline void NullRenderBackend::UpdateIndices(MeshHandle, const std::vector<uint32_t>& indices)
+	{
+		m_Contexts[0].counters.uploadedBytes += indices.size() * sizeof(uint32_t);
+	}
+
+	inline void NullRenderBackend::UploadInstances(const Matrix*, uint32_t count)
+	{
+		m_Contexts[0].counters.uploadedBytes += uint64_t{ count } * sizeof(Matrix);
+	}
+
+	inline MaterialHandle NullRenderBackend::CreateMaterial(MaterialType type)
+	{
+		m_MaterialTypes.push_back(type);
+		return static_cast<MaterialHandle>(m_MaterialTypes.size() - 1);
+	}
+
+	inline void NullRenderBackend::BeginFrame()
+	{
+		m_Contexts[0].Clear();
+	}
+
+	inline uint32_t NullRenderBackend::RecordParallel(uint32_t commandCount, const RecordChunkFunction& recordChunk)
+	{
+		ParallelCommandRecorder::Split(commandCount, m_MaxChunkCount, m_MinChunkSize, m_Chunks);
+
+		const uint32_t chunkCount = static_cast<uint32_t>(m_Chunks.size());
+		ParallelFor(chunkCount, [&](uint32_t chunkIndex)
+		{
+			Context& context = m_Contexts[chunkIndex + 1];
+			context.Clear();
+			recordChunk(context, chunkIndex, m_Chunks[chunkIndex]);
+		});
+
+		for (uint32_t chunk{}; chunk < chunkCount; ++chunk)
+		{
+			m_Contexts[0].Append(m_Contexts[chunk + 1]);
+		}
+		return chunkCount;
+	}
+
+	inline void NullRenderBackend::Context::BindMesh(MeshHandle mesh, bool)
+	{
+		commands.push_back({ NullRenderCommand::Type::BindMesh, mesh });
+		++counters.meshBindCount;
+	}
+
+	inline void NullRenderBackend::Context::Draw(MeshHandle mesh, MaterialHandle material, const Matrix&, const Matrix&)
+	{
+		commands.push_back({ NullRenderCommand::Type::Draw, mesh, material, 0, 1 });
+		++counters.drawCount;
+		++counters.instanceCount;
+		counters.triangleCount += m_Backend.m_MeshIndexCounts[mesh] / 3;
+	}
+
+	inline void NullRenderBackend::Context::DrawInstanced(MeshHandle mesh, MaterialHandle material, const Matrix&, uint32_t firstInstance, uint32_t instanceCount)
+	{
+		commands.push_back({ NullRenderCommand::Type::DrawInstanced, mesh, material, firstInstance, instanceCount });
+		++counters.drawCount;
+		counters.instanceCount += instanceCount;
+		counters.triangleCount += uint64_t{ m_Backend.m_MeshIndexCounts[mesh] / 3 } * instanceCount;
+	}
+
+	inline void NullRenderBackend::Context::Clear()
+	{
+		commands.clear();
+		counters = NullRenderCounters{};
+	}
+
+	inline void NullRenderBackend::Context::Append(const Context& other)
+	{
+		commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+		counters.drawCount += other.counters.drawCount;
+		counters.meshBindCount += other.counters.meshBindCount;
+		counters.instanceCount += other.counters.instanceCount;
+		counters.triangleCount += other.counters.triangleCount;
+	}
+}
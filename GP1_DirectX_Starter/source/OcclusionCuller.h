@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "BoundingVolumes.h"
+#include "JobSystem.h"
+#include "MathHelpers.h"
+#include "Matrix.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//Software occlusion culling against a low resolution CPU depth buffer
+	//Per frame: BeginFrame, add a few large simplified occluders, Rasterize, then test the bounds of everything else.
+	//Occluder triangles are binned to 32x16 pixel tiles, the tiles are rasterized in parallel, 4 pixels at a time with SSE.
+	//Every tile also keeps its farthest depth, so most tests are decided per tile before touching pixels.
+	//Depth is D3D clip space z / w (0 near, 1 far). Everything is conservative: triangles crossing the near plane are
+	//dropped as occluders, only pixels whose center an occluder covers get its depth, boxes crossing the near plane stay visible.
+	class OcclusionCuller final
+	{
+	public:
+		static constexpr int Width{ 256 };
+		static constexpr int Height{ 128 };
+		static constexpr int TileWidth{ 32 };
+		static constexpr int TileHeight{ 16 };
+		static constexpr int TilesX{ Width / TileWidth };
+		static constexpr int TilesY{ Height / TileHeight };
+		static constexpr int TileCount{ TilesX * TilesY };
+
+		OcclusionCuller() : m_Depth(Width * Height, 1.f) {}
+
+		//Clears the depth buffer and the binned occluders
+		void BeginFrame(const Matrix& viewProjection);
+
+		//positionsPtr points at the first position of a vertex array with the given stride in bytes, as in Aabb::FromPoints
+		void AddOccluder(const Vector3* positionsPtr, size_t vertexCount, size_t stride, const uint32_t* indicesPtr, size_t indexCount, const Matrix& world);
+		//the 12 triangles of a box, the usual simplified occluder
+		void AddOccluderBox(const Aabb& box, const Matrix& world);
+
+		//Rasterizes every binned occluder triangle, tiles run in parallel on jobSystem
+		void Rasterize(JobSystem& jobSystem);
+		void Rasterize() { Rasterize(JobSystem::Get()); }
+
+		//false when the box lies behind the depth buffer everywhere it covers on screen
+		bool IsVisible(const Aabb& worldBounds) const;
+
+		size_t GetTriangleCount() const { return m_Triangles.size(); }
+		//Width * Height depths, row-major, top row first
+		const std::vector<float>& GetDepth() const { return m_Depth; }
+
+	private:
+		//edge functions and depth as planes in screen space: value = a * x + b * y + c at pixel center (x, y)
+		struct ScreenTriangle
+		{
+			float edgeA[3]{};
+			float edgeB[3]{};
+			float edgeC[3]{};
+			float depthA{};
+			float depthB{};
+			float depthC{};
+			int minX{}, minY{}, maxX{}, maxY{}; //inclusive pixel bounds
+		};
+
+		Matrix m_ViewProjection{};
+		std::vector<float> m_Depth{};
+		std::array<float, TileCount> m_TileMaxDepth{};
+
+		std::vector<ScreenTriangle> m_Triangles{};
+		std::array<std::vector<uint32_t>, TileCount> m_TileBins{};
+		std::vector<Vector4> m_ClipPositions{};
+
+		static constexpr float m_MinClipW{ 1e-4f };
+		//a few ulps near 1, so a box is only culled when it is clearly behind, not when it touches the occluder
+		static constexpr float m_DepthBias{ 1e-6f };
+
+		static Vector3 ToScreen(const Vector4& clip)
+		{
+			const float invW = 1.f / clip.w;
+			return { (clip.x * invW * 0.5f + 0.5f) * Width, (0.5f - clip.y * invW * 0.5f) * Height, clip.z * invW };
+		}
+
+		void AddTriangle(const Vector4& clip0, const Vector4& clip1, const Vector4& clip2);
+		void RasterizeTile(int tile);
+	};
+
+	inline void OcclusionCuller::BeginFrame(const Matrix& viewProjection)
+	{
+		m_ViewProjection = viewProjection;
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.f);
+		m_TileMaxDepth.fill(1.f);
+		m_Triangles.clear();
+		for (std::vector<uint32_t>& bin : m_TileBins)
+		{
+			bin.clear();
+		}
+	}
+
+	inline void OcclusionCuller::AddOccluder(const Vector3* positionsPtr, size_t vertexCount, size_t stride, const uint32_t* indicesPtr, size_t indexCount, const Matrix& world)
+	{
+		const Matrix worldViewProjection = world * m_ViewProjection;
+		m_ClipPositions.resize(vertexCount);
+		const char* bytePtr = reinterpret_cast<const char*>(positionsPtr);
+		for (size_t i{}; i < vertexCount; ++i)
+		{
+			const Vector3& position = *reinterpret_cast<const Vector3*>(bytePtr + i * stride);
+			m_ClipPositions[i] = worldViewProjection.TransformPoint(Vector4{ position, 1.f });
+		}
+
+		for (size_t i{}; i + 2 < indexCount; i += 3)
+		{
+			AddTriangle(m_ClipPositions[indicesPtr[i]], m_ClipPositions[indicesPtr[i + 1]], m_ClipPositions[indicesPtr[i + 2]]);
+		}
+	}
+
+	inline void OcclusionCuller::AddOccluderBox(const Aabb& box, const Matrix& world)
+	{
+		const Vector3 corners[8]{
+			{ box.min.x, box.min.y, box.min.z }, { box.max.x, box.min.y, box.min.z },
+			{ box.min.x, box.max.y, box.min.z }, { box.max.x, box.max.y, box.min.z },
+			{ box.min.x, box.min.y, box.max.z }, { box.max.x, box.min.y, box.max.z },
+			{ box.min.x, box.max.y, box.max.z }, { box.max.x, box.max.y, box.max.z }
+		};
+		static constexpr uint32_t indices[36]{
+			0, 2, 1, 1, 2, 3, //-z
+			4, 5, 6, 5, 7, 6, //+z
+			0, 4, 2, 2, 4, 6, //-x
+			1, 3, 5, 3, 7, 5, //+x
+			0, 1, 4, 1, 5, 4, //-y
+			2, 6, 3, 3, 6, 7  //+y
+		};
+		AddOccluder(corners, 8, sizeof(Vector3), indices, 36, world);
+	}
+
+	inline void OcclusionCuller::AddTriangle(const Vector4& clip0, const Vector4& clip1, const Vector4& clip2)
+	{
+		if (clip0.w < m_MinClipW || clip1.w < m_MinClipW || clip2.w < m_MinClipW) return;
+
+		const Vector3 v0 = ToScreen(clip0);
+		Vector3 v1 = ToScreen(clip1);
+		Vector3 v2 = ToScreen(clip2);
+
+		//both facings occlude, give every triangle the same winding so inside means all edges >= 0
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (area < 0.f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+		if (!(area > 1e-6f)) return;
+
+		//pixels whose center can be inside, clamped to the screen
+		ScreenTriangle triangle{};
+		triangle.minX = std::max(static_cast<int>(std::ceil(std::min({ v0.x, v1.x, v2.x }) - 0.5f)), 0);
+		triangle.minY = std::max(static_cast<int>(std::ceil(std::min({ v0.y, v1.y, v2.y }) - 0.5f)), 0);
+		triangle.maxX = std::min(static_cast<int>(std::floor(std::max({ v0.x, v1.x, v2.x }) - 0.5f)), Width - 1);
+		triangle.maxY = std::min(static_cast<int>(std::floor(std::max({ v0.y, v1.y, v2.y }) - 0.5f)), Height - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+		//edge i is opposite vertex i, evaluated at pixel centers
+		const Vector3* vertices[3]{ &v0, &v1, &v2 };
+		for (int edge{}; edge < 3; ++edge)
+		{
+			const Vector3& a = *vertices[(edge + 1) % 3];
+			const Vector3& b = *vertices[(edge + 2) % 3];
+			triangle.edgeA[edge] = a.y - b.y;
+			triangle.edgeB[edge] = b.x - a.x;
+			triangle.edgeC[edge] = (a.x * b.y - a.y * b.x) + 0.5f * (triangle.edgeA[edge] + triangle.edgeB[edge]);
+		}
+
+		//z is affine in screen space: z = z0 * w0 + z1 * w1 + z2 * w2 with normalized edge values as weights
+		const float invArea = 1.f / area;
+		triangle.depthA = (v0.z * triangle.edgeA[0] + v1.z * triangle.edgeA[1] + v2.z * triangle.edgeA[2]) * invArea;
+		triangle.depthB = (v0.z * triangle.edgeB[0] + v1.z * triangle.edgeB[1] + v2.z * triangle.edgeB[2]) * invArea;
+		triangle.depthC = (v0.z * triangle.edgeC[0] + v1.z * triangle.edgeC[1] + v2.z * triangle.edgeC[2]) * invArea;
+
+		const uint32_t triangleIndex = static_cast<uint32_t>(m_Triangles.size());
+		m_Triangles.push_back(triangle);
+
+		for (int tileY{ triangle.minY / TileHeight }; tileY <= triangle.maxY / TileHeight; ++tileY)
+		{
+			for (int tileX{ triangle.minX / TileWidth }; tileX <= triangle.maxX / TileWidth; ++tileX)
+			{
+				m_TileBins[tileY * TilesX + tileX].push_back(triangleIndex);
+			}
+		}
+	}
+
+	inline void OcclusionCuller::Rasterize(JobSystem& jobSystem)
+	{
+		jobSystem.ParallelFor(TileCount, [this](uint32_t tile) { RasterizeTile(static_cast<int>(tile)); });
+	}
+
+	inline void OcclusionCuller::RasterizeTile(int tile)
+	{
+		const int tileMinX = (tile % TilesX) * TileWidth;
+		const int tileMinY = (tile / TilesX) * TileHeight;
+
+		for (const uint32_t triangleIndex : m_TileBins[tile])
+		{
+			const ScreenTriangle& triangle = m_Triangles[triangleIndex];
+			//4-pixel aligned span so the SSE loop never leaves the tile
+			const int minX = std::max(triangle.minX, tileMinX) & ~3;
+			const int maxX = std::min(triangle.maxX, tileMinX + TileWidth - 1);
+			const int minY = std::max(triangle.minY, tileMinY);
+			const int maxY = std::min(triangle.maxY, tileMinY + TileHeight - 1);
+
+			for (int y{ minY }; y <= maxY; ++y)
+			{
+				float* rowPtr = m_Depth.data() + y * Width;
+				const float fy = static_cast<float>(y);
+#if defined(DAE_SSE)
+				const __m128 xOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+				const __m128 zero = _mm_setzero_ps();
+				for (int x{ minX }; x <= maxX; x += 4)
+				{
+					const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), xOffsets);
+					__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+					for (int edge{}; edge < 3; ++edge)
+					{
+						const __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[edge]), px),
+							_mm_set1_ps(triangle.edgeB[edge] * fy + triangle.edgeC[edge]));
+						inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+					}
+					if (_mm_movemask_ps(inside) == 0) continue;
+
+					const __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), px),
+						_mm_set1_ps(triangle.depthB * fy + triangle.depthC));
+					const __m128 stored = _mm_loadu_ps(rowPtr + x);
+					const __m128 nearest = _mm_min_ps(stored, depth);
+					_mm_storeu_ps(rowPtr + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+				}
+#else
+				for (int x{ minX }; x <= maxX; ++x)
+				{
+					const float fx = static_cast<float>(x);
+					bool isInside{ true };
+					for (int edge{}; edge < 3; ++edge)
+					{
+						isInside &= triangle.edgeA[edge] * fx + triangle.edgeB[edge] * fy + triangle.edgeC[edge] >= 0.f;
+					}
+					if (!isInside) continue;
+
+					const float depth = triangle.depthA * fx + triangle.depthB * fy + triangle.depthC;
+					rowPtr[x] = std::min(rowPtr[x], depth);
+				}
+#endif
+			}
+		}
+
+		float maxDepth{};
+		for (int y{ tileMinY }; y < tileMinY + TileHeight; ++y)
+		{
+			const float* rowPtr = m_Depth.data() + y * Width + tileMinX;
+			maxDepth = std::max(maxDepth, *std::max_element(rowPtr, rowPtr + TileWidth));
+		}
+		m_TileMaxDepth[tile] = maxDepth;
+	}
+
+	inline bool OcclusionCuller::IsVisible(const Aabb& worldBounds) const
+	{
+		//screen rectangle and nearest depth of the 8 corners
+		float minX{ FLT_MAX }, minY{ FLT_MAX }, minZ{ FLT_MAX };
+		float maxX{ -FLT_MAX }, maxY{ -FLT_MAX };
+		for (int corner{}; corner < 8; ++corner)
+		{
+			const Vector4 clip = m_ViewProjection.TransformPoint(Vector4{
+				corner & 1 ? worldBounds.max.x : worldBounds.min.x,
+				corner & 2 ? worldBounds.max.y : worldBounds.min.y,
+				corner & 4 ? worldBounds.max.z : worldBounds.min.z, 1.f });
+			if (clip.w < m_MinClipW) return true;
+
+			const Vector3 screen = ToScreen(clip);
+			minX = std::min(minX, screen.x);
+			maxX = std::max(maxX, screen.x);
+			minY = std::min(minY, screen.y);
+			maxY = std::max(maxY, screen.y);
+			minZ = std::min(minZ, screen.z);
+		}
+		minZ -= m_DepthBias;
+
+		//every pixel the rectangle touches, not just the ones whose center it covers
+		const int pixelMinX = std::max(static_cast<int>(std::floor(minX)), 0);
+		const int pixelMinY = std::max(static_cast<int>(std::floor(minY)), 0);
+		const int pixelMaxX = std::min(static_cast<int>(std::floor(maxX)), Width - 1);
+		const int pixelMaxY = std::min(static_cast<int>(std::floor(maxY)), Height - 1);
+		if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY) return true; //off screen, that is the frustum's call
+
+		for (int tileY{ pixelMinY / TileHeight }; tileY <= pixelMaxY / TileHeight; ++tileY)
+		{
+			for (int tileX{ pixelMinX / TileWidth }; tileX <= pixelMaxX / TileWidth; ++tileX)
+			{
+				//the whole tile is nearer than the box
+				if (minZ > m_TileMaxDepth[tileY * TilesX + tileX]) continue;
+
+				const int tileMinX = std::max(pixelMinX, tileX * TileWidth);
+				const int tileMaxX = std::min(pixelMaxX, tileX * TileWidth + TileWidth - 1);
+				const int tileMinY = std::max(pixelMinY, tileY * TileHeight);
+				const int tileMaxY = std::min(pixelMaxY, tileY * TileHeight + TileHeight - 1);
+				for (int y{ tileMinY }; y <= tileMaxY; ++y)
+				{
+					const float* rowPtr = m_Depth.data() + y * Width;
+					for (int x{ tileMinX }; x <= tileMaxX; ++x)
+					{
+						if (minZ <= rowPtr[x]) return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
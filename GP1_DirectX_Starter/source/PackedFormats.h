@@ -0,0 +1,482 @@
+#pragma once
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#include "ColorRGB.h"
+#include "MathHelpers.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+//F16C ships with every AVX2 cpu, MSVC only announces it through /arch:AVX2
+#if defined(__F16C__) || defined(__AVX2__)
+#define DAE_F16C
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	//Conversions from float data to the compact DXGI formats
+	//All float -> integer conversions round to nearest even, all float -> small float conversions
+	//are IEEE round to nearest even with overflow to INF (matching the hardware conversion rules)
+	namespace Packing
+	{
+#pragma region Half / small float
+		//Packs a positive or signed float into a float with a 5 bit exponent (bias 15) and mantissaBits of mantissa
+		//Based on the branch-light RTNE conversion by F. Giesen; works for half (10), R11/G11 (6) and B10 (5)
+		template<int mantissaBits, bool hasSign>
+		uint32_t FloatToSmallFloat(float value)
+		{
+			constexpr int shift = 23 - mantissaBits;
+			constexpr uint32_t f32Infinity = 255u << 23;
+			constexpr uint32_t smallMax = (127u + 16u) << 23;
+			constexpr uint32_t denormMagic = ((127u - 15u) + static_cast<uint32_t>(shift) + 1u) << 23;
+			constexpr uint32_t expMask = 0x1Fu << mantissaBits;
+
+			uint32_t f = std::bit_cast<uint32_t>(value);
+			const uint32_t sign = f & 0x80000000u;
+			f ^= sign;
+
+			if constexpr (!hasSign)
+			{
+				//unsigned formats clamp negatives to 0 but keep NaN
+				if (sign && f <= f32Infinity) return 0;
+			}
+
+			uint32_t out{};
+			if (f >= smallMax)
+			{
+				//INF or NaN (NaN is quieted)
+				out = f > f32Infinity ? expMask | (1u << (mantissaBits - 1)) : expMask;
+			}
+			else if (f < (113u << 23))
+			{
+				//denormal or zero: align the mantissa bits at the bottom with a magic add, the FPU does the rounding
+				out = std::bit_cast<uint32_t>(std::bit_cast<float>(f) + std::bit_cast<float>(denormMagic)) - denormMagic;
+			}
+			else
+			{
+				const uint32_t mantissaOdd = (f >> shift) & 1u;
+				f += (static_cast<uint32_t>(15 - 127) << 23) + ((1u << (shift - 1)) - 1u);
+				f += mantissaOdd;
+				out = f >> shift;
+			}
+
+			if constexpr (hasSign)
+			{
+				out |= sign >> (31 - (5 + mantissaBits));
+			}
+			return out;
+		}
+
+		template<int mantissaBits, bool hasSign>
+		float SmallFloatToFloat(uint32_t value)
+		{
+			constexpr int shift = 23 - mantissaBits;
+			constexpr uint32_t shiftedExp = 0x1Fu << 23;
+			constexpr uint32_t bodyMask = (1u << (5 + mantissaBits)) - 1u;
+
+			uint32_t out = (value & bodyMask) << shift;
+			const uint32_t exp = shiftedExp & out;
+			out += (127u - 15u) << 23;
+
+			if (exp == shiftedExp)
+			{
+				//INF / NaN
+				out += (128u - 16u) << 23;
+			}
+			else if (exp == 0)
+			{
+				//zero / denormal: renormalize
+				out += 1u << 23;
+				out = std::bit_cast<uint32_t>(std::bit_cast<float>(out) - std::bit_cast<float>(113u << 23));
+			}
+
+			if constexpr (hasSign)
+			{
+				out |= (value >> (5 + mantissaBits) & 1u) << 31;
+			}
+			return std::bit_cast<float>(out);
+		}
+
+		inline uint16_t FloatToHalf(float value)
+		{
+			return static_cast<uint16_t>(FloatToSmallFloat<10, true>(value));
+		}
+
+		inline float HalfToFloat(uint16_t value)
+		{
+			return SmallFloatToFloat<10, true>(value);
+		}
+
+		//Bulk conversion, 8 values per instruction with F16C (identical results, except for NaN payloads)
+		inline void FloatToHalf(std::span<const float> source, std::span<uint16_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_F16C)
+			for (; i + 8 <= source.size(); i += 8)
+			{
+				const __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source.data() + i), _MM_FROUND_TO_NEAREST_INT);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), halves);
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = FloatToHalf(source[i]);
+			}
+		}
+
+		inline void HalfToFloat(std::span<const uint16_t> source, std::span<float> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_F16C)
+			for (; i + 8 <= source.size(); i += 8)
+			{
+				const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.data() + i));
+				_mm256_storeu_ps(destination.data() + i, _mm256_cvtph_ps(halves));
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = HalfToFloat(source[i]);
+			}
+		}
+
+		//Vector2 (e.g. uv) -> R16G16_FLOAT
+		inline void PackHalf2(std::span<const Vector2> source, std::span<uint32_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			static_assert(sizeof(Vector2) == 2 * sizeof(float));
+			FloatToHalf({ &source.data()->x, source.size() * 2 }, { reinterpret_cast<uint16_t*>(destination.data()), source.size() * 2 });
+		}
+#pragma endregion
+
+#pragma region UNORM / SNORM
+		template<int bits>
+		uint32_t FloatToUnorm(float value)
+		{
+			constexpr float scale = static_cast<float>((1u << bits) - 1u);
+			return static_cast<uint32_t>(std::nearbyint(Saturate(value) * scale));
+		}
+
+		template<int bits>
+		float UnormToFloat(uint32_t value)
+		{
+			constexpr float invScale = 1.f / static_cast<float>((1u << bits) - 1u);
+			return static_cast<float>(value) * invScale;
+		}
+
+		//-1 and +1 map to -(2^(bits-1) - 1) and +(2^(bits-1) - 1), the most negative code decodes to -1 as well
+		template<int bits>
+		int32_t FloatToSnorm(float value)
+		{
+			constexpr float scale = static_cast<float>((1 << (bits - 1)) - 1);
+			return static_cast<int32_t>(std::nearbyint(Clamp(value, -1.f, 1.f) * scale));
+		}
+
+		template<int bits>
+		float SnormToFloat(int32_t value)
+		{
+			constexpr float invScale = 1.f / static_cast<float>((1 << (bits - 1)) - 1);
+			return std::max(static_cast<float>(value) * invScale, -1.f);
+		}
+
+		//Bulk float -> UNORM8, 16 values per iteration with SSE2
+		inline void FloatToUnorm8(std::span<const float> source, std::span<uint8_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_SSE)
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(255.f);
+			const auto convert = [&](const float* ptr)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(ptr), zero), one), scale));
+			};
+			for (; i + 16 <= source.size(); i += 16)
+			{
+				const __m128i lo = _mm_packs_epi32(convert(source.data() + i), convert(source.data() + i + 4));
+				const __m128i hi = _mm_packs_epi32(convert(source.data() + i + 8), convert(source.data() + i + 12));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = static_cast<uint8_t>(FloatToUnorm<8>(source[i]));
+			}
+		}
+
+		//Bulk float -> SNORM8, 16 values per iteration with SSE2
+		inline void FloatToSnorm8(std::span<const float> source, std::span<int8_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_SSE)
+			const __m128 minusOne = _mm_set1_ps(-1.f);
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(127.f);
+			const auto convert = [&](const float* ptr)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(ptr), minusOne), one), scale));
+			};
+			for (; i + 16 <= source.size(); i += 16)
+			{
+				const __m128i lo = _mm_packs_epi32(convert(source.data() + i), convert(source.data() + i + 4));
+				const __m128i hi = _mm_packs_epi32(convert(source.data() + i + 8), convert(source.data() + i + 12));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), _mm_packs_epi16(lo, hi));
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = static_cast<int8_t>(FloatToSnorm<8>(source[i]));
+			}
+		}
+
+		//Bulk float -> UNORM16 / SNORM16, branch free so the compiler can vectorize it
+		inline void FloatToUnorm16(std::span<const float> source, std::span<uint16_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			for (size_t i{}; i < source.size(); ++i)
+			{
+				destination[i] = static_cast<uint16_t>(FloatToUnorm<16>(source[i]));
+			}
+		}
+
+		inline void FloatToSnorm16(std::span<const float> source, std::span<int16_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			for (size_t i{}; i < source.size(); ++i)
+			{
+				destination[i] = static_cast<int16_t>(FloatToSnorm<16>(source[i]));
+			}
+		}
+
+		//ColorRGB -> R8G8B8A8_UNORM (r in the lowest byte)
+		inline uint32_t PackR8G8B8A8(const ColorRGB& color, float alpha = 1.f)
+		{
+			return FloatToUnorm<8>(color.r) | FloatToUnorm<8>(color.g) << 8 | FloatToUnorm<8>(color.b) << 16 | FloatToUnorm<8>(alpha) << 24;
+		}
+#pragma endregion
+
+#pragma region R10G10B10A2 / R11G11B10F
+		inline uint32_t PackR10G10B10A2(const ColorRGB& color, float alpha = 1.f)
+		{
+			return FloatToUnorm<10>(color.r) | FloatToUnorm<10>(color.g) << 10 | FloatToUnorm<10>(color.b) << 20 | FloatToUnorm<2>(alpha) << 30;
+		}
+
+		inline Vector4 UnpackR10G10B10A2(uint32_t packed)
+		{
+			return {
+				UnormToFloat<10>(packed & 0x3FF),
+				UnormToFloat<10>(packed >> 10 & 0x3FF),
+				UnormToFloat<10>(packed >> 20 & 0x3FF),
+				UnormToFloat<2>(packed >> 30)
+			};
+		}
+
+		//Unsigned HDR color, R/G: 5 exponent + 6 mantissa bits, B: 5 exponent + 5 mantissa bits
+		inline uint32_t PackR11G11B10F(const ColorRGB& color)
+		{
+			return FloatToSmallFloat<6, false>(color.r) | FloatToSmallFloat<6, false>(color.g) << 11 | FloatToSmallFloat<5, false>(color.b) << 22;
+		}
+
+		inline ColorRGB UnpackR11G11B10F(uint32_t packed)
+		{
+			return {
+				SmallFloatToFloat<6, false>(packed & 0x7FF),
+				SmallFloatToFloat<6, false>(packed >> 11 & 0x7FF),
+				SmallFloatToFloat<5, false>(packed >> 22)
+			};
+		}
+
+#if defined(DAE_SSE)
+		//Loads 4 packed xyz triplets (ColorRGB, Vector3) as one register per component
+		inline void LoadXYZ4(const float* ptr, __m128& x, __m128& y, __m128& z)
+		{
+			//a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+			const __m128 a = _mm_loadu_ps(ptr);
+			const __m128 b = _mm_loadu_ps(ptr + 4);
+			const __m128 c = _mm_loadu_ps(ptr + 8);
+			x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+			y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+		}
+
+		inline __m128i SelectBits(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		//FloatToSmallFloat<mantissaBits, false> for 4 values, every branch is computed and the lanes pick theirs
+		template<int mantissaBits>
+		inline __m128i FloatToUnsignedSmallFloat4(__m128 value)
+		{
+			constexpr int shift = 23 - mantissaBits;
+			constexpr uint32_t normalBias = (static_cast<uint32_t>(15 - 127) << 23) + ((1u << (shift - 1)) - 1u);
+			const __m128i bits = _mm_castps_si128(value);
+			const __m128i f = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+			const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + shift + 1) << 23);
+
+			const __m128i isNaN = _mm_cmpgt_epi32(f, _mm_set1_epi32(255 << 23));
+			const __m128i isSpecial = _mm_cmpgt_epi32(f, _mm_set1_epi32(((127 + 16) << 23) - 1));
+			const __m128i isDenormal = _mm_cmplt_epi32(f, _mm_set1_epi32(113 << 23));
+
+			const __m128i special = _mm_or_si128(_mm_set1_epi32(0x1F << mantissaBits), _mm_and_si128(isNaN, _mm_set1_epi32(1 << (mantissaBits - 1))));
+			const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(denormMagic))), denormMagic);
+			const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(f, shift), _mm_set1_epi32(1));
+			const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, _mm_set1_epi32(static_cast<int>(normalBias))), mantissaOdd), shift);
+
+			const __m128i out = SelectBits(isSpecial, special, SelectBits(isDenormal, denormal, normal));
+			//negatives clamp to 0, NaN stays NaN
+			const __m128i isNegative = _mm_andnot_si128(isNaN, _mm_srai_epi32(bits, 31));
+			return _mm_andnot_si128(isNegative, out);
+		}
+#endif
+
+		//Bulk ColorRGB -> R10G10B10A2 with alpha 1, 4 colors per iteration with SSE2
+		inline void PackR10G10B10A2(std::span<const ColorRGB> source, std::span<uint32_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_SSE)
+			static_assert(sizeof(ColorRGB) == 3 * sizeof(float));
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(1023.f);
+			const auto convert = [&](__m128 v)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), scale));
+			};
+			const __m128i alpha = _mm_set1_epi32(static_cast<int>(3u << 30));
+			for (; i + 4 <= source.size(); i += 4)
+			{
+				__m128 r, g, b;
+				LoadXYZ4(&source[i].r, r, g, b);
+				const __m128i rg = _mm_or_si128(convert(r), _mm_slli_epi32(convert(g), 10));
+				const __m128i ba = _mm_or_si128(_mm_slli_epi32(convert(b), 20), alpha);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), _mm_or_si128(rg, ba));
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = PackR10G10B10A2(source[i]);
+			}
+		}
+
+		//Bulk ColorRGB -> R11G11B10F, 4 colors per iteration with SSE2
+		inline void PackR11G11B10F(std::span<const ColorRGB> source, std::span<uint32_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_SSE)
+			static_assert(sizeof(ColorRGB) == 3 * sizeof(float));
+			for (; i + 4 <= source.size(); i += 4)
+			{
+				__m128 r, g, b;
+				LoadXYZ4(&source[i].r, r, g, b);
+				const __m128i rg = _mm_or_si128(FloatToUnsignedSmallFloat4<6>(r), _mm_slli_epi32(FloatToUnsignedSmallFloat4<6>(g), 11));
+				const __m128i packed = _mm_or_si128(rg, _mm_slli_epi32(FloatToUnsignedSmallFloat4<5>(b), 22));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), packed);
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = PackR11G11B10F(source[i]);
+			}
+		}
+#pragma endregion
+
+#pragma region Octahedral normals
+		//Maps a unit vector onto the [-1, 1]^2 octahedron, folding the z < 0 half over the diagonals
+		inline Vector2 EncodeOctahedral(const Vector3& n)
+		{
+			const float invL1 = 1.f / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+			const float x = n.x * invL1;
+			const float y = n.y * invL1;
+			if (n.z >= 0.f)
+			{
+				return { x, y };
+			}
+			return {
+				(1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f),
+				(1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f)
+			};
+		}
+
+		inline Vector3 DecodeOctahedral(const Vector2& e)
+		{
+			Vector3 n{ e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y) };
+			const float t = Saturate(-n.z);
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			return n.Normalized();
+		}
+
+		//Unit vector -> R16G16_SNORM, decodes to within 0.004 degrees of n
+		inline uint32_t PackOctahedralSnorm16(const Vector3& n)
+		{
+			const Vector2 e = EncodeOctahedral(n);
+			return static_cast<uint16_t>(FloatToSnorm<16>(e.x)) | static_cast<uint32_t>(static_cast<uint16_t>(FloatToSnorm<16>(e.y))) << 16;
+		}
+
+		inline Vector3 UnpackOctahedralSnorm16(uint32_t packed)
+		{
+			return DecodeOctahedral({
+				SnormToFloat<16>(static_cast<int16_t>(packed & 0xFFFF)),
+				SnormToFloat<16>(static_cast<int16_t>(packed >> 16))
+			});
+		}
+
+		//Bulk unit vector -> R16G16_SNORM, 4 normals per iteration with SSE2
+		inline void PackOctahedralSnorm16(std::span<const Vector3> source, std::span<uint32_t> destination)
+		{
+			assert(destination.size() >= source.size());
+			size_t i{};
+#if defined(DAE_SSE)
+			static_assert(sizeof(Vector3) == 3 * sizeof(float));
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 minusOne = _mm_set1_ps(-1.f);
+			const __m128 scale = _mm_set1_ps(32767.f);
+			const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			const auto select = [](__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+			const auto convert = [&](__m128 v)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, minusOne), one), scale));
+			};
+			for (; i + 4 <= source.size(); i += 4)
+			{
+				__m128 nx, ny, nz;
+				LoadXYZ4(&source[i].x, nx, ny, nz);
+				const __m128 l1 = _mm_add_ps(_mm_add_ps(_mm_and_ps(nx, absMask), _mm_and_ps(ny, absMask)), _mm_and_ps(nz, absMask));
+				const __m128 invL1 = _mm_div_ps(one, l1);
+				const __m128 x = _mm_mul_ps(nx, invL1);
+				const __m128 y = _mm_mul_ps(ny, invL1);
+
+				//the z < 0 half folds over the diagonals
+				const __m128 signX = select(_mm_cmpge_ps(x, zero), one, minusOne);
+				const __m128 signY = select(_mm_cmpge_ps(y, zero), one, minusOne);
+				const __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(y, absMask)), signX);
+				const __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(x, absMask)), signY);
+				const __m128 isUpper = _mm_cmpge_ps(nz, zero);
+
+				const __m128i ex = convert(select(isUpper, x, foldedX));
+				const __m128i ey = convert(select(isUpper, y, foldedY));
+				const __m128i packed = _mm_or_si128(_mm_and_si128(ex, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(ey, 16));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), packed);
+			}
+#endif
+			for (; i < source.size(); ++i)
+			{
+				destination[i] = PackOctahedralSnorm16(source[i]);
+			}
+		}
+#pragma endregion
+	}
+}
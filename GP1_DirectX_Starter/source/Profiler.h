@@ -0,0 +1,330 @@
+#pragma once
+
+//Profiling is on unless DAE_PROFILING_OFF is defined (/D DAE_PROFILING_OFF, -DDAE_PROFILING_OFF), then the
+//DAE_PROFILE_* macros expand to nothing and none of the code below is compiled
+#if !defined(DAE_PROFILING_OFF)
+#define DAE_PROFILING
+#endif
+
+#if defined(DAE_PROFILING)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace dae
+{
+	//CPU profiler for scoped zones
+	//Every thread writes the zones it closes into a ring buffer of its own, recording shares nothing between threads:
+	//a zone is two timestamp reads and one store. Zones nest by time, a depth counter per thread keeps the hierarchy.
+	//The summary and the trace read the buffers between frames, while no other thread records zones: the job system is idle
+	//then and a pipelined simulation thread has to be paused around them (Renderer::PauseSimulation)
+	class Profiler final
+	{
+	public:
+		struct Zone
+		{
+			const char* name;
+			uint64_t start;
+			uint64_t end;
+			uint32_t depth;
+		};
+
+		//The zones of one frame with the same name and depth, merged over all threads
+		struct ZoneSummary
+		{
+			const char* name{};
+			uint32_t depth{};
+			uint32_t callCount{};
+			double totalMs{};
+			double selfMs{};		//without the time in nested zones
+			uint64_t firstStart{};
+		};
+
+		//zones kept per thread, the trace holds the last BufferSize of every thread
+		static constexpr uint32_t BufferSize{ 1 << 16 };
+
+		static Profiler& Get()
+		{
+			static Profiler profiler{};
+			return profiler;
+		}
+
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+		//rdtsc on x86, calibrated against steady_clock when read
+		static uint64_t GetTimestamp()
+		{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+		}
+
+		//Starts the next frame, the summary covers the frame before it. Called from one thread
+		void MarkFrame();
+		//Shown in the trace, "Thread <index>" otherwise
+		void SetThreadName(const char* name) { GetThreadBuffer().name = name; }
+
+		std::vector<ZoneSummary> GetFrameSummary() const;
+		void PrintFrameSummary() const;
+		bool WriteChromeTrace(const std::string& path) const;
+
+	private:
+		friend class ProfileScope;
+
+		struct ThreadBuffer
+		{
+			std::vector<Zone> zones = std::vector<Zone>(BufferSize);
+			std::atomic<uint64_t> count{};
+			uint32_t depth{};
+			uint32_t index{};
+			std::string name{};
+		};
+
+		mutable std::mutex m_BuffersMutex{};
+		std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers{};
+
+		uint64_t m_FrameStart{};
+		uint64_t m_LastFrameStart{};
+		uint64_t m_LastFrameEnd{};
+
+		const uint64_t m_CalibrationTimestamp{ GetTimestamp() };
+		const std::chrono::steady_clock::time_point m_CalibrationTime{ std::chrono::steady_clock::now() };
+
+		Profiler() = default;
+
+		static ThreadBuffer& GetThreadBuffer()
+		{
+			static thread_local ThreadBuffer* bufferPtr{ Get().AddThreadBuffer() };
+			return *bufferPtr;
+		}
+		ThreadBuffer* AddThreadBuffer();
+
+		double GetTicksPerMs() const;
+	};
+
+	//Records the time from construction to destruction as a zone, use DAE_PROFILE_SCOPE
+	class ProfileScope final
+	{
+	public:
+		explicit ProfileScope(const char* name) :
+			m_Name{ name },
+			m_Buffer{ Profiler::GetThreadBuffer() }
+		{
+			++m_Buffer.depth;
+			m_Start = Profiler::GetTimestamp();
+		}
+
+		~ProfileScope()
+		{
+			const uint64_t end = Profiler::GetTimestamp();
+			const uint32_t depth = --m_Buffer.depth;
+
+			//only this thread writes count, the release store publishes the zone to the reader
+			const uint64_t count = m_Buffer.count.load(std::memory_order_relaxed);
+			m_Buffer.zones[count & (Profiler::BufferSize - 1)] = { m_Name, m_Start, end, depth };
+			m_Buffer.count.store(count + 1, std::memory_order_release);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope(ProfileScope&&) noexcept = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		ProfileScope& operator=(ProfileScope&&) noexcept = delete;
+
+	private:
+		const char* m_Name;
+		Profiler::ThreadBuffer& m_Buffer;
+		uint64_t m_Start{};
+	};
+
+	inline Profiler::ThreadBuffer* Profiler::AddThreadBuffer()
+	{
+		std::lock_guard lock{ m_BuffersMutex };
+		m_Buffers.push_back(std::make_unique<ThreadBuffer>());
+		m_Buffers.back()->index = static_cast<uint32_t>(m_Buffers.size() - 1);
+		return m_Buffers.back().get();
+	}
+
+	inline void Profiler::MarkFrame()
+	{
+		const uint64_t now = GetTimestamp();
+		if (m_FrameStart != 0)
+		{
+			m_LastFrameStart = m_FrameStart;
+			m_LastFrameEnd = now;
+		}
+		m_FrameStart = now;
+	}
+
+	inline double Profiler::GetTicksPerMs() const
+	{
+		const uint64_t ticks = GetTimestamp() - m_CalibrationTimestamp;
+		const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_CalibrationTime).count();
+		return elapsedMs > 0.0 ? static_cast<double>(ticks) / elapsedMs : 1.0;
+	}
+
+	inline std::vector<Profiler::ZoneSummary> Profiler::GetFrameSummary() const
+	{
+		std::vector<ZoneSummary> summary{};
+		if (m_LastFrameEnd == 0) return summary;
+
+		const double msPerTick = 1.0 / GetTicksPerMs();
+		std::vector<Zone> zones{};
+		std::vector<uint64_t> childTicks{};
+
+		std::lock_guard lock{ m_BuffersMutex };
+		for (const std::unique_ptr<ThreadBuffer>& bufferPtr : m_Buffers)
+		{
+			//zones are stored in the order they end, walk back to the first one that ends inside the frame
+			const uint64_t count = bufferPtr->count.load(std::memory_order_acquire);
+			const uint64_t oldest = count > BufferSize ? count - BufferSize : 0;
+			uint64_t first = count;
+			while (first > oldest && bufferPtr->zones[(first - 1) & (BufferSize - 1)].end >= m_LastFrameStart) --first;
+
+			zones.clear();
+			for (uint64_t i{ first }; i < count; ++i)
+			{
+				const Zone& zone = bufferPtr->zones[i & (BufferSize - 1)];
+				if (zone.end > m_LastFrameEnd) break;
+				zones.push_back(zone);
+			}
+
+			//a zone ends after its children, their time is waiting in childTicks[depth + 1] when it arrives.
+			//Zones that started before the frame still clear their children, they just aren't counted
+			for (const Zone& zone : zones)
+			{
+				if (childTicks.size() < zone.depth + 2) childTicks.resize(zone.depth + 2);
+				const uint64_t ticks = zone.end - zone.start;
+				const uint64_t selfTicks = ticks - std::min(ticks, childTicks[zone.depth + 1]);
+				std::fill(childTicks.begin() + zone.depth + 1, childTicks.end(), 0);
+				childTicks[zone.depth] += ticks;
+				if (zone.start < m_LastFrameStart) continue;
+
+				auto it = std::find_if(summary.begin(), summary.end(), [&](const ZoneSummary& entry)
+				{
+					return entry.depth == zone.depth && std::string_view{ entry.name } == zone.name;
+				});
+				if (it == summary.end())
+				{
+					summary.push_back({ zone.name, zone.depth, 0, 0.0, 0.0, zone.start });
+					it = summary.end() - 1;
+				}
+				++it->callCount;
+				it->totalMs += static_cast<double>(ticks) * msPerTick;
+				it->selfMs += static_cast<double>(selfTicks) * msPerTick;
+				it->firstStart = std::min(it->firstStart, zone.start);
+			}
+			std::fill(childTicks.begin(), childTicks.end(), 0);
+		}
+
+		//parents start before their children, in start order the list reads as a tree
+		std::sort(summary.begin(), summary.end(), [](const ZoneSummary& a, const ZoneSummary& b)
+		{
+			return a.firstStart != b.firstStart ? a.firstStart < b.firstStart : a.depth < b.depth;
+		});
+		return summary;
+	}
+
+	inline void Profiler::PrintFrameSummary() const
+	{
+		const std::vector<ZoneSummary> summary = GetFrameSummary();
+		if (summary.empty()) return;
+
+		char line[160];
+		std::snprintf(line, sizeof(line), "frame %.3f ms\n%-40s %7s %10s %10s\n", static_cast<double>(m_LastFrameEnd - m_LastFrameStart) / GetTicksPerMs(),
+			"zone", "calls", "total ms", "self ms");
+		std::cout << line;
+		for (const ZoneSummary& zone : summary)
+		{
+			const std::string name = std::string(zone.depth * 2, ' ') + zone.name;
+			std::snprintf(line, sizeof(line), "%-40s %7u %10.3f %10.3f\n", name.c_str(), zone.callCount, zone.totalMs, zone.selfMs);
+			std::cout << line;
+		}
+	}
+
+	inline bool Profiler::WriteChromeTrace(const std::string& path) const
+	{
+		std::ofstream file{ path };
+		if (!file)
+		{
+			std::cerr << "Can't write " << path << std::endl;
+			return false;
+		}
+
+		//zone names are identifiers and function names, quotes and backslashes are all there is to escape
+		const auto writeString = [&](const char* text)
+		{
+			file << '"';
+			for (; *text; ++text)
+			{
+				if (*text == '"' || *text == '\\') file << '\\';
+				file << *text;
+			}
+			file << '"';
+		};
+
+		//Trace Event Format: complete events ("X") in microseconds, viewable in chrome://tracing and ui.perfetto.dev
+		const double usPerTick = 1000.0 / GetTicksPerMs();
+		char number[64];
+		bool isFirst{ true };
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		std::lock_guard lock{ m_BuffersMutex };
+		for (const std::unique_ptr<ThreadBuffer>& bufferPtr : m_Buffers)
+		{
+			const std::string threadName = bufferPtr->name.empty() ? "Thread " + std::to_string(bufferPtr->index) : bufferPtr->name;
+			file << (isFirst ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << bufferPtr->index << ",\"args\":{\"name\":";
+			writeString(threadName.c_str());
+			file << "}}";
+			isFirst = false;
+
+			const uint64_t count = bufferPtr->count.load(std::memory_order_acquire);
+			for (uint64_t i{ count > BufferSize ? count - BufferSize : 0 }; i < count; ++i)
+			{
+				const Zone& zone = bufferPtr->zones[i & (BufferSize - 1)];
+				file << ",\n{\"ph\":\"X\",\"name\":";
+				writeString(zone.name);
+				std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f", static_cast<double>(zone.start - m_CalibrationTimestamp) * usPerTick,
+					static_cast<double>(zone.end - zone.start) * usPerTick);
+				file << number << ",\"pid\":0,\"tid\":" << bufferPtr->index << '}';
+			}
+		}
+		file << "\n]}\n";
+
+		std::cout << "Trace written to " << path << std::endl;
+		return true;
+	}
+}
+
+#define DAE_PROFILE_CONCAT_INNER(a, b) a##b
+#define DAE_PROFILE_CONCAT(a, b) DAE_PROFILE_CONCAT_INNER(a, b)
+//Times the rest of the enclosing scope
+#define DAE_PROFILE_SCOPE(name) const dae::ProfileScope DAE_PROFILE_CONCAT(profileScope, __LINE__){ name }
+#define DAE_PROFILE_FUNCTION() DAE_PROFILE_SCOPE(__FUNCTION__)
+#define DAE_PROFILE_FRAME() dae::Profiler::Get().MarkFrame()
+#define DAE_PROFILE_THREAD(name) dae::Profiler::Get().SetThreadName(name)
+#else
+#define DAE_PROFILE_SCOPE(name) ((void)0)
+#define DAE_PROFILE_FUNCTION() ((void)0)
+#define DAE_PROFILE_FRAME() ((void)0)
+#define DAE_PROFILE_THREAD(name) ((void)0)
+#endif
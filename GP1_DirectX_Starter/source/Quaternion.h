@@ -0,0 +1,160 @@
+#pragma once
+#include <cmath>
+
+#include "FastMath.h"
+#include "MathHelpers.h"
+#include "Matrix.h"
+#include "Vector3.h"
+
+namespace dae
+{
+	//Unit quaternion rotation, q = (x, y, z) * sin(angle / 2) + w * cos(angle / 2)
+	//Matches the row-vector convention of Matrix: ToMatrix() rows are the rotated basis axes
+	struct Quaternion
+	{
+		float x{};
+		float y{};
+		float z{};
+		float w{ 1.f };
+
+		constexpr Quaternion() = default;
+		constexpr Quaternion(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+		static Quaternion CreateFromAxisAngle(const Vector3& axis, float angle)
+		{
+			float sinHalf{}, cosHalf{};
+			SinCos(angle * 0.5f, sinHalf, cosHalf);
+			const Vector3 n = axis.Normalized() * sinHalf;
+			return { n.x, n.y, n.z, cosHalf };
+		}
+
+		static Quaternion CreateFromMatrix(const Matrix& m)
+		{
+			//Shepperd's method, m is row-major (m[r][c] = R[c][r])
+			const float trace = m[0][0] + m[1][1] + m[2][2];
+			if (trace > 0.f)
+			{
+				const float s = 0.5f / sqrtf(trace + 1.f);
+				return { (m[1][2] - m[2][1]) * s, (m[2][0] - m[0][2]) * s, (m[0][1] - m[1][0]) * s, 0.25f / s };
+			}
+			if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+			{
+				const float s = 2.f * sqrtf(1.f + m[0][0] - m[1][1] - m[2][2]);
+				return { 0.25f * s, (m[1][0] + m[0][1]) / s, (m[2][0] + m[0][2]) / s, (m[1][2] - m[2][1]) / s };
+			}
+			if (m[1][1] > m[2][2])
+			{
+				const float s = 2.f * sqrtf(1.f + m[1][1] - m[0][0] - m[2][2]);
+				return { (m[1][0] + m[0][1]) / s, 0.25f * s, (m[2][1] + m[1][2]) / s, (m[2][0] - m[0][2]) / s };
+			}
+			const float s = 2.f * sqrtf(1.f + m[2][2] - m[0][0] - m[1][1]);
+			return { (m[2][0] + m[0][2]) / s, (m[2][1] + m[1][2]) / s, 0.25f * s, (m[0][1] - m[1][0]) / s };
+		}
+
+		constexpr Matrix ToMatrix() const
+		{
+			const float xx = x * x, yy = y * y, zz = z * z;
+			const float xy = x * y, xz = x * z, yz = y * z;
+			const float wx = w * x, wy = w * y, wz = w * z;
+
+			return {
+				Vector3{ 1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy) },
+				Vector3{ 2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx) },
+				Vector3{ 2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy) },
+				Vector3::Zero
+			};
+		}
+
+		constexpr float SqrMagnitude() const
+		{
+			return x * x + y * y + z * z + w * w;
+		}
+
+		float Magnitude() const
+		{
+			return sqrtf(SqrMagnitude());
+		}
+
+		template<MathPrecision precision = MathPrecision::Precise>
+		float Normalize()
+		{
+			const float sqrMagnitude = SqrMagnitude();
+			const float invMagnitude = InvSqrt<precision>(sqrMagnitude);
+			x *= invMagnitude;
+			y *= invMagnitude;
+			z *= invMagnitude;
+			w *= invMagnitude;
+
+			return sqrMagnitude * invMagnitude;
+		}
+
+		Quaternion Normalized() const
+		{
+			const float m = Magnitude();
+			return { x / m, y / m, z / m, w / m };
+		}
+
+		constexpr Quaternion Conjugate() const
+		{
+			return { -x, -y, -z, w };
+		}
+
+		//Rotates v by this (unit) quaternion
+		constexpr Vector3 Rotate(const Vector3& v) const
+		{
+			const Vector3 u{ x, y, z };
+			const Vector3 t = Vector3::Cross(u, v) * 2.f;
+			return v + t * w + Vector3::Cross(u, t);
+		}
+
+		static constexpr float Dot(const Quaternion& q1, const Quaternion& q2)
+		{
+			return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+		}
+
+		static Quaternion Slerp(const Quaternion& a, Quaternion b, float t)
+		{
+			//take the shortest arc
+			float cosTheta = Dot(a, b);
+			if (cosTheta < 0.f)
+			{
+				b = { -b.x, -b.y, -b.z, -b.w };
+				cosTheta = -cosTheta;
+			}
+
+			//nearly parallel: fall back to normalized lerp to avoid dividing by sin(~0)
+			if (cosTheta > 0.9995f)
+			{
+				return Quaternion{ Lerpf(a.x, b.x, t), Lerpf(a.y, b.y, t), Lerpf(a.z, b.z, t), Lerpf(a.w, b.w, t) }.Normalized();
+			}
+
+			const float theta = acosf(cosTheta);
+			const float invSinTheta = 1.f / sinf(theta);
+			const float wa = sinf((1.f - t) * theta) * invSinTheta;
+			const float wb = sinf(t * theta) * invSinTheta;
+
+			return { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+		}
+
+		//Hamilton product: (a * b) rotates by b first, then by a
+		constexpr Quaternion operator*(const Quaternion& q) const
+		{
+			return {
+				w * q.x + x * q.w + y * q.z - z * q.y,
+				w * q.y - x * q.z + y * q.w + z * q.x,
+				w * q.z + x * q.y - y * q.x + z * q.w,
+				w * q.w - x * q.x - y * q.y - z * q.z
+			};
+		}
+
+		constexpr Quaternion& operator*=(const Quaternion& q)
+		{
+			*this = *this * q;
+			return *this;
+		}
+
+		static const Quaternion Identity;
+	};
+
+	inline constexpr Quaternion Quaternion::Identity{ 0, 0, 0, 1 };
+}
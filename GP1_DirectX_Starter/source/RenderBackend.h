@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "CommandBackend.h"
+#include "Matrix.h"
+#include "RenderWorld.h"
+#include "Vector2.h"
+#include "Vector3.h"
+
+namespace dae
+{
+	//Vertex layout of every mesh, matches the input layout of the effects
+	struct MeshVertex
+	{
+		Vector3 position;
+		Vector3 color;
+		Vector2 uv;
+		Vector3 normal;
+		Vector3 tangent;
+	};
+
+	//The materials the renderer ships with, a backend maps each to its shaders, textures and render states
+	enum class MaterialType : uint8_t
+	{
+		Vehicle,
+		FireFX
+	};
+
+	//Records draws on one thread, either straight to the device or into one chunk of a parallel recording
+	class RenderContext
+	{
+	public:
+		virtual ~RenderContext() = default;
+
+		//Binds the vertex and index buffer of mesh, instanced binds stream the instance buffer as per-instance world matrices
+		virtual void BindMesh(MeshHandle mesh, bool isInstanced) = 0;
+
+		//Draws the bound mesh once
+		virtual void Draw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix) = 0;
+
+		//Draws instanceCount copies of the bound mesh whose world matrices start at firstInstance in the instance buffer
+		virtual void DrawInstanced(MeshHandle mesh, MaterialHandle material, const Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount) = 0;
+	};
+
+	using RecordChunkFunction = std::function<void(RenderContext& context, uint32_t chunkIndex, const CommandChunk& chunk)>;
+
+	//Everything the frame pipeline needs from a graphics API: buffers, materials (pipeline state and textures) and draws
+	//Handles are handed out in creation order, starting at 0
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() = default;
+
+		//Buffers
+		//material only decides the input layout and whether the index buffer can be rewritten (transparent materials)
+		virtual MeshHandle CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle material) = 0;
+		//Replaces the triangle order of a mesh with a transparent material, indices has to hold the same triangles
+		virtual void UpdateIndices(MeshHandle mesh, const std::vector<uint32_t>& indices) = 0;
+		//Replaces the contents of the instance buffer, one world matrix per instance
+		virtual void UploadInstances(const Matrix* worldMatricesPtr, uint32_t count) = 0;
+
+		//Pipeline state, every material owns its shaders, textures and blend state
+		virtual MaterialHandle CreateMaterial(MaterialType type) = 0;
+		virtual bool IsTransparent(MaterialHandle material) const = 0;
+		virtual bool SupportsInstancing(MaterialHandle material) const = 0;
+		virtual void SetCameraPosition(const Vector3& position) = 0;
+		//0: point, 1: linear, 2: anisotropic
+		virtual void SetSamplerState(int state) = 0;
+		virtual void SetUseNormalMap(bool useNormalMap) = 0;
+
+		//Draws
+		//BeginFrame clears the targets, EndFrame presents them
+		virtual void BeginFrame() = 0;
+		virtual void EndFrame() = 0;
+		virtual RenderContext& GetImmediateContext() = 0;
+
+		//How many chunks RecordParallel spreads a frame over, 0 when the backend can only record on one thread
+		virtual uint32_t GetMaxChunkCount() const = 0;
+		//Splits [0, commandCount) into chunks, records them in parallel through recordChunk and submits them in order
+		//Returns the number of chunks used
+		virtual uint32_t RecordParallel(uint32_t commandCount, const RecordChunkFunction& recordChunk) = 0;
+	};
+}
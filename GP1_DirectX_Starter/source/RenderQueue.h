@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "RenderWorld.h"
+
+namespace dae
+{
+	enum class RenderPass : uint8_t
+	{
+		Main
+	};
+
+	//A queued draw: its sort key and the index of the draw item it was built from
+	struct RenderCommand
+	{
+		uint64_t key{};
+		uint32_t item{};
+	};
+
+	//Draws sorted by a packed 64-bit key, most significant field first:
+	//	opaque:      pass (4) | 0 | material (12) | mesh (16) | view depth (24) | unused (7)
+	//	transparent: pass (4) | 1 | inverted view depth (24) | material (12) | mesh (16) | unused (7)
+	//so passes run in order and opaque draws come first, grouped by material and mesh and front-to-back inside a group.
+	//Blended draws follow back-to-front, equal depths still group by material and mesh.
+	//The material handle stands in for the effect and its texture set, every material owns both
+	class RenderQueue final
+	{
+	public:
+		static uint64_t MakeKey(RenderPass pass, bool isTransparent, MaterialHandle material, MeshHandle mesh, float viewDepth);
+		static bool IsTransparent(uint64_t key) { return (key >> m_TransparentShift) & 1; }
+
+		void Clear() { m_Commands.clear(); }
+		void Submit(uint64_t key, uint32_t item) { m_Commands.push_back({ key, item }); }
+		void Reserve(size_t count) { m_Commands.reserve(count); }
+
+		//Stable LSD radix sort on the key, 8 bits per pass, passes over digits every key shares are skipped
+		void Sort();
+
+		const std::vector<RenderCommand>& GetCommands() const { return m_Commands; }
+
+	private:
+		static constexpr uint32_t m_PassShift{ 60 };
+		static constexpr uint32_t m_TransparentShift{ 59 };
+		static constexpr uint32_t m_MaterialShift{ 47 };
+		static constexpr uint32_t m_MeshShift{ 31 };
+		static constexpr uint32_t m_DepthShift{ 7 };
+		static constexpr uint32_t m_TransparentDepthShift{ 35 };
+		static constexpr uint32_t m_TransparentMaterialShift{ 23 };
+		static constexpr uint32_t m_TransparentMeshShift{ 7 };
+		static constexpr uint32_t m_DepthBits{ 24 };
+		static constexpr uint32_t m_MaterialBits{ 12 };
+		static constexpr uint32_t m_MeshBits{ 16 };
+
+		//below this count an insertion sort beats building the histograms
+		static constexpr size_t m_SmallSortCount{ 64 };
+
+		std::vector<RenderCommand> m_Commands{};
+		std::vector<RenderCommand> m_Scratch{};
+	};
+
+	inline uint64_t RenderQueue::MakeKey(RenderPass pass, bool isTransparent, MaterialHandle material, MeshHandle mesh, float viewDepth)
+	{
+		assert(material < (1u << m_MaterialBits) && mesh < (1u << m_MeshBits));
+
+		//non-negative floats order like their bit patterns, keep the top 24 bits below the sign
+		const uint32_t depthBits = std::bit_cast<uint32_t>(std::max(viewDepth, 0.f)) >> 7;
+
+		const uint64_t passBits = static_cast<uint64_t>(pass) << m_PassShift;
+		if (isTransparent)
+		{
+			//farther draws get smaller keys, the radix sort on the whole key then orders them back-to-front
+			const uint32_t invertedDepthBits = ((1u << m_DepthBits) - 1) - depthBits;
+			return passBits
+				| uint64_t{ 1 } << m_TransparentShift
+				| static_cast<uint64_t>(invertedDepthBits) << m_TransparentDepthShift
+				| static_cast<uint64_t>(material) << m_TransparentMaterialShift
+				| static_cast<uint64_t>(mesh) << m_TransparentMeshShift;
+		}
+
+		return passBits
+			| static_cast<uint64_t>(material) << m_MaterialShift
+			| static_cast<uint64_t>(mesh) << m_MeshShift
+			| static_cast<uint64_t>(depthBits) << m_DepthShift;
+	}
+
+	inline void RenderQueue::Sort()
+	{
+		const size_t count = m_Commands.size();
+		if (count <= m_SmallSortCount)
+		{
+			for (size_t i{ 1 }; i < count; ++i)
+			{
+				const RenderCommand command = m_Commands[i];
+				size_t j{ i };
+				for (; j > 0 && m_Commands[j - 1].key > command.key; --j)
+				{
+					m_Commands[j] = m_Commands[j - 1];
+				}
+				m_Commands[j] = command;
+			}
+			return;
+		}
+
+		constexpr int digitCount{ 8 };
+		uint32_t histograms[digitCount][256]{};
+		for (const RenderCommand& command : m_Commands)
+		{
+			uint64_t key = command.key;
+			for (int digit{}; digit < digitCount; ++digit, key >>= 8)
+			{
+				++histograms[digit][key & 0xff];
+			}
+		}
+
+		m_Scratch.resize(count);
+		RenderCommand* sourcePtr = m_Commands.data();
+		RenderCommand* destinationPtr = m_Scratch.data();
+		bool isInScratch{ false };
+		for (int digit{}; digit < digitCount; ++digit)
+		{
+			const int shift = digit * 8;
+			const uint32_t* histogram = histograms[digit];
+			if (histogram[(sourcePtr[0].key >> shift) & 0xff] == count) continue;
+
+			//local offsets, so the compiler knows the scatter stores cannot modify them
+			uint32_t offsets[256];
+			uint32_t offset{};
+			for (int bucket{}; bucket < 256; ++bucket)
+			{
+				offsets[bucket] = offset;
+				offset += histogram[bucket];
+			}
+
+			for (size_t i{}; i < count; ++i)
+			{
+				const RenderCommand command = sourcePtr[i];
+				destinationPtr[offsets[(command.key >> shift) & 0xff]++] = command;
+			}
+
+			std::swap(sourcePtr, destinationPtr);
+			isInScratch = !isInScratch;
+		}
+
+		if (isInScratch)
+		{
+			m_Commands.swap(m_Scratch);
+		}
+	}
+}
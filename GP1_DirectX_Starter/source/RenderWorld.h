@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "BoundingVolumes.h"
+#include "JobSystem.h"
+#include "Matrix.h"
+#include "SceneGraph.h"
+#include "Transform.h"
+
+namespace dae
+{
+	//Low 24 bits index the sparse array, the high 8 bits are a version that changes every time the index is recycled
+	using Entity = uint32_t;
+	constexpr Entity InvalidEntity{ UINT32_MAX };
+
+	//Indices into the mesh and material arrays owned by the renderer
+	using MeshHandle = uint32_t;
+	using MaterialHandle = uint32_t;
+	constexpr MeshHandle InvalidMesh{ UINT32_MAX };
+
+	struct DrawItem
+	{
+		MeshHandle mesh{};
+		MaterialHandle material{};
+		uint32_t instance{}; //index into GetWorldMatrices(), valid until the next CreateEntity / DestroyEntity
+	};
+
+	//Sparse-set store for renderable entities
+	//Every component lives in its own dense array, all arrays share the same index so the per-frame
+	//update, cull and draw-list passes are linear walks. Destroying an entity swaps the last one into its slot.
+	//An entity can be attached to a scene graph node, its transform is then relative to that node.
+	//The per-frame passes split the dense arrays into blocks and run them on the job system, every block writes only
+	//its own elements so the results don't depend on the thread count.
+	class RenderWorld final
+	{
+	public:
+		Entity CreateEntity(MeshHandle mesh, MaterialHandle material, const Aabb& localBounds, const Transform& transform = Transform{}, NodeHandle parent = InvalidNode);
+		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const;
+
+		void SetTransform(Entity entity, const Transform& transform);
+		const Transform& GetTransform(Entity entity) const { return m_Transforms[GetIndex(entity)]; }
+		void SetEnabled(Entity entity, bool isEnabled) { m_IsEnabled[GetIndex(entity)] = static_cast<uint8_t>(isEnabled); }
+
+		//World matrix as of the last Update
+		const Matrix& GetWorldMatrix(Entity entity) const { return m_WorldMatrices[GetIndex(entity)]; }
+		const std::vector<Matrix>& GetWorldMatrices() const { return m_WorldMatrices; }
+		//World bounds as of the last Update, indexed like GetWorldMatrices()
+		const AabbSoA& GetWorldBounds() const { return m_WorldBounds; }
+
+		//Recomposes the world matrix and bounds of moved entities and of every entity attached to a node
+		//Call after sceneGraph.UpdateWorldMatrices(), returns the number of recomposed entities
+		size_t Update(const SceneGraph& sceneGraph);
+
+		//Tests the world bounds of every entity, returns the number of visible entities
+		size_t Cull(const Frustum& frustum);
+
+		//Appends every enabled entity that passed the last Cull
+		void BuildDrawList(std::vector<DrawItem>& drawList) const;
+
+		size_t GetEntityCount() const { return m_DenseToEntity.size(); }
+		void Reserve(size_t count);
+
+	private:
+		static constexpr uint32_t m_IndexBits{ 24 };
+		static constexpr uint32_t m_IndexMask{ (1u << m_IndexBits) - 1 };
+		static constexpr uint32_t m_InvalidIndex{ UINT32_MAX };
+		//entities per job of the per-frame passes, a multiple of the 8 boxes CullAabbs tests at once
+		static constexpr size_t m_BlockSize{ 1024 };
+
+		//dense, one element per live entity
+		std::vector<Transform> m_Transforms{};
+		std::vector<NodeHandle> m_Parents{};
+		std::vector<Matrix> m_WorldMatrices{};
+		std::vector<Aabb> m_LocalBounds{};
+		AabbSoA m_WorldBounds{};
+		std::vector<MeshHandle> m_Meshes{};
+		std::vector<MaterialHandle> m_Materials{};
+		std::vector<uint8_t> m_IsDirty{};
+		std::vector<uint8_t> m_IsEnabled{};
+		std::vector<uint8_t> m_IsVisible{};
+		std::vector<Entity> m_DenseToEntity{};
+
+		//sparse, one element per entity index ever created
+		std::vector<uint32_t> m_SparseToDense{};
+		std::vector<uint8_t> m_Versions{};
+		std::vector<uint32_t> m_FreeIndices{};
+
+		uint32_t GetIndex(Entity entity) const
+		{
+			assert(IsAlive(entity));
+			return m_SparseToDense[entity & m_IndexMask];
+		}
+
+		uint32_t GetBlockCount() const { return static_cast<uint32_t>((m_DenseToEntity.size() + m_BlockSize - 1) / m_BlockSize); }
+		//Runs task(begin, end) once per block with its dense range, spread over the job system
+		template<typename Task>
+		void ForEachBlock(const Task& task) const;
+	};
+
+	inline Entity RenderWorld::CreateEntity(MeshHandle mesh, MaterialHandle material, const Aabb& localBounds, const Transform& transform, NodeHandle parent)
+	{
+		uint32_t sparseIndex{};
+		if (!m_FreeIndices.empty())
+		{
+			sparseIndex = m_FreeIndices.back();
+			m_FreeIndices.pop_back();
+		}
+		else
+		{
+			sparseIndex = static_cast<uint32_t>(m_SparseToDense.size());
+			assert(sparseIndex <= m_IndexMask);
+			m_SparseToDense.push_back(m_InvalidIndex);
+			m_Versions.push_back(0);
+		}
+
+		const Entity entity = static_cast<Entity>(m_Versions[sparseIndex]) << m_IndexBits | sparseIndex;
+		m_SparseToDense[sparseIndex] = static_cast<uint32_t>(m_DenseToEntity.size());
+
+		m_Transforms.push_back(transform);
+		m_Parents.push_back(parent);
+		m_WorldMatrices.emplace_back();
+		m_LocalBounds.push_back(localBounds);
+		m_WorldBounds.PushBack(localBounds);
+		m_Meshes.push_back(mesh);
+		m_Materials.push_back(material);
+		m_IsDirty.push_back(1);
+		m_IsEnabled.push_back(1);
+		m_IsVisible.push_back(0);
+		m_DenseToEntity.push_back(entity);
+
+		return entity;
+	}
+
+	inline void RenderWorld::DestroyEntity(Entity entity)
+	{
+		const uint32_t index = GetIndex(entity);
+		const uint32_t lastIndex = static_cast<uint32_t>(m_DenseToEntity.size() - 1);
+
+		const auto swapRemove = [&](auto& values)
+		{
+			values[index] = values[lastIndex];
+			values.pop_back();
+		};
+		swapRemove(m_Transforms);
+		swapRemove(m_Parents);
+		swapRemove(m_WorldMatrices);
+		swapRemove(m_LocalBounds);
+		swapRemove(m_WorldBounds.centerX);
+		swapRemove(m_WorldBounds.centerY);
+		swapRemove(m_WorldBounds.centerZ);
+		swapRemove(m_WorldBounds.extentX);
+		swapRemove(m_WorldBounds.extentY);
+		swapRemove(m_WorldBounds.extentZ);
+		swapRemove(m_Meshes);
+		swapRemove(m_Materials);
+		swapRemove(m_IsDirty);
+		swapRemove(m_IsEnabled);
+		swapRemove(m_IsVisible);
+		swapRemove(m_DenseToEntity);
+
+		if (index != lastIndex)
+		{
+			m_SparseToDense[m_DenseToEntity[index] & m_IndexMask] = index;
+		}
+
+		const uint32_t sparseIndex = entity & m_IndexMask;
+		m_SparseToDense[sparseIndex] = m_InvalidIndex;
+		++m_Versions[sparseIndex];
+		m_FreeIndices.push_back(sparseIndex);
+	}
+
+	inline bool RenderWorld::IsAlive(Entity entity) const
+	{
+		const uint32_t sparseIndex = entity & m_IndexMask;
+		return entity != InvalidEntity
+			&& sparseIndex < m_SparseToDense.size()
+			&& m_SparseToDense[sparseIndex] != m_InvalidIndex
+			&& m_Versions[sparseIndex] == entity >> m_IndexBits;
+	}
+
+	inline void RenderWorld::SetTransform(Entity entity, const Transform& transform)
+	{
+		const uint32_t index = GetIndex(entity);
+		m_Transforms[index] = transform;
+		m_IsDirty[index] = 1;
+	}
+
+	template<typename Task>
+	void RenderWorld::ForEachBlock(const Task& task) const
+	{
+		const size_t entityCount = m_DenseToEntity.size();
+		JobSystem::Get().ParallelForRange(GetBlockCount(), 1, [&](uint32_t firstBlock, uint32_t lastBlock)
+		{
+			for (size_t block{ firstBlock }; block < lastBlock; ++block)
+			{
+				task(block * m_BlockSize, std::min((block + 1) * m_BlockSize, entityCount));
+			}
+		});
+	}
+
+	inline size_t RenderWorld::Update(const SceneGraph& sceneGraph)
+	{
+		std::atomic<size_t> updatedCount{};
+		ForEachBlock([&](size_t begin, size_t end)
+		{
+			size_t blockUpdatedCount{};
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				//attached entities follow their node, which may have moved without the store knowing
+				const NodeHandle parent = m_Parents[i];
+				if (!m_IsDirty[i] && parent == InvalidNode) continue;
+
+				const Matrix local = m_Transforms[i].ToMatrix();
+				m_WorldMatrices[i] = parent != InvalidNode ? local * sceneGraph.GetWorldMatrix(parent) : local;
+				m_WorldBounds.Set(i, m_LocalBounds[i].Transformed(m_WorldMatrices[i]));
+				m_IsDirty[i] = 0;
+				++blockUpdatedCount;
+			}
+			updatedCount.fetch_add(blockUpdatedCount, std::memory_order_relaxed);
+		});
+		return updatedCount.load(std::memory_order_relaxed);
+	}
+
+	inline size_t RenderWorld::Cull(const Frustum& frustum)
+	{
+		std::atomic<size_t> visibleCount{};
+		ForEachBlock([&](size_t begin, size_t end)
+		{
+			visibleCount.fetch_add(CullAabbs(frustum, m_WorldBounds, m_IsVisible.data(), begin, end), std::memory_order_relaxed);
+		});
+		return visibleCount.load(std::memory_order_relaxed);
+	}
+
+	inline void RenderWorld::BuildDrawList(std::vector<DrawItem>& drawList) const
+	{
+		//count every block, then every block writes from its offset: the same order as one walk over the arrays
+		const uint32_t blockCount = GetBlockCount();
+		std::vector<uint32_t> offsets(blockCount + 1);
+		ForEachBlock([&](size_t begin, size_t end)
+		{
+			uint32_t count{};
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				count += m_IsVisible[i] & m_IsEnabled[i];
+			}
+			offsets[begin / m_BlockSize + 1] = count;
+		});
+		for (uint32_t block{}; block < blockCount; ++block)
+		{
+			offsets[block + 1] += offsets[block];
+		}
+
+		const size_t first = drawList.size();
+		drawList.resize(first + offsets[blockCount]);
+		ForEachBlock([&](size_t begin, size_t end)
+		{
+			DrawItem* outputPtr = drawList.data() + first + offsets[begin / m_BlockSize];
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				if (!(m_IsVisible[i] & m_IsEnabled[i])) continue;
+				*outputPtr++ = { m_Meshes[i], m_Materials[i], static_cast<uint32_t>(i) };
+			}
+		});
+	}
+
+	inline void RenderWorld::Reserve(size_t count)
+	{
+		m_Transforms.reserve(count);
+		m_Parents.reserve(count);
+		m_WorldMatrices.reserve(count);
+		m_LocalBounds.reserve(count);
+		for (std::vector<float>* streamPtr : { &m_WorldBounds.centerX, &m_WorldBounds.centerY, &m_WorldBounds.centerZ, &m_WorldBounds.extentX, &m_WorldBounds.extentY, &m_WorldBounds.extentZ })
+		{
+			streamPtr->reserve(count);
+		}
+		m_Meshes.reserve(count);
+		m_Materials.reserve(count);
+		m_IsDirty.reserve(count);
+		m_IsEnabled.reserve(count);
+		m_IsVisible.reserve(count);
+		m_DenseToEntity.reserve(count);
+		m_SparseToDense.reserve(count);
+		m_Versions.reserve(count);
+	}
+}
@@ -1,8 +1,13 @@
 #include "pch.h"
 #include "Renderer.h"
 
-#include "FireFXEffect.h"
-#include "Mesh.h"
+#include <algorithm>
+#include <array>
+
+#include "Console.h"
+#include "D3D11RenderBackend.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include "Utils.h"
 
 namespace dae {
@@ -15,256 +20,249 @@ namespace dae {
 
 
 		//Initialize DirectX pipeline
-		const HRESULT result = InitializeDirectX();
-		if (result == S_OK)
-		{
-			m_IsInitialized = true;
-			std::cout << "DirectX is initialized and ready!\n";
-		}
-		else
-		{
-			std::cout << "DirectX initialization failed!\n";
-		}
+		m_BackendPtr = std::make_unique<D3D11RenderBackend>(pWindow);
+		m_IsInitialized = m_BackendPtr->IsInitialized();
+		m_PipelinePtr = std::make_unique<FramePipeline>(*m_BackendPtr);
 
 		// initialize camera
 		m_CameraPtr = new Camera({ 0,0,-50 }, 45.f, static_cast<float>(m_Width) / static_cast<float>(m_Height), m_VehiclePos);
 
+		// parse both meshes as parallel jobs, the pipeline takes them on this thread afterwards
+		struct ObjFile
+		{
+			const char* path;
+			std::vector<MeshVertex> vertices{ };
+			std::vector<uint32_t> indices{ };
+			bool isParsed{ false };
+		};
+		std::array<ObjFile, 2> objFiles{ { { "Resources/vehicle.obj" }, { "Resources/fireFX.obj" } } };
+		ParallelFor(static_cast<uint32_t>(objFiles.size()), [&](uint32_t file)
+		{
+			ObjFile& objFile{ objFiles[file] };
+			objFile.isParsed = Utils::ParseOBJ(objFile.path, objFile.vertices, objFile.indices);
+		});
+		const ObjFile& vehicleObj{ objFiles[0] };
+		const ObjFile& fireFXObj{ objFiles[1] };
+
 		// initialize vehicle object
-		VehicleEffect* vehicleMat = new VehicleEffect(m_DevicePtr);
+		m_VehicleMaterial = m_PipelinePtr->CreateMaterial(MaterialType::Vehicle);
 
-		std::vector<Mesh::Vertex> verticesVehicle{ };
-		std::vector<uint32_t> indicesVehicle{ };
+		constexpr Transform vehicleTransform{ m_VehiclePos };
+		m_VehicleNode = m_PipelinePtr->GetSceneGraph().CreateNode(vehicleTransform);
 
-		if(Utils::ParseOBJ("Resources/vehicle.obj", verticesVehicle, indicesVehicle))
+		if(vehicleObj.isParsed)
 		{
-			Mesh* vehicleMeshPtr = new Mesh(m_DevicePtr, verticesVehicle, indicesVehicle, vehicleMat);
-			m_MeshesPtr.push_back(vehicleMeshPtr);
-		}
+			m_VehicleMesh = m_PipelinePtr->CreateMesh(vehicleObj.vertices, vehicleObj.indices, m_VehicleMaterial);
+			const Aabb& vehicleBounds{ m_PipelinePtr->GetMeshBounds(m_VehicleMesh) };
+			m_PipelinePtr->GetRenderWorld().CreateEntity(m_VehicleMesh, m_VehicleMaterial, vehicleBounds, Transform{}, m_VehicleNode);
 
-		const Matrix TVMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, m_VehiclePos };
-		m_MeshesPtr[0]->GetWorldMatrix() *= TVMatrix;
+			// the body fills most of its bounds, a shrunk box stays inside it and makes a cheap occluder
+			m_PipelinePtr->SetOccluderBounds(m_VehicleMesh, Aabb::FromCenterExtents(vehicleBounds.GetCenter(), vehicleBounds.GetExtents() * m_OccluderScale));
+		}
 
 
-		// initialize vehicle object
-		FireFXEffect* fireFXMat = new FireFXEffect(m_DevicePtr);
+		// initialize fire fx object, attached to the vehicle
+		const MaterialHandle fireFXMaterial = m_PipelinePtr->CreateMaterial(MaterialType::FireFX);
 
-		std::vector<Mesh::Vertex> verticesFireFX{ };
-		std::vector<uint32_t> indicesFireFX{ };
-
-		if (Utils::ParseOBJ("Resources/fireFX.obj", verticesFireFX, indicesFireFX))
+		if (fireFXObj.isParsed)
 		{
-			Mesh* FireFxMeshPtr = new Mesh(m_DevicePtr, verticesFireFX, indicesFireFX, fireFXMat);
-			m_MeshesPtr.push_back(FireFxMeshPtr);
+			const MeshHandle fireFXMesh = m_PipelinePtr->CreateMesh(fireFXObj.vertices, fireFXObj.indices, fireFXMaterial);
+			m_FireFXEntity = m_PipelinePtr->GetRenderWorld().CreateEntity(fireFXMesh, fireFXMaterial, m_PipelinePtr->GetMeshBounds(fireFXMesh), Transform{}, m_VehicleNode);
 		}
-		const Matrix TFXMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, m_VehiclePos };
-		m_MeshesPtr[1]->GetWorldMatrix() *= TFXMatrix;
+
+		m_PipelinePtr->GetSceneGraph().UpdateWorldMatrices();
+		m_PipelinePtr->GetRenderWorld().Update(m_PipelinePtr->GetSceneGraph());
 	}
 
 	Renderer::~Renderer()
 	{
+		// the simulation thread works on the pipeline, it stops first
+		if (m_SimulationThread.joinable())
+		{
+			m_FrameRing.Close();
+			m_SimulationThread.join();
+		}
+
 		delete m_CameraPtr;
 		m_CameraPtr = nullptr;
 
-		for(int i{}; m_MeshesPtr.size() > i; ++i)
-		{
-			delete m_MeshesPtr[i];
-			m_MeshesPtr[i] = nullptr;
-		}
+		// the pipeline holds a reference to the backend
+		m_PipelinePtr.reset();
+		m_BackendPtr.reset();
+	}
 
-		if (m_DevicePtr)
-		{
-			m_DevicePtr->Release();
-		}
+	void Renderer::Update(const Timer* pTimer)
+	{
+		DAE_PROFILE_FUNCTION();
+		m_CameraPtr->Update(pTimer);
+		UpdateScene(pTimer->GetElapsed());
+	}
 
-		if(m_DeviceContextPtr)
+	void Renderer::UpdateScene(float elapsedSec)
+	{
+		DAE_PROFILE_FUNCTION();
+		Frame& frame{ m_PipelineDepth == 1 ? m_InlineFrame : m_FrameRing.BeginRequest() };
+
+		SimulationInput& input{ frame.input };
+		input.viewProjectionMatrix = m_CameraPtr->GetViewProjectionMatrix();
+		input.cameraPosition = m_CameraPtr->GetOrigin();
+		input.elapsedSec = elapsedSec;
+		input.canRotate = m_CanRotate;
+		input.renderFireFX = m_renderFireFX;
+		input.showCrowd = m_ShowCrowd;
+		input.settings = m_PipelineSettings;
+		input.sampleTime = std::chrono::steady_clock::now();
+
+		if (m_PipelineDepth == 1)
 		{
-			m_DeviceContextPtr->ClearState();
-			m_DeviceContextPtr->Flush();
-			m_DeviceContextPtr->Release();
+			Simulate(input, frame.packet);
 		}
-
-		if (m_SwapChainPtr)
+		else
 		{
-			m_SwapChainPtr->Release();
+			m_FrameRing.EndRequest();
 		}
+	}
 
-		if (m_DepthStencilBufferPtr)
+	void Renderer::Simulate(const SimulationInput& input, FramePipeline::FramePacket& packet)
+	{
+		DAE_PROFILE_FUNCTION();
+		m_PipelinePtr->GetSettings() = input.settings;
+
+		RenderWorld& renderWorld{ m_PipelinePtr->GetRenderWorld() };
+		if (m_FireFXEntity != InvalidEntity && input.renderFireFX != m_IsFireFXEnabled)
 		{
-			m_DepthStencilBufferPtr->Release();
+			m_IsFireFXEnabled = input.renderFireFX;
+			renderWorld.SetEnabled(m_FireFXEntity, m_IsFireFXEnabled);
 		}
 
-		if (m_DepthStencilViewPtr)
+		if (m_VehicleMesh != InvalidMesh && input.showCrowd != !m_CrowdEntities.empty())
 		{
-			m_DepthStencilViewPtr->Release();
+			if (input.showCrowd)
+			{
+				// grid of static vehicles behind the animated one
+				const Aabb& bounds{ m_PipelinePtr->GetMeshBounds(m_VehicleMesh) };
+				const Vector3 extents{ bounds.GetExtents() };
+				const float spacing{ 2.5f * std::max(extents.x, extents.z) };
+
+				m_CrowdEntities.reserve(m_CrowdGridSize * m_CrowdGridSize);
+				renderWorld.Reserve(renderWorld.GetEntityCount() + m_CrowdGridSize * m_CrowdGridSize);
+				for (int row{}; row < m_CrowdGridSize; ++row)
+				{
+					for (int column{}; column < m_CrowdGridSize; ++column)
+					{
+						const Vector3 position{ (static_cast<float>(column) - m_CrowdGridSize * 0.5f) * spacing, 0.f, static_cast<float>(row + 2) * spacing };
+						m_CrowdEntities.push_back(renderWorld.CreateEntity(m_VehicleMesh, m_VehicleMaterial, bounds, Transform{ m_VehiclePos + position }));
+					}
+				}
+			}
+			else
+			{
+				for (const Entity entity : m_CrowdEntities)
+				{
+					renderWorld.DestroyEntity(entity);
+				}
+				m_CrowdEntities.clear();
+			}
 		}
 
-		if (m_RenderTargetBufferPtr)
+		if (input.canRotate)
 		{
-			m_RenderTargetBufferPtr->Release();
+			// rotate vehicle, attached nodes (fire fx) follow through the scene graph
+			constexpr float rotationSpeedDegrees{ 45.0f }; // Set the rotation speed in degrees per second
+			constexpr float rotationSpeedRadians{ rotationSpeedDegrees * (M_PI / 180.0f) };
+
+			const float rotationAngle = input.elapsedSec * rotationSpeedRadians;
+
+			// Rotation around the y-axis, about the vehicle position
+			const Quaternion deltaRotation = Quaternion::CreateFromAxisAngle(Vector3::UnitY, rotationAngle);
+
+			SceneGraph& sceneGraph{ m_PipelinePtr->GetSceneGraph() };
+			Transform transform{ sceneGraph.GetLocalTransform(m_VehicleNode) };
+			transform.RotateAround(m_VehiclePos, deltaRotation);
+			sceneGraph.SetLocalTransform(m_VehicleNode, transform);
 		}
 
-		if (m_RenderTargetViewPtr)
+		// update, cull and sort for this frame's camera
+		m_PipelinePtr->Update(input.viewProjectionMatrix, packet);
+	}
+
+	void Renderer::RunSimulationThread()
+	{
+		DAE_PROFILE_THREAD("Simulation");
+		while (Frame* framePtr = m_FrameRing.BeginProduce())
 		{
-			m_RenderTargetViewPtr->Release();
+			Simulate(framePtr->input, framePtr->packet);
+			m_FrameRing.EndProduce();
 		}
 	}
 
-	void Renderer::Update(const Timer* pTimer) const
+	void Renderer::Render()
 	{
-		m_CameraPtr->Update(pTimer);
-
-		for (int i{}; m_MeshesPtr.size() > i; ++i)
+		DAE_PROFILE_FUNCTION();
+		if (m_PipelineDepth == 1)
 		{
-			m_MeshesPtr[i]->GetEffectPtr()->GetCameraPos()->SetFloatVector(reinterpret_cast<float*>(&m_CameraPtr->GetOrigin()));
+			m_RenderFramePtr = &m_InlineFrame;
 		}
-
-		if (m_CanRotate)
+		else
 		{
-			// rotate meshes
-			constexpr float rotationSpeedDegrees{ 45.0f }; // Set the rotation speed in degrees per second
-			constexpr float rotationSpeedRadians{ rotationSpeedDegrees * (M_PI / 180.0f) };
+			// the ring fills up before the first frame is drawn, the simulation then stays depth - 1 frames ahead
+			if (m_FrameRing.GetInFlightCount() < m_PipelineDepth) return;
+			m_RenderFramePtr = &m_FrameRing.BeginConsume();
+		}
+
+		if (!m_IsInitialized) return;
 
-			const float rotationAngle = pTimer->GetElapsed() * rotationSpeedRadians;
+		// upload + set pipeline + invoke draw calls (= render)
+		m_BackendPtr->BeginFrame();
+		m_BackendPtr->SetCameraPosition(m_RenderFramePtr->input.cameraPosition);
+		m_PipelinePtr->Submit(m_RenderFramePtr->packet);
+	}
 
-			// translation to world origin
-			const Matrix translationToOrigin = Matrix::CreateTranslation(-m_VehiclePos.x, -m_VehiclePos.y, -m_VehiclePos.z);
+	void Renderer::Present()
+	{
+		if (!m_RenderFramePtr) return;
+		DAE_PROFILE_FUNCTION();
 
-			// Rotation around the y-axis
-			const Matrix rotationMatrix = Matrix::CreateRotation(0, rotationAngle, 0);
+		if (m_IsInitialized)
+		{
+			m_BackendPtr->EndFrame();
+		}
 
-			// translation back to objectPos
-			const Matrix translationBack = Matrix::CreateTranslation(m_VehiclePos.x, m_VehiclePos.y, m_VehiclePos.z);
+		const auto latency = std::chrono::steady_clock::now() - m_RenderFramePtr->input.sampleTime;
+		m_Latencies.Add(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
 
-			// Combine and apply the matrices
-			for (int i{}; i < m_MeshesPtr.size(); ++i)
-			{
-				m_MeshesPtr[i]->GetWorldMatrix() *= translationToOrigin * rotationMatrix * translationBack;
-			}
+		if (m_PipelineDepth > 1)
+		{
+			m_FrameRing.EndConsume();
 		}
+		m_RenderFramePtr = nullptr;
 	}
 
-	void Renderer::Render() const
+	void Renderer::SetPipelineDepth(uint32_t frameCount)
 	{
-		if (!m_IsInitialized) return;
+		frameCount = std::clamp(frameCount, 1u, MaxPipelineDepth);
+		if (frameCount == m_PipelineDepth) return;
 
-		// clear RTV & DSV
-		constexpr float color[4] = {0.39f, 0.59f, 0.93f, 1.f};
-		m_DeviceContextPtr->ClearRenderTargetView(m_RenderTargetViewPtr, color);
-		m_DeviceContextPtr->ClearDepthStencilView(m_DepthStencilViewPtr, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+		// frames in flight are dropped, their simulation already happened so the scene doesn't jump back
+		m_FrameRing.Reset(frameCount);
+		m_PipelineDepth = frameCount;
+		m_Latencies.Clear();
 
-		// set pipeline + invoke draw calls (= render)
-		constexpr int fireFxIndex{ 1 };
-		for (int i{}; m_MeshesPtr.size() > i; ++i)
+		if (frameCount > 1 && !m_SimulationThread.joinable())
 		{
-			if(i != fireFxIndex || i == fireFxIndex && m_renderFireFX)
-			{
-				Matrix worldViewProjectionMatrix{ m_MeshesPtr[i]->GetWorldMatrix() * m_CameraPtr->GetInvViewMatrix() * m_CameraPtr->GetProjectionMatrix() };
-				m_MeshesPtr[i]->Render(m_DeviceContextPtr, reinterpret_cast<float*>(&worldViewProjectionMatrix));
-			}
+			m_SimulationThread = std::thread{ &Renderer::RunSimulationThread, this };
 		}
-
-		// present back buffer (swap)
-		m_SwapChainPtr->Present(0, 0);
 	}
 
-	HRESULT Renderer::InitializeDirectX()
+	void Renderer::CyclePipelineDepth()
 	{
-		// create device & deviceContext
-		constexpr D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
-		uint32_t createDeviceFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG)
-		createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
-#endif
-		HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, createDeviceFlags, &featureLevel,
-			1, D3D11_SDK_VERSION, &m_DevicePtr, nullptr, &m_DeviceContextPtr);
-		if (FAILED(result)) return result;
-
-		// create DGXIFactory
-		IDXGIFactory1* dxgiFactoryPtr{};
-		result = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&dxgiFactoryPtr));
-
-		if (FAILED(result)) return result;
-
-		// Create a swap chain
-		DXGI_SWAP_CHAIN_DESC swapChainDesc{};
-		swapChainDesc.BufferDesc.Width = m_Width;
-		swapChainDesc.BufferDesc.Height = m_Height;
-		swapChainDesc.BufferDesc.RefreshRate.Numerator = 1;
-		swapChainDesc.BufferDesc.RefreshRate.Denominator = 60;
-		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-		swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-		swapChainDesc.SampleDesc.Count = 1;
-		swapChainDesc.SampleDesc.Quality = 0;
-		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-		swapChainDesc.BufferCount = 1;
-		swapChainDesc.Windowed = true;
-		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-		swapChainDesc.Flags = 0;
-
-		// get the handle from the SDL backBuffer
-		SDL_SysWMinfo sysWMInfo{};
-		SDL_GetVersion(&sysWMInfo.version);
-		SDL_GetWindowWMInfo(m_WindowPtr, &sysWMInfo);
-		swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
-
-		// Create swap chain
-		result = dxgiFactoryPtr->CreateSwapChain(m_DevicePtr, &swapChainDesc, &m_SwapChainPtr);
-
-		dxgiFactoryPtr->Release();
-		if (FAILED(result)) return result;
-
-		//3. Create DepthStencil (DS) & DepthStencilView (DSV)
-		//Resource
-		D3D11_TEXTURE2D_DESC depthStencilDesc{};
-		depthStencilDesc.Width = m_Width;
-		depthStencilDesc.Height = m_Height;
-		depthStencilDesc.MipLevels = 1;
-		depthStencilDesc.ArraySize = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		depthStencilDesc.SampleDesc.Count = 1;
-		depthStencilDesc.SampleDesc.Quality = 0;
-		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
-		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-		depthStencilDesc.CPUAccessFlags = 0;
-		depthStencilDesc.MiscFlags = 0;
-
-		//View
-		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
-		depthStencilViewDesc.Format = depthStencilDesc.Format;
-		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-		depthStencilViewDesc.Texture2D.MipSlice = 0;
-
-		result = m_DevicePtr->CreateTexture2D(&depthStencilDesc, nullptr, &m_DepthStencilBufferPtr);
-		if (FAILED(result)) return result;
-
-		result = m_DevicePtr->CreateDepthStencilView(m_DepthStencilBufferPtr, &depthStencilViewDesc, &m_DepthStencilViewPtr);
-		if (FAILED(result)) return result;
-
-		// Create renderTarget and renderTargetView
-		// resource
-		result = m_SwapChainPtr->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_RenderTargetBufferPtr));
-		if (FAILED(result)) return result;
-
-		// view
-		result = m_DevicePtr->CreateRenderTargetView(m_RenderTargetBufferPtr, nullptr, &m_RenderTargetViewPtr);
-		if (FAILED(result)) return result;
-
-		// bind renderTargetView and depthStencilView to output merger stage
-		m_DeviceContextPtr->OMSetRenderTargets(1, &m_RenderTargetViewPtr, m_DepthStencilViewPtr);
-
-		// set viewport
-		D3D11_VIEWPORT viewport{};
-		viewport.Width = static_cast<float>(m_Width);
-		viewport.Height = static_cast<float>(m_Height);
-		viewport.TopLeftX = 0.f;
-		viewport.TopLeftY = 0.f;
-		viewport.MinDepth = 0.f;
-		viewport.MaxDepth = 1.f;
-
-		m_DeviceContextPtr->RSSetViewports(1, &viewport);
-
-		return S_OK;
+		SetPipelineDepth(m_PipelineDepth % MaxPipelineDepth + 1);
+
+		Console::SetTextAttribute(0x0c);
+		std::cout << "Pipelined Frames ";
+		Console::SetTextAttribute(m_PipelineDepth > 1 ? 0x0a : 0x04);
+		std::cout << m_PipelineDepth << (m_PipelineDepth > 1 ? " (simulation thread)" : " (off)") << std::endl;
+		Console::SetTextAttribute(0x07);
 	}
 
 	void Renderer::CycleSamplerState()
@@ -273,14 +271,10 @@ namespace dae {
 		++m_SamplerState;
 		m_SamplerState %= nrOfStates;
 
-		for (int i{}; m_MeshesPtr.size() > i; ++i)
-		{
-			m_MeshesPtr[i]->GetEffectPtr()->SetSamplerState(m_DevicePtr, m_SamplerState);
-		}
+		m_BackendPtr->SetSamplerState(m_SamplerState);
 
 		// set console textColor to red
-		const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		SetConsoleTextAttribute(hConsole, 0x0c);
+		Console::SetTextAttribute(0x0c);
 
 		switch (m_SamplerState)
 		{
@@ -299,57 +293,103 @@ namespace dae {
 		}
 
 		// set console textColor to white
-		SetConsoleTextAttribute(hConsole, 0x07);
+		Console::SetTextAttribute(0x07);
 	}
 
 	void Renderer::ToggleRotation()
 	{
 		m_CanRotate = !m_CanRotate;
+		Console::PrintToggle("Rotation", m_CanRotate);
+	}
 
-		const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		SetConsoleTextAttribute(hConsole, 0x0c);
-		std::cout << "Rotation ";
+	void Renderer::ToggleNormalMap()
+	{
+		m_UseNormalMap = !m_UseNormalMap;
+		Console::PrintToggle("Normal Map", m_UseNormalMap);
 
-		if (m_CanRotate) SetConsoleTextAttribute(hConsole, 0x0a);
-		else SetConsoleTextAttribute(hConsole, 0x04);
-		std::cout << std::boolalpha << m_CanRotate << std::endl;
+		m_BackendPtr->SetUseNormalMap(m_UseNormalMap);
+	}
 
-		SetConsoleTextAttribute(hConsole, 0x07);
+	void Renderer::ToggleFireFX()
+	{
+		SetFireFX(!m_renderFireFX);
+		Console::PrintToggle("Fire Effect", m_renderFireFX);
 	}
 
-	void Renderer::ToggleNormalMap()
+	void Renderer::ToggleCrowd()
 	{
-		m_UseNormalMap = !m_UseNormalMap;
+		if (m_VehicleMesh == InvalidMesh) return;
 
-		const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		SetConsoleTextAttribute(hConsole, 0x0c);
-		std::cout << "Normal Map ";
+		// the entities are created or destroyed by the simulation of the next frame
+		m_ShowCrowd = !m_ShowCrowd;
 
-		if (m_UseNormalMap) SetConsoleTextAttribute(hConsole, 0x0a);
-		else SetConsoleTextAttribute(hConsole, 0x04);
-		std::cout << std::boolalpha << m_UseNormalMap << std::endl;
+		Console::SetTextAttribute(0x0c);
+		std::cout << "Crowd ";
+		if (m_ShowCrowd)
+		{
+			Console::SetTextAttribute(0x0a);
+			std::cout << m_CrowdGridSize * m_CrowdGridSize << " vehicles" << std::endl;
+		}
+		else
+		{
+			Console::SetTextAttribute(0x04);
+			std::cout << "off" << std::endl;
+		}
 
-		SetConsoleTextAttribute(hConsole, 0x07);
+		Console::SetTextAttribute(0x07);
+	}
 
-		BaseEffect* baseEffectPtr = m_MeshesPtr[0]->GetEffectPtr();
-		// Check if the effect is of type VehicleEffect
-		const VehicleEffect* vehicleEffectPtr = reinterpret_cast<VehicleEffect*>(baseEffectPtr);
+	void Renderer::ToggleInstancing()
+	{
+		bool& useInstancing{ m_PipelineSettings.useInstancing };
+		useInstancing = !useInstancing;
+		Console::PrintToggle("Instancing", useInstancing);
+	}
 
-		vehicleEffectPtr->SetUseNormalMap(m_UseNormalMap);
+	void Renderer::ToggleRenderStats()
+	{
+		m_PrintRenderStats = !m_PrintRenderStats;
+		Console::PrintToggle("Render Stats", m_PrintRenderStats);
 	}
 
-	void Renderer::ToggleFireFX()
+	void Renderer::ToggleTriangleSorting()
 	{
-		m_renderFireFX = !m_renderFireFX;
+		bool& sortTransparentTriangles{ m_PipelineSettings.sortTransparentTriangles };
+		sortTransparentTriangles = !sortTransparentTriangles;
+		Console::PrintToggle("Transparent Triangle Sorting", sortTransparentTriangles);
+	}
 
-		const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		SetConsoleTextAttribute(hConsole, 0x0c);
-		std::cout << "Fire Effect ";
+	void Renderer::ToggleOcclusionCulling()
+	{
+		bool& useOcclusionCulling{ m_PipelineSettings.useOcclusionCulling };
+		useOcclusionCulling = !useOcclusionCulling;
+		Console::PrintToggle("Occlusion Culling", useOcclusionCulling);
+	}
 
-		if (m_renderFireFX) SetConsoleTextAttribute(hConsole, 0x0a);
-		else SetConsoleTextAttribute(hConsole, 0x04);
-		std::cout << std::boolalpha << m_renderFireFX << std::endl;
+	void Renderer::ToggleDeferredContexts()
+	{
+		bool& useParallelRecording{ m_PipelineSettings.useParallelRecording };
+		useParallelRecording = !useParallelRecording;
+		Console::PrintToggle("Deferred Contexts", useParallelRecording);
+	}
 
-		SetConsoleTextAttribute(hConsole, 0x07);
+	void Renderer::PrintRenderStats() const
+	{
+		if (!m_PrintRenderStats) return;
+
+		const FramePipeline::RenderStats& stats{ m_PipelinePtr->GetStats() };
+		std::cout << "visible: " << stats.visibleCount
+			<< " | culled: " << stats.culledCount
+			<< " in " << stats.cullTimeMs << " ms"
+			<< " | occluded: " << stats.occludedCount
+			<< " by " << stats.occluderCount << " occluders"
+			<< " in " << stats.occlusionTimeMs << " ms" << std::endl;
+		std::cout << "draws: " << stats.drawCount
+			<< " | mesh binds: " << stats.meshBindCount
+			<< " (skipped " << stats.meshBindsSkipped << ")"
+			<< " | effect switches: " << stats.effectSwitchCount
+			<< " | chunks: " << stats.chunkCount
+			<< " | queue: " << stats.queueSize
+			<< " sorted in " << stats.sortTimeMs << " ms" << std::endl;
 	}
 }
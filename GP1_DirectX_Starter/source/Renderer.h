@@ -1,8 +1,14 @@
 #pragma once
-#include "Mesh.h"
+#include <chrono>
+#include <thread>
+
 #include "Camera.h"
+#include "FramePipeline.h"
+#include "FrameRing.h"
+#include "FrameTimeHistogram.h"
 struct SDL_Window;
 struct SDL_Surface;
+class D3D11RenderBackend;
 
 namespace dae
 {
@@ -17,8 +23,14 @@ namespace dae
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
-		void Update(const Timer* pTimer) const;
-		void Render() const;
+		void Update(const Timer* pTimer);
+		//Update without the camera input, the caller places the camera
+		//Samples the input of a frame, simulated right away or handed to the simulation thread when pipelined
+		void UpdateScene(float elapsedSec);
+		//Records and submits the oldest simulated frame, Present shows it
+		//While pipelined the first frames after a switch only fill the ring and nothing is drawn
+		void Render();
+		void Present();
 
 		Camera& GetCamera() const { return *m_CameraPtr; }
 
@@ -26,24 +38,81 @@ namespace dae
 		void ToggleRotation();
 		void ToggleNormalMap();
 		void ToggleFireFX();
+		void ToggleCrowd();
+		void ToggleInstancing();
+		void ToggleRenderStats();
+		void ToggleTriangleSorting();
+		void ToggleOcclusionCulling();
+		void ToggleDeferredContexts();
+		void CyclePipelineDepth();
+
+		//Silent versions of the toggles, for scripted runs
+		void SetRotation(bool canRotate) { m_CanRotate = canRotate; }
+		void SetFireFX(bool renderFireFX) { m_renderFireFX = renderFireFX; }
+		//Frames in flight between input and present: 1 simulates and renders on this thread, 2 or 3 simulate frame N + 1
+		//on the simulation thread while this one renders frame N, at one or two frames of extra latency
+		void SetPipelineDepth(uint32_t frameCount);
+		uint32_t GetPipelineDepth() const { return m_PipelineDepth; }
+		//Holds the simulation thread between two frames, nothing it records (profiler zones) changes until ResumeSimulation
+		void PauseSimulation() { m_FrameRing.Pause(); }
+		void ResumeSimulation() { m_FrameRing.Resume(); }
+
+		//Input sample to the end of present of the last FrameTimeHistogram::WindowSize frames, in microseconds
+		const FrameTimeHistogram& GetLatencies() const { return m_Latencies; }
+
+		//Prints the stats of the last frame when enabled
+		void PrintRenderStats() const;
+
+		static constexpr uint32_t MaxPipelineDepth{ 3 };
 
 	private:
-		SDL_Window*				m_WindowPtr{};
-		ID3D11Device*			m_DevicePtr{};
-		ID3D11DeviceContext*	m_DeviceContextPtr{};
-		IDXGISwapChain*			m_SwapChainPtr{};
+		//Everything the simulation of a frame needs from this thread, the camera and window input stay here
+		struct SimulationInput
+		{
+			Matrix viewProjectionMatrix{};
+			Vector3 cameraPosition{};
+			float elapsedSec{};
+			bool canRotate{};
+			bool renderFireFX{};
+			bool showCrowd{};
+			FramePipeline::Settings settings{};
+			std::chrono::steady_clock::time_point sampleTime{};
+		};
 
-		ID3D11Texture2D*		m_DepthStencilBufferPtr{};
-		ID3D11DepthStencilView* m_DepthStencilViewPtr{};
+		struct Frame
+		{
+			SimulationInput input{};
+			FramePipeline::FramePacket packet{};
+		};
 
-		ID3D11Resource*			m_RenderTargetBufferPtr{};
-		ID3D11RenderTargetView* m_RenderTargetViewPtr{};
+		SDL_Window* m_WindowPtr{};
+
+		// the device and everything on it sit behind the backend, the frame pipeline only sees handles
+		std::unique_ptr<D3D11RenderBackend> m_BackendPtr{};
+		std::unique_ptr<FramePipeline> m_PipelinePtr{};
 
 		Camera* m_CameraPtr{};
-		Mesh* m_TrianglePtr{};
 
-		std::vector<Mesh*> m_MeshesPtr{};
-		const Vector3 m_VehiclePos{ 0, 0, 0 };
+		static constexpr float m_OccluderScale{ 0.6f };
+
+		NodeHandle m_VehicleNode{ InvalidNode };
+		MeshHandle m_VehicleMesh{ InvalidMesh };
+		MaterialHandle m_VehicleMaterial{};
+		Entity m_FireFXEntity{ InvalidEntity };
+		static constexpr Vector3 m_VehiclePos{ 0, 0, 0 };
+		static constexpr int m_CrowdGridSize{ 64 };
+
+		// owned by whichever thread simulates, synced from the input of every frame
+		std::vector<Entity> m_CrowdEntities{};
+		bool m_IsFireFXEnabled{ true };
+
+		// depth 1 uses the inline frame, deeper pipelines the ring and the simulation thread
+		uint32_t m_PipelineDepth{ 1 };
+		Frame m_InlineFrame{};
+		FrameRing<Frame> m_FrameRing{ MaxPipelineDepth };
+		std::thread m_SimulationThread{};
+		Frame* m_RenderFramePtr{};
+		FrameTimeHistogram m_Latencies{};
 
 		int m_Width{};
 		int m_Height{};
@@ -54,9 +123,11 @@ namespace dae
 		bool m_CanRotate{ false };
 		bool m_UseNormalMap{ true };
 		bool m_renderFireFX{ true };
+		bool m_ShowCrowd{ false };
+		bool m_PrintRenderStats{ false };
+		FramePipeline::Settings m_PipelineSettings{};
 
-		//DIRECTX
-		HRESULT InitializeDirectX();
-		//...
+		void Simulate(const SimulationInput& input, FramePipeline::FramePacket& packet);
+		void RunSimulationThread();
 	};
 }
@@ -10,6 +10,7 @@ Texture2D gGlossinessMap : GlossinessMap;
 float3 gLightDirection : LightDirection = float3(0.577f, -0.577f, 0.577f);
 float3 gAmbientIntensity : Ambient = float3(0.03f, 0.03f, 0.03f);
 float4x4 gWorldMatrix : WORLD;
+float4x4 gViewProj : ViewProjection; // instanced technique only
 float3 gCameraPosition : CAMERA;
 
 float gPI : PI = float(3.14159265359);
@@ -53,6 +54,20 @@ struct VS_INPUT
     float3 Tangent : TANGENT;
 };
 
+// per-vertex data in slot 0, the rows of the instance world matrix in slot 1
+struct VS_INSTANCED_INPUT
+{
+    float3 Position : POSITION;
+    float3 Color : COLOR;
+    float2 UV : TEXCOORD;
+    float3 Normal : NORMAL;
+    float3 Tangent : TANGENT;
+    float4 World0 : WORLD0;
+    float4 World1 : WORLD1;
+    float4 World2 : WORLD2;
+    float4 World3 : WORLD3;
+};
+
 struct VS_OUTPUT
 {
     float4 Position : SV_POSITION;
@@ -78,6 +93,21 @@ VS_OUTPUT VS(VS_INPUT input)
     return output;
 }
 
+VS_OUTPUT VS_Instanced(VS_INSTANCED_INPUT input)
+{
+    VS_OUTPUT output = (VS_OUTPUT) 0;
+
+    const float4x4 world = float4x4(input.World0, input.World1, input.World2, input.World3);
+
+    output.WorldPosition = mul(float4(input.Position, 1.0f), world);
+    output.Position = mul(output.WorldPosition, gViewProj);
+    output.UV = input.UV;
+    output.Normal = mul(normalize(input.Normal), (float3x3) world);
+    output.Tangent = mul(normalize(input.Tangent), (float3x3) world);
+
+    return output;
+}
+
 float4 Diffuse(VS_OUTPUT input)
 {
     return gDiffuseMap.Sample(gSamplerState, input.UV);
@@ -149,4 +179,17 @@ technique11 DefaultTechnique
         SetGeometryShader(NULL);
         SetPixelShader(CompileShader(ps_5_0, PS()));
     }
+}
+
+technique11 InstancedTechnique
+{
+    pass PO
+    {
+        SetRasterizerState(gRasterizerState);
+        SetDepthStencilState(gDepthStencilState, 0);
+        SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+        SetVertexShader(CompileShader(vs_5_0, VS_Instanced()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PS()));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Matrix.h"
+#include "Transform.h"
+
+namespace dae
+{
+	using NodeHandle = uint32_t;
+	constexpr NodeHandle InvalidNode{ UINT32_MAX };
+
+	//Transform hierarchy stored as flat arrays sorted by depth, parents always come before their children
+	//UpdateWorldMatrices is one linear pass that only recomposes dirty nodes and their descendants
+	//Handles stay valid when the arrays are re-sorted
+	class SceneGraph final
+	{
+	public:
+		NodeHandle CreateNode(const Transform& localTransform = Transform{}, NodeHandle parent = InvalidNode);
+
+		void SetLocalTransform(NodeHandle node, const Transform& localTransform);
+		const Transform& GetLocalTransform(NodeHandle node) const { return m_LocalTransforms[GetIndex(node)]; }
+		NodeHandle GetParent(NodeHandle node) const;
+
+		//World matrix as of the last UpdateWorldMatrices
+		const Matrix& GetWorldMatrix(NodeHandle node) const { return m_WorldMatrices[GetIndex(node)]; }
+
+		//Returns the number of recomposed world matrices
+		size_t UpdateWorldMatrices();
+
+		size_t GetNodeCount() const { return m_LocalTransforms.size(); }
+		void Reserve(size_t count);
+
+	private:
+		//per node, in depth order
+		std::vector<Transform> m_LocalTransforms{};
+		std::vector<Matrix> m_WorldMatrices{};
+		std::vector<uint32_t> m_ParentIndices{};
+		std::vector<uint32_t> m_Depths{};
+		std::vector<uint8_t> m_IsDirty{};
+		std::vector<NodeHandle> m_IndexToHandle{};
+
+		//per handle
+		std::vector<uint32_t> m_HandleToIndex{};
+
+		bool m_NeedsSort{ false };
+
+		uint32_t GetIndex(NodeHandle node) const
+		{
+			assert(node < m_HandleToIndex.size());
+			return m_HandleToIndex[node];
+		}
+
+		void SortByDepth();
+	};
+
+	inline NodeHandle SceneGraph::CreateNode(const Transform& localTransform, NodeHandle parent)
+	{
+		const NodeHandle handle = static_cast<NodeHandle>(m_HandleToIndex.size());
+		const uint32_t index = static_cast<uint32_t>(m_LocalTransforms.size());
+		const uint32_t parentIndex = parent != InvalidNode ? GetIndex(parent) : InvalidNode;
+		const uint32_t depth = parent != InvalidNode ? m_Depths[parentIndex] + 1 : 0;
+
+		//appending a shallower node breaks the depth order, restore it lazily before the next update
+		if (!m_Depths.empty() && depth < m_Depths.back())
+		{
+			m_NeedsSort = true;
+		}
+
+		m_LocalTransforms.push_back(localTransform);
+		m_WorldMatrices.emplace_back();
+		m_ParentIndices.push_back(parentIndex);
+		m_Depths.push_back(depth);
+		m_IsDirty.push_back(1);
+		m_IndexToHandle.push_back(handle);
+		m_HandleToIndex.push_back(index);
+
+		return handle;
+	}
+
+	inline void SceneGraph::SetLocalTransform(NodeHandle node, const Transform& localTransform)
+	{
+		const uint32_t index = GetIndex(node);
+		m_LocalTransforms[index] = localTransform;
+		m_IsDirty[index] = 1;
+	}
+
+	inline NodeHandle SceneGraph::GetParent(NodeHandle node) const
+	{
+		const uint32_t parentIndex = m_ParentIndices[GetIndex(node)];
+		return parentIndex != InvalidNode ? m_IndexToHandle[parentIndex] : InvalidNode;
+	}
+
+	inline size_t SceneGraph::UpdateWorldMatrices()
+	{
+		if (m_NeedsSort)
+		{
+			SortByDepth();
+		}
+
+		size_t updatedCount{};
+		const size_t nodeCount = m_LocalTransforms.size();
+		for (size_t i{}; i < nodeCount; ++i)
+		{
+			//parents were handled earlier in this pass, so their flag already includes every dirty ancestor
+			const uint32_t parentIndex = m_ParentIndices[i];
+			if (parentIndex != InvalidNode)
+			{
+				m_IsDirty[i] |= m_IsDirty[parentIndex];
+			}
+			if (!m_IsDirty[i]) continue;
+
+			const Matrix local = m_LocalTransforms[i].ToMatrix();
+			m_WorldMatrices[i] = parentIndex != InvalidNode ? local * m_WorldMatrices[parentIndex] : local;
+			++updatedCount;
+		}
+
+		if (updatedCount > 0)
+		{
+			std::fill(m_IsDirty.begin(), m_IsDirty.end(), uint8_t{ 0 });
+		}
+		return updatedCount;
+	}
+
+	inline void SceneGraph::Reserve(size_t count)
+	{
+		m_LocalTransforms.reserve(count);
+		m_WorldMatrices.reserve(count);
+		m_ParentIndices.reserve(count);
+		m_Depths.reserve(count);
+		m_IsDirty.reserve(count);
+		m_IndexToHandle.reserve(count);
+		m_HandleToIndex.reserve(count);
+	}
+
+	inline void SceneGraph::SortByDepth()
+	{
+		const size_t nodeCount = m_LocalTransforms.size();
+
+		//counting sort on depth: stable, so siblings keep their creation order
+		const uint32_t maxDepth = *std::max_element(m_Depths.begin(), m_Depths.end());
+		std::vector<uint32_t> depthOffsets(maxDepth + 2, 0);
+		for (const uint32_t depth : m_Depths)
+		{
+			++depthOffsets[depth + 1];
+		}
+		for (size_t depth{ 1 }; depth < depthOffsets.size(); ++depth)
+		{
+			depthOffsets[depth] += depthOffsets[depth - 1];
+		}
+
+		std::vector<uint32_t> oldToNew(nodeCount);
+		for (size_t i{}; i < nodeCount; ++i)
+		{
+			oldToNew[i] = depthOffsets[m_Depths[i]]++;
+		}
+
+		const auto permute = [&](auto& values)
+		{
+			std::remove_reference_t<decltype(values)> sorted(values.size());
+			for (size_t i{}; i < nodeCount; ++i)
+			{
+				sorted[oldToNew[i]] = values[i];
+			}
+			values.swap(sorted);
+		};
+		permute(m_LocalTransforms);
+		permute(m_WorldMatrices);
+		permute(m_Depths);
+		permute(m_IsDirty);
+		permute(m_IndexToHandle);
+		permute(m_ParentIndices);
+
+		for (uint32_t& parentIndex : m_ParentIndices)
+		{
+			if (parentIndex != InvalidNode)
+			{
+				parentIndex = oldToNew[parentIndex];
+			}
+		}
+		for (size_t i{}; i < nodeCount; ++i)
+		{
+			m_HandleToIndex[m_IndexToHandle[i]] = static_cast<uint32_t>(i);
+		}
+
+		m_NeedsSort = false;
+	}
+}
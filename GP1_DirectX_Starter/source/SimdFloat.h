@@ -0,0 +1,385 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+#include "MathHelpers.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//One register of floats: 8 lanes with AVX2, 4 with SSE, 1 without SIMD
+	//Kernels written against SimdFloat run at the widest width the build targets, the scalar build doubles as the reference.
+	//Comparisons return a SimdMask, Select picks per lane, there are no branches on lanes.
+#if defined(DAE_AVX2)
+	using SimdRegister = __m256;
+	using SimdMaskRegister = __m256;
+	using SimdIntRegister = __m256i;
+#elif defined(DAE_SSE)
+	using SimdRegister = __m128;
+	using SimdMaskRegister = __m128;
+	using SimdIntRegister = __m128i;
+#else
+	using SimdRegister = float;
+	using SimdMaskRegister = bool;
+	using SimdIntRegister = uint32_t;
+#endif
+
+	struct SimdMask
+	{
+		SimdMaskRegister value{};
+
+		//bit i set when lane i is
+		uint32_t GetBits() const
+		{
+#if defined(DAE_AVX2)
+			return static_cast<uint32_t>(_mm256_movemask_ps(value));
+#elif defined(DAE_SSE)
+			return static_cast<uint32_t>(_mm_movemask_ps(value));
+#else
+			return value ? 1u : 0u;
+#endif
+		}
+
+		SimdMask operator&(const SimdMask& other) const
+		{
+#if defined(DAE_AVX2)
+			return { _mm256_and_ps(value, other.value) };
+#elif defined(DAE_SSE)
+			return { _mm_and_ps(value, other.value) };
+#else
+			return { value && other.value };
+#endif
+		}
+
+		SimdMask operator|(const SimdMask& other) const
+		{
+#if defined(DAE_AVX2)
+			return { _mm256_or_ps(value, other.value) };
+#elif defined(DAE_SSE)
+			return { _mm_or_ps(value, other.value) };
+#else
+			return { value || other.value };
+#endif
+		}
+	};
+
+	struct SimdFloat
+	{
+#if defined(DAE_AVX2)
+		static constexpr int Width{ 8 };
+#elif defined(DAE_SSE)
+		static constexpr int Width{ 4 };
+#else
+		static constexpr int Width{ 1 };
+#endif
+
+		SimdRegister value{};
+
+		SimdFloat() = default;
+		SimdFloat(SimdRegister _value) : value{ _value } {}
+#if defined(DAE_SSE)
+		//broadcast
+		SimdFloat(float _value)
+#if defined(DAE_AVX2)
+			: value{ _mm256_set1_ps(_value) }
+#else
+			: value{ _mm_set1_ps(_value) }
+#endif
+		{
+		}
+#endif
+
+		//Width floats, no alignment needed
+		static SimdFloat Load(const float* valuesPtr)
+		{
+#if defined(DAE_AVX2)
+			return _mm256_loadu_ps(valuesPtr);
+#elif defined(DAE_SSE)
+			return _mm_loadu_ps(valuesPtr);
+#else
+			return *valuesPtr;
+#endif
+		}
+
+		void Store(float* valuesPtr) const
+		{
+#if defined(DAE_AVX2)
+			_mm256_storeu_ps(valuesPtr, value);
+#elif defined(DAE_SSE)
+			_mm_storeu_ps(valuesPtr, value);
+#else
+			*valuesPtr = value;
+#endif
+		}
+
+		//0, 1, 2, ... Width - 1
+		static SimdFloat LaneIndices()
+		{
+#if defined(DAE_AVX2)
+			return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+#elif defined(DAE_SSE)
+			return _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+#else
+			return 0.f;
+#endif
+		}
+
+		float GetLane(int lane) const
+		{
+			alignas(32) float lanes[Width];
+			Store(lanes);
+			return lanes[lane];
+		}
+
+#pragma region Operator
+		SimdFloat operator+(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return _mm256_add_ps(value, other.value);
+#elif defined(DAE_SSE)
+			return _mm_add_ps(value, other.value);
+#else
+			return value + other.value;
+#endif
+		}
+
+		SimdFloat operator-(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return _mm256_sub_ps(value, other.value);
+#elif defined(DAE_SSE)
+			return _mm_sub_ps(value, other.value);
+#else
+			return value - other.value;
+#endif
+		}
+
+		SimdFloat operator*(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return _mm256_mul_ps(value, other.value);
+#elif defined(DAE_SSE)
+			return _mm_mul_ps(value, other.value);
+#else
+			return value * other.value;
+#endif
+		}
+
+		SimdFloat operator/(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return _mm256_div_ps(value, other.value);
+#elif defined(DAE_SSE)
+			return _mm_div_ps(value, other.value);
+#else
+			return value / other.value;
+#endif
+		}
+
+		SimdFloat operator-() const { return SimdFloat{ 0.f } - *this; }
+		SimdFloat& operator+=(const SimdFloat& other) { return *this = *this + other; }
+
+		SimdMask operator<(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return { _mm256_cmp_ps(value, other.value, _CMP_LT_OQ) };
+#elif defined(DAE_SSE)
+			return { _mm_cmplt_ps(value, other.value) };
+#else
+			return { value < other.value };
+#endif
+		}
+
+		SimdMask operator<=(const SimdFloat& other) const
+		{
+#if defined(DAE_AVX2)
+			return { _mm256_cmp_ps(value, other.value, _CMP_LE_OQ) };
+#elif defined(DAE_SSE)
+			return { _mm_cmple_ps(value, other.value) };
+#else
+			return { value <= other.value };
+#endif
+		}
+
+		SimdMask operator>(const SimdFloat& other) const { return other < *this; }
+		SimdMask operator>=(const SimdFloat& other) const { return other <= *this; }
+#pragma endregion
+	};
+
+	//mask ? ifTrue : ifFalse per lane
+	inline SimdFloat Select(const SimdMask& mask, const SimdFloat& ifTrue, const SimdFloat& ifFalse)
+	{
+#if defined(DAE_AVX2)
+		return _mm256_blendv_ps(ifFalse.value, ifTrue.value, mask.value);
+#elif defined(DAE_SSE)
+		return _mm_or_ps(_mm_and_ps(mask.value, ifTrue.value), _mm_andnot_ps(mask.value, ifFalse.value));
+#else
+		return mask.value ? ifTrue.value : ifFalse.value;
+#endif
+	}
+
+	//Like minps / maxps: the second operand when either is NaN, so clamping also flushes NaN
+	inline SimdFloat Min(const SimdFloat& a, const SimdFloat& b)
+	{
+#if defined(DAE_AVX2)
+		return _mm256_min_ps(a.value, b.value);
+#elif defined(DAE_SSE)
+		return _mm_min_ps(a.value, b.value);
+#else
+		return a.value < b.value ? a.value : b.value;
+#endif
+	}
+
+	inline SimdFloat Max(const SimdFloat& a, const SimdFloat& b)
+	{
+#if defined(DAE_AVX2)
+		return _mm256_max_ps(a.value, b.value);
+#elif defined(DAE_SSE)
+		return _mm_max_ps(a.value, b.value);
+#else
+		return a.value > b.value ? a.value : b.value;
+#endif
+	}
+
+	inline SimdFloat Saturate(const SimdFloat& value) { return Max(Min(value, 1.f), 0.f); }
+	inline SimdFloat Abs(const SimdFloat& value) { return Max(value, -value); }
+	inline SimdFloat Square(const SimdFloat& value) { return value * value; }
+
+	inline SimdFloat Sqrt(const SimdFloat& value)
+	{
+#if defined(DAE_AVX2)
+		return _mm256_sqrt_ps(value.value);
+#elif defined(DAE_SSE)
+		return _mm_sqrt_ps(value.value);
+#else
+		return std::sqrt(value.value);
+#endif
+	}
+
+	//only exact for |value| < 2^31, callers clamp first
+	inline SimdFloat Floor(const SimdFloat& value)
+	{
+#if defined(DAE_AVX2)
+		return _mm256_floor_ps(value.value);
+#elif defined(DAE_SSE)
+		//SSE2 has no round: truncate, then step down where that rounded up
+		const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value.value));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value.value), _mm_set1_ps(1.f)));
+#else
+		return std::floor(value.value);
+#endif
+	}
+
+	//log2 for value > 0: exponent bits plus an atanh series on the mantissa, about 1e-7 relative error
+	inline SimdFloat Log2(const SimdFloat& value)
+	{
+		SimdFloat exponent{}, mantissa{};
+#if defined(DAE_AVX2)
+		const __m256i bits = _mm256_castps_si256(value.value);
+		exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+#elif defined(DAE_SSE)
+		const __m128i bits = _mm_castps_si128(value.value);
+		exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+#else
+		const uint32_t bits = std::bit_cast<uint32_t>(value.value);
+		exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+		mantissa = std::bit_cast<float>((bits & 0x007fffff) | 0x3f800000);
+#endif
+		//mantissa in [sqrt(0.5), sqrt(2)) keeps the series short
+		const SimdMask isLarge = mantissa > 1.41421356f;
+		mantissa = Select(isLarge, mantissa * 0.5f, mantissa);
+		exponent = Select(isLarge, exponent + 1.f, exponent);
+
+		//ln(m) = 2 * atanh(s), s = (m - 1) / (m + 1)
+		const SimdFloat s = (mantissa - 1.f) / (mantissa + 1.f);
+		const SimdFloat s2 = s * s;
+		const SimdFloat series = ((((s2 * (1.f / 9.f) + 1.f / 7.f) * s2 + 1.f / 5.f) * s2 + 1.f / 3.f) * s2 + 1.f) * s;
+		return exponent + series * (2.f / 0.69314718f);
+	}
+
+	//2^value, value clamped to the normal float range
+	inline SimdFloat Exp2(const SimdFloat& value)
+	{
+		const SimdFloat clamped = Max(Min(value, 126.f), -126.f);
+		const SimdFloat whole = Floor(clamped);
+
+		//e^t around the middle of [0, 1): 2^f = sqrt(2) * e^((f - 0.5) * ln 2)
+		const SimdFloat t = (clamped - whole - 0.5f) * 0.69314718f;
+		const SimdFloat fraction = ((((((t * (1.f / 720.f) + 1.f / 120.f) * t + 1.f / 24.f) * t + 1.f / 6.f) * t + 0.5f) * t + 1.f) * t + 1.f) * 1.41421356f;
+
+		SimdFloat scale{};
+#if defined(DAE_AVX2)
+		scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(whole.value), _mm256_set1_epi32(127)), 23));
+#elif defined(DAE_SSE)
+		scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(whole.value), _mm_set1_epi32(127)), 23));
+#else
+		scale = std::bit_cast<float>(static_cast<uint32_t>(static_cast<int>(whole.value) + 127) << 23);
+#endif
+		return fraction * scale;
+	}
+
+	//base^exponent for base > 0
+	inline SimdFloat Pow(const SimdFloat& base, const SimdFloat& exponent)
+	{
+		return Exp2(exponent * Log2(base));
+	}
+
+	struct SimdVector2
+	{
+		SimdFloat x{};
+		SimdFloat y{};
+
+		SimdVector2() = default;
+		SimdVector2(const SimdFloat& _x, const SimdFloat& _y) : x{ _x }, y{ _y } {}
+		explicit SimdVector2(const Vector2& v) : x{ v.x }, y{ v.y } {}
+
+		SimdVector2 operator+(const SimdVector2& v) const { return { x + v.x, y + v.y }; }
+		SimdVector2 operator-(const SimdVector2& v) const { return { x - v.x, y - v.y }; }
+		SimdVector2 operator*(const SimdFloat& scale) const { return { x * scale, y * scale }; }
+	};
+
+	struct SimdVector3
+	{
+		SimdFloat x{};
+		SimdFloat y{};
+		SimdFloat z{};
+
+		SimdVector3() = default;
+		SimdVector3(const SimdFloat& _x, const SimdFloat& _y, const SimdFloat& _z) : x{ _x }, y{ _y }, z{ _z } {}
+		explicit SimdVector3(const Vector3& v) : x{ v.x }, y{ v.y }, z{ v.z } {}
+
+		SimdVector3 operator+(const SimdVector3& v) const { return { x + v.x, y + v.y, z + v.z }; }
+		SimdVector3 operator-(const SimdVector3& v) const { return { x - v.x, y - v.y, z - v.z }; }
+		SimdVector3 operator*(const SimdFloat& scale) const { return { x * scale, y * scale, z * scale }; }
+		SimdVector3 operator-() const { return { -x, -y, -z }; }
+
+		SimdVector3 Normalized() const { return *this * (SimdFloat{ 1.f } / Sqrt(Dot(*this, *this))); }
+
+		static SimdFloat Dot(const SimdVector3& a, const SimdVector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		static SimdVector3 Cross(const SimdVector3& a, const SimdVector3& b)
+		{
+			return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		}
+	};
+
+	struct SimdVector4
+	{
+		SimdFloat x{};
+		SimdFloat y{};
+		SimdFloat z{};
+		SimdFloat w{};
+
+		SimdVector4() = default;
+		SimdVector4(const SimdFloat& _x, const SimdFloat& _y, const SimdFloat& _z, const SimdFloat& _w) : x{ _x }, y{ _y }, z{ _z }, w{ _w } {}
+		explicit SimdVector4(const Vector4& v) : x{ v.x }, y{ v.y }, z{ v.z }, w{ v.w } {}
+
+		SimdVector4 operator+(const SimdVector4& v) const { return { x + v.x, y + v.y, z + v.z, w + v.w }; }
+		SimdVector4 operator*(const SimdFloat& scale) const { return { x * scale, y * scale, z * scale, w * scale }; }
+
+		Vector4 GetLane(int lane) const { return { x.GetLane(lane), y.GetLane(lane), z.GetLane(lane), w.GetLane(lane) }; }
+	};
+}
@@ -0,0 +1,800 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MathHelpers.h"
+#include "SoftwareShading.h"
+#include "SoftwareTexture.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//Vertex shader output: clip space position and the attributes interpolated for the pixel shader
+	struct RasterVertex
+	{
+		Vector4 position{};
+		PixelInput attributes{};
+	};
+
+	//An indexed triangle list with the fixed function state of its effect
+	struct RasterDraw
+	{
+		const RasterVertex* verticesPtr{};
+		const uint32_t* indicesPtr{};
+		uint32_t indexCount{};
+		uint32_t material{}; //handed back to the shader
+		bool cullBackFaces{ true };
+		bool writeDepth{ true };
+		bool blend{ false }; //src alpha over inv src alpha, target alpha becomes 0 like the fire fx blend state
+	};
+
+	struct SoftwareRasterizerStats
+	{
+		uint64_t triangleCount{};			//submitted
+		uint64_t setupTriangleCount{};		//after clipping and culling, clipped triangles count once per piece
+		uint64_t binnedTriangleCount{};		//triangle-tile pairs
+		uint64_t shadedPixelCount{};		//passed coverage and depth test
+		uint64_t coveredPixelCount{};		//shaded at least once
+		uint64_t hiZCulledTriangleCount{};	//triangle-tile pairs behind every Hi-Z block they touch
+		uint64_t hiZCulledBlockCount{};		//Hi-Z blocks of the remaining triangles skipped the same way
+
+		//how often a covered pixel got shaded, 1 is no overdraw
+		double GetOverdraw() const { return coveredPixelCount ? static_cast<double>(shadedPixelCount) / static_cast<double>(coveredPixelCount) : 0.0; }
+	};
+
+	//Sort-middle tiled rasterizer
+	//Setup clips, culls and bins triangles into screen tiles on every thread, each thread takes a contiguous
+	//range of the submitted triangles so the bins keep submission order. Tiles are then rasterized in parallel,
+	//every tile owns its part of the color buffer and its own depth buffer, so no locks are needed.
+	//Coverage, depth and interpolation run on rows of SimdFloat::Width pixels, 8 with AVX2 and 4 with SSE. Visible pixels
+	//are queued per tile and shaded in full blocks, small triangles would otherwise leave most lanes empty.
+	//Every HiZBlockSize block of a tile keeps the min and max of its depths, triangles and blocks behind the max are
+	//skipped before their edges are evaluated and blocks in front of the min skip the depth test.
+	//Follows the D3D11 rules: pixel centers at .5, top-left fill rule, clockwise front faces, depth test less
+	class SoftwareRasterizer final
+	{
+	public:
+		static constexpr uint32_t TileSize{ 32 };
+		static constexpr uint32_t HiZBlockSize{ 8 };
+
+		struct Settings
+		{
+			bool useHiZ{ true };
+			//opaque draws fill the depth of a tile before anything is shaded, then only the pixels that end up
+			//visible are shaded, each once. Pays a second coverage pass to save the shading of overdraw
+			bool useDepthPrepass{ false };
+		};
+
+		SoftwareRasterizer(uint32_t width, uint32_t height, JobSystem& jobSystem = JobSystem::Get());
+
+		//Fills the color buffer with color and the depth buffer with 1
+		void Clear(const Vector4& color);
+
+		//Rasterizes draws in order, shader(material, pixelBlock) returns the RGBA colors of SimdFloat::Width pixels in [0, 1]
+		//The pixels of a block are not neighbours on screen and the last block of a batch can be padded with stale pixels
+		template<typename Shader>
+		void Render(const std::vector<RasterDraw>& draws, const Shader& shader);
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		//RGBA8, red in the low byte, row pitch GetPitch() texels
+		const std::vector<uint32_t>& GetColorBuffer() const { return m_Color; }
+		uint32_t GetPitch() const { return m_TileCountX * TileSize; }
+		uint32_t GetPixel(uint32_t x, uint32_t y) const { return m_Color[y * GetPitch() + x]; }
+		float GetDepth(uint32_t x, uint32_t y) const { return m_Depth[GetDepthIndex(x, y)]; }
+
+		Settings& GetSettings() { return m_Settings; }
+		//Stats of the last Render
+		const SoftwareRasterizerStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Triangle
+		{
+			//edge i is opposite vertex i: value = a * x + b * y + c, inside is >= 0 on top-left edges, > 0 otherwise
+			std::array<float, 3> edgeA{};
+			std::array<float, 3> edgeB{};
+			std::array<float, 3> edgeC{};
+			std::array<bool, 3> isTopLeft{};
+			std::array<float, 3> depth{};
+			std::array<float, 3> invW{};
+			std::array<PixelInput, 3> attributes{}; //divided by w, so the pixel can interpolate them perspective correct
+			//screen space gradients of uv / w and 1 / w, for the uv derivatives
+			Vector2 uvOverWDx{};
+			Vector2 uvOverWDy{};
+			float invWDx{};
+			float invWDy{};
+			float invArea{};
+			float minDepth{};
+			float maxDepth{};
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+			uint32_t draw{};
+		};
+
+		//Visible pixels of one draw waiting for the shader: their color buffer offset and PixelInput, as structure of arrays
+		//Blended draws flush after every triangle, so a pixel never blends against a color that is still queued
+		struct PixelQueue
+		{
+			static constexpr uint32_t Capacity{ 128 };
+			static constexpr int ComponentCount{ 15 };
+
+			uint32_t count{};
+			uint32_t draw{};
+			std::array<uint32_t, Capacity> offsets{};
+			std::array<std::array<float, Capacity>, ComponentCount> components{};
+		};
+
+		struct HiZBlock
+		{
+			float minDepth{ 1.f };
+			float maxDepth{ 1.f };
+		};
+
+		//What RasterizeTile keeps while it walks the bins of one tile
+		struct TileContext
+		{
+			uint32_t x{};
+			uint32_t y{};
+			float* depthPtr{};
+			HiZBlock* hiZPtr{};
+			std::array<uint32_t, TileSize> coveredRows{}; //bit x of row y is set once that pixel is shaded
+			std::array<uint32_t, TileSize> visibleRows{}; //the same for the visible pixels queued after the prepass
+			PixelQueue queue{};
+			SoftwareRasterizerStats stats{};
+		};
+
+		//Shade tests depth less and writes it when the draw does, the prepass only writes depth,
+		//the shading pass after it tests less equal against the final depth without writing and shades each pixel once
+		enum class TrianglePass
+		{
+			Shade,
+			DepthOnly,
+			ShadeVisible
+		};
+
+		//A contiguous range of the submitted triangles, set up and binned by one thread
+		struct SetupJob
+		{
+			uint64_t firstTriangle{};
+			uint64_t triangleCount{};
+			std::vector<Triangle> triangles{};
+			std::vector<std::vector<uint32_t>> bins{}; //per tile, indices into triangles
+			SoftwareRasterizerStats stats{};
+		};
+
+		//homogeneous clip bounds: the near and far plane, and a guard band of GuardBand times the viewport
+		static constexpr float m_GuardBand{ 2.f };
+		static constexpr uint32_t m_MaxClipVertexCount{ 9 };
+		static constexpr uint32_t m_HiZBlocksPerRow{ TileSize / HiZBlockSize };
+		static_assert(TileSize <= 32 && TileSize % HiZBlockSize == 0 && HiZBlockSize % SimdFloat::Width == 0);
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		uint32_t m_TileCountX{};
+		uint32_t m_TileCountY{};
+		JobSystem& m_JobSystem;
+		Settings m_Settings{};
+
+		std::vector<uint32_t> m_Color{};
+		std::vector<float> m_Depth{}; //tile after tile, TileSize * TileSize each
+		std::vector<HiZBlock> m_HiZ{}; //tile after tile, row major
+		std::vector<SetupJob> m_SetupJobs{};
+		std::vector<uint64_t> m_DrawFirstTriangles{};
+		std::vector<SoftwareRasterizerStats> m_TileStats{};
+		SoftwareRasterizerStats m_Stats{};
+
+		uint32_t GetTileCount() const { return m_TileCountX * m_TileCountY; }
+		size_t GetDepthIndex(uint32_t x, uint32_t y) const
+		{
+			const uint32_t tile = (y / TileSize) * m_TileCountX + x / TileSize;
+			return size_t{ tile } * TileSize * TileSize + (y % TileSize) * TileSize + x % TileSize;
+		}
+
+		void SetupTriangles(const std::vector<RasterDraw>& draws, SetupJob& job) const;
+		void SetupTriangle(const RasterVertex& vertex0, const RasterVertex& vertex1, const RasterVertex& vertex2, const RasterDraw& draw, uint32_t drawIndex, SetupJob& job) const;
+		void AddTriangle(const std::array<RasterVertex, 3>& vertices, const RasterDraw& draw, uint32_t drawIndex, SetupJob& job) const;
+
+		template<typename Shader>
+		void RasterizeTile(uint32_t tile, const std::vector<RasterDraw>& draws, const Shader& shader);
+		template<typename Shader>
+		void RasterizeTriangle(const Triangle& triangle, TrianglePass pass, const std::vector<RasterDraw>& draws, TileContext& context, const Shader& shader);
+		//Recomputes the Hi-Z of a block after depth was written to it
+		void UpdateHiZ(TileContext& context, int blockColumn, int blockRow) const;
+		//Shades and writes every queued pixel, returns how many
+		template<typename Shader>
+		uint32_t ShadePixels(PixelQueue& queue, const std::vector<RasterDraw>& draws, const Shader& shader);
+
+		static std::array<SimdFloat*, PixelQueue::ComponentCount> GetComponents(PixelBlock& block);
+
+		static RasterVertex Lerp(const RasterVertex& from, const RasterVertex& to, float factor);
+	};
+
+	inline SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, JobSystem& jobSystem)
+		: m_Width{ width }
+		, m_Height{ height }
+		, m_TileCountX{ (width + TileSize - 1) / TileSize }
+		, m_TileCountY{ (height + TileSize - 1) / TileSize }
+		, m_JobSystem{ jobSystem }
+	{
+		//padded to whole tiles, so a tile never checks the buffer edge before touching memory
+		m_Color.resize(size_t{ GetPitch() } * m_TileCountY * TileSize);
+		m_Depth.resize(size_t{ GetTileCount() } * TileSize * TileSize);
+		m_HiZ.resize(size_t{ GetTileCount() } * m_HiZBlocksPerRow * m_HiZBlocksPerRow);
+		m_TileStats.resize(GetTileCount());
+	}
+
+	inline void SoftwareRasterizer::Clear(const Vector4& color)
+	{
+		std::fill(m_Color.begin(), m_Color.end(), SoftwareTexture::PackColor(color));
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.f);
+		std::fill(m_HiZ.begin(), m_HiZ.end(), HiZBlock{});
+	}
+
+	template<typename Shader>
+	void SoftwareRasterizer::Render(const std::vector<RasterDraw>& draws, const Shader& shader)
+	{
+		m_Stats = SoftwareRasterizerStats{};
+
+		m_DrawFirstTriangles.resize(draws.size() + 1);
+		uint64_t triangleCount{};
+		for (size_t draw{}; draw < draws.size(); ++draw)
+		{
+			m_DrawFirstTriangles[draw] = triangleCount;
+			triangleCount += draws[draw].indexCount / 3;
+		}
+		m_DrawFirstTriangles[draws.size()] = triangleCount;
+		if (triangleCount == 0) return;
+
+		//a few jobs per thread, the cost of a triangle depends on how much of it gets clipped and culled
+		const uint32_t jobCount = static_cast<uint32_t>(std::min<uint64_t>(triangleCount, m_JobSystem.GetThreadCount() * 4));
+		m_SetupJobs.resize(jobCount);
+		for (uint32_t job{}; job < jobCount; ++job)
+		{
+			SetupJob& setupJob = m_SetupJobs[job];
+			setupJob.firstTriangle = triangleCount * job / jobCount;
+			setupJob.triangleCount = triangleCount * (job + 1) / jobCount - setupJob.firstTriangle;
+		}
+		for (size_t job{ jobCount }; job < m_SetupJobs.size(); ++job)
+		{
+			m_SetupJobs[job].triangleCount = 0;
+		}
+
+		m_JobSystem.ParallelFor(jobCount, [&](uint32_t job) { SetupTriangles(draws, m_SetupJobs[job]); });
+		m_JobSystem.ParallelFor(GetTileCount(), [&](uint32_t tile) { RasterizeTile(tile, draws, shader); });
+
+		for (uint32_t job{}; job < jobCount; ++job)
+		{
+			const SoftwareRasterizerStats& jobStats = m_SetupJobs[job].stats;
+			m_Stats.triangleCount += jobStats.triangleCount;
+			m_Stats.setupTriangleCount += jobStats.setupTriangleCount;
+			m_Stats.binnedTriangleCount += jobStats.binnedTriangleCount;
+		}
+		for (const SoftwareRasterizerStats& tileStats : m_TileStats)
+		{
+			m_Stats.shadedPixelCount += tileStats.shadedPixelCount;
+			m_Stats.coveredPixelCount += tileStats.coveredPixelCount;
+			m_Stats.hiZCulledTriangleCount += tileStats.hiZCulledTriangleCount;
+			m_Stats.hiZCulledBlockCount += tileStats.hiZCulledBlockCount;
+		}
+	}
+
+	inline void SoftwareRasterizer::SetupTriangles(const std::vector<RasterDraw>& draws, SetupJob& job) const
+	{
+		job.triangles.clear();
+		job.bins.resize(GetTileCount());
+		for (std::vector<uint32_t>& bin : job.bins)
+		{
+			bin.clear();
+		}
+		job.stats = SoftwareRasterizerStats{};
+		job.stats.triangleCount = job.triangleCount;
+
+		//first draw that holds firstTriangle, draws without triangles are skipped by the search
+		uint32_t drawIndex = static_cast<uint32_t>(std::upper_bound(m_DrawFirstTriangles.begin(), m_DrawFirstTriangles.end(), job.firstTriangle) - m_DrawFirstTriangles.begin()) - 1;
+		for (uint64_t triangle{ job.firstTriangle }; triangle < job.firstTriangle + job.triangleCount; ++triangle)
+		{
+			while (triangle >= m_DrawFirstTriangles[drawIndex + 1]) ++drawIndex;
+
+			const RasterDraw& draw = draws[drawIndex];
+			const uint32_t* indicesPtr = draw.indicesPtr + (triangle - m_DrawFirstTriangles[drawIndex]) * 3;
+			SetupTriangle(draw.verticesPtr[indicesPtr[0]], draw.verticesPtr[indicesPtr[1]], draw.verticesPtr[indicesPtr[2]], draw, drawIndex, job);
+		}
+	}
+
+	inline void SoftwareRasterizer::SetupTriangle(const RasterVertex& vertex0, const RasterVertex& vertex1, const RasterVertex& vertex2, const RasterDraw& draw, uint32_t drawIndex, SetupJob& job) const
+	{
+		//outcodes against near (z >= 0), far (z <= w) and the guard band, 6 planes in clip space
+		const auto getOutcode = [](const Vector4& position)
+		{
+			const float guardW = m_GuardBand * position.w;
+			return static_cast<uint32_t>(position.z < 0.f)
+				| static_cast<uint32_t>(position.z > position.w) << 1
+				| static_cast<uint32_t>(position.x < -guardW) << 2
+				| static_cast<uint32_t>(position.x > guardW) << 3
+				| static_cast<uint32_t>(position.y < -guardW) << 4
+				| static_cast<uint32_t>(position.y > guardW) << 5;
+		};
+		const uint32_t outcode0 = getOutcode(vertex0.position);
+		const uint32_t outcode1 = getOutcode(vertex1.position);
+		const uint32_t outcode2 = getOutcode(vertex2.position);
+
+		if (outcode0 & outcode1 & outcode2) return;
+		if ((outcode0 | outcode1 | outcode2) == 0)
+		{
+			AddTriangle({ vertex0, vertex1, vertex2 }, draw, drawIndex, job);
+			return;
+		}
+
+		//Sutherland-Hodgman against every plane the triangle crosses, then fan the polygon
+		std::array<RasterVertex, m_MaxClipVertexCount> polygon{ vertex0, vertex1, vertex2 };
+		std::array<RasterVertex, m_MaxClipVertexCount> clipped{};
+		uint32_t vertexCount{ 3 };
+		const uint32_t crossedPlanes = outcode0 | outcode1 | outcode2;
+		for (uint32_t plane{}; plane < 6 && vertexCount >= 3; ++plane)
+		{
+			if (!(crossedPlanes & (1u << plane))) continue;
+
+			//signed distance, inside is >= 0
+			const auto getDistance = [plane](const Vector4& position)
+			{
+				const float guardW = m_GuardBand * position.w;
+				switch (plane)
+				{
+				case 0: return position.z;
+				case 1: return position.w - position.z;
+				case 2: return position.x + guardW;
+				case 3: return guardW - position.x;
+				case 4: return position.y + guardW;
+				default: return guardW - position.y;
+				}
+			};
+
+			uint32_t clippedCount{};
+			for (uint32_t vertex{}; vertex < vertexCount; ++vertex)
+			{
+				const RasterVertex& current = polygon[vertex];
+				const RasterVertex& next = polygon[(vertex + 1) % vertexCount];
+				const float currentDistance = getDistance(current.position);
+				const float nextDistance = getDistance(next.position);
+
+				if (currentDistance >= 0.f) clipped[clippedCount++] = current;
+				if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+				{
+					clipped[clippedCount++] = Lerp(current, next, currentDistance / (currentDistance - nextDistance));
+				}
+			}
+			std::swap(polygon, clipped);
+			vertexCount = clippedCount;
+		}
+
+		for (uint32_t vertex{ 2 }; vertex < vertexCount; ++vertex)
+		{
+			AddTriangle({ polygon[0], polygon[vertex - 1], polygon[vertex] }, draw, drawIndex, job);
+		}
+	}
+
+	inline void SoftwareRasterizer::AddTriangle(const std::array<RasterVertex, 3>& vertices, const RasterDraw& draw, uint32_t drawIndex, SetupJob& job) const
+	{
+		//viewport transform, y points down
+		std::array<float, 3> x{}, y{};
+		Triangle triangle{};
+		for (int vertex{}; vertex < 3; ++vertex)
+		{
+			const Vector4& position = vertices[vertex].position;
+			const float invW = 1.f / position.w;
+			x[vertex] = (position.x * invW + 1.f) * 0.5f * static_cast<float>(m_Width);
+			y[vertex] = (1.f - position.y * invW) * 0.5f * static_cast<float>(m_Height);
+			triangle.depth[vertex] = position.z * invW;
+			triangle.invW[vertex] = invW;
+		}
+
+		//clockwise on screen is positive and front facing
+		const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0.f || (draw.cullBackFaces && area < 0.f)) return;
+
+		//turn back faces that are not culled around, so inside is positive for every triangle
+		std::array<int, 3> order{ 0, 1, 2 };
+		if (area < 0.f)
+		{
+			std::swap(order[1], order[2]);
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(triangle.depth[1], triangle.depth[2]);
+			std::swap(triangle.invW[1], triangle.invW[2]);
+		}
+
+		triangle.minX = std::max(static_cast<int>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)), 0);
+		triangle.minY = std::max(static_cast<int>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)), 0);
+		triangle.maxX = std::min(static_cast<int>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)), static_cast<int>(m_Width) - 1);
+		triangle.maxY = std::min(static_cast<int>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)), static_cast<int>(m_Height) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+		for (int edge{}; edge < 3; ++edge)
+		{
+			const int from = (edge + 1) % 3;
+			const int to = (edge + 2) % 3;
+
+			//evaluated from the same end point in both directions, so a shared edge is the exact negation
+			//of its neighbour's and the fill rule leaves no gaps or double pixels
+			const bool isSwapped = x[from] > x[to] || (x[from] == x[to] && y[from] > y[to]);
+			const int first = isSwapped ? to : from;
+			const int second = isSwapped ? from : to;
+			const float a = y[first] - y[second];
+			const float b = x[second] - x[first];
+			const float c = -(a * x[first] + b * y[first]);
+			const float sign = isSwapped ? -1.f : 1.f;
+			triangle.edgeA[edge] = a * sign;
+			triangle.edgeB[edge] = b * sign;
+			triangle.edgeC[edge] = c * sign;
+
+			const float deltaX = x[to] - x[from];
+			const float deltaY = y[to] - y[from];
+			triangle.isTopLeft[edge] = deltaY < 0.f || (deltaY == 0.f && deltaX > 0.f);
+		}
+		triangle.invArea = 1.f / std::abs(area);
+		//depth is linear in screen space, so the vertices bound every pixel of the triangle
+		triangle.minDepth = std::min({ triangle.depth[0], triangle.depth[1], triangle.depth[2] });
+		triangle.maxDepth = std::max({ triangle.depth[0], triangle.depth[1], triangle.depth[2] });
+
+		for (int vertex{}; vertex < 3; ++vertex)
+		{
+			const PixelInput& attributes = vertices[order[vertex]].attributes;
+			const float invW = triangle.invW[vertex];
+			triangle.attributes[vertex] = { attributes.worldPosition * invW, attributes.uv * invW, attributes.normal * invW, attributes.tangent * invW };
+
+			//the weight of a vertex changes by a * invArea per pixel right and b * invArea per pixel down
+			const float weightDx = triangle.edgeA[vertex] * triangle.invArea;
+			const float weightDy = triangle.edgeB[vertex] * triangle.invArea;
+			triangle.uvOverWDx += triangle.attributes[vertex].uv * weightDx;
+			triangle.uvOverWDy += triangle.attributes[vertex].uv * weightDy;
+			triangle.invWDx += invW * weightDx;
+			triangle.invWDy += invW * weightDy;
+		}
+		triangle.draw = drawIndex;
+
+		const uint32_t triangleIndex = static_cast<uint32_t>(job.triangles.size());
+		job.triangles.push_back(triangle);
+		++job.stats.setupTriangleCount;
+
+		for (int tileY{ triangle.minY / static_cast<int>(TileSize) }; tileY <= triangle.maxY / static_cast<int>(TileSize); ++tileY)
+		{
+			for (int tileX{ triangle.minX / static_cast<int>(TileSize) }; tileX <= triangle.maxX / static_cast<int>(TileSize); ++tileX)
+			{
+				job.bins[tileY * m_TileCountX + tileX].push_back(triangleIndex);
+				++job.stats.binnedTriangleCount;
+			}
+		}
+	}
+
+	template<typename Shader>
+	void SoftwareRasterizer::RasterizeTile(uint32_t tile, const std::vector<RasterDraw>& draws, const Shader& shader)
+	{
+		TileContext context{};
+		context.x = (tile % m_TileCountX) * TileSize;
+		context.y = (tile / m_TileCountX) * TileSize;
+		context.depthPtr = m_Depth.data() + size_t{ tile } * TileSize * TileSize;
+		context.hiZPtr = m_HiZ.data() + size_t{ tile } * m_HiZBlocksPerRow * m_HiZBlocksPerRow;
+
+		//jobs hold consecutive triangle ranges, walking them in order keeps the submission order
+		const auto forEachTriangle = [&](const auto& function)
+		{
+			for (const SetupJob& job : m_SetupJobs)
+			{
+				if (job.triangleCount == 0) continue;
+				for (const uint32_t triangleIndex : job.bins[tile])
+				{
+					function(job.triangles[triangleIndex]);
+				}
+			}
+		};
+
+		if (m_Settings.useDepthPrepass)
+		{
+			forEachTriangle([&](const Triangle& triangle)
+			{
+				const RasterDraw& draw = draws[triangle.draw];
+				if (draw.writeDepth && !draw.blend) RasterizeTriangle(triangle, TrianglePass::DepthOnly, draws, context, shader);
+			});
+		}
+
+		forEachTriangle([&](const Triangle& triangle)
+		{
+			if (triangle.draw != context.queue.draw)
+			{
+				context.stats.shadedPixelCount += ShadePixels(context.queue, draws, shader);
+				context.queue.draw = triangle.draw;
+			}
+
+			const RasterDraw& draw = draws[triangle.draw];
+			const bool isInPrepass = m_Settings.useDepthPrepass && draw.writeDepth && !draw.blend;
+			RasterizeTriangle(triangle, isInPrepass ? TrianglePass::ShadeVisible : TrianglePass::Shade, draws, context, shader);
+			if (draw.blend)
+			{
+				context.stats.shadedPixelCount += ShadePixels(context.queue, draws, shader);
+			}
+		});
+		context.stats.shadedPixelCount += ShadePixels(context.queue, draws, shader);
+
+		for (const uint32_t coveredRow : context.coveredRows)
+		{
+			context.stats.coveredPixelCount += std::popcount(coveredRow);
+		}
+		m_TileStats[tile] = context.stats;
+	}
+
+	template<typename Shader>
+	void SoftwareRasterizer::RasterizeTriangle(const Triangle& triangle, TrianglePass pass, const std::vector<RasterDraw>& draws, TileContext& context, const Shader& shader)
+	{
+		constexpr int laneCount{ SimdFloat::Width };
+		constexpr int hiZBlockSize{ static_cast<int>(HiZBlockSize) };
+		const int tileX = static_cast<int>(context.x);
+		const int tileY = static_cast<int>(context.y);
+		const int minX = std::max(triangle.minX, tileX);
+		const int maxX = std::min(triangle.maxX, tileX + static_cast<int>(TileSize) - 1);
+		const int minY = std::max(triangle.minY, tileY);
+		const int maxY = std::min(triangle.maxY, tileY + static_cast<int>(TileSize) - 1);
+		if (minX > maxX || minY > maxY) return;
+
+		const RasterDraw& draw = draws[triangle.draw];
+		const bool isLessEqual = pass == TrianglePass::ShadeVisible;
+		const bool writeDepth = pass == TrianglePass::DepthOnly || (pass == TrianglePass::Shade && draw.writeDepth);
+		const auto isOccluded = [&](const HiZBlock& hiZ) { return isLessEqual ? triangle.minDepth > hiZ.maxDepth : triangle.minDepth >= hiZ.maxDepth; };
+
+		const int firstBlockColumn = (minX - tileX) / hiZBlockSize;
+		const int lastBlockColumn = (maxX - tileX) / hiZBlockSize;
+		const int firstBlockRow = (minY - tileY) / hiZBlockSize;
+		const int lastBlockRow = (maxY - tileY) / hiZBlockSize;
+		if (m_Settings.useHiZ)
+		{
+			HiZBlock farthest{ 0.f, 0.f };
+			for (int blockRow{ firstBlockRow }; blockRow <= lastBlockRow; ++blockRow)
+			{
+				for (int blockColumn{ firstBlockColumn }; blockColumn <= lastBlockColumn; ++blockColumn)
+				{
+					farthest.maxDepth = std::max(farthest.maxDepth, context.hiZPtr[blockRow * m_HiZBlocksPerRow + blockColumn].maxDepth);
+				}
+			}
+			if (isOccluded(farthest))
+			{
+				++context.stats.hiZCulledTriangleCount;
+				return;
+			}
+		}
+
+		const uint32_t pitch = GetPitch();
+		const SimdFloat laneIndices = SimdFloat::LaneIndices();
+		const SimdFloat invArea{ triangle.invArea };
+		const SimdFloat zero{ 0.f };
+
+		alignas(32) float lanes[PixelQueue::ComponentCount][laneCount];
+		for (int blockRow{ firstBlockRow }; blockRow <= lastBlockRow; ++blockRow)
+		{
+			for (int blockColumn{ firstBlockColumn }; blockColumn <= lastBlockColumn; ++blockColumn)
+			{
+				const HiZBlock& hiZ = context.hiZPtr[blockRow * m_HiZBlocksPerRow + blockColumn];
+				if (m_Settings.useHiZ && isOccluded(hiZ))
+				{
+					++context.stats.hiZCulledBlockCount;
+					continue;
+				}
+				//nothing in this block is closer than the triangle, every covered pixel passes either test
+				const bool isInFront = m_Settings.useHiZ && triangle.maxDepth < hiZ.minDepth;
+
+				//lane groups start aligned inside the block, lanes outside [minX, maxX] are masked off
+				const int blockX = tileX + blockColumn * hiZBlockSize;
+				const int blockY = tileY + blockRow * hiZBlockSize;
+				const int firstGroupX = blockX + ((std::max(minX, blockX) - blockX) / laneCount) * laneCount;
+				const int lastX = std::min(maxX, blockX + hiZBlockSize - 1);
+				bool hasWrittenDepth{};
+				for (int y{ std::max(minY, blockY) }; y <= std::min(maxY, blockY + hiZBlockSize - 1); ++y)
+				{
+					const float pixelY = static_cast<float>(y) + 0.5f;
+					float* depthRowPtr = context.depthPtr + (y - tileY) * TileSize - tileX;
+					const uint32_t rowOffset = static_cast<uint32_t>(y) * pitch;
+
+					for (int groupX{ firstGroupX }; groupX <= lastX; groupX += laneCount)
+					{
+						const SimdFloat pixelX = laneIndices + (static_cast<float>(groupX) + 0.5f);
+						SimdMask isInside = (pixelX > static_cast<float>(minX)) & (pixelX < static_cast<float>(maxX + 1));
+
+						std::array<SimdFloat, 3> weights{};
+						SimdFloat depth{ 0.f };
+						for (int edge{}; edge < 3; ++edge)
+						{
+							const SimdFloat value = SimdFloat{ triangle.edgeA[edge] } * pixelX + (triangle.edgeB[edge] * pixelY + triangle.edgeC[edge]);
+							isInside = isInside & (triangle.isTopLeft[edge] ? value >= zero : value > zero);
+							//the barycentric weight of vertex edge
+							weights[edge] = value * invArea;
+							depth += weights[edge] * triangle.depth[edge];
+						}
+						if (isInside.GetBits() == 0) continue;
+						//rounding can push the weights past the triangle, kept inside its depth range so the Hi-Z tests stay exact
+						depth = Min(Max(depth, triangle.minDepth), triangle.maxDepth);
+
+						const SimdFloat storedDepth = SimdFloat::Load(depthRowPtr + groupX);
+						SimdMask isVisible = isInside;
+						if (!isInFront)
+						{
+							isVisible = isVisible & (isLessEqual ? depth <= storedDepth : depth < storedDepth);
+						}
+						uint32_t coverage = isVisible.GetBits();
+						if (pass == TrianglePass::ShadeVisible)
+						{
+							//triangles tied with the final depth all pass less equal, the first one takes the pixel like less would
+							uint32_t& visibleRow = context.visibleRows[y - tileY];
+							coverage &= ~(visibleRow >> (groupX - tileX));
+							visibleRow |= coverage << (groupX - tileX);
+						}
+						if (coverage == 0) continue;
+						if (writeDepth)
+						{
+							Select(isVisible, depth, storedDepth).Store(depthRowPtr + groupX);
+							hasWrittenDepth = true;
+						}
+						if (pass == TrianglePass::DepthOnly) continue;
+
+						//perspective correct: the attributes were divided by w in setup. Hidden lanes are never queued,
+						//they take the first vertex so the division stays finite where w can be 0 outside the triangle
+						weights[0] = Select(isVisible, weights[0], 1.f);
+						weights[1] = Select(isVisible, weights[1], zero);
+						weights[2] = Select(isVisible, weights[2], zero);
+						const SimdFloat w = SimdFloat{ 1.f } / (weights[0] * triangle.invW[0] + weights[1] * triangle.invW[1] + weights[2] * triangle.invW[2]);
+						const auto interpolate = [&](const auto& getAttribute)
+						{
+							return (SimdFloat{ getAttribute(triangle.attributes[0]) } * weights[0]
+								+ SimdFloat{ getAttribute(triangle.attributes[1]) } * weights[1]
+								+ SimdFloat{ getAttribute(triangle.attributes[2]) } * weights[2]) * w;
+						};
+
+						PixelBlock block{};
+						block.worldPosition = { interpolate([](const PixelInput& input) { return input.worldPosition.x; }),
+							interpolate([](const PixelInput& input) { return input.worldPosition.y; }),
+							interpolate([](const PixelInput& input) { return input.worldPosition.z; }) };
+						block.uv = { interpolate([](const PixelInput& input) { return input.uv.x; }),
+							interpolate([](const PixelInput& input) { return input.uv.y; }) };
+						block.normal = { interpolate([](const PixelInput& input) { return input.normal.x; }),
+							interpolate([](const PixelInput& input) { return input.normal.y; }),
+							interpolate([](const PixelInput& input) { return input.normal.z; }) };
+						block.tangent = { interpolate([](const PixelInput& input) { return input.tangent.x; }),
+							interpolate([](const PixelInput& input) { return input.tangent.y; }),
+							interpolate([](const PixelInput& input) { return input.tangent.z; }) };
+
+						//quotient rule on uv = (uv / w) / (1 / w)
+						block.uvDx = (SimdVector2{ triangle.uvOverWDx } - block.uv * triangle.invWDx) * w;
+						block.uvDy = (SimdVector2{ triangle.uvOverWDy } - block.uv * triangle.invWDy) * w;
+
+						const std::array<SimdFloat*, PixelQueue::ComponentCount> components = GetComponents(block);
+						for (int component{}; component < PixelQueue::ComponentCount; ++component)
+						{
+							components[component]->Store(lanes[component]);
+						}
+
+						//always room for a whole block
+						PixelQueue& queue = context.queue;
+						if (queue.count + laneCount > PixelQueue::Capacity)
+						{
+							context.stats.shadedPixelCount += ShadePixels(queue, draws, shader);
+						}
+						context.coveredRows[y - tileY] |= coverage << (groupX - tileX);
+						while (coverage)
+						{
+							const int lane = std::countr_zero(coverage);
+							coverage &= coverage - 1;
+							queue.offsets[queue.count] = rowOffset + static_cast<uint32_t>(groupX + lane);
+							for (int component{}; component < PixelQueue::ComponentCount; ++component)
+							{
+								queue.components[component][queue.count] = lanes[component][lane];
+							}
+							++queue.count;
+						}
+					}
+				}
+
+				if (hasWrittenDepth) UpdateHiZ(context, blockColumn, blockRow);
+			}
+		}
+	}
+
+	inline void SoftwareRasterizer::UpdateHiZ(TileContext& context, int blockColumn, int blockRow) const
+	{
+		constexpr int laneCount{ SimdFloat::Width };
+		const float* blockDepthPtr = context.depthPtr + blockRow * HiZBlockSize * TileSize + blockColumn * HiZBlockSize;
+		SimdFloat nearest{ 1.f };
+		SimdFloat farthest{ 0.f };
+		for (uint32_t row{}; row < HiZBlockSize; ++row)
+		{
+			for (uint32_t column{}; column < HiZBlockSize; column += laneCount)
+			{
+				const SimdFloat depth = SimdFloat::Load(blockDepthPtr + row * TileSize + column);
+				nearest = Min(nearest, depth);
+				farthest = Max(farthest, depth);
+			}
+		}
+
+		HiZBlock& hiZ = context.hiZPtr[blockRow * m_HiZBlocksPerRow + blockColumn];
+		hiZ = { nearest.GetLane(0), farthest.GetLane(0) };
+		for (int lane{ 1 }; lane < laneCount; ++lane)
+		{
+			hiZ.minDepth = std::min(hiZ.minDepth, nearest.GetLane(lane));
+			hiZ.maxDepth = std::max(hiZ.maxDepth, farthest.GetLane(lane));
+		}
+	}
+
+	template<typename Shader>
+	uint32_t SoftwareRasterizer::ShadePixels(PixelQueue& queue, const std::vector<RasterDraw>& draws, const Shader& shader)
+	{
+		constexpr int laneCount{ SimdFloat::Width };
+		if (queue.count == 0) return 0;
+
+		const RasterDraw& draw = draws[queue.draw];
+		alignas(32) uint32_t colors[laneCount];
+		for (uint32_t first{}; first < queue.count; first += laneCount)
+		{
+			//lanes past count shade whatever an earlier batch left there and are not written
+			PixelBlock block{};
+			const std::array<SimdFloat*, PixelQueue::ComponentCount> components = GetComponents(block);
+			for (int component{}; component < PixelQueue::ComponentCount; ++component)
+			{
+				*components[component] = SimdFloat::Load(queue.components[component].data() + first);
+			}
+
+			const int pixelCount = std::min(laneCount, static_cast<int>(queue.count - first));
+			SimdVector4 color = shader(draw.material, block);
+			if (draw.blend)
+			{
+				//src alpha / inv src alpha on the color, zero / zero on the alpha
+				for (int lane{}; lane < laneCount; ++lane)
+				{
+					colors[lane] = m_Color[queue.offsets[first + std::min(lane, pixelCount - 1)]];
+				}
+				const SimdVector4 target = SoftwareTexture::UnpackColors(colors);
+				const SimdFloat alpha = Saturate(color.w);
+				const SimdFloat invAlpha = SimdFloat{ 1.f } - alpha;
+				color = { color.x * alpha + target.x * invAlpha, color.y * alpha + target.y * invAlpha, color.z * alpha + target.z * invAlpha, 0.f };
+			}
+			SoftwareTexture::PackColors(color, colors);
+
+			for (int lane{}; lane < pixelCount; ++lane)
+			{
+				m_Color[queue.offsets[first + lane]] = colors[lane];
+			}
+		}
+
+		const uint32_t shadedPixelCount = queue.count;
+		queue.count = 0;
+		return shadedPixelCount;
+	}
+
+	inline std::array<SimdFloat*, SoftwareRasterizer::PixelQueue::ComponentCount> SoftwareRasterizer::GetComponents(PixelBlock& block)
+	{
+		return {
+			&block.worldPosition.x, &block.worldPosition.y, &block.worldPosition.z,
+			&block.uv.x, &block.uv.y,
+			&block.normal.x, &block.normal.y, &block.normal.z,
+			&block.tangent.x, &block.tangent.y, &block.tangent.z,
+			&block.uvDx.x, &block.uvDx.y,
+			&block.uvDy.x, &block.uvDy.y
+		};
+	}
+
+	inline RasterVertex SoftwareRasterizer::Lerp(const RasterVertex& from, const RasterVertex& to, float factor)
+	{
+		const auto lerp = [factor](const auto& a, const auto& b) { return a + (b - a) * factor; };
+		return {
+			lerp(from.position, to.position),
+			{
+				lerp(from.attributes.worldPosition, to.attributes.worldPosition),
+				lerp(from.attributes.uv, to.attributes.uv),
+				lerp(from.attributes.normal, to.attributes.normal),
+				lerp(from.attributes.tangent, to.attributes.tangent)
+			}
+		};
+	}
+}
@@ -0,0 +1,263 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JobSystem.h"
+#include "RenderBackend.h"
+#include "SoftwareRasterizer.h"
+#include "SoftwareShading.h"
+#include "SoftwareTexture.h"
+
+namespace dae
+{
+	//Backend that renders on the CPU through the tiled SoftwareRasterizer, with the vertex and pixel shaders of
+	//PosCol3D.fx and PartialCoverage.fx and their render states. Draws are recorded during the frame and
+	//transformed and rasterized in EndFrame, which leaves the image in GetRasterizer().GetColorBuffer()
+	class SoftwareRenderBackend final : public RenderBackend
+	{
+	public:
+		//Fills texture from an image file and returns false when it can't, the texture then falls back to a solid color
+		//Textures of a material load as parallel jobs, so it has to be safe to call from several threads at once
+		using TextureLoader = std::function<bool(const std::string& path, SoftwareTexture& texture)>;
+
+		SoftwareRenderBackend(uint32_t width, uint32_t height, TextureLoader loadTexture = {}, JobSystem& jobSystem = JobSystem::Get());
+
+		MeshHandle CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle material) override;
+		void UpdateIndices(MeshHandle mesh, const std::vector<uint32_t>& indices) override { m_Meshes[mesh].indices = indices; }
+		void UploadInstances(const Matrix* worldMatricesPtr, uint32_t count) override { m_InstanceMatrices.assign(worldMatricesPtr, worldMatricesPtr + count); }
+
+		MaterialHandle CreateMaterial(MaterialType type) override;
+		bool IsTransparent(MaterialHandle material) const override { return m_MaterialTypes[material] == MaterialType::FireFX; }
+		bool SupportsInstancing(MaterialHandle material) const override { return m_MaterialTypes[material] == MaterialType::Vehicle; }
+		void SetCameraPosition(const Vector3& position) override { m_VehicleShading.cameraPosition = position; }
+		void SetSamplerState(int state) override;
+		void SetUseNormalMap(bool useNormalMap) override { m_VehicleShading.useNormalMap = useNormalMap; }
+
+		void BeginFrame() override;
+		void EndFrame() override;
+		RenderContext& GetImmediateContext() override { return m_Context; }
+
+		//draws are only recorded until EndFrame, so one context is enough
+		uint32_t GetMaxChunkCount() const override { return 0; }
+		uint32_t RecordParallel(uint32_t, const RecordChunkFunction&) override { return 0; }
+
+		const SoftwareRasterizer& GetRasterizer() const { return m_Rasterizer; }
+		SoftwareRasterizer::Settings& GetRasterizerSettings() { return m_Rasterizer.GetSettings(); }
+
+	private:
+		class Context final : public RenderContext
+		{
+		public:
+			explicit Context(SoftwareRenderBackend& backend) : m_Backend{ backend } {}
+
+			void BindMesh(MeshHandle, bool) override {}
+			void Draw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix) override;
+			void DrawInstanced(MeshHandle mesh, MaterialHandle material, const Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount) override;
+
+		private:
+			SoftwareRenderBackend& m_Backend;
+		};
+
+		struct MeshData
+		{
+			std::vector<MeshVertex> vertices{};
+			std::vector<uint32_t> indices{};
+		};
+
+		//One mesh instance, transformed into m_TransformedVertices from firstVertex on
+		struct DrawCommand
+		{
+			MeshHandle mesh{};
+			MaterialHandle material{};
+			Matrix worldMatrix{};
+			Matrix worldViewProjectionMatrix{};
+			uint32_t firstVertex{};
+		};
+
+		//A range of the vertices of one draw, the unit of work of the vertex stage
+		struct VertexJob
+		{
+			uint32_t draw{};
+			uint32_t firstVertex{};
+			uint32_t vertexCount{};
+		};
+
+		static constexpr uint32_t m_VertexJobSize{ 1024 };
+		static constexpr Vector4 m_ClearColor{ 0.39f, 0.59f, 0.93f, 1.f };
+
+		SoftwareRasterizer m_Rasterizer;
+		JobSystem& m_JobSystem;
+		TextureLoader m_LoadTexture;
+		Context m_Context{ *this };
+
+		std::vector<MeshData> m_Meshes{};
+		std::vector<MaterialType> m_MaterialTypes{};
+		std::vector<Matrix> m_InstanceMatrices{};
+
+		//textures are shared by every material of a type, the effects load the same files
+		std::array<SoftwareTexture, 4> m_VehicleTextures{};
+		SoftwareTexture m_FireFXTexture{};
+		VehicleShading m_VehicleShading{};
+		FireFXShading m_FireFXShading{};
+
+		std::vector<DrawCommand> m_DrawCommands{};
+		std::vector<VertexJob> m_VertexJobs{};
+		std::vector<RasterVertex> m_TransformedVertices{};
+		std::vector<RasterDraw> m_RasterDraws{};
+
+		SoftwareTexture LoadTexture(const std::string& path, const Vector4& fallbackColor) const;
+		void AddDraw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix);
+		void TransformVertices(const VertexJob& job);
+	};
+
+	inline SoftwareRenderBackend::SoftwareRenderBackend(uint32_t width, uint32_t height, TextureLoader loadTexture, JobSystem& jobSystem)
+		: m_Rasterizer{ width, height, jobSystem }
+		, m_JobSystem{ jobSystem }
+		, m_LoadTexture{ std::move(loadTexture) }
+	{
+	}
+
+	inline MeshHandle SoftwareRenderBackend::CreateMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, MaterialHandle)
+	{
+		m_Meshes.push_back({ vertices, indices });
+		return static_cast<MeshHandle>(m_Meshes.size() - 1);
+	}
+
+	inline MaterialHandle SoftwareRenderBackend::CreateMaterial(MaterialType type)
+	{
+		//same files as VehicleEffect and FireFXEffect, loaded with the first material that needs them
+		const bool isFirstOfType = std::find(m_MaterialTypes.begin(), m_MaterialTypes.end(), type) == m_MaterialTypes.end();
+		if (isFirstOfType && type == MaterialType::Vehicle)
+		{
+			//decoding dominates, one job per file
+			static const std::array<std::pair<const char*, Vector4>, 4> files{ {
+				{ "Resources/vehicle_diffuse.png", { 0.5f, 0.5f, 0.5f, 1.f } },
+				{ "Resources/vehicle_normal.png", { 0.5f, 0.5f, 1.f, 1.f } },
+				{ "Resources/vehicle_specular.png", { 0.f, 0.f, 0.f, 1.f } },
+				{ "Resources/vehicle_gloss.png", { 0.f, 0.f, 0.f, 1.f } }
+			} };
+			m_JobSystem.ParallelFor(static_cast<uint32_t>(files.size()), [&](uint32_t file)
+			{
+				m_VehicleTextures[file] = LoadTexture(files[file].first, files[file].second);
+			});
+			m_VehicleShading.diffuseMapPtr = &m_VehicleTextures[0];
+			m_VehicleShading.normalMapPtr = &m_VehicleTextures[1];
+			m_VehicleShading.specularMapPtr = &m_VehicleTextures[2];
+			m_VehicleShading.glossinessMapPtr = &m_VehicleTextures[3];
+		}
+		else if (isFirstOfType && type == MaterialType::FireFX)
+		{
+			m_FireFXTexture = LoadTexture("Resources/fireFX_diffuse.png", { 1.f, 0.6f, 0.2f, 0.5f });
+			m_FireFXShading.diffuseMapPtr = &m_FireFXTexture;
+		}
+
+		m_MaterialTypes.push_back(type);
+		return static_cast<MaterialHandle>(m_MaterialTypes.size() - 1);
+	}
+
+	inline void SoftwareRenderBackend::SetSamplerState(int state)
+	{
+		const SamplerFilter filter = static_cast<SamplerFilter>(std::clamp(state, 0, 2));
+		m_VehicleShading.filter = filter;
+		m_FireFXShading.filter = filter;
+	}
+
+	inline void SoftwareRenderBackend::BeginFrame()
+	{
+		m_DrawCommands.clear();
+		m_Rasterizer.Clear(m_ClearColor);
+	}
+
+	inline void SoftwareRenderBackend::EndFrame()
+	{
+		//vertex stage, large meshes are split over several jobs
+		uint32_t vertexCount{};
+		m_VertexJobs.clear();
+		for (uint32_t draw{}; draw < static_cast<uint32_t>(m_DrawCommands.size()); ++draw)
+		{
+			DrawCommand& command = m_DrawCommands[draw];
+			const uint32_t meshVertexCount = static_cast<uint32_t>(m_Meshes[command.mesh].vertices.size());
+			command.firstVertex = vertexCount;
+			for (uint32_t first{}; first < meshVertexCount; first += m_VertexJobSize)
+			{
+				m_VertexJobs.push_back({ draw, first, std::min(m_VertexJobSize, meshVertexCount - first) });
+			}
+			vertexCount += meshVertexCount;
+		}
+		m_TransformedVertices.resize(vertexCount);
+		m_JobSystem.ParallelFor(static_cast<uint32_t>(m_VertexJobs.size()), [this](uint32_t job) { TransformVertices(m_VertexJobs[job]); });
+
+		//render states of the techniques: PosCol3D culls back faces and writes depth, PartialCoverage blends without culling or depth writes
+		m_RasterDraws.clear();
+		for (const DrawCommand& command : m_DrawCommands)
+		{
+			const std::vector<uint32_t>& indices = m_Meshes[command.mesh].indices;
+			const bool isTransparent = IsTransparent(command.material);
+			m_RasterDraws.push_back({
+				m_TransformedVertices.data() + command.firstVertex,
+				indices.data(),
+				static_cast<uint32_t>(indices.size()),
+				static_cast<uint32_t>(m_MaterialTypes[command.material]),
+				!isTransparent,
+				!isTransparent,
+				isTransparent });
+		}
+
+		m_Rasterizer.Render(m_RasterDraws, [this](uint32_t material, const PixelBlock& block)
+		{
+			return static_cast<MaterialType>(material) == MaterialType::Vehicle ? ShadeVehicle(m_VehicleShading, block) : ShadeFireFX(m_FireFXShading, block);
+		});
+	}
+
+	inline SoftwareTexture SoftwareRenderBackend::LoadTexture(const std::string& path, const Vector4& fallbackColor) const
+	{
+		SoftwareTexture texture{};
+		if (m_LoadTexture && m_LoadTexture(path, texture) && texture.IsValid()) return texture;
+		return SoftwareTexture::CreateSolid(fallbackColor);
+	}
+
+	inline void SoftwareRenderBackend::AddDraw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix)
+	{
+		m_DrawCommands.push_back({ mesh, material, worldMatrix, worldViewProjectionMatrix });
+	}
+
+	inline void SoftwareRenderBackend::TransformVertices(const VertexJob& job)
+	{
+		//VS of PosCol3D.fx, the fire fx shader passes the same outputs
+		const DrawCommand& command = m_DrawCommands[job.draw];
+		const MeshVertex* verticesPtr = m_Meshes[command.mesh].vertices.data() + job.firstVertex;
+		RasterVertex* transformedPtr = m_TransformedVertices.data() + command.firstVertex + job.firstVertex;
+		for (uint32_t vertex{}; vertex < job.vertexCount; ++vertex)
+		{
+			const MeshVertex& input = verticesPtr[vertex];
+			transformedPtr[vertex] = {
+				command.worldViewProjectionMatrix.TransformPoint(Vector4{ input.position, 1.f }),
+				{
+					command.worldMatrix.TransformPoint(input.position),
+					input.uv,
+					command.worldMatrix.TransformVector(input.normal.Normalized()),
+					command.worldMatrix.TransformVector(input.tangent.Normalized())
+				}
+			};
+		}
+	}
+
+	inline void SoftwareRenderBackend::Context::Draw(MeshHandle mesh, MaterialHandle material, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix)
+	{
+		m_Backend.AddDraw(mesh, material, worldMatrix, worldViewProjectionMatrix);
+	}
+
+	inline void SoftwareRenderBackend::Context::DrawInstanced(MeshHandle mesh, MaterialHandle material, const Matrix& viewProjectionMatrix, uint32_t firstInstance, uint32_t instanceCount)
+	{
+		//VS_Instanced: every instance is a draw with its own world matrix from the instance buffer
+		for (uint32_t instance{ firstInstance }; instance < firstInstance + instanceCount; ++instance)
+		{
+			const Matrix& worldMatrix = m_Backend.m_InstanceMatrices[instance];
+			m_Backend.AddDraw(mesh, material, worldMatrix, worldMatrix * viewProjectionMatrix);
+		}
+	}
+}
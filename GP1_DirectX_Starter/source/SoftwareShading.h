@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "MathHelpers.h"
+#include "SimdFloat.h"
+#include "SoftwareTexture.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//Interpolated vertex shader output of one pixel, VS_OUTPUT of the effects
+	//uvDx and uvDy are the screen space derivatives of uv, what ddx / ddy would return, for the anisotropic filter
+	struct PixelInput
+	{
+		Vector3 worldPosition{};
+		Vector2 uv{};
+		Vector3 normal{};
+		Vector3 tangent{};
+		Vector2 uvDx{};
+		Vector2 uvDy{};
+	};
+
+	//PixelInput of a row of SimdFloat::Width pixels
+	struct PixelBlock
+	{
+		SimdVector3 worldPosition{};
+		SimdVector2 uv{};
+		SimdVector3 normal{};
+		SimdVector3 tangent{};
+		SimdVector2 uvDx{};
+		SimdVector2 uvDy{};
+
+		PixelInput GetLane(int lane) const
+		{
+			return {
+				{ worldPosition.x.GetLane(lane), worldPosition.y.GetLane(lane), worldPosition.z.GetLane(lane) },
+				{ uv.x.GetLane(lane), uv.y.GetLane(lane) },
+				{ normal.x.GetLane(lane), normal.y.GetLane(lane), normal.z.GetLane(lane) },
+				{ tangent.x.GetLane(lane), tangent.y.GetLane(lane), tangent.z.GetLane(lane) },
+				{ uvDx.x.GetLane(lane), uvDx.y.GetLane(lane) },
+				{ uvDy.x.GetLane(lane), uvDy.y.GetLane(lane) }
+			};
+		}
+	};
+
+	//Inputs of PS in PosCol3D.fx, constants keep the defaults of the effect file
+	struct VehicleShading
+	{
+		const SoftwareTexture* diffuseMapPtr{};
+		const SoftwareTexture* normalMapPtr{};
+		const SoftwareTexture* specularMapPtr{};
+		const SoftwareTexture* glossinessMapPtr{};
+		Vector3 cameraPosition{};
+		SamplerFilter filter{ SamplerFilter::Anisotropic };
+		bool useNormalMap{ true };
+
+		static constexpr Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
+		static constexpr float ambientIntensity{ 0.03f };
+		static constexpr float lightIntensity{ 7.f };
+		static constexpr float shininess{ 25.f };
+	};
+
+	//Inputs of PS in PartialCoverage.fx
+	struct FireFXShading
+	{
+		const SoftwareTexture* diffuseMapPtr{};
+		SamplerFilter filter{ SamplerFilter::Anisotropic };
+	};
+
+	//Scalar port of PosCol3D.fx PS: Lambert diffuse, Phong specular from the gloss and specular maps,
+	//tangent space normal mapping and ambient, saturated like the shader output
+	//The reference for the SIMD version below, which shades a whole PixelBlock
+	inline Vector4 ShadeVehicle(const VehicleShading& shading, const PixelInput& input)
+	{
+		const auto sample = [&](const SoftwareTexture* texturePtr) { return texturePtr->Sample(input.uv, input.uvDx, input.uvDy, shading.filter); };
+
+		Vector3 normal{ input.normal };
+		if (shading.useNormalMap)
+		{
+			const Vector4 sampledNormal{ sample(shading.normalMapPtr) };
+			const Vector3 tangentSpaceNormal{ 2.f * sampledNormal.x - 1.f, 2.f * sampledNormal.y - 1.f, 2.f * sampledNormal.z - 1.f };
+			const Vector3 binormal{ Vector3::Cross(input.normal, input.tangent) };
+			normal = (input.tangent * tangentSpaceNormal.x + binormal * tangentSpaceNormal.y + input.normal * tangentSpaceNormal.z).Normalized();
+		}
+
+		const Vector4 diffuse{ sample(shading.diffuseMapPtr) };
+		const float observedArea{ Vector3::Dot(normal, -VehicleShading::lightDirection) };
+		const float lambertScale{ VehicleShading::lightIntensity / PI * observedArea };
+
+		//Phong, the shader leaves the normal unnormalized without the normal map, so does this
+		const Vector3 invViewDirection{ (shading.cameraPosition - input.worldPosition).Normalized() };
+		const float exponent{ sample(shading.glossinessMapPtr).x * VehicleShading::shininess };
+		const float specularReflectance{ sample(shading.specularMapPtr).x };
+		const Vector3 reflectedRay{ Vector3::Reflect(VehicleShading::lightDirection, -normal) };
+		const float cosAlpha{ Vector3::Dot(reflectedRay.Normalized(), invViewDirection) };
+		//pow of a negative base is NaN on the GPU, which saturate turns into 0
+		const float specular{ cosAlpha > 0.f ? Saturate(specularReflectance * std::pow(cosAlpha, exponent)) : 0.f };
+
+		return {
+			Saturate(diffuse.x * lambertScale + specular + VehicleShading::ambientIntensity),
+			Saturate(diffuse.y * lambertScale + specular + VehicleShading::ambientIntensity),
+			Saturate(diffuse.z * lambertScale + specular + VehicleShading::ambientIntensity),
+			Saturate(diffuse.w * lambertScale + specular + 1.f)
+		};
+	}
+
+	//PartialCoverage.fx PS: the diffuse map, blended over the target with its alpha
+	inline Vector4 ShadeFireFX(const FireFXShading& shading, const PixelInput& input)
+	{
+		return shading.diffuseMapPtr->Sample(input.uv, input.uvDx, input.uvDy, shading.filter);
+	}
+
+	//ShadeVehicle for SimdFloat::Width pixels at once, pow goes through Log2 / Exp2
+	inline SimdVector4 ShadeVehicle(const VehicleShading& shading, const PixelBlock& input)
+	{
+		const auto sample = [&](const SoftwareTexture* texturePtr) { return texturePtr->Sample(input.uv, input.uvDx, input.uvDy, shading.filter); };
+
+		SimdVector3 normal{ input.normal };
+		if (shading.useNormalMap)
+		{
+			const SimdVector4 sampledNormal{ sample(shading.normalMapPtr) };
+			const SimdVector3 tangentSpaceNormal{ sampledNormal.x * 2.f - 1.f, sampledNormal.y * 2.f - 1.f, sampledNormal.z * 2.f - 1.f };
+			const SimdVector3 binormal{ SimdVector3::Cross(input.normal, input.tangent) };
+			normal = (input.tangent * tangentSpaceNormal.x + binormal * tangentSpaceNormal.y + input.normal * tangentSpaceNormal.z).Normalized();
+		}
+
+		const SimdVector3 lightDirection{ VehicleShading::lightDirection };
+		const SimdVector4 diffuse{ sample(shading.diffuseMapPtr) };
+		const SimdFloat observedArea{ SimdVector3::Dot(normal, -lightDirection) };
+		const SimdFloat lambertScale{ observedArea * (VehicleShading::lightIntensity / PI) };
+
+		const SimdVector3 invViewDirection{ (SimdVector3{ shading.cameraPosition } - input.worldPosition).Normalized() };
+		const SimdFloat exponent{ sample(shading.glossinessMapPtr).x * VehicleShading::shininess };
+		const SimdFloat specularReflectance{ sample(shading.specularMapPtr).x };
+		//reflecting about -n is the same as about n
+		const SimdVector3 reflectedRay{ lightDirection - normal * (SimdVector3::Dot(lightDirection, normal) * 2.f) };
+		const SimdFloat cosAlpha{ SimdVector3::Dot(reflectedRay.Normalized(), invViewDirection) };
+		const SimdFloat specular{ Select(cosAlpha > 0.f, Saturate(specularReflectance * Pow(cosAlpha, exponent)), 0.f) };
+
+		const SimdFloat ambient{ VehicleShading::ambientIntensity };
+		return {
+			Saturate(diffuse.x * lambertScale + specular + ambient),
+			Saturate(diffuse.y * lambertScale + specular + ambient),
+			Saturate(diffuse.z * lambertScale + specular + ambient),
+			Saturate(diffuse.w * lambertScale + specular + 1.f)
+		};
+	}
+
+	inline SimdVector4 ShadeFireFX(const FireFXShading& shading, const PixelBlock& input)
+	{
+		return shading.diffuseMapPtr->Sample(input.uv, input.uvDx, input.uvDy, shading.filter);
+	}
+}
@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "SimdFloat.h"
+#include "Vector2.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//Filters of BaseEffect::SetSamplerState, in the same order
+	enum class SamplerFilter : uint8_t
+	{
+		Point,
+		Linear,
+		Anisotropic
+	};
+
+	//RGBA8 texture in CPU memory, sampled like the samplers of the effects: wrap addressing and a single mip
+	//Texels are stored like R8G8B8A8_UNORM, red in the low byte
+	//Every sampler has a scalar version and a SimdFloat version for a row of pixels, both do the same math
+	struct SoftwareTexture
+	{
+		uint32_t width{};
+		uint32_t height{};
+		std::vector<uint32_t> texels{};
+
+		//matches MaxAnisotropy of the anisotropic sampler state in BaseEffect
+		static constexpr int MaxAnisotropy{ 16 };
+
+		bool IsValid() const { return width > 0 && height > 0 && texels.size() == size_t{ width } * height; }
+
+		//1x1 texture of color, components in [0, 1]
+		static SoftwareTexture CreateSolid(const Vector4& color);
+
+		static uint32_t PackColor(const Vector4& color);
+		static Vector4 UnpackColor(uint32_t texel);
+		//SimdFloat::Width texels at a time
+		static void PackColors(const SimdVector4& colors, uint32_t* texelsPtr);
+		static SimdVector4 UnpackColors(const uint32_t* texelsPtr);
+
+		//Returns the color in [0, 1]. uvDx and uvDy are the uv steps to the next pixel right and down,
+		//only the anisotropic filter uses them
+		Vector4 Sample(const Vector2& uv, SamplerFilter filter) const { return Sample(uv, {}, {}, filter); }
+		Vector4 Sample(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy, SamplerFilter filter) const;
+		Vector4 SamplePoint(const Vector2& uv) const;
+		Vector4 SampleLinear(const Vector2& uv) const;
+		Vector4 SampleAnisotropic(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy) const;
+
+		SimdVector4 Sample(const SimdVector2& uv, const SimdVector2& uvDx, const SimdVector2& uvDy, SamplerFilter filter) const;
+		SimdVector4 SamplePoint(const SimdVector2& uv) const;
+		SimdVector4 SampleLinear(const SimdVector2& uv) const;
+		SimdVector4 SampleAnisotropic(const SimdVector2& uv, const SimdVector2& uvDx, const SimdVector2& uvDy) const;
+
+	private:
+		//coordinates far outside the texture lose the fraction anyway, clamping keeps Floor and the int conversion exact
+		static constexpr float m_MaxCoordinate{ 1048576.f };
+
+		//Texels at integer coordinates, wrapped into the texture
+		SimdVector4 GatherTexels(const SimdFloat& x, const SimdFloat& y) const;
+		static SimdVector4 UnpackColors(const SimdIntRegister& texels);
+
+		static int Wrap(int coordinate, int size)
+		{
+			const int wrapped = coordinate % size;
+			return wrapped < 0 ? wrapped + size : wrapped;
+		}
+
+		uint32_t GetTexel(int x, int y) const
+		{
+			return texels[static_cast<size_t>(Wrap(y, static_cast<int>(height))) * width + Wrap(x, static_cast<int>(width))];
+		}
+	};
+
+	inline SoftwareTexture SoftwareTexture::CreateSolid(const Vector4& color)
+	{
+		return SoftwareTexture{ 1, 1, { PackColor(color) } };
+	}
+
+	inline uint32_t SoftwareTexture::PackColor(const Vector4& color)
+	{
+		//round to nearest, like the float to UNORM conversion of the output merger
+		const auto toByte = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f); };
+		return toByte(color.x) | toByte(color.y) << 8 | toByte(color.z) << 16 | toByte(color.w) << 24;
+	}
+
+	inline Vector4 SoftwareTexture::UnpackColor(uint32_t texel)
+	{
+		constexpr float scale{ 1.f / 255.f };
+		return {
+			static_cast<float>(texel & 0xff) * scale,
+			static_cast<float>((texel >> 8) & 0xff) * scale,
+			static_cast<float>((texel >> 16) & 0xff) * scale,
+			static_cast<float>(texel >> 24) * scale
+		};
+	}
+
+	inline void SoftwareTexture::PackColors(const SimdVector4& colors, uint32_t* texelsPtr)
+	{
+		const auto toBytes = [](const SimdFloat& value) { return Saturate(value) * 255.f + 0.5f; };
+#if defined(DAE_AVX2)
+		const __m256i red = _mm256_cvttps_epi32(toBytes(colors.x).value);
+		const __m256i green = _mm256_slli_epi32(_mm256_cvttps_epi32(toBytes(colors.y).value), 8);
+		const __m256i blue = _mm256_slli_epi32(_mm256_cvttps_epi32(toBytes(colors.z).value), 16);
+		const __m256i alpha = _mm256_slli_epi32(_mm256_cvttps_epi32(toBytes(colors.w).value), 24);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(texelsPtr), _mm256_or_si256(_mm256_or_si256(red, green), _mm256_or_si256(blue, alpha)));
+#elif defined(DAE_SSE)
+		const __m128i red = _mm_cvttps_epi32(toBytes(colors.x).value);
+		const __m128i green = _mm_slli_epi32(_mm_cvttps_epi32(toBytes(colors.y).value), 8);
+		const __m128i blue = _mm_slli_epi32(_mm_cvttps_epi32(toBytes(colors.z).value), 16);
+		const __m128i alpha = _mm_slli_epi32(_mm_cvttps_epi32(toBytes(colors.w).value), 24);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(texelsPtr), _mm_or_si128(_mm_or_si128(red, green), _mm_or_si128(blue, alpha)));
+#else
+		(void)toBytes;
+		*texelsPtr = PackColor({ colors.x.value, colors.y.value, colors.z.value, colors.w.value });
+#endif
+	}
+
+	inline SimdVector4 SoftwareTexture::UnpackColors(const uint32_t* texelsPtr)
+	{
+#if defined(DAE_AVX2)
+		return UnpackColors(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(texelsPtr)));
+#elif defined(DAE_SSE)
+		return UnpackColors(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texelsPtr)));
+#else
+		return UnpackColors(*texelsPtr);
+#endif
+	}
+
+	inline SimdVector4 SoftwareTexture::UnpackColors(const SimdIntRegister& texels)
+	{
+		const SimdFloat scale{ 1.f / 255.f };
+#if defined(DAE_AVX2)
+		const __m256i byteMask = _mm256_set1_epi32(0xff);
+		return {
+			SimdFloat{ _mm256_cvtepi32_ps(_mm256_and_si256(texels, byteMask)) } * scale,
+			SimdFloat{ _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 8), byteMask)) } * scale,
+			SimdFloat{ _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 16), byteMask)) } * scale,
+			SimdFloat{ _mm256_cvtepi32_ps(_mm256_srli_epi32(texels, 24)) } * scale
+		};
+#elif defined(DAE_SSE)
+		const __m128i byteMask = _mm_set1_epi32(0xff);
+		return {
+			SimdFloat{ _mm_cvtepi32_ps(_mm_and_si128(texels, byteMask)) } * scale,
+			SimdFloat{ _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), byteMask)) } * scale,
+			SimdFloat{ _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), byteMask)) } * scale,
+			SimdFloat{ _mm_cvtepi32_ps(_mm_srli_epi32(texels, 24)) } * scale
+		};
+#else
+		(void)scale;
+		const Vector4 color = UnpackColor(texels);
+		return { color.x, color.y, color.z, color.w };
+#endif
+	}
+
+	inline Vector4 SoftwareTexture::Sample(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy, SamplerFilter filter) const
+	{
+		switch (filter)
+		{
+		case SamplerFilter::Point: return SamplePoint(uv);
+		case SamplerFilter::Linear: return SampleLinear(uv);
+		default: return SampleAnisotropic(uv, uvDx, uvDy);
+		}
+	}
+
+	inline Vector4 SoftwareTexture::SamplePoint(const Vector2& uv) const
+	{
+		const int x = static_cast<int>(std::floor(std::clamp(uv.x * static_cast<float>(width), -m_MaxCoordinate, m_MaxCoordinate)));
+		const int y = static_cast<int>(std::floor(std::clamp(uv.y * static_cast<float>(height), -m_MaxCoordinate, m_MaxCoordinate)));
+		return UnpackColor(GetTexel(x, y));
+	}
+
+	inline Vector4 SoftwareTexture::SampleLinear(const Vector2& uv) const
+	{
+		//texel centers sit at half coordinates
+		const float u = uv.x * static_cast<float>(width) - 0.5f;
+		const float v = uv.y * static_cast<float>(height) - 0.5f;
+		const float floorU = std::floor(std::clamp(u, -m_MaxCoordinate, m_MaxCoordinate));
+		const float floorV = std::floor(std::clamp(v, -m_MaxCoordinate, m_MaxCoordinate));
+		const float fractionU = u - floorU;
+		const float fractionV = v - floorV;
+		const int x = static_cast<int>(floorU);
+		const int y = static_cast<int>(floorV);
+
+		const Vector4 top = UnpackColor(GetTexel(x, y)) * (1.f - fractionU) + UnpackColor(GetTexel(x + 1, y)) * fractionU;
+		const Vector4 bottom = UnpackColor(GetTexel(x, y + 1)) * (1.f - fractionU) + UnpackColor(GetTexel(x + 1, y + 1)) * fractionU;
+		return top * (1.f - fractionV) + bottom * fractionV;
+	}
+
+	inline Vector4 SoftwareTexture::SampleAnisotropic(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy) const
+	{
+		//Without mips: spread bilinear taps along the longer side of the pixel footprint, one per texel it is longer
+		//than the shorter side, and average them. Magnified pixels take a single tap, like the linear filter.
+		const float lengthX = Vector2{ uvDx.x * static_cast<float>(width), uvDx.y * static_cast<float>(height) }.Magnitude();
+		const float lengthY = Vector2{ uvDy.x * static_cast<float>(width), uvDy.y * static_cast<float>(height) }.Magnitude();
+		const Vector2 majorAxis = lengthX > lengthY ? uvDx : uvDy;
+		const float ratio = std::max(lengthX, lengthY) / std::max(std::min(lengthX, lengthY), 1.f);
+		//NaN footprints take one tap
+		const float clampedRatio = ratio > 1.f ? std::min(ratio, static_cast<float>(MaxAnisotropy)) : 1.f;
+		const int tapCount = static_cast<int>(std::ceil(clampedRatio));
+
+		Vector4 color{};
+		for (int tap{}; tap < tapCount; ++tap)
+		{
+			const float offset = (static_cast<float>(tap) + 0.5f) / static_cast<float>(tapCount) - 0.5f;
+			color += SampleLinear(uv + majorAxis * offset);
+		}
+		return color * (1.f / static_cast<float>(tapCount));
+	}
+
+	inline SimdVector4 SoftwareTexture::Sample(const SimdVector2& uv, const SimdVector2& uvDx, const SimdVector2& uvDy, SamplerFilter filter) const
+	{
+		switch (filter)
+		{
+		case SamplerFilter::Point: return SamplePoint(uv);
+		case SamplerFilter::Linear: return SampleLinear(uv);
+		default: return SampleAnisotropic(uv, uvDx, uvDy);
+		}
+	}
+
+	inline SimdVector4 SoftwareTexture::SamplePoint(const SimdVector2& uv) const
+	{
+		return GatherTexels(Floor(uv.x * static_cast<float>(width)), Floor(uv.y * static_cast<float>(height)));
+	}
+
+	inline SimdVector4 SoftwareTexture::SampleLinear(const SimdVector2& uv) const
+	{
+		const SimdFloat u = uv.x * static_cast<float>(width) - 0.5f;
+		const SimdFloat v = uv.y * static_cast<float>(height) - 0.5f;
+		const SimdFloat floorU = Floor(Max(Min(u, m_MaxCoordinate), -m_MaxCoordinate));
+		const SimdFloat floorV = Floor(Max(Min(v, m_MaxCoordinate), -m_MaxCoordinate));
+		const SimdFloat fractionU = u - floorU;
+		const SimdFloat fractionV = v - floorV;
+		const SimdFloat nextU = floorU + 1.f;
+		const SimdFloat nextV = floorV + 1.f;
+
+		const SimdFloat invFractionU = SimdFloat{ 1.f } - fractionU;
+		const SimdVector4 top = GatherTexels(floorU, floorV) * invFractionU + GatherTexels(nextU, floorV) * fractionU;
+		const SimdVector4 bottom = GatherTexels(floorU, nextV) * invFractionU + GatherTexels(nextU, nextV) * fractionU;
+		return top * (SimdFloat{ 1.f } - fractionV) + bottom * fractionV;
+	}
+
+	inline SimdVector4 SoftwareTexture::SampleAnisotropic(const SimdVector2& uv, const SimdVector2& uvDx, const SimdVector2& uvDy) const
+	{
+		//see the scalar version, lanes that need fewer taps mask the rest out
+		const SimdFloat textureWidth{ static_cast<float>(width) };
+		const SimdFloat textureHeight{ static_cast<float>(height) };
+		const SimdFloat lengthX = Sqrt(Square(uvDx.x * textureWidth) + Square(uvDx.y * textureHeight));
+		const SimdFloat lengthY = Sqrt(Square(uvDy.x * textureWidth) + Square(uvDy.y * textureHeight));
+		const SimdMask isXMajor = lengthX > lengthY;
+		const SimdVector2 majorAxis{ Select(isXMajor, uvDx.x, uvDy.x), Select(isXMajor, uvDx.y, uvDy.y) };
+		const SimdFloat ratio = Max(lengthX, lengthY) / Max(Min(lengthX, lengthY), 1.f);
+		//ceil, NaN footprints take one tap
+		const SimdFloat tapCount = -Floor(-Select(ratio > 1.f, Min(ratio, static_cast<float>(MaxAnisotropy)), 1.f));
+
+		float maxTapCount{};
+		for (int lane{}; lane < SimdFloat::Width; ++lane)
+		{
+			maxTapCount = std::max(maxTapCount, tapCount.GetLane(lane));
+		}
+
+		SimdVector4 color{};
+		const SimdFloat invTapCount = SimdFloat{ 1.f } / tapCount;
+		for (int tap{}; tap < static_cast<int>(maxTapCount); ++tap)
+		{
+			const SimdFloat offset = (SimdFloat{ static_cast<float>(tap) + 0.5f }) * invTapCount - 0.5f;
+			const SimdVector4 sample = SampleLinear(uv + majorAxis * offset);
+			const SimdMask isActive = SimdFloat{ static_cast<float>(tap) } < tapCount;
+			color = color + SimdVector4{ Select(isActive, sample.x, 0.f), Select(isActive, sample.y, 0.f), Select(isActive, sample.z, 0.f), Select(isActive, sample.w, 0.f) };
+		}
+		return color * invTapCount;
+	}
+
+	inline SimdVector4 SoftwareTexture::GatherTexels(const SimdFloat& x, const SimdFloat& y) const
+	{
+		//wrap, then clamp so a NaN or rounding at the border can never index outside the texels
+		const SimdFloat textureWidth{ static_cast<float>(width) };
+		const SimdFloat textureHeight{ static_cast<float>(height) };
+		const SimdFloat clampedX = Max(Min(x, m_MaxCoordinate), -m_MaxCoordinate);
+		const SimdFloat clampedY = Max(Min(y, m_MaxCoordinate), -m_MaxCoordinate);
+		const SimdFloat wrappedX = Max(Min(clampedX - textureWidth * Floor(clampedX / textureWidth), textureWidth - 1.f), 0.f);
+		const SimdFloat wrappedY = Max(Min(clampedY - textureHeight * Floor(clampedY / textureHeight), textureHeight - 1.f), 0.f);
+		const SimdFloat index = wrappedY * textureWidth + wrappedX;
+#if defined(DAE_AVX2)
+		return UnpackColors(_mm256_i32gather_epi32(reinterpret_cast<const int*>(texels.data()), _mm256_cvttps_epi32(index.value), 4));
+#elif defined(DAE_SSE)
+		alignas(16) int32_t indices[SimdFloat::Width];
+		alignas(16) uint32_t gathered[SimdFloat::Width];
+		_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(index.value));
+		for (int lane{}; lane < SimdFloat::Width; ++lane)
+		{
+			gathered[lane] = texels[indices[lane]];
+		}
+		return UnpackColors(gathered);
+#else
+		return UnpackColors(texels[static_cast<size_t>(index.value)]);
+#endif
+	}
+}
@@ -5,8 +5,8 @@ namespace dae
 {
 	Timer::Timer()
 	{
-		const uint64_t countsPerSecond = SDL_GetPerformanceFrequency();
-		m_SecondsPerCount = 1.0f / static_cast<float>(countsPerSecond);
+		m_CountsPerSecond = SDL_GetPerformanceFrequency();
+		m_SecondsPerCount = 1.0f / static_cast<float>(m_CountsPerSecond);
 	}
 
 	void Timer::Reset()
@@ -18,6 +18,7 @@ namespace dae
 		m_StopTime = 0;
 		m_FPSTimer = 0.0f;
 		m_FPSCount = 0;
+		m_FrameTimes.Clear();
 		m_IsStopped = false;
 	}
 
@@ -48,9 +49,13 @@ namespace dae
 		const uint64_t currentTime = SDL_GetPerformanceCounter();
 		m_CurrentTime = currentTime;
 
-		m_ElapsedTime = static_cast<float>(m_CurrentTime - m_PreviousTime) * m_SecondsPerCount;
+		const uint64_t elapsedCounts = m_CurrentTime - m_PreviousTime;
+		m_ElapsedTime = static_cast<float>(elapsedCounts) * m_SecondsPerCount;
 		m_PreviousTime = m_CurrentTime;
 
+		//before the upper bound, a hitch should look like one
+		m_FrameTimes.Add(static_cast<uint32_t>(std::min(elapsedCounts * 1'000'000 / m_CountsPerSecond, uint64_t{ UINT32_MAX })));
+
 		if (m_ElapsedTime < 0.0f)
 			m_ElapsedTime = 0.0f;
 
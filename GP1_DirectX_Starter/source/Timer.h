@@ -3,6 +3,8 @@
 //Standard includes
 #include <cstdint>
 
+#include "FrameTimeHistogram.h"
+
 namespace dae
 {
 	class Timer
@@ -26,6 +28,9 @@ namespace dae
 		float GetElapsed() const { return m_ElapsedTime; };
 		float GetTotal() const { return m_TotalTime; };
 		bool IsRunning() const { return !m_IsStopped; };
+		//Unclamped durations of the last FrameTimeHistogram::WindowSize frames
+		const FrameTimeHistogram& GetFrameTimes() const { return m_FrameTimes; }
+		void SetHitchThreshold(float seconds) { m_FrameTimes.SetHitchThreshold(static_cast<uint32_t>(seconds * 1'000'000.f)); }
 
 	private:
 		uint64_t m_BaseTime = 0;
@@ -33,6 +38,7 @@ namespace dae
 		uint64_t m_StopTime = 0;
 		uint64_t m_PreviousTime = 0;
 		uint64_t m_CurrentTime = 0;
+		uint64_t m_CountsPerSecond = 0;
 
 		uint32_t m_FPS = 0;
 		float m_dFPS = 0.0f;
@@ -44,6 +50,8 @@ namespace dae
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
 
+		FrameTimeHistogram m_FrameTimes{};
+
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
 	};
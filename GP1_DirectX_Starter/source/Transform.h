@@ -0,0 +1,46 @@
+#pragma once
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Vector3.h"
+
+namespace dae
+{
+	//Compact translation-rotation-scale transform (40 bytes vs 64 for a Matrix)
+	//World matrix = Scale * Rotation * Translation (row-vector convention)
+	struct Transform
+	{
+		Vector3 translation{};
+		Quaternion rotation{};
+		Vector3 scale{ 1.f, 1.f, 1.f };
+
+		constexpr Transform() = default;
+		constexpr explicit Transform(const Vector3& _translation, const Quaternion& _rotation = Quaternion::Identity, const Vector3& _scale = { 1.f, 1.f, 1.f })
+			: translation(_translation), rotation(_rotation), scale(_scale) {}
+
+		constexpr Matrix ToMatrix() const
+		{
+			const Matrix r = rotation.ToMatrix();
+			return {
+				r.GetAxisX() * scale.x,
+				r.GetAxisY() * scale.y,
+				r.GetAxisZ() * scale.z,
+				translation
+			};
+		}
+
+		constexpr Vector3 TransformPoint(const Vector3& p) const
+		{
+			return rotation.Rotate(Vector3{ p.x * scale.x, p.y * scale.y, p.z * scale.z }) + translation;
+		}
+
+		//Applies a world-space rotation around pivot, renormalizing so repeated calls do not drift
+		void RotateAround(const Vector3& pivot, const Quaternion& delta)
+		{
+			translation = pivot + delta.Rotate(translation - pivot);
+			rotation = delta * rotation;
+			rotation.Normalize<MathPrecision::Fast>();
+		}
+	};
+
+	static_assert(sizeof(Transform) == 40, "Transform is expected to stay tightly packed");
+}
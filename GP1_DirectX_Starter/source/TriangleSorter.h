@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "Matrix.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//Reorders the triangles of a blended mesh back-to-front for one view, so it blends correctly with itself
+	//Triangles are sorted in clusters of consecutive triangles (a cluster size of 1 sorts every triangle) on the view depth of
+	//the cluster centroid, quantized to 16 bits over the depth range of the mesh and ordered with a two pass radix sort
+	class TriangleSorter final
+	{
+	public:
+		//positionsPtr points at the first position of a vertex array with the given stride in bytes,
+		//worldViewProjection maps the positions to clip space, clip space w is the view depth
+		const std::vector<uint32_t>& Sort(const Vector3* positionsPtr, size_t vertexCount, size_t stride,
+			const std::vector<uint32_t>& indices, const Matrix& worldViewProjection, uint32_t clusterTriangleCount = 1);
+
+		//Triangle indices of the last Sort, farthest cluster first
+		const std::vector<uint32_t>& GetSortedIndices() const { return m_SortedIndices; }
+
+	private:
+		std::vector<float> m_VertexDepths{};
+		std::vector<float> m_ClusterDepths{};
+		std::vector<uint64_t> m_Keys{};
+		std::vector<uint64_t> m_Scratch{};
+		std::vector<uint32_t> m_SortedIndices{};
+	};
+
+	inline const std::vector<uint32_t>& TriangleSorter::Sort(const Vector3* positionsPtr, size_t vertexCount, size_t stride,
+		const std::vector<uint32_t>& indices, const Matrix& worldViewProjection, uint32_t clusterTriangleCount)
+	{
+		assert(indices.size() % 3 == 0 && clusterTriangleCount > 0);
+
+		//w only needs the last column, it is linear so a centroid's depth is the mean of its vertex depths
+		const Vector4 depthRow{ worldViewProjection[0].w, worldViewProjection[1].w, worldViewProjection[2].w, worldViewProjection[3].w };
+		m_VertexDepths.resize(vertexCount);
+		const uint8_t* bytePtr = reinterpret_cast<const uint8_t*>(positionsPtr);
+		for (size_t vertex{}; vertex < vertexCount; ++vertex, bytePtr += stride)
+		{
+			const Vector3& position = *reinterpret_cast<const Vector3*>(bytePtr);
+			m_VertexDepths[vertex] = position.x * depthRow.x + position.y * depthRow.y + position.z * depthRow.z + depthRow.w;
+		}
+
+		const size_t clusterIndexCount = size_t{ clusterTriangleCount } * 3;
+		const size_t clusterCount = (indices.size() + clusterIndexCount - 1) / clusterIndexCount;
+		m_ClusterDepths.resize(clusterCount);
+		float minDepth{ FLT_MAX };
+		float maxDepth{ -FLT_MAX };
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			const size_t first = cluster * clusterIndexCount;
+			const size_t last = std::min(first + clusterIndexCount, indices.size());
+			float depthSum{};
+			for (size_t i{ first }; i < last; ++i)
+			{
+				depthSum += m_VertexDepths[indices[i]];
+			}
+			const float depth = depthSum / static_cast<float>(last - first);
+			m_ClusterDepths[cluster] = depth;
+			minDepth = std::min(minDepth, depth);
+			maxDepth = std::max(maxDepth, depth);
+		}
+
+		//quantized distance to the farthest cluster in the high half, cluster index in the low half
+		const float scale = maxDepth > minDepth ? 65535.f / (maxDepth - minDepth) : 0.f;
+		m_Keys.resize(clusterCount);
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			const uint64_t quantized = static_cast<uint64_t>((maxDepth - m_ClusterDepths[cluster]) * scale);
+			m_Keys[cluster] = quantized << 32 | cluster;
+		}
+
+		//stable LSD radix sort on the two bytes of the quantized depth
+		m_Scratch.resize(clusterCount);
+		for (const uint32_t shift : { 32u, 40u })
+		{
+			uint32_t offsets[256]{};
+			for (const uint64_t key : m_Keys)
+			{
+				++offsets[(key >> shift) & 0xff];
+			}
+			uint32_t offset{};
+			for (uint32_t& bucket : offsets)
+			{
+				const uint32_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+			for (const uint64_t key : m_Keys)
+			{
+				m_Scratch[offsets[(key >> shift) & 0xff]++] = key;
+			}
+			m_Keys.swap(m_Scratch);
+		}
+
+		m_SortedIndices.resize(indices.size());
+		uint32_t* destinationPtr = m_SortedIndices.data();
+		for (const uint64_t key : m_Keys)
+		{
+			const size_t first = (key & UINT32_MAX) * clusterIndexCount;
+			const size_t last = std::min(first + clusterIndexCount, indices.size());
+			destinationPtr = std::copy(indices.begin() + first, indices.begin() + last, destinationPtr);
+		}
+		return m_SortedIndices;
+	}
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <cassert>
+#include <cmath>
 
 namespace dae
 {
@@ -7,39 +9,124 @@ namespace dae
 		float x{};
 		float y{};
 
-		Vector2() = default;
-		Vector2(float _x, float _y);
-		Vector2(const Vector2& from, const Vector2& to);
+		constexpr Vector2() = default;
+		constexpr Vector2(float _x, float _y) : x(_x), y(_y) {}
+		constexpr Vector2(const Vector2& from, const Vector2& to) : x(to.x - from.x), y(to.y - from.y) {}
 
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector2 Normalized() const;
+		float Magnitude() const
+		{
+			return sqrtf(x * x + y * y);
+		}
 
-		static float Dot(const Vector2& v1, const Vector2& v2);
-		static float Cross(const Vector2& v1, const Vector2& v2);
+		constexpr float SqrMagnitude() const
+		{
+			return x * x + y * y;
+		}
 
+		float Normalize()
+		{
+			const float m = Magnitude();
+			x /= m;
+			y /= m;
+
+			return m;
+		}
+
+		Vector2 Normalized() const
+		{
+			const float m = Magnitude();
+			return { x / m, y / m };
+		}
+
+		static constexpr float Dot(const Vector2& v1, const Vector2& v2)
+		{
+			return v1.x * v2.x + v1.y * v2.y;
+		}
+
+		static constexpr float Cross(const Vector2& v1, const Vector2& v2)
+		{
+			return v1.x * v2.y - v1.y * v2.x;
+		}
+
+#pragma region Operator Overloads
 		//Member Operators
-		Vector2 operator*(float scale) const;
-		Vector2 operator/(float scale) const;
-		Vector2 operator+(const Vector2& v) const;
-		Vector2 operator-(const Vector2& v) const;
-		Vector2 operator-() const;
-		//Vector2& operator-();
-		Vector2& operator+=(const Vector2& v);
-		Vector2& operator-=(const Vector2& v);
-		Vector2& operator/=(float scale);
-		Vector2& operator*=(float scale);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector2 operator*(float scale) const
+		{
+			return { x * scale, y * scale };
+		}
+
+		constexpr Vector2 operator/(float scale) const
+		{
+			return { x / scale, y / scale };
+		}
+
+		constexpr Vector2 operator+(const Vector2& v) const
+		{
+			return { x + v.x, y + v.y };
+		}
+
+		constexpr Vector2 operator-(const Vector2& v) const
+		{
+			return { x - v.x, y - v.y };
+		}
+
+		constexpr Vector2 operator-() const
+		{
+			return { -x ,-y };
+		}
+
+		constexpr Vector2& operator+=(const Vector2& v)
+		{
+			x += v.x;
+			y += v.y;
+			return *this;
+		}
+
+		constexpr Vector2& operator-=(const Vector2& v)
+		{
+			x -= v.x;
+			y -= v.y;
+			return *this;
+		}
+
+		constexpr Vector2& operator/=(float scale)
+		{
+			x /= scale;
+			y /= scale;
+			return *this;
+		}
+
+		constexpr Vector2& operator*=(float scale)
+		{
+			x *= scale;
+			y *= scale;
+			return *this;
+		}
+
+		constexpr float& operator[](int index)
+		{
+			assert(index <= 1 && index >= 0);
+			return index == 0 ? x : y;
+		}
+
+		constexpr float operator[](int index) const
+		{
+			assert(index <= 1 && index >= 0);
+			return index == 0 ? x : y;
+		}
+#pragma endregion
 
 		static const Vector2 UnitX;
 		static const Vector2 UnitY;
 		static const Vector2 Zero;
 	};
 
+	inline constexpr Vector2 Vector2::UnitX{ 1, 0 };
+	inline constexpr Vector2 Vector2::UnitY{ 0, 1 };
+	inline constexpr Vector2 Vector2::Zero{ 0, 0 };
+
 	//Global Operators
-	inline Vector2 operator*(float scale, const Vector2& v)
+	constexpr Vector2 operator*(float scale, const Vector2& v)
 	{
 		return { v.x * scale, v.y * scale };
 	}
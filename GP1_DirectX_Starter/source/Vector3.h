@@ -1,8 +1,13 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "FastMath.h"
+#include "Vector2.h"
 
 namespace dae
 {
-	struct Vector2;
 	struct Vector4;
 	struct Vector3
 	{
@@ -10,44 +15,192 @@ namespace dae
 		float y{};
 		float z{};
 
-		Vector3() = default;
-		Vector3(float _x, float _y, float _z);
-		Vector3(const Vector3& from, const Vector3& to);
-		Vector3(const Vector4& v);
+		constexpr Vector3() = default;
+		constexpr Vector3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+		constexpr Vector3(const Vector3& from, const Vector3& to) : x(to.x - from.x), y(to.y - from.y), z(to.z - from.z) {}
+		constexpr Vector3(const Vector4& v);
+
+		float Magnitude() const
+		{
+			return sqrtf(x * x + y * y + z * z);
+		}
+
+		constexpr float SqrMagnitude() const
+		{
+			return x * x + y * y + z * z;
+		}
+
+		//Precise divides by the magnitude, the other policies multiply by an approximate reciprocal square root
+		template<MathPrecision precision = MathPrecision::Precise>
+		float Normalize()
+		{
+			if constexpr (precision == MathPrecision::Precise)
+			{
+				const float m = Magnitude();
+				x /= m;
+				y /= m;
+				z /= m;
+
+				return m;
+			}
+			else
+			{
+				const float sqrMagnitude = SqrMagnitude();
+				const float invMagnitude = InvSqrt<precision>(sqrMagnitude);
+				x *= invMagnitude;
+				y *= invMagnitude;
+				z *= invMagnitude;
+
+				return sqrMagnitude * invMagnitude;
+			}
+		}
+
+		template<MathPrecision precision = MathPrecision::Precise>
+		Vector3 Normalized() const
+		{
+			Vector3 result{ *this };
+			result.Normalize<precision>();
+			return result;
+		}
 
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector3 Normalized() const;
+		static constexpr float Dot(const Vector3& v1, const Vector3& v2)
+		{
+			return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+		}
 
-		static float Dot(const Vector3& v1, const Vector3& v2);
-		static Vector3 Cross(const Vector3& v1, const Vector3& v2);
-		static Vector3 Project(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reject(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reflect(const Vector3& v1, const Vector3& v2);
+		static constexpr Vector3 Cross(const Vector3& v1, const Vector3& v2)
+		{
+			return Vector3{
+				v1.y * v2.z - v1.z * v2.y,
+				v1.z * v2.x - v1.x * v2.z,
+				v1.x * v2.y - v1.y * v2.x
+			};
+		}
 
-		Vector4 ToPoint4() const;
-		Vector4 ToVector4() const;
+		static constexpr Vector3 Project(const Vector3& v1, const Vector3& v2)
+		{
+			return (v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
 
-		Vector2 GetXY() const;
+		static constexpr Vector3 Reject(const Vector3& v1, const Vector3& v2)
+		{
+			return (v1 - v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
 
-		static float Distance(const Vector3& v1, const Vector3& v2);
-		static float DistanceSqrd(const Vector3& v1, const Vector3& v2);
-		static Vector3 Lerp(const Vector3& a, const Vector3& b, float t);
+		static constexpr Vector3 Reflect(const Vector3& v1, const Vector3& v2)
+		{
+			return v1 - v2 * (2.f * Vector3::Dot(v1, v2));
+		}
 
+		constexpr Vector4 ToPoint4() const;
+		constexpr Vector4 ToVector4() const;
+
+		constexpr Vector2 GetXY() const
+		{
+			return { x, y };
+		}
+
+		static float Distance(const Vector3& v1, const Vector3& v2)
+		{
+			return std::sqrt(DistanceSqrd(v1, v2));
+		}
+
+		static constexpr float DistanceSqrd(const Vector3& v1, const Vector3& v2)
+		{
+			const float deltaX = v2.x - v1.x;
+			const float deltaY = v2.y - v1.y;
+			const float deltaZ = v2.z - v1.z;
+
+			return deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ;
+		}
+
+		static constexpr Vector3 Lerp(const Vector3& a, const Vector3& b, float t)
+		{
+			t = std::clamp(t, 0.0f, 1.0f);
+			return {
+				a.x + t * (b.x - a.x),
+				a.y + t * (b.y - a.y),
+				a.z + t * (b.z - a.z)
+			};
+		}
+
+#pragma region Operator Overloads
 		//Member Operators
-		Vector3 operator*(float scale) const;
-		Vector3 operator/(float scale) const;
-		Vector3 operator+(const Vector3& v) const;
-		Vector3 operator-(const Vector3& v) const;
-		Vector3 operator-() const;
-		//Vector3& operator-();
-		Vector3& operator+=(const Vector3& v);
-		Vector3& operator-=(const Vector3& v);
-		Vector3& operator/=(float scale);
-		Vector3& operator*=(float scale);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector3 operator*(float scale) const
+		{
+			return { x * scale, y * scale, z * scale };
+		}
+
+		constexpr Vector3 operator/(float scale) const
+		{
+			return { x / scale, y / scale, z / scale };
+		}
+
+		constexpr Vector3 operator+(const Vector3& v) const
+		{
+			return { x + v.x, y + v.y, z + v.z };
+		}
+
+		constexpr Vector3 operator-(const Vector3& v) const
+		{
+			return { x - v.x, y - v.y, z - v.z };
+		}
+
+		constexpr Vector3 operator-() const
+		{
+			return { -x ,-y,-z };
+		}
+
+		constexpr Vector3& operator+=(const Vector3& v)
+		{
+			x += v.x;
+			y += v.y;
+			z += v.z;
+			return *this;
+		}
+
+		constexpr Vector3& operator-=(const Vector3& v)
+		{
+			x -= v.x;
+			y -= v.y;
+			z -= v.z;
+			return *this;
+		}
+
+		constexpr Vector3& operator/=(float scale)
+		{
+			x /= scale;
+			y /= scale;
+			z /= scale;
+			return *this;
+		}
+
+		constexpr Vector3& operator*=(float scale)
+		{
+			x *= scale;
+			y *= scale;
+			z *= scale;
+			return *this;
+		}
+
+		constexpr float& operator[](int index)
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
+
+		constexpr float operator[](int index) const
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
+#pragma endregion
 
 		static const Vector3 UnitX;
 		static const Vector3 UnitY;
@@ -55,9 +208,17 @@ namespace dae
 		static const Vector3 Zero;
 	};
 
+	inline constexpr Vector3 Vector3::UnitX{ 1, 0, 0 };
+	inline constexpr Vector3 Vector3::UnitY{ 0, 1, 0 };
+	inline constexpr Vector3 Vector3::UnitZ{ 0, 0, 1 };
+	inline constexpr Vector3 Vector3::Zero{ 0, 0, 0 };
+
 	//Global Operators
-	inline Vector3 operator*(float scale, const Vector3& v)
+	constexpr Vector3 operator*(float scale, const Vector3& v)
 	{
 		return { v.x * scale, v.y * scale, v.z * scale };
 	}
 }
+
+//Vector3 <-> Vector4 conversions are defined once both types are complete
+#include "Vector4.h"
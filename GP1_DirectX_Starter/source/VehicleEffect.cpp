@@ -1,8 +1,29 @@
 #include "pch.h"
 #include "VehicleEffect.h"
 
+#include <array>
+
+#include "JobSystem.h"
+
 VehicleEffect::VehicleEffect(ID3D11Device* devicePtr):
-	BaseEffect(devicePtr, L"Resources/PosCol3D.fx")
+	VehicleEffect(LoadEffect(devicePtr, L"Resources/PosCol3D.fx"))
+{
+	// decode and create the textures as parallel jobs, the device is free threaded
+	constexpr std::array<const char*, 4> paths{ "Resources/vehicle_diffuse.png", "Resources/vehicle_normal.png", "Resources/vehicle_specular.png", "Resources/vehicle_gloss.png" };
+	std::array<const Texture*, 4> texturePtrs{};
+	dae::ParallelFor(static_cast<uint32_t>(paths.size()), [&](uint32_t texture)
+	{
+		texturePtrs[texture] = new Texture(paths[texture], devicePtr);
+	});
+
+	SetDiffuseMap( texturePtrs[0] );
+	SetNormalMap( texturePtrs[1] );
+	SetSpecularMap( texturePtrs[2] );
+	SetGlossinessMap( texturePtrs[3] );
+}
+
+VehicleEffect::VehicleEffect(ID3DX11Effect* effectPtr):
+	BaseEffect(effectPtr)
 {
 	m_DiffuseMapVariablePtr = m_EffectPtr->GetVariableByName("gDiffuseMap")->AsShaderResource();
 	if (!m_DiffuseMapVariablePtr->IsValid())
@@ -33,17 +54,19 @@ VehicleEffect::VehicleEffect(ID3D11Device* devicePtr):
 	{
 		std::wcout << L"UseNormalMapVariable not valid!\n";
 	}
-
-	SetDiffuseMap( new Texture("Resources/vehicle_diffuse.png", devicePtr) );
-	SetNormalMap( new Texture("Resources/vehicle_normal.png", devicePtr) );
-	SetSpecularMap( new Texture("Resources/vehicle_specular.png", devicePtr) );
-	SetGlossinessMap( new Texture("Resources/vehicle_gloss.png", devicePtr) );
 }
 
 VehicleEffect::~VehicleEffect()
 {
 }
 
+std::unique_ptr<BaseEffect> VehicleEffect::Clone() const
+{
+	ID3DX11Effect* clonePtr = CloneEffect();
+	if (!clonePtr) return nullptr;
+	return std::unique_ptr<BaseEffect>(new VehicleEffect(clonePtr));
+}
+
 void VehicleEffect::SetDiffuseMap(const Texture* diffuseTexturePtr) const
 {
 	if (m_DiffuseMapVariablePtr) m_DiffuseMapVariablePtr->SetResource(diffuseTexturePtr->GetResourceView());
@@ -8,6 +8,8 @@ public:
 	VehicleEffect(ID3D11Device* devicePtr);
 	~VehicleEffect();
 
+	std::unique_ptr<BaseEffect> Clone() const override;
+
 	void SetDiffuseMap(const Texture* diffuseTexturePtr) const;
 	void SetNormalMap(const Texture* normalTexturePtr) const;
 	void SetSpecularMap(const Texture* specularTexturePtr) const;
@@ -16,6 +18,8 @@ public:
 	void SetUseNormalMap(bool useNormalMap) const;
 
 private:
+	explicit VehicleEffect(ID3DX11Effect* effectPtr);
+
 	ID3DX11EffectShaderResourceVariable* m_DiffuseMapVariablePtr{};
 	ID3DX11EffectShaderResourceVariable* m_NormalMapVariablePtr{};
 	ID3DX11EffectShaderResourceVariable* m_SpecularMapVariablePtr{};
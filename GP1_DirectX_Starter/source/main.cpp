@@ -5,6 +5,16 @@
 #endif
 
 #undef main
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Console.h"
+#include "FlythroughBenchmark.h"
+#include "Profiler.h"
 #include "Renderer.h"
 
 using namespace dae;
@@ -12,35 +22,46 @@ using namespace dae;
 void ShutDown(SDL_Window* pWindow)
 {
 	SDL_DestroyWindow(pWindow);
+	IMG_Quit();
 	SDL_Quit();
 }
 
 void PrintControls()
 {
-	const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, 0x0e);
+	Console::SetTextAttribute(0x0e);
 
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0xe0);
+	Console::SetTextAttribute(0xe0);
 	std::cout << "RENDERING";
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Console::SetTextAttribute(0x07);
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x0e);
+	Console::SetTextAttribute(0x0e);
 	std::cout << "'F4' \t cycle sampling state" << std::endl;
 	std::cout << "'F5' \t toggle rotation" << std::endl;
 	std::cout << "'F6' \t toggle normal map" << std::endl;
 	std::cout << "'F7' \t toggle fire fx" << std::endl;
+	std::cout << "'F8' \t toggle vehicle crowd" << std::endl;
+	std::cout << "'F9' \t toggle instancing" << std::endl;
+	std::cout << "'F10' \t toggle render stats" << std::endl;
+	std::cout << "'F11' \t toggle transparent triangle sorting" << std::endl;
+	std::cout << "'O' \t toggle occlusion culling" << std::endl;
+	std::cout << "'M' \t toggle multithreaded recording (instancing off)" << std::endl;
+	std::cout << "'L' \t cycle pipelined frames (1 off, 2, 3)" << std::endl;
+#if defined(DAE_PROFILING)
+	std::cout << "'P' \t toggle profiler zone summary" << std::endl;
+	std::cout << "'T' \t write profiler trace (profile.json)" << std::endl;
+#endif
 
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0xf0);
+	Console::SetTextAttribute(0xf0);
 	std::cout << "KEYBOARD";
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Console::SetTextAttribute(0x07);
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x0f);
+	Console::SetTextAttribute(0x0f);
 	std::cout << "'W / UP'        move camera forward" << std::endl;
 	std::cout << "'S / DOWN'      move camera backward" << std::endl;
 	std::cout << "'A / LEFT'      move camera left" << std::endl;
@@ -52,12 +73,12 @@ void PrintControls()
 
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x90);
+	Console::SetTextAttribute(0x90);
 	std::cout << "MOUSE";
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Console::SetTextAttribute(0x07);
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x09);
+	Console::SetTextAttribute(0x09);
 	std::cout << "'RMB'           look around" << std::endl;
 	std::cout << "'LMB'           move camera forward / backwards" << std::endl;
 	std::cout << "'LMB + RMB'     move camera up / down" << std::endl;
@@ -67,17 +88,129 @@ void PrintControls()
 
 	std::cout << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Console::SetTextAttribute(0x07);
+}
+
+//Average FPS plus the frame time and input-to-present latency distributions of the last FrameTimeHistogram::WindowSize frames
+void PrintFrameTimes(const Timer* pTimer, const Renderer* pRenderer)
+{
+	const FrameTimeHistogram& frameTimes{ pTimer->GetFrameTimes() };
+	const auto toMs = [](double microseconds) { return microseconds / 1000.0; };
+
+	char line[160];
+	std::snprintf(line, sizeof(line), "dFPS: %.1f | ms p50 %.2f p95 %.2f p99 %.2f max %.2f | pacing sd %.2f | hitches %u (%llu total)\n",
+		static_cast<double>(pTimer->GetdFPS()),
+		toMs(frameTimes.GetPercentile(0.50)), toMs(frameTimes.GetPercentile(0.95)), toMs(frameTimes.GetPercentile(0.99)),
+		toMs(frameTimes.GetMax()), toMs(std::sqrt(frameTimes.GetVariance())),
+		frameTimes.GetHitchCount(), static_cast<unsigned long long>(frameTimes.GetTotalHitchCount()));
+	std::cout << line;
+
+	const FrameTimeHistogram& latencies{ pRenderer->GetLatencies() };
+	std::snprintf(line, sizeof(line), "latency: %u frame(s) in flight | ms p50 %.2f p99 %.2f max %.2f\n",
+		pRenderer->GetPipelineDepth(),
+		toMs(latencies.GetPercentile(0.50)), toMs(latencies.GetPercentile(0.99)), toMs(latencies.GetMax()));
+	std::cout << line;
 }
 
+//Runs the scripted flythrough with the keyboard and mouse ignored, closing the window aborts it
+int RunBenchmark(Renderer* pRenderer, const FlythroughBenchmark::Settings& settings)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto toMs = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	FlythroughBenchmark benchmark{ settings };
+	std::cout << "Running benchmark: " << settings.warmupFrameCount << " warmup + " << benchmark.GetFrameCount() << " frames" << std::endl;
+
+	auto frameStart = Clock::now();
+	while (!benchmark.IsFinished())
+	{
+		DAE_PROFILE_FRAME();
+		DAE_PROFILE_SCOPE("Frame");
+
+		SDL_Event e;
+		while (SDL_PollEvent(&e))
+		{
+			if (e.type == SDL_QUIT)
+			{
+				std::cout << "Benchmark aborted" << std::endl;
+				return 1;
+			}
+		}
+
+		//--------- Update ---------
+		const auto updateStart = Clock::now();
+		const FlythroughBenchmark::Frame frame{ benchmark.GetFrame() };
+		pRenderer->GetCamera().SetLookAt(frame.cameraOrigin, frame.cameraTarget);
+		pRenderer->SetRotation(frame.canRotate);
+		pRenderer->SetFireFX(frame.renderFireFX);
+		pRenderer->UpdateScene(FlythroughBenchmark::FixedTimestep);
+
+		//--------- Render ---------
+		const auto renderStart = Clock::now();
+		pRenderer->Render();
+
+		//--------- Present ---------
+		// without vsync, waiting on the GPU shows up here once the driver queue is full
+		const auto presentStart = Clock::now();
+		pRenderer->Present();
+
+		const auto frameEnd = Clock::now();
+		benchmark.EndFrame({ toMs(renderStart - updateStart), toMs(presentStart - renderStart), toMs(frameEnd - presentStart), toMs(frameEnd - frameStart) });
+		frameStart = frameEnd;
+	}
+
+	benchmark.PrintReport();
+	return benchmark.WriteReport() ? 0 : 1;
+}
+
+//The whole argument has to be the number, no exceptions and no trailing characters
+template<typename T>
+bool ParseNumber(const char* text, T& value)
+{
+	const char* end = text + std::strlen(text);
+	const auto [last, error] = std::from_chars(text, end, value);
+	return error == std::errc{} && last == end;
+}
+
+//Usage: DirectX [--benchmark [seconds, 20]] [--benchmark-out <path without extension, benchmark>] [--pipeline <frames in flight, 1..3, 1>]
+//Exits with 2 on a bad seconds or frames in flight value
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	bool isBenchmark{ false };
+	uint32_t pipelineDepth{ 1 };
+	FlythroughBenchmark::Settings benchmarkSettings{};
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		bool isValid{ true };
+		if (std::strcmp(args[i], "--benchmark") == 0)
+		{
+			isBenchmark = true;
+			if (i + 1 < argc && args[i + 1][0] != '-')
+			{
+				isValid = ParseNumber(args[++i], benchmarkSettings.duration) && benchmarkSettings.duration > 0.f;
+			}
+		}
+		else if (i + 1 < argc && std::strcmp(args[i], "--benchmark-out") == 0)
+		{
+			benchmarkSettings.reportPath = args[++i];
+		}
+		else if (i + 1 < argc && std::strcmp(args[i], "--pipeline") == 0)
+		{
+			isValid = ParseNumber(args[++i], pipelineDepth);
+			pipelineDepth = std::clamp(pipelineDepth, 1u, Renderer::MaxPipelineDepth);
+		}
+
+		if (!isValid)
+		{
+			std::cerr << "invalid value '" << args[i] << "' for " << args[i - 1] << std::endl;
+			return 2;
+		}
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
+	//up front, textures load on several threads and IMG_Load would otherwise load libpng lazily on each of them
+	IMG_Init(IMG_INIT_PNG);
 
 	const uint32_t width = 640;
 	const uint32_t height = 480;
@@ -92,22 +225,40 @@ int main(int argc, char* args[])
 		return 1;
 
 	// show info text
-	const HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, 0xc0);
+	Console::SetTextAttribute(0xc0);
 	std::cout << "press 'i' for key-bindings" << std::endl;
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Console::SetTextAttribute(0x07);
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
 	const auto pRenderer = new Renderer(pWindow);
 	pRenderer->CycleSamplerState();
+	pRenderer->SetPipelineDepth(pipelineDepth);
+
+	if (isBenchmark)
+	{
+		const int result{ RunBenchmark(pRenderer, benchmarkSettings) };
+
+		delete pRenderer;
+		delete pTimer;
+
+		ShutDown(pWindow);
+		return result;
+	}
 
 	//Start loop
+	DAE_PROFILE_THREAD("Main");
 	pTimer->Start();
 	float printTimer = 0.f;
+#if defined(DAE_PROFILING)
+	bool printProfile = false;
+#endif
 	bool isLooping = true;
 	while (isLooping)
 	{
+		DAE_PROFILE_FRAME();
+		DAE_PROFILE_SCOPE("Frame");
+
 		//--------- Get input events ---------
 		SDL_Event e;
 		while (SDL_PollEvent(&e))
@@ -140,6 +291,47 @@ int main(int argc, char* args[])
 				{
 					pRenderer->ToggleFireFX();
 				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+				{
+					pRenderer->ToggleCrowd();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+				{
+					pRenderer->ToggleInstancing();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+				{
+					pRenderer->ToggleRenderStats();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+				{
+					pRenderer->ToggleTriangleSorting();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_O)
+				{
+					pRenderer->ToggleOcclusionCulling();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_M)
+				{
+					pRenderer->ToggleDeferredContexts();
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_L)
+				{
+					pRenderer->CyclePipelineDepth();
+				}
+#if defined(DAE_PROFILING)
+				if (e.key.keysym.scancode == SDL_SCANCODE_P)
+				{
+					printProfile = !printProfile;
+					Console::PrintToggle("Profiler Summary", printProfile);
+				}
+				if (e.key.keysym.scancode == SDL_SCANCODE_T)
+				{
+					pRenderer->PauseSimulation();
+					Profiler::Get().WriteChromeTrace("profile.json");
+					pRenderer->ResumeSimulation();
+				}
+#endif
 				break;
 			case SDL_MOUSEWHEEL:
 				{
@@ -162,6 +354,7 @@ int main(int argc, char* args[])
 
 		//--------- Render ---------
 		pRenderer->Render();
+		pRenderer->Present();
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -169,7 +362,16 @@ int main(int argc, char* args[])
 		if (printTimer >= 1.f)
 		{
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			PrintFrameTimes(pTimer, pRenderer);
+			pRenderer->PrintRenderStats();
+#if defined(DAE_PROFILING)
+			if (printProfile)
+			{
+				pRenderer->PauseSimulation();
+				Profiler::Get().PrintFrameSummary();
+				pRenderer->ResumeSimulation();
+			}
+#endif
 		}
 	}
 	pTimer->Stop();